@@ -1,4 +1,11 @@
 #include "BaseMesh.h"
+#include <map>
+#include <set>
+#include <tuple>
+#include <climits> // INT_MAX
+#include <string.h> // memcpy
+
+int BaseMesh::num_draws_ = 0;
 
 BaseMesh::BaseMesh()
 {
@@ -36,21 +43,25 @@ void BaseMesh::setColour(Colour4 colour)
 void BaseMesh::setScale(Vector3 scale)
 {
 	scale_ = scale;
+	markTransformDirty();
 }
 
 void BaseMesh::invertVertically()
 {
 	scale_.y *= -1.0f;
+	markTransformDirty();
 }
 
 void BaseMesh::invertHorizontally()
 {
 	scale_.x *= -1.0f;
+	markTransformDirty();
 }
 
 void BaseMesh::invertZ()
 {
 	scale_.z *= -1.0f;
+	markTransformDirty();
 }
 
 void BaseMesh::setMode(GLenum mode)
@@ -80,6 +91,7 @@ void BaseMesh::setIsRotating(vector<bool> is_rotating)
 void BaseMesh::setRotationAngles(Vector3 rotation_angles)
 {
 	rotation_angles_ = rotation_angles;
+	markTransformDirty();
 }
 
 Vector3 BaseMesh::getRotationAngles() const
@@ -90,21 +102,25 @@ Vector3 BaseMesh::getRotationAngles() const
 void BaseMesh::setTranslation(Vector3 translation)
 {
 	translation_ = translation;
+	markTransformDirty();
 }
 
 void BaseMesh::setTranslationX(float translation_x)
 {
 	translation_.x = translation_x;
+	markTransformDirty();
 }
 
 void BaseMesh::setTranslationY(float translation_y)
 {
 	translation_.y = translation_y;
+	markTransformDirty();
 }
 
 void BaseMesh::setTranslationZ(float translation_z)
 {
 	translation_.z = translation_z;
+	markTransformDirty();
 }
 
 Vector3 BaseMesh::getTranslation() const
@@ -132,9 +148,39 @@ void BaseMesh::setAxisLimits(AxisLimits axis_limits)
 	axis_limits_ = axis_limits;
 }
 
+float BaseMesh::getSpeed() const
+{
+	return speed_;
+}
+
+const vector<bool>& BaseMesh::getIsRotating() const
+{
+	return is_rotating_;
+}
+
+const vector<bool>& BaseMesh::getIsMoving() const
+{
+	return is_moving_;
+}
+
+Vector3 BaseMesh::getDirection() const
+{
+	return direction_;
+}
+
+AxisLimits BaseMesh::getAxisLimits() const
+{
+	return axis_limits_;
+}
+
 
 void BaseMesh::update(float dt)
 {
+	// the matrix is only calculated again if the mesh moves or rotates
+	if (is_rotating_[0] || is_rotating_[1] || is_rotating_[2] || is_moving_[0] || is_moving_[1] || is_moving_[2])
+	{
+		markTransformDirty();
+	}
 
 	/* rotate automatically around x, y and/or z axis */ 
 	if (is_rotating_[0]) // on the x axis
@@ -202,6 +248,10 @@ void BaseMesh::update(float dt)
 
 void BaseMesh::render(bool is_shadow)
 {
+	// the geometry has been evicted by the residency manager, it is rendered again when it is restored
+	if (!geometry_resident_)
+		return;
+
 	// To Turn on Wireframe to draw the lines (for test proposed) 
 	if(*shared_context_->wireframe_mode)
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // draw lines
@@ -217,7 +267,7 @@ void BaseMesh::render(bool is_shadow)
 	/* Apply texture_ if this object has one */
 	if (texture_ != nullptr && !is_shadow)
 	{
-		texture_->use();
+		bindTexture();
 	}
 
 	/* Enable Arrays of coords (vertices_, normals_, textures and index) and link them */
@@ -243,44 +293,12 @@ void BaseMesh::render(bool is_shadow)
 	// remember where we are
 	glPushMatrix();
 
-		// scale the object
-		//glScalef(scale_.x, scale_.y, scale_.z);
-		
-		// translate the square
-		glTranslatef(translation_.x, translation_.y, translation_.z);
-
-		// rotate on the x axis
-		glRotatef(rotation_angles_.x, 1.0f, 0.0f, 0.0f);
-		// rotate on the y axis
-		glRotatef(rotation_angles_.y, 0.0f, 1.0f, 0.0f);
-		// rotate on the z axis
-		glRotatef(rotation_angles_.z, 0.0f, 0.0f, 1.0f);
-
-		// scale the object
-		glScalef(scale_.x, scale_.y, scale_.z);
+		// translate, rotate and scale the object (cached matrix)
+		applyTransform();
 
 
 		/* DRAW */
-		// Method 1
-		if (dereference_method_ == DereferenceMethod::kMethod1)
-		{
-			glBegin(mode_);
-				for (GLint i = 0; i < (int)vertices_.size()/3; i++)
-				{
-					glArrayElement(i);
-				}
-			glEnd();
-		}
-		// Method 2
-		else if (dereference_method_ == DereferenceMethod::kMethod2)
-		{
-			glDrawArrays(mode_, 0, (int)vertices_.size()/3);
-		}
-		// Method 3
-		else if (dereference_method_ == DereferenceMethod::kMethod3)
-		{
-			glDrawElements(mode_, (unsigned int)indices_.size(), GL_UNSIGNED_INT, indices_.data()); // method 3 of dereference
-		}
+		drawGeometry();
 
 		// render all the submeshes of this mesh (hierarchical)
 		for (BaseMesh* submesh : submeshes_)
@@ -305,7 +323,7 @@ void BaseMesh::render(bool is_shadow)
 	/* Stop using the texture_ if this object has one*/
 	if (texture_ != nullptr && !is_shadow)
 	{
-		texture_->stopUsing();
+		unbindTexture();
 	}
 
 	/* reset to white colour */
@@ -337,6 +355,8 @@ void BaseMesh::copyMovementComponents(BaseMesh* base_shape_to_copy)
 	translation_ = base_shape_to_copy->getTranslation();
 
 	rotation_angles_ = base_shape_to_copy->getRotationAngles();
+
+	markTransformDirty();
 }
 
 
@@ -375,4 +395,686 @@ void BaseMesh::setSharedContext(SharedContext* shared_context)
 void BaseMesh::addSubmesh(BaseMesh* submesh)
 {
 	submeshes_.push_back(submesh);
-}
\ No newline at end of file
+}
+
+void BaseMesh::remapTextureCoordsToAtlas()
+{
+	// remap the submeshes (hierarchical)
+	for (BaseMesh* submesh : submeshes_)
+	{
+		submesh->remapTextureCoordsToAtlas();
+	}
+
+	// nothing to remap if it has no texture, the texture is not in an atlas or it has already been remapped
+	if (texture_ == nullptr || !texture_->isInAtlas() || uses_atlas_)
+	{
+		return;
+	}
+
+	// the region of the atlas is not repeated so coords out of 0-1 would read the neighbour regions, in that case the texture itself is used
+	// (a small tolerance is allowed for the rounding of the models exported)
+	const float tolerance = 0.01f;
+	for (float coord : texture_coords_)
+	{
+		if (coord < -tolerance || coord > 1.0f + tolerance)
+		{
+			return;
+		}
+	}
+
+	// transform each pair of coords (u,v) into the coords of the atlas page
+	for (size_t i = 0; i + 1 < texture_coords_.size(); i += 2)
+	{
+		texture_->remapToAtlas(texture_coords_[i], texture_coords_[i + 1]);
+	}
+
+	uses_atlas_ = true;
+}
+
+void BaseMesh::bindTexture()
+{
+	if (uses_atlas_)
+		texture_->useAtlas(); // the page is only bound if it is not already bound
+	else
+		texture_->use();
+}
+
+void BaseMesh::unbindTexture()
+{
+	if (uses_atlas_)
+		texture_->stopUsingAtlas();
+	else
+		texture_->stopUsing();
+}
+
+void BaseMesh::getTextures(vector<Texture*>& textures) const
+{
+	if (texture_ != nullptr)
+	{
+		textures.push_back(texture_);
+	}
+	for (BaseMesh* submesh : submeshes_)
+	{
+		submesh->getTextures(textures);
+	}
+}
+
+void BaseMesh::updateBounds()
+{
+	// the local sphere is calculated only the first time
+	if (!bounds_computed_)
+	{
+		has_bounds_ = computeLocalBoundingSphere(local_center_, local_radius_);
+		bounds_computed_ = true;
+	}
+	getLocalMatrix(); // recalculate the cached matrix if it is dirty
+}
+
+bool BaseMesh::getBoundingSphere(Vector3& center, float& radius) const
+{
+	if (!bounds_computed_ || !has_bounds_)
+	{
+		return false;
+	}
+
+	// move the sphere with the mesh, the radius grows with the biggest scale
+	center = transformPoint(local_center_);
+	float max_scale = fabsf(scale_.x);
+	if (fabsf(scale_.y) > max_scale) max_scale = fabsf(scale_.y);
+	if (fabsf(scale_.z) > max_scale) max_scale = fabsf(scale_.z);
+	radius = local_radius_ * max_scale;
+
+	return true;
+}
+
+bool BaseMesh::computeLocalBoundingSphere(Vector3& center, float& radius)
+{
+	// spheres of the submeshes (they are in the space of this mesh)
+	vector<pair<Vector3, float>> spheres;
+	for (BaseMesh* submesh : submeshes_)
+	{
+		Vector3 submesh_center;
+		float submesh_radius;
+		submesh->updateBounds();
+		if (submesh->getBoundingSphere(submesh_center, submesh_radius))
+		{
+			spheres.push_back(make_pair(submesh_center, submesh_radius));
+		}
+	}
+
+	return computeBoundingSphere(vertices_, spheres, center, radius);
+}
+
+bool BaseMesh::computeBoundingSphere(const vector<float>& vertices, const vector<pair<Vector3, float>>& spheres, Vector3& center, float& radius)
+{
+	if (vertices.size() < 3 && spheres.empty())
+	{
+		return false;
+	}
+
+	// center: middle of the bounding box
+	Vector3 box_min(1e30f, 1e30f, 1e30f), box_max(-1e30f, -1e30f, -1e30f);
+	for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+	{
+		box_min.set(fminf(box_min.x, vertices[i]), fminf(box_min.y, vertices[i + 1]), fminf(box_min.z, vertices[i + 2]));
+		box_max.set(fmaxf(box_max.x, vertices[i]), fmaxf(box_max.y, vertices[i + 1]), fmaxf(box_max.z, vertices[i + 2]));
+	}
+	for (const pair<Vector3, float>& sphere : spheres)
+	{
+		box_min.set(fminf(box_min.x, sphere.first.x - sphere.second), fminf(box_min.y, sphere.first.y - sphere.second), fminf(box_min.z, sphere.first.z - sphere.second));
+		box_max.set(fmaxf(box_max.x, sphere.first.x + sphere.second), fmaxf(box_max.y, sphere.first.y + sphere.second), fmaxf(box_max.z, sphere.first.z + sphere.second));
+	}
+	center.set((box_min.x + box_max.x) * 0.5f, (box_min.y + box_max.y) * 0.5f, (box_min.z + box_max.z) * 0.5f);
+
+	// radius: farthest vertex or sphere from the center
+	float radius_squared = 0.0f;
+	for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+	{
+		float dx = vertices[i] - center.x, dy = vertices[i + 1] - center.y, dz = vertices[i + 2] - center.z;
+		radius_squared = fmaxf(radius_squared, dx * dx + dy * dy + dz * dz);
+	}
+	radius = sqrtf(radius_squared);
+	for (const pair<Vector3, float>& sphere : spheres)
+	{
+		float dx = sphere.first.x - center.x, dy = sphere.first.y - center.y, dz = sphere.first.z - center.z;
+		radius = fmaxf(radius, sqrtf(dx * dx + dy * dy + dz * dz) + sphere.second);
+	}
+
+	return true;
+}
+
+Vector3 BaseMesh::transformPoint(Vector3 point) const
+{
+	// a mesh moved after its last updateBounds() uses a temporary matrix
+	if (local_matrix_dirty_)
+	{
+		return Matrix4::fromTranslationRotationScale(translation_, rotation_angles_, scale_).transformPoint(point);
+	}
+	return local_matrix_.transformPoint(point);
+}
+
+const float* BaseMesh::getLocalMatrix() const
+{
+	if (local_matrix_dirty_)
+	{
+		// rotation = rotate x * rotate y * rotate z (the same order as glRotatef in render())
+		local_matrix_ = Matrix4::fromTranslationRotationScale(translation_, rotation_angles_, scale_);
+
+		local_matrix_dirty_ = false;
+	}
+	return local_matrix_.data();
+}
+
+unsigned int BaseMesh::getTransformVersion() const
+{
+	return transform_version_;
+}
+
+void BaseMesh::applyTransform() const
+{
+	glMultMatrixf(getLocalMatrix());
+}
+
+size_t BaseMesh::getGeometryBytes() const
+{
+	return (vertices_.size() + normals_.size() + texture_coords_.size()) * sizeof(float) + indices_.size() * sizeof(unsigned int);
+}
+
+bool BaseMesh::isGeometryResident() const
+{
+	return geometry_resident_;
+}
+
+bool BaseMesh::evictGeometry(const string& cache_url)
+{
+	if (!geometry_resident_)
+	{
+		return true;
+	}
+
+	// the bounds are needed to know when the mesh is visible again, so they are calculated before freeing the vertices
+	Vector3 center;
+	float radius;
+	getBoundingSphere(center, radius);
+
+	// the geometry doesn't change, so it is saved only the first time
+	if (!geometry_saved_)
+	{
+		FILE* file = fopen(cache_url.c_str(), "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		unsigned int sizes[4] = { (unsigned int)vertices_.size(), (unsigned int)normals_.size(), (unsigned int)texture_coords_.size(), (unsigned int)indices_.size() };
+		bool written = fwrite(sizes, sizeof(sizes), 1, file) == 1;
+		written = written && fwrite(vertices_.data(), sizeof(float), vertices_.size(), file) == vertices_.size();
+		written = written && fwrite(normals_.data(), sizeof(float), normals_.size(), file) == normals_.size();
+		written = written && fwrite(texture_coords_.data(), sizeof(float), texture_coords_.size(), file) == texture_coords_.size();
+		written = written && fwrite(indices_.data(), sizeof(unsigned int), indices_.size(), file) == indices_.size();
+		fclose(file);
+
+		if (!written)
+		{
+			return false;
+		}
+		geometry_saved_ = true;
+	}
+
+	// free the memory of the arrays
+	vector<float>().swap(vertices_);
+	vector<float>().swap(normals_);
+	vector<float>().swap(texture_coords_);
+	vector<unsigned int>().swap(indices_);
+	geometry_resident_ = false;
+
+	return true;
+}
+
+bool BaseMesh::readGeometry(const string& cache_url, GeometryData& geometry)
+{
+	FILE* file = fopen(cache_url.c_str(), "rb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	unsigned int sizes[4];
+	bool read = fread(sizes, sizeof(sizes), 1, file) == 1;
+	if (read)
+	{
+		geometry.vertices.resize(sizes[0]);
+		geometry.normals.resize(sizes[1]);
+		geometry.texture_coords.resize(sizes[2]);
+		geometry.indices.resize(sizes[3]);
+		read = fread(geometry.vertices.data(), sizeof(float), sizes[0], file) == sizes[0];
+		read = read && fread(geometry.normals.data(), sizeof(float), sizes[1], file) == sizes[1];
+		read = read && fread(geometry.texture_coords.data(), sizeof(float), sizes[2], file) == sizes[2];
+		read = read && fread(geometry.indices.data(), sizeof(unsigned int), sizes[3], file) == sizes[3];
+	}
+	fclose(file);
+
+	return read;
+}
+
+void BaseMesh::restoreGeometry(GeometryData& geometry)
+{
+	vertices_.swap(geometry.vertices);
+	normals_.swap(geometry.normals);
+	texture_coords_.swap(geometry.texture_coords);
+	indices_.swap(geometry.indices);
+	geometry_resident_ = true;
+}
+
+void BaseMesh::getLocalTriangles(vector<float>& triangles) const
+{
+	// only the triangles and quads can be read (the quads are split in two triangles)
+	int vertices_per_face = (mode_ == GL_TRIANGLES) ? 3 : (mode_ == GL_QUADS) ? 4 : 0;
+	if (vertices_per_face > 0)
+	{
+		// the vertices are read in the same order as render()
+		bool use_indices = dereference_method_ == DereferenceMethod::kMethod3;
+		size_t num_vertices = use_indices ? indices_.size() : vertices_.size() / 3;
+
+		for (size_t face = 0; face + vertices_per_face <= num_vertices; face += vertices_per_face)
+		{
+			unsigned int v[4];
+			for (int i = 0; i < vertices_per_face; i++)
+			{
+				v[i] = use_indices ? indices_[face + i] : (unsigned int)(face + i);
+			}
+
+			// triangle 0, 1, 2 and for the quads also 0, 2, 3
+			unsigned int order[6] = { v[0], v[1], v[2], v[0], v[2], v[3] };
+			int num_triangles = vertices_per_face - 2;
+			for (int i = 0; i < num_triangles * 3; i++)
+			{
+				triangles.push_back(vertices_[order[i] * 3]);
+				triangles.push_back(vertices_[order[i] * 3 + 1]);
+				triangles.push_back(vertices_[order[i] * 3 + 2]);
+			}
+		}
+	}
+
+	for (BaseMesh* submesh : submeshes_)
+	{
+		submesh->getTriangles(triangles);
+	}
+}
+
+void BaseMesh::getTriangles(vector<float>& triangles) const
+{
+	size_t first = triangles.size();
+	getLocalTriangles(triangles);
+
+	// move the new triangles with this mesh
+	for (size_t i = first; i + 2 < triangles.size(); i += 3)
+	{
+		Vector3 point = transformPoint(Vector3(triangles[i], triangles[i + 1], triangles[i + 2]));
+		triangles[i] = point.x;
+		triangles[i + 1] = point.y;
+		triangles[i + 2] = point.z;
+	}
+}
+
+void BaseMesh::getTransformMatrix(float matrix[16]) const
+{
+	// as transformPoint(), the cached matrix is only read (the cull tasks call it)
+	if (local_matrix_dirty_)
+	{
+		memcpy(matrix, Matrix4::fromTranslationRotationScale(translation_, rotation_angles_, scale_).data(), 16 * sizeof(float));
+		return;
+	}
+	memcpy(matrix, local_matrix_.data(), 16 * sizeof(float));
+}
+
+bool BaseMesh::hasShadowProxy()
+{
+	// the proxy is built once the mesh has its triangles (ex: a model which is still loading or evicted has none)
+	if (!shadow_proxy_built_)
+	{
+		vector<float> triangles;
+		if (shadow_proxy_simplified_)
+			getShadowProxyTriangles(triangles);
+		else
+			getLocalTriangles(triangles);
+
+		if (!triangles.empty())
+		{
+			buildShadowProxy(triangles, shadow_proxy_simplified_ ? kShadowProxyMaxTriangles : INT_MAX, shadow_proxy_vertices_, shadow_proxy_indices_);
+			shadow_proxy_built_ = true;
+		}
+	}
+
+	return shadow_proxy_built_ && !shadow_proxy_indices_.empty();
+}
+
+const vector<float>& BaseMesh::getShadowProxyVertices() const
+{
+	return shadow_proxy_vertices_;
+}
+
+const vector<unsigned int>& BaseMesh::getShadowProxyIndices() const
+{
+	return shadow_proxy_indices_;
+}
+
+void BaseMesh::setShadowProxySimplified(bool simplified)
+{
+	shadow_proxy_simplified_ = simplified;
+}
+
+void BaseMesh::renderShadow()
+{
+	// the geometry has been evicted by the residency manager
+	if (!geometry_resident_)
+		return;
+
+	if (!hasShadowProxy())
+	{
+		render(true);
+		return;
+	}
+
+	// same colour as render(true)
+	glColor4f(0.1f, 0.1f, 0.1f, 1.0f);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, shadow_proxy_vertices_.data());
+
+	glPushMatrix();
+		applyTransform();
+		glDrawElements(GL_TRIANGLES, (GLsizei)shadow_proxy_indices_.size(), GL_UNSIGNED_INT, shadow_proxy_indices_.data());
+		num_draws_++;
+	glPopMatrix();
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void BaseMesh::drawGeometry() const
+{
+	// Method 1
+	if (dereference_method_ == DereferenceMethod::kMethod1)
+	{
+		glBegin(mode_);
+			for (GLint i = 0; i < (int)vertices_.size()/3; i++)
+			{
+				glArrayElement(i);
+			}
+		glEnd();
+	}
+	// Method 2
+	else if (dereference_method_ == DereferenceMethod::kMethod2)
+	{
+		glDrawArrays(mode_, 0, (int)vertices_.size()/3);
+	}
+	// Method 3
+	else if (dereference_method_ == DereferenceMethod::kMethod3)
+	{
+		glDrawElements(mode_, (unsigned int)indices_.size(), GL_UNSIGNED_INT, indices_.data()); // method 3 of dereference
+	}
+	num_draws_++;
+}
+
+bool BaseMesh::isStatic() const
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (is_moving_[axis] || is_rotating_[axis])
+			return false;
+	}
+	return true;
+}
+
+bool BaseMesh::getStaticParts(const Matrix4& parent_matrix, vector<StaticPart>& parts) const
+{
+	// same transformations as render()
+	Matrix4 matrix = parent_matrix * Matrix4(getLocalMatrix());
+
+	if (!vertices_.empty() && !addStaticPart(matrix, mode_, parts))
+	{
+		return false;
+	}
+	for (BaseMesh* submesh : submeshes_)
+	{
+		if (!submesh->getStaticParts(matrix, parts))
+			return false;
+	}
+	return true;
+}
+
+bool BaseMesh::addStaticPart(const Matrix4& matrix, GLenum mode, vector<StaticPart>& parts, int first_vertex, int end_vertex) const
+{
+	// only the triangles and quads can be merged (the quads are split in two triangles)
+	int vertices_per_face = (mode == GL_TRIANGLES) ? 3 : (mode == GL_QUADS) ? 4 : 0;
+	if (vertices_per_face == 0)
+	{
+		return false;
+	}
+
+	StaticPart part;
+	part.texture = texture_;
+	part.uses_atlas = uses_atlas_;
+	part.colour = colour_;
+
+	// the vertices of the faces, in the same order as render()
+	bool use_indices = end_vertex < 0 && dereference_method_ == DereferenceMethod::kMethod3;
+	int num_vertices = use_indices ? (int)indices_.size() : (end_vertex < 0 ? (int)vertices_.size() / 3 : end_vertex) - first_vertex;
+	vector<unsigned int> face_vertices;
+	for (int face = 0; face + vertices_per_face <= num_vertices; face += vertices_per_face)
+	{
+		unsigned int v[4];
+		for (int i = 0; i < vertices_per_face; i++)
+		{
+			v[i] = use_indices ? indices_[face + i] : (unsigned int)(first_vertex + face + i);
+		}
+
+		// triangle 0, 1, 2 and for the quads also 0, 2, 3
+		unsigned int order[6] = { v[0], v[1], v[2], v[0], v[2], v[3] };
+		face_vertices.insert(face_vertices.end(), order, order + (vertices_per_face - 2) * 3);
+	}
+
+	// each vertex used is transformed once, the indices are remapped to the vertices of the part
+	bool has_normals = normals_.size() == vertices_.size();
+	bool has_texture_coords = texture_coords_.size() / 2 == vertices_.size() / 3;
+	vector<int> new_index(vertices_.size() / 3, -1);
+	for (unsigned int vertex : face_vertices)
+	{
+		if (vertex * 3 + 2 >= vertices_.size())
+		{
+			continue;
+		}
+		if (new_index[vertex] < 0)
+		{
+			new_index[vertex] = (int)part.vertices.size() / 3;
+
+			Vector3 position = matrix.transformPoint(Vector3(vertices_[vertex * 3], vertices_[vertex * 3 + 1], vertices_[vertex * 3 + 2]));
+			part.vertices.insert(part.vertices.end(), { position.x, position.y, position.z });
+
+			Vector3 normal(0.0f, 1.0f, 0.0f);
+			if (has_normals)
+				normal = matrix.transformNormal(Vector3(normals_[vertex * 3], normals_[vertex * 3 + 1], normals_[vertex * 3 + 2]));
+			part.normals.insert(part.normals.end(), { normal.x, normal.y, normal.z });
+
+			if (has_texture_coords)
+				part.texture_coords.insert(part.texture_coords.end(), { texture_coords_[vertex * 2], texture_coords_[vertex * 2 + 1] });
+			else
+				part.texture_coords.insert(part.texture_coords.end(), { 0.0f, 0.0f });
+		}
+		part.indices.push_back((unsigned int)new_index[vertex]);
+	}
+
+	if (!part.indices.empty())
+	{
+		parts.push_back(part);
+	}
+	return true;
+}
+
+void BaseMesh::setGeometryKey(const string& geometry_key)
+{
+	geometry_key_ = geometry_key;
+}
+
+const string& BaseMesh::getGeometryKey() const
+{
+	return geometry_key_;
+}
+
+bool BaseMesh::isGroupable() const
+{
+	return submeshes_.empty();
+}
+
+Texture* BaseMesh::getTexture() const
+{
+	return texture_;
+}
+
+void BaseMesh::beginGroupedDraws()
+{
+	// same state as render()
+	if (*shared_context_->wireframe_mode)
+		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	else
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	if (texture_ != nullptr)
+	{
+		bindTexture();
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(2, GL_FLOAT, 0, texture_coords_.data());
+	}
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, vertices_.data());
+	glNormalPointer(GL_FLOAT, 0, normals_.data());
+}
+
+void BaseMesh::drawGrouped(const BaseMesh* member) const
+{
+	// only the colour and the matrix change between the meshes of the group
+	glColor4fv(member->colour_.rgba);
+	glPushMatrix();
+		member->applyTransform();
+		drawGeometry();
+	glPopMatrix();
+}
+
+void BaseMesh::endGroupedDraws()
+{
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	if (texture_ != nullptr)
+	{
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		unbindTexture();
+	}
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+int BaseMesh::getNumDraws()
+{
+	return num_draws_;
+}
+
+void BaseMesh::resetNumDraws()
+{
+	num_draws_ = 0;
+}
+
+void BaseMesh::countDraw()
+{
+	num_draws_++;
+}
+
+void BaseMesh::getShadowProxyTriangles(vector<float>& triangles) const
+{
+	getLocalTriangles(triangles);
+}
+
+void BaseMesh::buildShadowProxy(const vector<float>& triangles, int max_triangles, vector<float>& vertices, vector<unsigned int>& indices)
+{
+	/* Box of the triangles, for the grid */
+
+	Vector3 box_min(1e30f, 1e30f, 1e30f), box_max(-1e30f, -1e30f, -1e30f);
+	for (size_t i = 0; i + 2 < triangles.size(); i += 3)
+	{
+		box_min = Vector3(fminf(box_min.x, triangles[i]), fminf(box_min.y, triangles[i + 1]), fminf(box_min.z, triangles[i + 2]));
+		box_max = Vector3(fmaxf(box_max.x, triangles[i]), fmaxf(box_max.y, triangles[i + 1]), fmaxf(box_max.z, triangles[i + 2]));
+	}
+	float box_size = fmaxf(box_max.x - box_min.x, fmaxf(box_max.y - box_min.y, box_max.z - box_min.z));
+	if (box_size <= 0.0f)
+	{
+		box_size = 1.0f;
+	}
+
+	// first the vertices are only merged if they are in the same position (the meshes repeat them for the normals and texture coords),
+	// then, while there are too many triangles, the vertices in the same cell of a grid are merged (the grid is made coarser each time)
+	int cells = 0; // 0: no grid
+	while (true)
+	{
+		vertices.clear();
+		indices.clear();
+
+		map<tuple<int, int, int>, unsigned int> vertex_indices;
+		set<tuple<unsigned int, unsigned int, unsigned int>> triangles_added; // the merged vertices can give the same triangle several times
+		float precision = (cells == 0) ? 10000.0f : cells / box_size;
+		Vector3 origin = (cells == 0) ? Vector3(0.0f, 0.0f, 0.0f) : box_min;
+
+		for (size_t i = 0; i + 8 < triangles.size(); i += 9)
+		{
+			unsigned int triangle[3];
+			for (int j = 0; j < 3; j++)
+			{
+				const float* vertex = &triangles[i + j * 3];
+				tuple<int, int, int> key((int)floorf((vertex[0] - origin.x) * precision + 0.5f), (int)floorf((vertex[1] - origin.y) * precision + 0.5f),
+					(int)floorf((vertex[2] - origin.z) * precision + 0.5f));
+
+				auto found = vertex_indices.find(key);
+				if (found == vertex_indices.end())
+				{
+					// the first vertex of the cell is kept as the position of the cell
+					triangle[j] = (unsigned int)(vertices.size() / 3);
+					vertex_indices[key] = triangle[j];
+					vertices.insert(vertices.end(), vertex, vertex + 3);
+				}
+				else
+				{
+					triangle[j] = found->second;
+				}
+			}
+
+			// the triangles which have become a line or a point are not needed
+			if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2])
+			{
+				continue;
+			}
+			Vector3 p0(vertices[triangle[0] * 3], vertices[triangle[0] * 3 + 1], vertices[triangle[0] * 3 + 2]);
+			Vector3 p1(vertices[triangle[1] * 3], vertices[triangle[1] * 3 + 1], vertices[triangle[1] * 3 + 2]);
+			Vector3 p2(vertices[triangle[2] * 3], vertices[triangle[2] * 3 + 1], vertices[triangle[2] * 3 + 2]);
+			if ((p1 - p0).cross(p2 - p0).lengthSquared() == 0.0f)
+			{
+				continue;
+			}
+
+			// key: the vertices starting by the smallest one (so the order is kept)
+			int first = (triangle[0] < triangle[1]) ? ((triangle[0] < triangle[2]) ? 0 : 2) : ((triangle[1] < triangle[2]) ? 1 : 2);
+			if (!triangles_added.insert(make_tuple(triangle[first], triangle[(first + 1) % 3], triangle[(first + 2) % 3])).second)
+			{
+				continue;
+			}
+
+			indices.insert(indices.end(), triangle, triangle + 3);
+		}
+
+		if ((int)indices.size() / 3 <= max_triangles || cells == 2)
+		{
+			break;
+		}
+		cells = (cells == 0) ? 64 : cells / 2;
+	}
+
+	vertices.shrink_to_fit();
+	indices.shrink_to_fit();
+}
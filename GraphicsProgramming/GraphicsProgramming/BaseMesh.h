@@ -16,10 +16,12 @@
 #include <gl/GLU.h>
 #include <vector>
 #include <list>
+#include <string>
 #include <cmath> // for cos() and sin()
 
 #include "Texture.h"
 #include "Vector3.h"
+#include "MathSIMD.h"
 #include "SharedContext.h"
 #include "Colour4.h"
 
@@ -54,14 +56,42 @@ struct AxisLimits
 };
 #endif
 
+#ifndef GEOMETRY_DATA
+#define GEOMETRY_DATA
+// arrays of coords of a mesh, it is used to save them in the disk and load them again when the mesh is evicted
+struct GeometryData
+{
+	vector<float> vertices;
+	vector<float> normals;
+	vector<float> texture_coords;
+	vector<unsigned int> indices;
+};
+#endif
+
+#ifndef STATIC_PART
+#define STATIC_PART
+// arrays of a part of a mesh already transformed to world space (indexed triangles), the static batch merges the parts with the same
+// texture and colour in the same arrays
+struct StaticPart
+{
+	Texture* texture;
+	bool uses_atlas; // the texture coords are in the atlas page of the texture
+	Colour4 colour;
+	vector<float> vertices;
+	vector<float> normals;
+	vector<float> texture_coords;
+	vector<unsigned int> indices;
+};
+#endif
+
 class BaseMesh
 {
 public:
 	// constructor
 	BaseMesh();
 
-	// destructor
-	~BaseMesh();
+	// destructor (virtual, the scene deletes the meshes through BaseMesh pointers)
+	virtual ~BaseMesh();
 
 
 	/* FUNCTIONS TO MODIFY THE CHARACTERISTICS OF A MESH */
@@ -118,6 +148,21 @@ public:
 	// set the axis limits of this mesh in case is moving
 	void setAxisLimits(AxisLimits axis_limits);
 
+	// return the movement components (the motion system copies them when the mesh is added)
+	float getSpeed() const;
+	const vector<bool>& getIsRotating() const;
+	const vector<bool>& getIsMoving() const;
+	Vector3 getDirection() const;
+	AxisLimits getAxisLimits() const;
+
+	// set the components which change while the mesh is moving (the motion system writes its result back with it)
+	// it is inline (at the end of this file), as the motion system calls it for each moving mesh in one loop
+	void setMovementState(const Vector3& translation, const Vector3& rotation_angles, const Vector3& direction);
+
+	// load the components set by setMovementState() into the cache, the motion system calls it some meshes ahead of the one it writes
+	// (it only writes to the meshes, so without it each mesh would stall the loop until its memory is read)
+	void prefetchMovementState() const;
+
 	/* FUNCTIONS TO UPDATE AND RENDER A MESH*/
 
 	// update the shape
@@ -141,12 +186,122 @@ public:
 	// return a clone of this shape
 	virtual BaseMesh* clone();
 
+	// remap the texture coords of this mesh (and its submeshes) into the region of the texture atlas where its texture has been packed
+	// it must be called once the textures have been set and the atlas has been built, the coords are only remapped if they are between 0 and 1
+	virtual void remapTextureCoordsToAtlas();
+
+
+	/* FUNCTIONS FOR THE RESIDENCY (BOUNDS AND GEOMETRY IN MEMORY) */
+
+	// add to the list the textures used by this mesh and its parts (submeshes, faces, discs...)
+	virtual void getTextures(vector<Texture*>& textures) const;
+
+	// calculate the bounding sphere before the transformation (only the first time) and the cached matrix, so getBoundingSphere() only reads them
+	// it must be called in a serial step after moving the mesh (ex: before the frame tasks which cull the meshes)
+	void updateBounds();
+
+	// return the bounding sphere of the mesh (and its submeshes) transformed by the translation, rotation and scale of this mesh
+	// it returns false if the mesh has no geometry or updateBounds() has not been called yet, it doesn't change the mesh (it can be called from the tasks)
+	bool getBoundingSphere(Vector3& center, float& radius) const;
+
+	// return the memory used by the arrays of coords
+	size_t getGeometryBytes() const;
+
+	// return false if the arrays of coords have been evicted (the mesh is not rendered until they are restored)
+	bool isGeometryResident() const;
+
+	// save the arrays of coords in the file (only the first time) and free them
+	bool evictGeometry(const string& cache_url);
+
+	// read the arrays of coords saved by evictGeometry(), it doesn't use the mesh so it can be run in another thread
+	static bool readGeometry(const string& cache_url, GeometryData& geometry);
+
+	// set the arrays of coords read by readGeometry(), the mesh is rendered again
+	void restoreGeometry(GeometryData& geometry);
+
+
+	/* FUNCTIONS FOR THE SHADOW VOLUMES */
+
+	// add the triangles (9 floats each) of this mesh and its parts before the transformation of this mesh (only triangles and quads are read)
+	virtual void getLocalTriangles(vector<float>& triangles) const;
+
+	// add the triangles transformed by the translation, rotation and scale of this mesh (in the space of its parent)
+	void getTriangles(vector<float>& triangles) const;
+
+	// return the matrix (column major as openGL) of the translation, rotation and scale of this mesh (same as render())
+	void getTransformMatrix(float matrix[16]) const;
+
+	// return the cached matrix of this mesh, it is only calculated again after the translation, rotation or scale have changed
+	const float* getLocalMatrix() const;
+
+	// number which changes each time the translation, rotation or scale change (to know if the mesh has moved without comparing matrices)
+	unsigned int getTransformVersion() const;
+
+
+	/* FUNCTIONS FOR THE SHADOW PROXY */
+
+	// the shadow passes use a simplified copy of the mesh (only positions and indices, in the space of the mesh) which is built the first time it is needed
+	// it returns false if the mesh has no proxy (the mesh has no triangles yet), then the shadow passes render the full mesh
+	bool hasShadowProxy();
+	const vector<float>& getShadowProxyVertices() const;
+	const vector<unsigned int>& getShadowProxyIndices() const;
+
+	// set if the proxy is simplified (by default) or it has all the triangles of the mesh (for the meshes whose shadow needs all the detail)
+	// it must be set before the proxy is built
+	void setShadowProxySimplified(bool simplified);
+
+	// render the shadow of this mesh with its proxy (or with render(true) if it has no proxy)
+	void renderShadow();
+
+
+	/* FUNCTIONS FOR THE STATIC BATCHING */
+
+	// true if the mesh doesn't move or rotate by itself, so its geometry can be transformed to world space once
+	bool isStatic() const;
+
+	// add the arrays of this mesh and its parts (submeshes, faces, discs...) transformed to world space, one part for each of them
+	// parent_matrix: matrix of the parent of this mesh (the identity for the meshes of the scene)
+	// it returns false if some part is not made of triangles or quads (then the mesh must be rendered by itself)
+	virtual bool getStaticParts(const Matrix4& parent_matrix, vector<StaticPart>& parts) const;
+
+
+	/* FUNCTIONS FOR THE GROUPED DRAWS */
+
+	// the meshes with the same key have the same arrays of coords (same generator and parameters, or the same model file), so they can be
+	// drawn in a group with the arrays of one of them (the clones keep the key), an empty key means the geometry is not shared
+	void setGeometryKey(const string& geometry_key);
+	const string& getGeometryKey() const;
+
+	// true if the whole mesh is drawn by drawGeometry() (it has no parts drawn with other arrays, ex: submeshes, faces or discs)
+	virtual bool isGroupable() const;
+
+	// texture of this mesh (nullptr if it doesn't have)
+	Texture* getTexture() const;
+
+	// set the arrays and the texture of this mesh, then each drawGrouped() draws this geometry with the colour and matrix of a member of the
+	// group (a mesh with the same geometry key and texture) with one draw call for each one, and endGroupedDraws() unsets them
+	void beginGroupedDraws();
+	void drawGrouped(const BaseMesh* member) const;
+	void endGroupedDraws();
+
+
+	/* STATS */
+
+	// number of draw calls done since the last reset by the meshes, models, shadows and mirrors (for the stats of the scene)
+	static int getNumDraws();
+	static void resetNumDraws();
+	// count a draw call done outside of the meshes (ex: the cached planar shadows)
+	static void countDraw();
+
 protected:
 	/* CHARACTERISTICS OF A BASE MESH */
 
 	// Texture component of this shape
 	Texture* texture_;
 
+	// true if the texture coords have been remapped into the texture atlas, so the atlas page must be used instead of the texture
+	bool uses_atlas_ = false;
+
 	// colour component
 	Colour4 colour_ = { 1.0f, 1.0f, 1.0f, 1.0f };
 
@@ -196,13 +351,104 @@ protected:
 	// initialise arrays of textures coords
 	virtual void initTextureCoords();
 
+	// bind the texture of this mesh (or its atlas page if the coords have been remapped) and stop using it
+	void bindTexture();
+	void unbindTexture();
+
+	/* BOUNDS AND RESIDENCY COMPONENTS */
+
+	// bounding sphere before the transformation of this mesh, it is calculated only once (the geometry doesn't change)
+	bool bounds_computed_ = false;
+	bool has_bounds_ = false;
+	Vector3 local_center_;
+	float local_radius_ = 0.0f;
+
+	// calculate the bounding sphere of the vertices and submeshes, the meshes made of other meshes (ex: cube) override it
+	virtual bool computeLocalBoundingSphere(Vector3& center, float& radius);
+
+	// bounding sphere which contains the vertices (x,y,z array) and the spheres passed
+	static bool computeBoundingSphere(const vector<float>& vertices, const vector<pair<Vector3, float>>& spheres, Vector3& center, float& radius);
+
+	// transform a point by the translation, rotation and scale of this mesh (same order as render()), the cached matrix is not changed
+	Vector3 transformPoint(Vector3 point) const;
+
+	/* CACHED MATRIX (translate * rotate x * rotate y * rotate z * scale) */
+
+	mutable Matrix4 local_matrix_;
+	mutable bool local_matrix_dirty_ = true;
+	unsigned int transform_version_ = 0;
+
+	// the translation, rotation or scale have changed (the setters call it, the subclasses must call it if they change them directly)
+	void markTransformDirty();
+
+	// multiply the current openGL matrix by the cached matrix (one call instead of translating, rotating and scaling each time)
+	void applyTransform() const;
+
+	// component to know if the arrays are in memory and if they have been saved in the disk
+	bool geometry_resident_ = true;
+	bool geometry_saved_ = false;
+
+	/* SHADOW PROXY COMPONENTS */
+
+	// maximum triangles of a proxy, the bigger meshes are simplified
+	static const int kShadowProxyMaxTriangles = 1024;
+
+	bool shadow_proxy_simplified_ = true;
+	bool shadow_proxy_built_ = false;
+	vector<float> shadow_proxy_vertices_;
+	vector<unsigned int> shadow_proxy_indices_;
+
+	// add the triangles (9 floats each, in the space of this mesh) the proxy is built from, by default the triangles of the mesh
+	// the meshes made by a generator (sphere, cone, torus) override it to give the same shape with less segments
+	virtual void getShadowProxyTriangles(vector<float>& triangles) const;
+
+	// merge the vertices in the same position and, if there are more triangles than the maximum, simplify them by merging the vertices in a grid
+	static void buildShadowProxy(const vector<float>& triangles, int max_triangles, vector<float>& vertices, vector<unsigned int>& indices);
+
 	/* OTHERS COMPONENTS */
 	// shared context component
 	SharedContext* shared_context_;
 
 	// collection of submeshes created outside of this class, these can been added to the system: using of hierarchical
 	vector<BaseMesh*> submeshes_;
+
+	// draw calls of the arrays already set (without the transform), the meshes which don't draw as the base mesh override it
+	virtual void drawGeometry() const;
+
+	// add the part of the arrays of this mesh (the faces of the vertices from first_vertex to end_vertex drawn with the mode, or all the
+	// faces of the indices if end_vertex is -1) transformed by the matrix, it returns false if the mode is not triangles or quads
+	bool addStaticPart(const Matrix4& matrix, GLenum mode, vector<StaticPart>& parts, int first_vertex = 0, int end_vertex = -1) const;
+
+	// key of the arrays of coords, the meshes with the same key can be drawn in one group
+	string geometry_key_;
+
+	// number of draw calls done (shared by all the meshes)
+	static int num_draws_;
 };
 
+/* INLINE FUNCTIONS */
+
+inline void BaseMesh::setMovementState(const Vector3& translation, const Vector3& rotation_angles, const Vector3& direction)
+{
+	translation_ = translation;
+	rotation_angles_ = rotation_angles;
+	direction_ = direction;
+	markTransformDirty();
+}
+
+inline void BaseMesh::prefetchMovementState() const
+{
+	_mm_prefetch((const char*)&rotation_angles_, _MM_HINT_T0);
+	_mm_prefetch((const char*)&translation_, _MM_HINT_T0);
+	_mm_prefetch((const char*)&direction_, _MM_HINT_T0);
+	_mm_prefetch((const char*)&transform_version_, _MM_HINT_T0);
+}
+
+inline void BaseMesh::markTransformDirty()
+{
+	local_matrix_dirty_ = true;
+	transform_version_++;
+}
+
 #endif
 
@@ -0,0 +1,104 @@
+#include "BlobShadow.h"
+#include <math.h>
+
+BlobShadow::BlobShadow(int size)
+	: texture_(0), size_(size)
+{
+}
+
+BlobShadow::~BlobShadow()
+{
+	if (texture_ != 0)
+	{
+		glDeleteTextures(1, &texture_);
+	}
+}
+
+void BlobShadow::createTexture()
+{
+	// alpha of each texel: 1 in the middle, fading to 0 from half the radius to the border
+	vector<unsigned char> texels(size_ * size_);
+	for (int y = 0; y < size_; y++)
+	{
+		for (int x = 0; x < size_; x++)
+		{
+			float dx = (x + 0.5f) / size_ * 2.0f - 1.0f;
+			float dy = (y + 0.5f) / size_ * 2.0f - 1.0f;
+			float distance = sqrtf(dx * dx + dy * dy);
+			float alpha = (distance < 0.5f) ? 1.0f : (distance < 1.0f) ? (1.0f - distance) * 2.0f : 0.0f;
+			texels[y * size_ + x] = (unsigned char)(alpha * alpha * 255.0f); // squared so the border is softer
+		}
+	}
+
+	glGenTextures(1, &texture_);
+	Texture::bindTextureObject(texture_);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, size_, size_, 0, GL_ALPHA, GL_UNSIGNED_BYTE, texels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+}
+
+void BlobShadow::render(const vector<BlobShadowPlacement>& blobs, const Vector3& normal, const float colour[4])
+{
+	if (blobs.empty())
+	{
+		return;
+	}
+
+	if (texture_ == 0)
+	{
+		createTexture();
+	}
+
+	// the planes are aligned with the axes, the quad uses the two axes which are not the normal
+	int normal_axis = (fabsf(normal.x) > 0.5f) ? 0 : (fabsf(normal.y) > 0.5f) ? 1 : 2;
+	int axis_u = (normal_axis + 1) % 3;
+	int axis_v = (normal_axis + 2) % 3;
+
+	// the blobs are blended (blending is enabled by the shadow pass)
+	// the transparent texels are not drawn, so they don't set the stencil and the other shadows can be drawn there
+	glEnable(GL_TEXTURE_2D);
+	Texture::bindTextureObject(texture_);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glEnable(GL_ALPHA_TEST);
+	glAlphaFunc(GL_GREATER, 0.02f);
+
+	// the quads are seen from both sides
+	GLboolean cull_face = glIsEnabled(GL_CULL_FACE);
+	glDisable(GL_CULL_FACE);
+
+	// same colour as the full shadows
+	glColor4fv(colour);
+
+	glBegin(GL_QUADS);
+	for (const BlobShadowPlacement& blob : blobs)
+	{
+		float min[3] = { blob.shadow_min.x, blob.shadow_min.y, blob.shadow_min.z };
+		float max[3] = { blob.shadow_max.x, blob.shadow_max.y, blob.shadow_max.z };
+		float corner[3];
+		corner[normal_axis] = min[normal_axis];
+
+		// the 4 corners of the box on the plane
+		float us[4] = { min[axis_u], max[axis_u], max[axis_u], min[axis_u] };
+		float vs[4] = { min[axis_v], min[axis_v], max[axis_v], max[axis_v] };
+		float tex_us[4] = { 0.0f, 1.0f, 1.0f, 0.0f };
+		float tex_vs[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+		for (int i = 0; i < 4; i++)
+		{
+			corner[axis_u] = us[i];
+			corner[axis_v] = vs[i];
+			glTexCoord2f(tex_us[i], tex_vs[i]);
+			glVertex3f(corner[0], corner[1], corner[2]);
+		}
+	}
+	glEnd();
+	BaseMesh::countDraw();
+
+	if (cull_face)
+		glEnable(GL_CULL_FACE);
+	glDisable(GL_ALPHA_TEST);
+	glDisable(GL_TEXTURE_2D);
+}
@@ -0,0 +1,40 @@
+// Class Blob Shadow
+// It renders cheap shadows for the casters which are far or small: a quad with a soft round texture placed on the box of the shadow on the receiver.
+// The texture is generated the first time (only alpha: opaque in the middle and transparent on the border), so there is no image to load.
+// The blobs are rendered in the planar shadow pass, so they use its stencil (they are only drawn on the receiver and only once per pixel).
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+// Include GLUT, openGL, input.
+#include "glut.h"
+#include <gl/GL.h>
+#include <gl/GLU.h>
+#include <vector>
+
+#include "PlanarShadowPairing.h"
+#include "Texture.h"
+#include "Vector3.h"
+
+using namespace std;
+
+class BlobShadow
+{
+public:
+	// constructor
+	// size: width and height of the texture in texels
+	BlobShadow(int size = 64);
+
+	// destructor
+	~BlobShadow();
+
+	// render the blobs on the receiver whose plane has the normal passed, the alpha of the colour is multiplied by the alpha of the blob
+	void render(const vector<BlobShadowPlacement>& blobs, const Vector3& normal, const float colour[4]);
+
+private:
+	GLuint texture_;
+	int size_;
+
+	// create the texture of the blob
+	void createTexture();
+};
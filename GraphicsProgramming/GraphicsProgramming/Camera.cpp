@@ -369,36 +369,22 @@ void Camera::controlRoll()
 
 void Camera::recalculateUpForwardRightVectors()
 {
-	// temp values for sin/cos
-	float cos_pitch, cos_roll, cos_yaw;
-	float sin_pitch, sin_roll, sin_yaw;
-
-	// handle rotations
-	cos_pitch = cosf(pitch_ * M_PI / 180.0f);
-	cos_yaw = cosf(yaw_ * M_PI / 180.0f);
-	cos_roll = cosf(roll_ * M_PI / 180.0f);
-
-	sin_pitch = sinf(pitch_ * M_PI / 180.0f);
-	sin_yaw = sinf(yaw_ * M_PI / 180.0f);
-	sin_roll = sinf(roll_ * M_PI / 180.0f);
+	// orientation of the camera: yaw around y (turning right is negative), then pitch around the x of the camera and roll around its z
+	// it gives the same vectors as the parametric equation of a sphere used before (forward is -z without rotation)
+	Quaternion orientation = Quaternion::fromAxisAngle(Vector3(0.0f, 1.0f, 0.0f), -yaw_)
+		* Quaternion::fromAxisAngle(Vector3(1.0f, 0.0f, 0.0f), pitch_)
+		* Quaternion::fromAxisAngle(Vector3(0.0f, 0.0f, 1.0f), roll_);
 
 	// calculate Forward vector (z-direction)
-	// using parametric equation of a sphere
-	forward_.setX(sin_yaw * cos_pitch);
-	forward_.setY(sin_pitch);
-	forward_.setZ(cos_pitch * (-cos_yaw));
+	forward_ = orientation.rotate(Vector3(0.0f, 0.0f, -1.0f));
 	forward_.normalise(); // to keep a consistent movement
 
 	// calculate Up vector (y-direction)
-	// using parametric equation of a sphere
-	up_.setX((-cos_yaw * sin_roll) - (sin_yaw * sin_pitch * cos_roll));
-	up_.setY(cos_pitch * cos_roll);
-	up_.setZ((-sin_yaw * sin_roll) - (sin_pitch * cos_roll * (-cos_yaw)));
+	up_ = orientation.rotate(Vector3(0.0f, 1.0f, 0.0f));
 	up_.normalise(); // to keep a consistent movement
 
-	// calculate Right vector (x-direction)
-	// using cross product between the forward_ and up_ vector
-	right_ = forward_.cross(up_);
+	// calculate Right vector (x-direction), it is the same as the cross product between the forward_ and up_ vector
+	right_ = orientation.rotate(Vector3(1.0f, 0.0f, 0.0f));
 	right_.normalise(); // to keep a consistent movement
 }
 
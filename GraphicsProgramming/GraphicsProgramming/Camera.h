@@ -14,6 +14,7 @@
 
 #include <vector>
 #include "Vector3.h"
+#include "MathSIMD.h"
 
 #include "SharedContext.h"
 #include "BaseMesh.h" // for linking the camera to an object in kFirstPerson, kTracking etc
@@ -1,74 +1,36 @@
 #include "CameraManager.h"
 
-CameraManager::CameraManager(SharedContext* shared_context)
+CameraManager::CameraManager(SharedContext* shared_context, const SceneDescription& scene_description)
 	: shared_context_(shared_context)
 {
+	// create the cameras of the scene, the id of each camera is its position in the vector + 1 (the key which selects it)
+	for (int i = 0; i < scene_description.getNumCameras(); i++)
+	{
+		const SceneCameraDesc& camera = scene_description.getCamera(i);
+		cameras_.push_back(new Camera(i + 1, shared_context_));
+		cameras_.back()->setPosition({ camera.position[0], camera.position[1], camera.position[2] });
+		cameras_.back()->setRotationSpeed(camera.rotation_speed);
+		cameras_.back()->setMovementSpeed(camera.movement_speed);
+		cameras_.back()->setZoomSpeed(camera.zoom_speed);
+		cameras_.back()->setRotation({ camera.rotation[0], camera.rotation[1], camera.rotation[2] });
+		cameras_.back()->setPitchLimits(AngleLimits(camera.pitch_limits[0], camera.pitch_limits[1]));
+		cameras_.back()->setYawLimits(AngleLimits(camera.yaw_limits[0], camera.yaw_limits[1]));
+		cameras_.back()->setCameraType((CameraType)camera.type);
+	}
 
-	// create the floating/main camera
-	cameras_.push_back(new Camera(1, shared_context_)); // id of the camera is the vector position + 1
-	cameras_.back()->setPosition({ 10, 2, -1 });
-	cameras_.back()->setRotationSpeed(80.0f);
-	cameras_.back()->setMovementSpeed(80.0f);
-	cameras_.back()->setZoomSpeed(400.0f);
-	cameras_.back()->setPitchLimits(AngleLimits(89.0f, -89.0f));
-	cameras_.back()->setYawLimits(AngleLimits(360.0f, -360.0f));
-	cameras_.back()->setCameraType(CameraType::kFloating);
-
-	// create the right front corner camera (simulate a security camera)
-	cameras_.push_back(new Camera(2, shared_context_)); // id of the camera is the vector position + 1
-	cameras_.back()->setPosition({19.5, 3, -1});
-	cameras_.back()->setRotationSpeed(80.0f);
-	cameras_.back()->setZoomSpeed(400.0f);
-	cameras_.back()->setRotation({ -10.0f, -45.0f, 0.0f}); // rotate the camera to look at the center of the plane
-	cameras_.back()->setPitchLimits(AngleLimits(-3.0f, -45.0f)); // it can turn 42 degrees vertically
-	cameras_.back()->setYawLimits(AngleLimits(-32.0f, -58.0f)); // it can only turn 26 degrees horizontally to avoid look back the walls
-	cameras_.back()->setCameraType(CameraType::kRotating);
-
-	// create the right back corner camera (simulate a security camera)
-	cameras_.push_back(new Camera(3, shared_context_)); // id of the camera is the vector position + 1
-	cameras_.back()->setPosition({ 19.5, 3, -23.5});
-	cameras_.back()->setRotationSpeed(80.0f);
-	cameras_.back()->setZoomSpeed(400.0f);
-	cameras_.back()->setRotation({ -10.0f, -135.0f, 0.0f });  // rotate the camera to look at the center of the plane
-	cameras_.back()->setPitchLimits(AngleLimits(-3.0f, -45.0f)); // it can turn 42 degrees vertically
-	cameras_.back()->setYawLimits(AngleLimits(-122.0f, -148.0f)); // it can only turn 26 degrees horizontally to avoid look back the walls
-	cameras_.back()->setCameraType(CameraType::kRotating);
-
-	// create the middle back corner camera (simulate a security camera)
-	cameras_.push_back(new Camera(4, shared_context_)); // id of the camera is the vector position + 1
-	cameras_.back()->setPosition({ 10, 3, -23.5 });
-	cameras_.back()->setRotationSpeed(80.0f);
-	cameras_.back()->setZoomSpeed(400.0f);
-	cameras_.back()->setRotation({ -10.0f, -180.0f, 0.0f });  // rotate the camera to look at the center of the plane
-	cameras_.back()->setPitchLimits(AngleLimits(-3.0f, -45.0f)); // it can turn 42 degrees vertically
-	cameras_.back()->setYawLimits(AngleLimits(-90.0f, -270.0f)); // it can only turn 180 degrees horizontally to avoid look back the walls
-	cameras_.back()->setCameraType(CameraType::kRotating);
-
-	// create the left back corner camera (simulate a security camera)
-	cameras_.push_back(new Camera(5, shared_context_)); // id of the camera is the vector position + 1
-	cameras_.back()->setPosition({ 1, 3, -23.5 });
-	cameras_.back()->setRotationSpeed(80.0f);
-	cameras_.back()->setZoomSpeed(400.0f);
-	cameras_.back()->setRotation({ -10.0f, +135.0f, 0.0f });  // rotate the camera to look at the center of the plane
-	cameras_.back()->setPitchLimits(AngleLimits(-3.0f, -45.0f)); // it can turn 42 degrees vertically
-	cameras_.back()->setYawLimits(AngleLimits(+148.0f, +122.0f)); // it can only turn 26 degrees horizontally
-	cameras_.back()->setCameraType(CameraType::kRotating);
-
-	// create the top camera (a fixed camera looking down)
-	cameras_.push_back(new Camera(6, shared_context_)); // id of the camera is the vector position + 1
-	cameras_.back()->setPosition({ 12, 33, -12 }); // set above the center of the plane
-	cameras_.back()->setRotation({ -90.0f, 0.0f, 0.0f });  // rotate the camera to look down
-	cameras_.back()->setCameraType(CameraType::kFixedPoint);
-
-	// create a tracking camera (spaceship which is moving along z-axis)
-	cameras_.push_back(new Camera(7, shared_context_)); // id of the camera is the vector position + 1
-	cameras_.back()->setCameraType(CameraType::kTracking);
-
-	// create other camera (shapeship2 which is moving along x-axis)
-	cameras_.push_back(new Camera(8, shared_context_)); // id of the camera is the vector position + 1
-	cameras_.back()->setCameraType(CameraType::kTracking);
-
-	// set the current camera to the floating one by default
+	// the scene must have a camera, if it doesn't have any a floating one is created
+	if (cameras_.empty())
+	{
+		printf("The scene doesn't have cameras, using a floating camera\n");
+		cameras_.push_back(new Camera(1, shared_context_));
+		cameras_.back()->setRotationSpeed(80.0f);
+		cameras_.back()->setMovementSpeed(80.0f);
+		cameras_.back()->setZoomSpeed(400.0f);
+		cameras_.back()->setPitchLimits(AngleLimits(89.0f, -89.0f));
+		cameras_.back()->setCameraType(CameraType::kFloating);
+	}
+
+	// set the current camera to the first one by default
 	current_camera_ = cameras_.at(0);
 }
 
@@ -88,61 +50,15 @@ void CameraManager::handleInput(float dt)
 {
 	/* Switching between cameras */
 
-	// switch to the flight/main camera
-	if (shared_context_->input->isKeyDown((int)'1'))
-	{
-		shared_context_->input->setKeyUp((int)'1');
-
-		current_camera_ = cameras_.at(0);
-	}
-	// switch to the fixed front-right camera
-	else if (shared_context_->input->isKeyDown((int)'2'))
-	{
-		shared_context_->input->setKeyUp((int)'2');
-
-		current_camera_ = cameras_.at(1);
-	}
-	// switch to the fixed back-right camera
-	else if (shared_context_->input->isKeyDown((int)'3'))
-	{
-		shared_context_->input->setKeyUp((int)'3');
-
-		current_camera_ = cameras_.at(2);
-	}
-	// switch to the fixed back-middle camera
-	else if (shared_context_->input->isKeyDown((int)'4'))
-	{
-		shared_context_->input->setKeyUp((int)'4');
-
-		current_camera_ = cameras_.at(3);
-	}
-	// switch to the fixed back-left camera
-	else if (shared_context_->input->isKeyDown((int)'5'))
-	{
-		shared_context_->input->setKeyUp((int)'5');
-
-		current_camera_ = cameras_.at(4);
-	}
-	// switch to the fixed front-left camera
-	else if (shared_context_->input->isKeyDown((int)'6'))
-	{
-		shared_context_->input->setKeyUp((int)'6');
-
-		current_camera_ = cameras_.at(5);
-	}
-	// switch to the tracking camera (spaceship which is moving along z-axis)
-	else if (shared_context_->input->isKeyDown((int)'7'))
+	// the keys 1 to 8 switch to the camera with that id (the cameras of the scene in the order they are written)
+	for (int i = 0; i < 8 && i < (int)cameras_.size(); i++)
 	{
-		shared_context_->input->setKeyUp((int)'7');
-
-		current_camera_ = cameras_.at(6);
-	}
-	// switch to the tracking camera (spaceship2 which is moving along x-axis)
-	else if (shared_context_->input->isKeyDown((int)'8'))
-	{
-		shared_context_->input->setKeyUp((int)'8');
+		if (shared_context_->input->isKeyDown((int)'1' + i))
+		{
+			shared_context_->input->setKeyUp((int)'1' + i);
 
-		current_camera_ = cameras_.at(7);
+			current_camera_ = cameras_.at(i);
+		}
 	}
 
 	// handle the current camera
@@ -2,8 +2,9 @@
 // Contain the collection of cameras of a scene
 // author Francisco Diaz @FMGameDev
 
-#include <Vector>
+#include <vector>
 #include "Camera.h"
+#include "SceneDescription.h"
 
 using namespace std;
 
@@ -11,8 +12,8 @@ using namespace std;
 class CameraManager
 {
 public:
-	// constructor
-	CameraManager(SharedContext* shared_context);
+	// constructor, it creates the cameras of the scene
+	CameraManager(SharedContext* shared_context, const SceneDescription& scene_description);
 
 	// destructor
 	~CameraManager();
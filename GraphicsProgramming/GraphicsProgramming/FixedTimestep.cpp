@@ -0,0 +1,42 @@
+#include "FixedTimestep.h"
+
+FixedTimestep::FixedTimestep(float step, int max_steps)
+	: step_(step), max_steps_(max_steps), accumulator_(0.0f), num_dropped_steps_(0)
+{
+}
+
+int FixedTimestep::advance(float dt)
+{
+	// a negative time would make the accumulator go back (ex: the clock of the first frame)
+	if (dt > 0.0f)
+	{
+		accumulator_ += dt;
+	}
+
+	int num_steps = (int)(accumulator_ / step_);
+	accumulator_ -= num_steps * step_;
+
+	// spiral of death: too many steps, the ones over the maximum are dropped
+	if (num_steps > max_steps_)
+	{
+		num_dropped_steps_ += num_steps - max_steps_;
+		num_steps = max_steps_;
+	}
+
+	return num_steps;
+}
+
+float FixedTimestep::getStep() const
+{
+	return step_;
+}
+
+float FixedTimestep::getAlpha() const
+{
+	return accumulator_ / step_;
+}
+
+int FixedTimestep::getNumDroppedSteps() const
+{
+	return num_dropped_steps_;
+}
@@ -0,0 +1,38 @@
+// Class Fixed Timestep
+// Clock of the simulation: the time of the frames is accumulated and the simulation advances in steps of the same size (by default 1/60 s),
+// so the movement is the same whatever the frame rate is and a slow frame doesn't make the objects jump through their limits.
+// The time left in the accumulator (less than a step) is returned as alpha, the fraction of a step the render is ahead of the last step,
+// which is used to interpolate between the last two steps so the movement is smooth when the frame rate is not a multiple of the steps.
+// If a frame is very slow only max_steps are run and the rest of the time is dropped (otherwise the next frame would be even slower).
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+class FixedTimestep
+{
+public:
+	// constructor
+	// step: size of each step (s), max_steps: steps run at most in a frame
+	FixedTimestep(float step = 1.0f / 60.0f, int max_steps = 8);
+
+	// add the time of the frame (s) and return the number of steps to run
+	int advance(float dt);
+
+	// size of each step (s)
+	float getStep() const;
+
+	// fraction of a step [0, 1) left after the last advance()
+	float getAlpha() const;
+
+	// number of steps dropped because the frames were too slow (since the start)
+	int getNumDroppedSteps() const;
+
+private:
+	float step_;
+	int max_steps_;
+
+	// time not simulated yet (s), it is always less than a step after advance()
+	float accumulator_;
+
+	int num_dropped_steps_;
+};
@@ -0,0 +1,84 @@
+#include "Frustum.h"
+#include <math.h>
+
+Frustum::Frustum()
+	: viewport_height_(1)
+{
+	// the matrices are the identity by default
+	for (int i = 0; i < 8; i++)
+	{
+		planes_a_[i] = planes_b_[i] = planes_c_[i] = 0.0f;
+		planes_d_[i] = 1.0f; // everything is inside until it is updated
+	}
+}
+
+void Frustum::update()
+{
+	glGetFloatv(GL_MODELVIEW_MATRIX, modelview_.m);
+	glGetFloatv(GL_PROJECTION_MATRIX, projection_.m);
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	viewport_height_ = (viewport[3] > 0) ? viewport[3] : 1;
+
+	// clip = projection * modelview (column major: m[column * 4 + row])
+	Matrix4 clip_matrix = projection_ * modelview_;
+	const float* clip = clip_matrix.data();
+
+	// the planes are the 4th row of the clip matrix plus/minus the other rows (Gribb and Hartmann)
+	for (int i = 0; i < 6; i++)
+	{
+		int row = i / 2; // left/right use the row 0 (x), bottom/top the row 1 (y), near/far the row 2 (z)
+		float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+		Vector4 plane(clip[3] + sign * clip[row], clip[7] + sign * clip[4 + row], clip[11] + sign * clip[8 + row], clip[15] + sign * clip[12 + row]);
+
+		// normalise the plane so the distance to the plane is in world units
+		float length = plane.length3();
+		if (length > 0.0f)
+		{
+			plane = plane * (1.0f / length);
+		}
+
+		planes_a_[i] = plane.x;
+		planes_b_[i] = plane.y;
+		planes_c_[i] = plane.z;
+		planes_d_[i] = plane.w;
+	}
+}
+
+bool Frustum::isSphereVisible(const Vector3& center, float radius) const
+{
+	// distances to 4 planes at a time, it is outside if it is further than the radius behind any of them
+	__m128 x = _mm_set1_ps(center.x), y = _mm_set1_ps(center.y), z = _mm_set1_ps(center.z);
+	__m128 minus_radius = _mm_set1_ps(-radius);
+	__m128 outside = _mm_setzero_ps();
+	for (int i = 0; i < 8; i += 4)
+	{
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(planes_a_ + i), x), _mm_mul_ps(_mm_loadu_ps(planes_b_ + i), y)),
+			_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(planes_c_ + i), z), _mm_loadu_ps(planes_d_ + i)));
+		outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, minus_radius));
+	}
+	return _mm_movemask_ps(outside) == 0;
+}
+
+float Frustum::getProjectedSize(const Vector3& center, float radius) const
+{
+	// depth of the center in the camera space (the camera looks along -z)
+	float depth = -modelview_.transformPoint(center).z;
+
+	// if the camera is inside the sphere it covers all the screen
+	if (depth <= radius)
+	{
+		return (depth > -radius) ? (float)viewport_height_ : 0.0f;
+	}
+
+	// projection_[5] is cot(fov / 2), so the height of the screen at that depth is 2 * depth / projection_[5]
+	return (radius * projection_.m[5] / depth) * (float)viewport_height_;
+}
+
+Vector3 Frustum::getEyePosition() const
+{
+	// the eye is -R^t * t of the modelview matrix
+	Vector3 translation(modelview_.m[12], modelview_.m[13], modelview_.m[14]);
+	return modelview_.transposed().transformVector(translation) * -1.0f;
+}
@@ -0,0 +1,47 @@
+// Class Frustum
+// It keeps the six planes of the view frustum of the camera, so it can be checked if an object (bounding sphere) can be seen or not.
+// It also calculates the size in pixels an object has on the screen, it is used to choose the detail (ex: the mip level of the textures).
+// update() must be called after setting the camera (gluLookAt) and before transforming any object, as it reads the current matrices.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+// Include GLUT, openGL, input.
+#include "glut.h"
+#include <gl/GL.h>
+#include <gl/GLU.h>
+
+#include "Vector3.h"
+#include "MathSIMD.h"
+
+class Frustum
+{
+public:
+	// constructor
+	Frustum();
+
+	// read the projection and modelview (camera) matrices and the viewport, and calculate the planes
+	void update();
+
+	// return true if the sphere is inside or intersects the frustum
+	bool isSphereVisible(const Vector3& center, float radius) const;
+
+	// return the diameter in pixels of the sphere projected on the screen (0 if it is behind the camera)
+	float getProjectedSize(const Vector3& center, float radius) const;
+
+	// return the position of the camera (eye)
+	Vector3 getEyePosition() const;
+
+private:
+	// planes (a, b, c, d) with the normal pointing inside: left, right, bottom, top, near, far
+	// they are kept by components (SoA) so a sphere is checked against 4 planes at a time, the last 2 are padding (0, 0, 0, 1) which never cull
+	float planes_a_[8];
+	float planes_b_[8];
+	float planes_c_[8];
+	float planes_d_[8];
+
+	// matrices and the height of the viewport
+	Matrix4 modelview_;
+	Matrix4 projection_;
+	int viewport_height_;
+};
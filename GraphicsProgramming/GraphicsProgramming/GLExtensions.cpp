@@ -0,0 +1,112 @@
+#include "GLExtensions.h"
+
+// functions loaded
+CompressedTexImage2DProc GLExtensions::compressedTexImage2D = nullptr;
+ActiveTextureProc GLExtensions::activeTexture = nullptr;
+GenQueriesProc GLExtensions::genQueries = nullptr;
+DeleteQueriesProc GLExtensions::deleteQueries = nullptr;
+BeginQueryProc GLExtensions::beginQuery = nullptr;
+EndQueryProc GLExtensions::endQuery = nullptr;
+GetQueryObjectuivProc GLExtensions::getQueryObjectuiv = nullptr;
+GenFramebuffersProc GLExtensions::genFramebuffers = nullptr;
+DeleteFramebuffersProc GLExtensions::deleteFramebuffers = nullptr;
+BindFramebufferProc GLExtensions::bindFramebuffer = nullptr;
+CheckFramebufferStatusProc GLExtensions::checkFramebufferStatus = nullptr;
+GenRenderbuffersProc GLExtensions::genRenderbuffers = nullptr;
+DeleteRenderbuffersProc GLExtensions::deleteRenderbuffers = nullptr;
+BindRenderbufferProc GLExtensions::bindRenderbuffer = nullptr;
+RenderbufferStorageProc GLExtensions::renderbufferStorage = nullptr;
+FramebufferRenderbufferProc GLExtensions::framebufferRenderbuffer = nullptr;
+
+// components of the loader
+bool GLExtensions::loaded_ = false;
+std::string GLExtensions::extensions_;
+
+void GLExtensions::load()
+{
+	if (loaded_)
+	{
+		return;
+	}
+
+	// read the extensions supported (it needs the openGL context, so it must be done after creating the window)
+	const GLubyte* extensions = glGetString(GL_EXTENSIONS);
+	if (extensions == nullptr)
+	{
+		printf("GL extensions - the openGL context has not been created yet\n");
+		return;
+	}
+	extensions_ = " " + std::string((const char*)extensions) + " "; // the spaces allow to search full names
+
+	// openGL 1.3 functions
+	compressedTexImage2D = (CompressedTexImage2DProc)getProcAddress("glCompressedTexImage2D");
+	if (compressedTexImage2D == nullptr)
+	{
+		compressedTexImage2D = (CompressedTexImage2DProc)getProcAddress("glCompressedTexImage2DARB");
+	}
+	activeTexture = (ActiveTextureProc)getProcAddress("glActiveTexture");
+	if (activeTexture == nullptr)
+	{
+		activeTexture = (ActiveTextureProc)getProcAddress("glActiveTextureARB");
+	}
+
+	// occlusion queries (ARB_occlusion_query, the ARB names are used as they are in more drivers)
+	genQueries = (GenQueriesProc)getProcAddress("glGenQueriesARB");
+	deleteQueries = (DeleteQueriesProc)getProcAddress("glDeleteQueriesARB");
+	beginQuery = (BeginQueryProc)getProcAddress("glBeginQueryARB");
+	endQuery = (EndQueryProc)getProcAddress("glEndQueryARB");
+	getQueryObjectuiv = (GetQueryObjectuivProc)getProcAddress("glGetQueryObjectuivARB");
+
+	// framebuffer objects (EXT_framebuffer_object, the headless mode renders in one when there is no OSMesa)
+	genFramebuffers = (GenFramebuffersProc)getProcAddress("glGenFramebuffersEXT");
+	deleteFramebuffers = (DeleteFramebuffersProc)getProcAddress("glDeleteFramebuffersEXT");
+	bindFramebuffer = (BindFramebufferProc)getProcAddress("glBindFramebufferEXT");
+	checkFramebufferStatus = (CheckFramebufferStatusProc)getProcAddress("glCheckFramebufferStatusEXT");
+	genRenderbuffers = (GenRenderbuffersProc)getProcAddress("glGenRenderbuffersEXT");
+	deleteRenderbuffers = (DeleteRenderbuffersProc)getProcAddress("glDeleteRenderbuffersEXT");
+	bindRenderbuffer = (BindRenderbufferProc)getProcAddress("glBindRenderbufferEXT");
+	renderbufferStorage = (RenderbufferStorageProc)getProcAddress("glRenderbufferStorageEXT");
+	framebufferRenderbuffer = (FramebufferRenderbufferProc)getProcAddress("glFramebufferRenderbufferEXT");
+
+	loaded_ = true;
+}
+
+GLUTproc GLExtensions::getProcAddress(const char* name)
+{
+#ifdef HEADLESS_OSMESA
+	// there is no glut window in the headless mode, the functions come from the OSMesa context
+	if (OSMesaGetCurrentContext() != nullptr)
+	{
+		return (GLUTproc)OSMesaGetProcAddress(name);
+	}
+#endif
+	return glutGetProcAddress(name);
+}
+
+bool GLExtensions::isSupported(const char* extension_name)
+{
+	return extensions_.find(" " + std::string(extension_name) + " ") != std::string::npos;
+}
+
+bool GLExtensions::hasCompressedTextures()
+{
+	return compressedTexImage2D != nullptr && isSupported("GL_EXT_texture_compression_s3tc");
+}
+
+bool GLExtensions::hasShadowMaps()
+{
+	return activeTexture != nullptr && isSupported("GL_ARB_depth_texture") && isSupported("GL_ARB_shadow");
+}
+
+bool GLExtensions::hasOcclusionQueries()
+{
+	return genQueries != nullptr && deleteQueries != nullptr && beginQuery != nullptr && endQuery != nullptr && getQueryObjectuiv != nullptr
+		&& isSupported("GL_ARB_occlusion_query");
+}
+
+bool GLExtensions::hasFramebufferObjects()
+{
+	return genFramebuffers != nullptr && deleteFramebuffers != nullptr && bindFramebuffer != nullptr && checkFramebufferStatus != nullptr
+		&& genRenderbuffers != nullptr && deleteRenderbuffers != nullptr && bindRenderbuffer != nullptr && renderbufferStorage != nullptr
+		&& framebufferRenderbuffer != nullptr && isSupported("GL_EXT_framebuffer_object") && isSupported("GL_EXT_packed_depth_stencil");
+}
@@ -0,0 +1,166 @@
+// Class GL Extensions
+// The windows openGL header only declares the functions of openGL 1.1, the newer functions must be loaded from the driver at runtime.
+// This class loads the functions used by the project (by using glutGetProcAddress) and it keeps the extensions supported by the graphics card,
+// so the classes can check if a feature is available before using it and use the old path if it is not.
+// load() must be called once the window (openGL context) has been created. In the headless mode built with HEADLESS_OSMESA the functions are
+// loaded from OSMesa when its context is the current one.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+// Include GLUT, openGL, input.
+#include "glut.h"
+#include "freeglut_ext.h" // glutGetProcAddress
+#ifdef HEADLESS_OSMESA
+#include <GL/osmesa.h> // OSMesaGetProcAddress
+#endif
+#include <gl/GL.h>
+#include <gl/GLU.h>
+#include <stdio.h> // printf
+#include <string>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+/* CONSTANTS NOT INCLUDED IN THE OPENGL 1.1 HEADER */
+
+// S3TC (DXT) compressed formats
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// mip levels of a texture
+#ifndef GL_TEXTURE_BASE_LEVEL
+#define GL_TEXTURE_BASE_LEVEL 0x813C
+#endif
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+
+// multitexture (texture units)
+#ifndef GL_TEXTURE0_ARB
+#define GL_TEXTURE0_ARB 0x84C0
+#endif
+#ifndef GL_TEXTURE1_ARB
+#define GL_TEXTURE1_ARB 0x84C1
+#endif
+
+// depth textures and the depth comparison of the shadow maps
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+#ifndef GL_DEPTH_TEXTURE_MODE_ARB
+#define GL_DEPTH_TEXTURE_MODE_ARB 0x884B
+#endif
+#ifndef GL_TEXTURE_COMPARE_MODE_ARB
+#define GL_TEXTURE_COMPARE_MODE_ARB 0x884C
+#endif
+#ifndef GL_TEXTURE_COMPARE_FUNC_ARB
+#define GL_TEXTURE_COMPARE_FUNC_ARB 0x884D
+#endif
+#ifndef GL_COMPARE_R_TO_TEXTURE_ARB
+#define GL_COMPARE_R_TO_TEXTURE_ARB 0x884E
+#endif
+
+// occlusion queries (number of fragments which passed the depth and stencil tests)
+#ifndef GL_SAMPLES_PASSED_ARB
+#define GL_SAMPLES_PASSED_ARB 0x8914
+#endif
+#ifndef GL_QUERY_RESULT_ARB
+#define GL_QUERY_RESULT_ARB 0x8866
+#endif
+
+// framebuffer objects (EXT_framebuffer_object and the depth/stencil format of EXT_packed_depth_stencil)
+#ifndef GL_FRAMEBUFFER_EXT
+#define GL_FRAMEBUFFER_EXT 0x8D40
+#endif
+#ifndef GL_RENDERBUFFER_EXT
+#define GL_RENDERBUFFER_EXT 0x8D41
+#endif
+#ifndef GL_COLOR_ATTACHMENT0_EXT
+#define GL_COLOR_ATTACHMENT0_EXT 0x8CE0
+#endif
+#ifndef GL_DEPTH_ATTACHMENT_EXT
+#define GL_DEPTH_ATTACHMENT_EXT 0x8D00
+#endif
+#ifndef GL_STENCIL_ATTACHMENT_EXT
+#define GL_STENCIL_ATTACHMENT_EXT 0x8D20
+#endif
+#ifndef GL_FRAMEBUFFER_COMPLETE_EXT
+#define GL_FRAMEBUFFER_COMPLETE_EXT 0x8CD5
+#endif
+#ifndef GL_DEPTH24_STENCIL8_EXT
+#define GL_DEPTH24_STENCIL8_EXT 0x88F0
+#endif
+
+// types of the functions loaded
+typedef void (APIENTRY* CompressedTexImage2DProc)(GLenum target, GLint level, GLenum internal_format, GLsizei width, GLsizei height, GLint border, GLsizei image_size, const void* data);
+typedef void (APIENTRY* ActiveTextureProc)(GLenum texture);
+typedef void (APIENTRY* GenQueriesProc)(GLsizei n, GLuint* ids);
+typedef void (APIENTRY* DeleteQueriesProc)(GLsizei n, const GLuint* ids);
+typedef void (APIENTRY* BeginQueryProc)(GLenum target, GLuint id);
+typedef void (APIENTRY* EndQueryProc)(GLenum target);
+typedef void (APIENTRY* GetQueryObjectuivProc)(GLuint id, GLenum pname, GLuint* params);
+typedef void (APIENTRY* GenFramebuffersProc)(GLsizei n, GLuint* framebuffers);
+typedef void (APIENTRY* DeleteFramebuffersProc)(GLsizei n, const GLuint* framebuffers);
+typedef void (APIENTRY* BindFramebufferProc)(GLenum target, GLuint framebuffer);
+typedef GLenum (APIENTRY* CheckFramebufferStatusProc)(GLenum target);
+typedef void (APIENTRY* GenRenderbuffersProc)(GLsizei n, GLuint* renderbuffers);
+typedef void (APIENTRY* DeleteRenderbuffersProc)(GLsizei n, const GLuint* renderbuffers);
+typedef void (APIENTRY* BindRenderbufferProc)(GLenum target, GLuint renderbuffer);
+typedef void (APIENTRY* RenderbufferStorageProc)(GLenum target, GLenum internal_format, GLsizei width, GLsizei height);
+typedef void (APIENTRY* FramebufferRenderbufferProc)(GLenum target, GLenum attachment, GLenum renderbuffer_target, GLuint renderbuffer);
+
+class GLExtensions
+{
+public:
+	// load the functions and read the extensions supported, it only loads them the first time it is called
+	static void load();
+
+	// return true if the extension (ex: "GL_EXT_texture_compression_s3tc") is supported by the graphics card
+	static bool isSupported(const char* extension_name);
+
+	// return true if the graphics card can receive DXT1/DXT5 compressed textures
+	static bool hasCompressedTextures();
+
+	// return true if the graphics card can use depth textures with comparison in a second texture unit (shadow maps)
+	static bool hasShadowMaps();
+
+	// return true if the graphics card can count the fragments rendered (occlusion queries)
+	static bool hasOcclusionQueries();
+
+	// return true if the graphics card can render in a framebuffer object with depth and stencil (the offscreen buffer of the headless mode)
+	static bool hasFramebufferObjects();
+
+	// functions loaded (nullptr if they are not supported)
+	static CompressedTexImage2DProc compressedTexImage2D;
+	static ActiveTextureProc activeTexture;
+	static GenQueriesProc genQueries;
+	static DeleteQueriesProc deleteQueries;
+	static BeginQueryProc beginQuery;
+	static EndQueryProc endQuery;
+	static GetQueryObjectuivProc getQueryObjectuiv;
+	static GenFramebuffersProc genFramebuffers;
+	static DeleteFramebuffersProc deleteFramebuffers;
+	static BindFramebufferProc bindFramebuffer;
+	static CheckFramebufferStatusProc checkFramebufferStatus;
+	static GenRenderbuffersProc genRenderbuffers;
+	static DeleteRenderbuffersProc deleteRenderbuffers;
+	static BindRenderbufferProc bindRenderbuffer;
+	static RenderbufferStorageProc renderbufferStorage;
+	static FramebufferRenderbufferProc framebufferRenderbuffer;
+
+private:
+	// address of a function of the current context (glut window or OSMesa)
+	static GLUTproc getProcAddress(const char* name);
+
+	// component to load the functions only once
+	static bool loaded_;
+
+	// list of extensions supported, separated by spaces
+	static std::string extensions_;
+};
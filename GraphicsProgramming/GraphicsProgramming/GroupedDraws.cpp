@@ -0,0 +1,118 @@
+#include "GroupedDraws.h"
+
+GroupedDraws::GroupedDraws()
+	: num_grouped_(0), num_culled_(0)
+{
+}
+
+void GroupedDraws::addMesh(BaseMesh* mesh)
+{
+	if (!mesh->isGroupable() || mesh->getGeometryKey().empty())
+	{
+		single_meshes_.push_back(mesh);
+		return;
+	}
+
+	pair<string, Texture*> key(mesh->getGeometryKey(), mesh->getTexture());
+	auto group_index = group_indices_.find(key);
+	if (group_index == group_indices_.end())
+	{
+		group_index = group_indices_.insert(make_pair(key, (int)groups_.size())).first;
+		groups_.push_back(DrawGroup());
+	}
+	groups_[group_index->second].meshes.push_back(mesh);
+}
+
+void GroupedDraws::clear()
+{
+	groups_.clear();
+	group_indices_.clear();
+	single_meshes_.clear();
+	visible_single_meshes_.clear();
+	num_grouped_ = 0;
+	num_culled_ = 0;
+}
+
+void GroupedDraws::cull(const Frustum& frustum)
+{
+	num_grouped_ = 0;
+	num_culled_ = 0;
+
+	for (DrawGroup& group : groups_)
+	{
+		group.visible.clear();
+		for (BaseMesh* mesh : group.meshes)
+		{
+			cullMesh(mesh, frustum, group.visible);
+		}
+		if (group.visible.size() > 1)
+		{
+			num_grouped_ += (int)group.visible.size();
+		}
+	}
+
+	visible_single_meshes_.clear();
+	for (BaseMesh* mesh : single_meshes_)
+	{
+		cullMesh(mesh, frustum, visible_single_meshes_);
+	}
+}
+
+void GroupedDraws::cullMesh(BaseMesh* mesh, const Frustum& frustum, vector<BaseMesh*>& visible)
+{
+	// the evicted meshes are not rendered until they are restored
+	if (!mesh->isGeometryResident())
+	{
+		return;
+	}
+
+	// the bounds have already been calculated by the residency manager this frame
+	Vector3 center;
+	float radius;
+	if (mesh->getBoundingSphere(center, radius) && !frustum.isSphereVisible(center, radius))
+	{
+		num_culled_++;
+		return;
+	}
+	visible.push_back(mesh);
+}
+
+void GroupedDraws::render()
+{
+	for (DrawGroup& group : groups_)
+	{
+		if (group.visible.empty())
+		{
+			continue;
+		}
+
+		// the first visible mesh gives the arrays and the texture to all the meshes of the group (all of them are the same)
+		BaseMesh* prototype = group.visible[0];
+		prototype->beginGroupedDraws();
+		for (BaseMesh* member : group.visible)
+		{
+			prototype->drawGrouped(member);
+		}
+		prototype->endGroupedDraws();
+	}
+
+	for (BaseMesh* mesh : visible_single_meshes_)
+	{
+		mesh->render();
+	}
+}
+
+int GroupedDraws::getNumGroups() const
+{
+	return (int)groups_.size();
+}
+
+int GroupedDraws::getNumGrouped() const
+{
+	return num_grouped_;
+}
+
+int GroupedDraws::getNumCulled() const
+{
+	return num_culled_;
+}
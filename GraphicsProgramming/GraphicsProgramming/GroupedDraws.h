@@ -0,0 +1,65 @@
+// Class Grouped Draws
+// The meshes which have the same geometry (same generator and parameters, or the same model file) and the same texture are drawn in a
+// group with the arrays of one of them: the arrays of coords and the texture are set once for the group, then each mesh only sets its
+// colour and its matrix before its draw, instead of each mesh setting and unsetting all of them. It is still one draw call for each mesh
+// (openGL 1.1 has no instanced draws), what is saved are the changes of state.
+// The groups are made when the meshes are added, and the meshes of each group are chosen again each frame with the meshes inside the
+// frustum (and with their geometry in memory), so the meshes out of the screen are not drawn. cull() doesn't use openGL, so it can be a task.
+// The meshes which cannot be grouped (they have parts with their own arrays, ex: the cubes) are culled and drawn by themselves.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include "BaseMesh.h"
+#include "Frustum.h"
+#include <vector>
+#include <map>
+#include <string>
+
+using namespace std;
+
+class GroupedDraws
+{
+public:
+	// constructor
+	GroupedDraws();
+
+	// add a mesh to the group of its geometry and texture (or to the meshes drawn by themselves)
+	void addMesh(BaseMesh* mesh);
+
+	// remove all the meshes
+	void clear();
+
+	// choose the meshes of each group (and the meshes drawn by themselves) which are inside the frustum
+	void cull(const Frustum& frustum);
+
+	// draw the meshes chosen by cull(), a group after another, and then the rest of meshes
+	void render();
+
+	// stats of the last cull()
+	int getNumGroups() const;
+	int getNumGrouped() const; // meshes drawn in a group with more than one visible
+	int getNumCulled() const;
+
+private:
+	// meshes with the same geometry and texture
+	struct DrawGroup
+	{
+		vector<BaseMesh*> meshes;
+		vector<BaseMesh*> visible; // rebuilt each frame
+	};
+	vector<DrawGroup> groups_;
+
+	// index of the group of each geometry key and texture
+	map<pair<string, Texture*>, int> group_indices_;
+
+	// meshes which cannot be grouped and the visible ones
+	vector<BaseMesh*> single_meshes_;
+	vector<BaseMesh*> visible_single_meshes_;
+
+	int num_grouped_;
+	int num_culled_;
+
+	// add the mesh to the list if it is in memory and inside the frustum (or it has no bounds yet)
+	void cullMesh(BaseMesh* mesh, const Frustum& frustum, vector<BaseMesh*>& visible);
+};
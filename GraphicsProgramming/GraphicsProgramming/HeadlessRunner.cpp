@@ -0,0 +1,217 @@
+#include "HeadlessRunner.h"
+#include "GLExtensions.h"
+#include "freeglut_ext.h" // glutMainLoopEvent
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h> // atoi
+#include <string.h> // strcmp
+#include <algorithm> // max
+
+HeadlessRunner::HeadlessRunner(SharedContext* shared_context)
+	: shared_context_(shared_context), dt_(1.0f / 60.0f)
+#ifdef HEADLESS_OSMESA
+	, context_(nullptr)
+#else
+	, framebuffer_(0), colour_renderbuffer_(0), depth_stencil_renderbuffer_(0)
+#endif
+{
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+#ifdef HEADLESS_OSMESA
+	if (context_ != nullptr)
+	{
+		OSMesaDestroyContext(context_);
+		context_ = nullptr;
+	}
+#else
+	if (framebuffer_ != 0)
+	{
+		GLExtensions::bindFramebuffer(GL_FRAMEBUFFER_EXT, 0);
+		GLExtensions::deleteFramebuffers(1, &framebuffer_);
+		GLExtensions::deleteRenderbuffers(1, &colour_renderbuffer_);
+		GLExtensions::deleteRenderbuffers(1, &depth_stencil_renderbuffer_);
+	}
+#endif
+}
+
+HeadlessOptions HeadlessRunner::parseArguments(int argc, char** argv)
+{
+	HeadlessOptions options;
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		const char* value = argv[i + 1];
+		if (strcmp(argv[i], "--headless") == 0)
+			options.num_frames = atoi(value);
+		else if (strcmp(argv[i], "--width") == 0)
+			options.width = atoi(value);
+		else if (strcmp(argv[i], "--height") == 0)
+			options.height = atoi(value);
+		else if (strcmp(argv[i], "--dump-frames") == 0)
+			options.dump_folder = value;
+		else if (strcmp(argv[i], "--dump-every") == 0)
+			options.dump_every = atoi(value);
+	}
+
+	options.num_frames = max(options.num_frames, 1);
+	options.width = max(options.width, 1);
+	options.height = max(options.height, 1);
+	options.dump_every = max(options.dump_every, 1);
+	return options;
+}
+
+bool HeadlessRunner::createContext(const HeadlessOptions& options, int& argc, char** argv)
+{
+	shared_context_->headless = true;
+	*shared_context_->window_width = options.width;
+	*shared_context_->window_height = options.height;
+
+#ifdef HEADLESS_OSMESA
+	// RGBA with depth (24 bits) and stencil (8 bits, the planar shadows and the mirrors use it), no accumulation buffer
+	context_ = OSMesaCreateContextExt(OSMESA_RGBA, 24, 8, 0, nullptr);
+	if (context_ == nullptr)
+	{
+		printf("HeadlessRunner: the OSMesa context cannot be created\n");
+		return false;
+	}
+	colour_buffer_.resize((size_t)options.width * options.height * 4);
+	if (!OSMesaMakeCurrent(context_, colour_buffer_.data(), GL_UNSIGNED_BYTE, options.width, options.height))
+	{
+		printf("HeadlessRunner: the OSMesa context cannot be made current\n");
+		return false;
+	}
+#else
+	// without OSMesa the context is the one of a glut window which is never shown, the scene is rendered in a framebuffer object
+	glutInit(&argc, argv);
+	glutInitDisplayMode(GLUT_DEPTH | GLUT_DOUBLE | GLUT_RGBA | GLUT_STENCIL);
+	glutInitWindowSize(options.width, options.height);
+	glutCreateWindow("CMP203 Coursework - 1902654 (headless)");
+	glutHideWindow();
+	glutMainLoopEvent(); // process the hide
+	if (!createFramebuffer(options.width, options.height))
+	{
+		return false;
+	}
+#endif
+
+	printf("HeadlessRunner: %ix%i offscreen context, renderer %s\n", options.width, options.height, (const char*)glGetString(GL_RENDERER));
+	return true;
+}
+
+#ifndef HEADLESS_OSMESA
+bool HeadlessRunner::createFramebuffer(int width, int height)
+{
+	GLExtensions::load();
+	if (!GLExtensions::hasFramebufferObjects())
+	{
+		printf("HeadlessRunner: the graphics card has no framebuffer objects with depth and stencil, build with HEADLESS_OSMESA\n");
+		return false;
+	}
+
+	// RGBA colour and depth (24 bits) with stencil (8 bits, the planar shadows and the mirrors use it), as the OSMesa context
+	GLExtensions::genRenderbuffers(1, &colour_renderbuffer_);
+	GLExtensions::bindRenderbuffer(GL_RENDERBUFFER_EXT, colour_renderbuffer_);
+	GLExtensions::renderbufferStorage(GL_RENDERBUFFER_EXT, GL_RGBA8, width, height);
+	GLExtensions::genRenderbuffers(1, &depth_stencil_renderbuffer_);
+	GLExtensions::bindRenderbuffer(GL_RENDERBUFFER_EXT, depth_stencil_renderbuffer_);
+	GLExtensions::renderbufferStorage(GL_RENDERBUFFER_EXT, GL_DEPTH24_STENCIL8_EXT, width, height);
+	GLExtensions::bindRenderbuffer(GL_RENDERBUFFER_EXT, 0);
+
+	// the scene renders in it from now on (the framebuffer of the window is never used)
+	GLExtensions::genFramebuffers(1, &framebuffer_);
+	GLExtensions::bindFramebuffer(GL_FRAMEBUFFER_EXT, framebuffer_);
+	GLExtensions::framebufferRenderbuffer(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_RENDERBUFFER_EXT, colour_renderbuffer_);
+	GLExtensions::framebufferRenderbuffer(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, depth_stencil_renderbuffer_);
+	GLExtensions::framebufferRenderbuffer(GL_FRAMEBUFFER_EXT, GL_STENCIL_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, depth_stencil_renderbuffer_);
+	if (GLExtensions::checkFramebufferStatus(GL_FRAMEBUFFER_EXT) != GL_FRAMEBUFFER_COMPLETE_EXT)
+	{
+		printf("HeadlessRunner: the framebuffer object of %ix%i is not complete\n", width, height);
+		return false;
+	}
+	return true;
+}
+#endif
+
+void HeadlessRunner::run(Scene* scene, const HeadlessOptions& options)
+{
+	using Clock = chrono::high_resolution_clock;
+
+	scene->resize(options.width, options.height);
+	glFinish();
+
+	// sums of the frames, the averages are calculated at the end
+	double total_ms = 0.0, worst_frame_ms = 0.0;
+	SceneFrameStats parts = {};
+	int num_dumped = 0;
+
+	for (int frame = 0; frame < options.num_frames; frame++)
+	{
+		Clock::time_point frame_start = Clock::now();
+		scene->update(dt_);
+		scene->render();
+		glFinish();
+		double frame_ms = chrono::duration<double, milli>(Clock::now() - frame_start).count();
+
+		const SceneFrameStats& frame_parts = scene->getFrameStats();
+		total_ms += frame_ms;
+		worst_frame_ms = max(worst_frame_ms, frame_ms);
+		parts.update_ms += frame_parts.update_ms;
+		parts.culling_ms += frame_parts.culling_ms;
+		parts.reflections_ms += frame_parts.reflections_ms;
+		parts.meshes_ms += frame_parts.meshes_ms;
+		parts.mirrors_ms += frame_parts.mirrors_ms;
+		parts.num_draws += frame_parts.num_draws;
+		parts.num_texture_binds += frame_parts.num_texture_binds;
+
+		// the frames are saved out of the time measured
+		if (!options.dump_folder.empty() && frame % options.dump_every == 0)
+		{
+			char url[64];
+			snprintf(url, sizeof(url), "/frame_%05i.ppm", frame);
+			if (saveFrame(options.dump_folder + url, options.width, options.height))
+				num_dumped++;
+		}
+	}
+
+	int num_frames = options.num_frames;
+	printf("\nHeadless run: %i frames of %ix%i\n", num_frames, options.width, options.height);
+	printf(" Frame: %.2f ms average (%.1f FPS), %.2f ms worst, %.2f s in total\n", total_ms / num_frames, 1000.0 * num_frames / total_ms,
+		worst_frame_ms, total_ms / 1000.0);
+	printf(" Parts: update %.2f ms, culling %.2f ms, reflections %.2f ms, meshes %.2f ms, mirrors %.2f ms\n", parts.update_ms / num_frames,
+		parts.culling_ms / num_frames, parts.reflections_ms / num_frames, parts.meshes_ms / num_frames, parts.mirrors_ms / num_frames);
+	printf(" Calls: %i draws and %i texture binds per frame\n", parts.num_draws / num_frames, parts.num_texture_binds / num_frames);
+	if (!options.dump_folder.empty())
+		printf(" %i frames saved in %s\n", num_dumped, options.dump_folder.c_str());
+	printf("\n");
+}
+
+bool HeadlessRunner::saveFrame(const string& url, int width, int height)
+{
+	// the rows are read from the bottom, the PPM images start from the top
+	vector<unsigned char> pixels((size_t)width * height * 3);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+#ifndef HEADLESS_OSMESA
+	glReadBuffer(GL_COLOR_ATTACHMENT0_EXT); // the colour buffer of the framebuffer object
+#endif
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+	FILE* file = nullptr;
+#ifdef _WIN32
+	fopen_s(&file, url.c_str(), "wb");
+#else
+	file = fopen(url.c_str(), "wb");
+#endif
+	if (file == nullptr)
+	{
+		printf("HeadlessRunner: %s cannot be written\n", url.c_str());
+		return false;
+	}
+	fprintf(file, "P6\n%i %i\n255\n", width, height);
+	for (int row = height - 1; row >= 0; row--)
+	{
+		fwrite(pixels.data() + (size_t)row * width * 3, 1, (size_t)width * 3, file);
+	}
+	fclose(file);
+	return true;
+}
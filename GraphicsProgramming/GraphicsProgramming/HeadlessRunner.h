@@ -0,0 +1,78 @@
+// Class Headless Runner
+// It runs the scene without a window for the automated runs (ex: the performance runs of the build machines, which have no display):
+// an offscreen openGL context of a fixed size is created, and the scene is updated and rendered N frames with the same fixed time step and
+// without input. At the end the time of the frames (glFinish, so the graphics card is included) and the average of each part are printed,
+// and each frame (or one of each K) can be saved as a PPM image to compare the results of two builds.
+// The offscreen context is OSMesa (ex: Mesa llvmpipe on Linux) when the project is built with HEADLESS_OSMESA (and linked with OSMesa, the
+// CMakeLists.txt of the solution builds it that way out of visual studio). Otherwise it is the context of a glut window which is never shown
+// and the scene is rendered in a framebuffer object (the pixels of a hidden window don't belong to it, so they can't be read back), this one
+// still needs a display (the desktop or an X server).
+// It is run from the command line with: GraphicsProgramming.exe --headless N [--width W] [--height H] [--dump-frames folder] [--dump-every K]
+// and the scene is chosen as in the window mode: [--scene file] or [--stress N [--lights M] [--mirrors K] [--seed S]]
+// The folder of the frames must exist.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include "Scene.h"
+#include "SharedContext.h"
+#include <string>
+#include <vector>
+
+#ifdef HEADLESS_OSMESA
+#include <GL/osmesa.h>
+#endif
+
+using namespace std;
+
+// options of the headless run
+struct HeadlessOptions
+{
+	int num_frames = 300;
+	int width = 1280; // size of the offscreen buffer
+	int height = 720;
+	string dump_folder; // empty: the frames are not saved
+	int dump_every = 1; // save one of each K frames
+};
+
+class HeadlessRunner
+{
+public:
+	// constructor
+	HeadlessRunner(SharedContext* shared_context);
+	// destructor, it destroys the offscreen context
+	~HeadlessRunner();
+
+	// read the options from the command line (the values not passed keep their default)
+	static HeadlessOptions parseArguments(int argc, char** argv);
+
+	// create the offscreen context of the size of the options and make it the current one, it returns false if it cannot be created
+	bool createContext(const HeadlessOptions& options, int& argc, char** argv);
+
+	// update and render the scene the frames of the options, print the times and save the frames
+	void run(Scene* scene, const HeadlessOptions& options);
+
+private:
+	// context of the scene, it is marked as headless
+	SharedContext* shared_context_;
+
+	// time step of each frame (s), fixed so all the runs simulate the same
+	float dt_;
+
+#ifdef HEADLESS_OSMESA
+	// offscreen context and its colour buffer (RGBA)
+	OSMesaContext context_;
+	vector<unsigned char> colour_buffer_;
+#else
+	// framebuffer object where the scene is rendered and its buffers (colour and packed depth/stencil)
+	GLuint framebuffer_;
+	GLuint colour_renderbuffer_;
+	GLuint depth_stencil_renderbuffer_;
+
+	// create the framebuffer object of the size of the options and bind it, it returns false if the graphics card can't
+	bool createFramebuffer(int width, int height);
+#endif
+
+	// save the frame rendered as a binary PPM image, it returns false if the file cannot be written
+	bool saveFrame(const string& url, int width, int height);
+};
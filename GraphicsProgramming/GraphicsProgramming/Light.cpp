@@ -1,4 +1,5 @@
 #include "Light.h"
+#include <chrono>
 
 Light::Light(GLenum light_id, Colour4 light_ambient_colour, Colour4 light_diffuse_colour, Colour4 light_specular_colour, vector<GLfloat> light_position)
 	: light_id_(light_id), light_ambient_colour_(light_ambient_colour), light_diffuse_colour_(light_diffuse_colour), light_specular_colour_(light_specular_colour), light_position_(light_position)
@@ -13,6 +14,8 @@ Light::Light(GLenum light_id, Colour4 light_ambient_colour, Colour4 light_diffus
 		light_type_ = LightType::kDirectional;
 	}
 
+	updateWorldPosition();
+
 	if (debug_mode_)
 	{
 
@@ -35,6 +38,7 @@ Light::Light(GLenum light_id, Colour4 light_ambient_colour, Colour4 light_diffus
 		light_type_ = LightType::kDirectional;
 	}
 
+	updateWorldPosition();
 }
 
 
@@ -121,6 +125,10 @@ void Light::update(float dt)
 	{
 		rotation_angles_.z += (speed_ * dt);
 	}
+	if (is_rotating_[0] || is_rotating_[1] || is_rotating_[2])
+	{
+		updateWorldPosition();
+	}
 
 	// if the light is automatically changing over the time
 	if (light_colour_changing_)
@@ -232,10 +240,14 @@ void Light::setLightColourChangingOverTime(bool changing_colour)
 
 void Light::changeColourOverTime()
 {
+	// milliseconds since the first call, read from the steady clock so it also works without a glut window (headless mode)
+	static const chrono::steady_clock::time_point start_time = chrono::steady_clock::now();
+	float time = chrono::duration<float, milli>(chrono::steady_clock::now() - start_time).count();
+
 	Vector3 lightColor;
-	lightColor.x = abs(sinf(glutGet(GLUT_ELAPSED_TIME) * 2.0f));
-	lightColor.y = abs(sinf(glutGet(GLUT_ELAPSED_TIME) * 0.7f));
-	lightColor.z = abs(sinf(glutGet(GLUT_ELAPSED_TIME) * 1.3f));
+	lightColor.x = abs(sinf(time * 2.0f));
+	lightColor.y = abs(sinf(time * 0.7f));
+	lightColor.z = abs(sinf(time * 1.3f));
 
 	light_diffuse_colour_ = { lightColor.x * 0.5f, lightColor.y * 0.5f, lightColor.z * 0.5f, 1.0f};
 	light_ambient_colour_ = { lightColor.x * 0.2f, lightColor.y * 0.2f, lightColor.z * 0.2f, 1.0f };
@@ -244,18 +256,21 @@ void Light::changeColourOverTime()
 void Light::orbitAroundXAxis(float dt)
 {
 	rotation_angles_.x += (speed_ * dt);
+	updateWorldPosition();
 }
 
 
 void Light::orbitAroundYAxis(float dt)
 {
 	rotation_angles_.y += (speed_ * dt);
+	updateWorldPosition();
 }
 
 
 void Light::orbitAroundZAxis(float dt)
 {
 	rotation_angles_.z += (speed_ * dt);
+	updateWorldPosition();
 }
 
 
@@ -263,6 +278,7 @@ void Light::orbitAroundZAxis(float dt)
 void Light::moveAlongXAxis(float dt)
 {
 	light_position_[0] += (speed_* dt);
+	updateWorldPosition();
 }
 
 
@@ -275,12 +291,15 @@ void Light::moveAlongYAxis(float dt)
 		light_position_[1] = 1.0f;
 	else if(light_position_[1] >= 30.0f) // set max in y
 		light_position_[1] = 30.0f;
+
+	updateWorldPosition();
 }
 
 
 void Light::moveAlongZAxis(float dt)
 {
 	light_position_[2] += (speed_* dt);
+	updateWorldPosition();
 }
 
 
@@ -290,4 +309,80 @@ void Light::setPosition(GLfloat pos_x, GLfloat pos_y, GLfloat pos_z)
 	light_position_[1] = pos_y;
 	light_position_[2] = pos_z;
 	// the last light position (w) or pos (3), it is not changed in running time
+
+	updateWorldPosition();
+}
+
+const vector<GLfloat>& Light::getWorldPosition() const
+{
+	return world_position_;
+}
+
+unsigned int Light::getPositionVersion() const
+{
+	return position_version_;
+}
+
+float Light::getContribution(Vector3 point) const
+{
+	if (!is_turned_on_)
+	{
+		return 0.0f;
+	}
+
+	// intensity of the diffuse colour
+	float contribution = (light_diffuse_colour_.rgba[0] + light_diffuse_colour_.rgba[1] + light_diffuse_colour_.rgba[2]) / 3.0f;
+
+	// the directional lights have no attenuation or spot cone
+	if (light_type_ == LightType::kDirectional)
+	{
+		return contribution;
+	}
+
+	Vector3 position(world_position_[0], world_position_[1], world_position_[2]);
+	Vector3 to_point = point - position;
+	float distance = to_point.length();
+
+	// same attenuation as openGL
+	float attenuation = constant_attenuation_ + linear_attenuation_ * distance + quadratic_attenuation_ * distance * distance;
+	if (attenuation > 0.0f)
+	{
+		contribution /= attenuation;
+	}
+
+	// same spot factor as openGL (0 outside the cone)
+	if (light_type_ == LightType::kSpot && spot_cutoff_ < 180.0f && distance > 0.0f)
+	{
+		Vector3 direction = Vector3(spot_direction_[0], spot_direction_[1], spot_direction_[2]).normalised();
+		float cosine = direction.dot(to_point * (1.0f / distance));
+		if (cosine < cosf(spot_cutoff_ * 3.14159265f / 180.0f))
+		{
+			return 0.0f;
+		}
+		contribution *= powf(fmaxf(cosine, 0.0f), spot_exponent_);
+	}
+
+	return contribution;
+}
+
+void Light::updateWorldPosition()
+{
+	// same rotations as render(): x, then y, then z (so the point is rotated first around z)
+	float x = light_position_[0], y = light_position_[1], z = light_position_[2];
+	float angle, c, s, temp;
+
+	angle = rotation_angles_.z * 3.14159265f / 180.0f;
+	c = cosf(angle); s = sinf(angle);
+	temp = x * c - y * s; y = x * s + y * c; x = temp;
+
+	angle = rotation_angles_.y * 3.14159265f / 180.0f;
+	c = cosf(angle); s = sinf(angle);
+	temp = x * c + z * s; z = -x * s + z * c; x = temp;
+
+	angle = rotation_angles_.x * 3.14159265f / 180.0f;
+	c = cosf(angle); s = sinf(angle);
+	temp = y * c - z * s; z = y * s + z * c; y = temp;
+
+	world_position_ = { x, y, z, light_position_[3] };
+	position_version_++;
 }
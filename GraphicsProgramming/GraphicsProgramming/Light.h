@@ -123,6 +123,17 @@ public:
 	// return the position/direction of the light
 	vector<GLfloat> getPosition();
 
+	// return the position/direction of the light in the world (with the orbit rotation applied), it is not copied
+	const vector<GLfloat>& getWorldPosition() const;
+
+	// return a number which changes each time the light moves (moveAlong*, orbitAround*, setPosition or rotating in update), so the data
+	// calculated from the position (ex: the shadow matrices) is only calculated again when it has changed
+	unsigned int getPositionVersion() const;
+
+	// return how much this light lights the point (diffuse intensity by the attenuation and the spot cone), 0 if it is turned off
+	// it is used to choose the lights which cast shadows
+	float getContribution(Vector3 point) const;
+
 	// function to set if change the light colour over the time or not
 	void setLightColourChangingOverTime(bool changing_colour);
 
@@ -156,6 +167,13 @@ private:
 	//vector<GLfloat> light_position_ = { x, y, z, w };
 	vector<GLfloat> light_position_ = { 0.0f, 0.0f, 1.0f, 0.0f };
 
+	// position in the world (light_position_ rotated by rotation_angles_) and its version
+	vector<GLfloat> world_position_ = { 0.0f, 0.0f, 1.0f, 0.0f };
+	unsigned int position_version_ = 0;
+
+	// calculate the world position and change the version, it must be called each time the position or the rotation change
+	void updateWorldPosition();
+
 
 	// VARIABLES FOR SPOT LIGHT
 	vector<GLfloat> spot_direction_ = { 0.0f, 0.0f, -1.0f};
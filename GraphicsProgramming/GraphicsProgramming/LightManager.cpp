@@ -1,11 +1,12 @@
 #include "LightManager.h"
+#include <algorithm> // sort
 
 // constructor
-LightManager::LightManager(SharedContext* shared_context) 
+LightManager::LightManager(SharedContext* shared_context, const SceneDescription& scene_description) 
 	: shared_context_(shared_context)
 {
-	// initialise lights
-	initLights();
+	// initialise the lights of the scene
+	initLights(scene_description);
 }
 
 // destructor
@@ -150,12 +151,19 @@ void LightManager::handleInput(float dt)
 // function for update the Lights
 void LightManager::update(float dt)
 {
-	// update each light in the collection
-	for (Light* light : lights_)
+	// update each light in the collection, they don't depend on each other so they are shared between the threads of the pool
+	auto update_lights = [this, dt](int begin, int end)
 	{
-		if(light->getIsTurnedOn() == true)
-			light->update(dt);
-	}
+		for (int i = begin; i < end; i++)
+		{
+			if (lights_[i]->getIsTurnedOn() == true)
+				lights_[i]->update(dt);
+		}
+	};
+	if (shared_context_->thread_pool != nullptr)
+		shared_context_->thread_pool->parallelFor(0, (int)lights_.size(), update_lights);
+	else
+		update_lights(0, (int)lights_.size());
 
 }
 
@@ -169,66 +177,95 @@ void LightManager::render()
 	}
 }
 
-vector<GLfloat> LightManager::getLightPosition(GLenum light_id)
+const vector<GLfloat>& LightManager::getLightPosition(GLenum light_id)
 {
-	for (Light* light : lights_)
+	Light* light = getLight(light_id);
+	if (light != nullptr)
 	{
-		if (light->getLightId() == light_id)
-		{
-			return light->getPosition();
-		}
+		return light->getWorldPosition();
 	}
 
+	// no light with this id, the default openGL position (directional light looking down the z axis)
+	static const vector<GLfloat> default_position = { 0.0f, 0.0f, 1.0f, 0.0f };
+	return default_position;
 }
 
-void LightManager::initLights()
+Light* LightManager::getLight(GLenum light_id)
 {
-	// enable lighting
-	glEnable(GL_LIGHTING);
-
-	// Components to create the Lights
-
-	// Light ambient components
-	Colour4 light_ambient_colour = { 0.2f, 0.2f, 0.2f, 1.0f}; // Ambient colours SHOULD NOT BE MORE THAN { 0.4f, 0.4f, 0.4f, 1.0f} in total (all the ambient colours light) because it could be too bright. Between 0.2 to 0.4 is right
-
-	// Light diffuse components
-	Colour4 light_diffuse_white_colour = { (unsigned int)0xFFFFFFFF };// = {1.0f, 1.0f, 1.0f, 1.0f} it has used hexadecimal just to show it is admited
-	Colour4 light_diffuse_pomegranate_colour = { 240, 52, 52, 1, false }; // pomegranate colour (rgba will be transformed to opengl glut format by the constructure of the struct colour4)
-	Colour4 light_diffuse_cabaret_colour = { 210, 82, 127, 1, false }; // cabaret colour
-	Colour4 light_diffuse_froly_colour = { 255, 148, 120, 1, false }; // froly colour
+	if (light_id < GL_LIGHT0 || light_id >= GL_LIGHT0 + 8)
+	{
+		return nullptr;
+	}
+	return lights_by_id_[light_id - GL_LIGHT0];
+}
 
-	// Light specular components
-	Colour4 light_specular_colour = {1.0f, 1.0f, 1.0f, 1.0f};
-	Colour4 no_light_colour = { 0.0f, 0.0f, 0.0f, 1.0f };
+float LightManager::getMostContributingLights(const Vector3& point, int max_lights, vector<Light*>& lights)
+{
+	lights.clear();
 
-	// Light emission components
-	vector<GLfloat> light_position0 = { 7.0f, 7.0f, -9.0f, 1.0f };   // ambient + diffuse light
-	vector<GLfloat> light_position1 = { 12.0f, 7.5f, -17.0f, 1.0f }; // spot light
-	vector<GLfloat> light_position2 = { 18.0f, 5.5f, -9.0f, 1.0f };  // specular light
+	// contribution of each light turned on
+	vector<pair<float, Light*>> contributions;
+	float total_contribution = 0.0f;
+	for (Light* light : lights_)
+	{
+		float contribution = light->getContribution(point);
+		if (contribution > 0.0f)
+		{
+			contributions.push_back(make_pair(contribution, light));
+			total_contribution += contribution;
+		}
+	}
 
-	// Values for spot light
-	vector<GLfloat> spot_direction = { 0.0f, -1.0f, 0.0f }; // looking down down
-	float spot_cutoff = 90.0f;
-	float spot_exponent = 50.0f;
+	// the ones with the biggest contribution first
+	sort(contributions.begin(), contributions.end(), [](const pair<float, Light*>& a, const pair<float, Light*>& b) { return a.first > b.first; });
+	for (size_t i = 0; i < contributions.size() && (int)i < max_lights; i++)
+	{
+		lights.push_back(contributions[i].second);
+	}
 
-	// Attenuation components
-	const GLfloat constant_attenuation = 1.0f; // default 1
-	GLfloat linear_attenuantion = 0.25f; // default 0
-	GLfloat quadratic_attenuantion = 1.0f; // default 0
+	return total_contribution;
+}
 
+void LightManager::initLights(const SceneDescription& scene_description)
+{
+	// enable lighting
+	glEnable(GL_LIGHTING);
 
-	// Create lights:
+	// Create the lights of the scene, the first one is GL_LIGHT0 (openGL only has 8)
+	for (int i = 0; i < scene_description.getNumLights() && i < 8; i++)
+	{
+		const SceneLightDesc& light = scene_description.getLight(i);
+		Colour4 ambient_colour = { light.ambient[0], light.ambient[1], light.ambient[2], light.ambient[3] };
+		Colour4 diffuse_colour = { light.diffuse[0], light.diffuse[1], light.diffuse[2], light.diffuse[3] };
+		Colour4 specular_colour = { light.specular[0], light.specular[1], light.specular[2], light.specular[3] };
+		vector<GLfloat> position = { light.position[0], light.position[1], light.position[2], light.position[3] };
 
-	// Diffuse white light + ambient light
-	lights_.push_back(new Light(GL_LIGHT0, light_ambient_colour, light_diffuse_white_colour, no_light_colour, light_position0));
-	lights_.back()->setSpeed(10.5f);
+		if (light.spot)
+		{
+			vector<GLfloat> spot_direction = { light.spot_direction[0], light.spot_direction[1], light.spot_direction[2] };
+			lights_.push_back(new Light(GL_LIGHT0 + i, ambient_colour, diffuse_colour, specular_colour, position, spot_direction, light.spot_cutoff, light.spot_exponent));
+		}
+		else
+		{
+			lights_.push_back(new Light(GL_LIGHT0 + i, ambient_colour, diffuse_colour, specular_colour, position));
+		}
+		if (light.has_attenuation)
+			lights_.back()->setAttenuation(light.attenuation[0], light.attenuation[1], light.attenuation[2]);
+		if (light.changing_colour)
+			lights_.back()->setLightColourChangingOverTime(true);
+		lights_.back()->setSpeed(light.speed);
+	}
 
-	// spot light
-	lights_.push_back(new Light(GL_LIGHT1, light_ambient_colour, light_diffuse_white_colour, no_light_colour, light_position1, spot_direction, spot_cutoff, spot_exponent));
-	lights_.back()->setLightColourChangingOverTime(true);
-	lights_.back()->setSpeed(10.5f);
+	// the shadows need GL_LIGHT0, if the scene doesn't have lights a white one is created
+	if (lights_.empty())
+	{
+		printf("The scene doesn't have lights, using a white light\n");
+		lights_.push_back(new Light(GL_LIGHT0, { 0.2f, 0.2f, 0.2f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 7.0f, 7.0f, -9.0f, 1.0f }));
+	}
 
-	// light specular + attenuation
-	lights_.push_back(new Light(GL_LIGHT2, light_ambient_colour, light_diffuse_white_colour, light_specular_colour, light_position2));
-	lights_.back()->setAttenuation(constant_attenuation, linear_attenuantion, quadratic_attenuantion);
+	// keep them by their id
+	for (Light* light : lights_)
+	{
+		lights_by_id_[light->getLightId() - GL_LIGHT0] = light;
+	}
 }
@@ -1,12 +1,13 @@
 
 // Manager Class for Lights
 // It manage the colection of Lights created for a scene.
-// it sets all the lights in the initlights function
+// it creates the lights of the scene description in the initlights function
 // @author Francisco Diaz (FMGameDev)
 
 #pragma once
 #include "Light.h"
 #include "SharedContext.h"
+#include "SceneDescription.h"
 
 #include <vector>
 
@@ -15,8 +16,8 @@ using namespace std;
 class LightManager
 {
 public:
-	// constructor
-	LightManager(SharedContext *shared_context);
+	// constructor, it creates the lights of the scene
+	LightManager(SharedContext *shared_context, const SceneDescription& scene_description);
 
 	// destructor
 	~LightManager();
@@ -30,18 +31,28 @@ public:
 	// function for render the Lights
 	void render();
 
-	// return the light position by its identifier
-	vector<GLfloat> getLightPosition(GLenum light_id);
+	// return the light position (in the world) by its identifier, it is not copied
+	const vector<GLfloat>& getLightPosition(GLenum light_id);
+
+	// return the light by its identifier (nullptr if there is no light with that id)
+	Light* getLight(GLenum light_id);
+
+	// fill the list with the lights which light the point the most (the turned off ones are not added), at most max_lights, sorted by contribution
+	// it returns the contribution of all the lights turned on, so the contribution of each light can be compared with the total
+	float getMostContributingLights(const Vector3& point, int max_lights, vector<Light*>& lights);
 
 private:
 
-	// initialise the lights for a scene
-	void initLights();
+	// initialise the lights of the scene
+	void initLights(const SceneDescription& scene_description);
 
 	// Shared Context component
 	SharedContext* shared_context_;
 
 	// collection of Lights
 	vector<Light*> lights_;
+
+	// lights by their identifier (GL_LIGHT0 to GL_LIGHT7), so they are found without searching
+	Light* lights_by_id_[8] = { nullptr };
 };
 
@@ -11,12 +11,26 @@
 #include <gl/GLU.h>
 #include "Scene.h"
 #include "SharedContext.h"
+#include "TextureBenchmark.h"
+#include "MotionBenchmark.h"
+#include "MathBenchmark.h"
+#include "StressBenchmark.h"
+#include "HeadlessRunner.h"
 #include <iostream>
+#include <cstring>
+#include <cstdlib> // atoi
+#include <chrono>
+
+// windows.h (included by glut) defines the code of the escape key, the other systems use its ASCII value
+#ifndef VK_ESCAPE
+#define VK_ESCAPE 27
+#endif
 
 // Required variables; pointer to scene and input objects. Initialise variable used in delta time calculation.
+// The time is read from the steady clock instead of glutGet(GLUT_ELAPSED_TIME), which is in whole milliseconds (the fixed steps need more precision).
 Scene* scene;
 SharedContext shared_context;
-int oldTimeSinceStart = 0;
+chrono::steady_clock::time_point oldTimeSinceStart;
 
 // Called when the window detects a change in size.
 // GLUT handles the window refresh, this function passes the new width and height to the
@@ -32,10 +46,9 @@ void changeSize(int w, int h)
 void renderScene(void) 
 {
 	// Calculate delta time.
-	int timeSinceStart = glutGet(GLUT_ELAPSED_TIME);
-	float deltaTime = (float)timeSinceStart - (float)oldTimeSinceStart;
+	chrono::steady_clock::time_point timeSinceStart = chrono::steady_clock::now();
+	float deltaTime = chrono::duration<float>(timeSinceStart - oldTimeSinceStart).count();
 	oldTimeSinceStart = timeSinceStart;
-	deltaTime = deltaTime / 1000.0f;
 
 	// Update Scene and render next frame.
 	scene->handleInput(deltaTime);
@@ -174,6 +187,35 @@ void deletePointers()
 	shared_context.game_focused = nullptr;
 	delete shared_context.first_mouse_click;
 	shared_context.first_mouse_click = nullptr;
+	delete shared_context.thread_pool;
+	shared_context.thread_pool = nullptr;
+}
+
+// Create the scene passed in the command line: scenes/main.scene unless another file is passed with --scene <file>, or a scene of N objects is
+// generated with --stress N (the openGL context must have been created)
+Scene* createScene(int argc, char** argv)
+{
+	const char* scene_url = "scenes/main.scene";
+	int stress_objects = 0;
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], "--scene") == 0)
+		{
+			scene_url = argv[i + 1];
+		}
+		else if (strcmp(argv[i], "--stress") == 0)
+		{
+			stress_objects = atoi(argv[i + 1]);
+		}
+	}
+	if (stress_objects > 0)
+	{
+		StressOptions stress_options = StressBenchmark::parseArguments(argc, argv);
+		SceneDescription stress_description;
+		StressBenchmark::generateScene(stress_description, stress_objects, stress_options.num_lights, stress_options.num_mirrors, stress_options.seed);
+		return new Scene(&shared_context, stress_description);
+	}
+	return new Scene(&shared_context, scene_url);
 }
 
 // Main entery point for application.
@@ -188,6 +230,57 @@ int main(int argc, char **argv)
 	shared_context.wireframe_mode = new bool(false); // by default the project is not in wireframe mode
 	shared_context.game_focused = new bool(false); // by default the game has not the focus (mouse not jailed, etc)
 	shared_context.first_mouse_click = new bool(true); // it is updated to false in camera.cpp after the user has clicked, and it is set to true again in scene when the game lost the focus
+	shared_context.thread_pool = new ThreadPool(); // one worker per core (minus the main thread)
+
+	// Benchmark mode: compare the motion system with the update() of each mesh and exit (it doesn't need a window)
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--motion-benchmark") == 0)
+		{
+			int num_objects = (i + 1 < argc) ? atoi(argv[i + 1]) : 0;
+			MotionBenchmark motion_benchmark(shared_context.thread_pool);
+			motion_benchmark.run(num_objects > 0 ? num_objects : 100000);
+
+			deletePointers();
+			return 0;
+		}
+		if (strcmp(argv[i], "--motion-pipeline-check") == 0)
+		{
+			int num_objects = (i + 1 < argc) ? atoi(argv[i + 1]) : 0;
+			int num_frames = (i + 2 < argc) ? atoi(argv[i + 2]) : 0;
+			MotionBenchmark motion_benchmark(shared_context.thread_pool);
+			bool same = motion_benchmark.runPipelineCheck(num_objects > 0 ? num_objects : 20000, num_frames > 0 ? num_frames : 300);
+
+			deletePointers();
+			return same ? 0 : 1;
+		}
+		if (strcmp(argv[i], "--math-benchmark") == 0)
+		{
+			int num_elements = (i + 1 < argc) ? atoi(argv[i + 1]) : 0;
+			MathBenchmark math_benchmark;
+			math_benchmark.run(num_elements > 0 ? num_elements : 100000);
+
+			deletePointers();
+			return 0;
+		}
+		// Headless mode: render N frames of the scene in an offscreen context, without window or input, and print the times
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			HeadlessOptions headless_options = HeadlessRunner::parseArguments(argc, argv);
+			HeadlessRunner headless_runner(&shared_context);
+			if (!headless_runner.createContext(headless_options, argc, argv))
+			{
+				deletePointers();
+				return 1;
+			}
+			shared_context.input = new Input(); // the scene reads it, but nothing writes on it
+			scene = createScene(argc, argv);
+			headless_runner.run(scene, headless_options);
+
+			deletePointers(); // the scene is deleted before the context
+			return 0;
+		}
+	}
 
 	// Init GLUT and create window
 	glutInit(&argc, argv);
@@ -196,6 +289,33 @@ int main(int argc, char **argv)
 	
 	glutInitWindowSize(*shared_context.window_width, *shared_context.window_height);
 	glutCreateWindow("CMP203 Coursework - 1902654");
+
+	// Benchmark mode: compare the texture preprocessor with SOIL on the scene images and exit (it needs the openGL context of the window)
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--texture-benchmark") == 0)
+		{
+			TextureBenchmark texture_benchmark(shared_context.thread_pool);
+			texture_benchmark.run({
+				{ "gfx/donut.png", false }, { "gfx/earth.png", false }, { "gfx/dicemap.png", false },
+				{ "gfx/dark_gray_wood.jpg", false }, { "gfx/metal.jpg", false },
+				{ "gfx/sword_texture.jpg", true }, { "gfx/sword_bronze_texture.jpg", true },
+				{ "gfx/spaceship.jpg", true }, { "gfx/spaceship2_texture.png", false } });
+
+			deletePointers();
+			return 0;
+		}
+		// Benchmark mode: render generated scenes of more and more objects and print how the frame time grows
+		if (strcmp(argv[i], "--stress-sweep") == 0)
+		{
+			shared_context.input = new Input(); // the scenes print the mouse position
+			StressBenchmark stress_benchmark(&shared_context);
+			stress_benchmark.run(StressBenchmark::parseArguments(argc, argv));
+
+			deletePointers();
+			return 0;
+		}
+	}
 	
 	// Register callback functions for change in size and rendering.
 	glutDisplayFunc(renderScene);
@@ -223,7 +343,8 @@ int main(int argc, char **argv)
 
 	// Initialise input and scene objects.
 	shared_context.input = new Input();
-	scene = new Scene(&shared_context);
+	scene = createScene(argc, argv);
+	oldTimeSinceStart = chrono::steady_clock::now();
 	
 	// Enter GLUT event processing cycle
 	glutMainLoop();
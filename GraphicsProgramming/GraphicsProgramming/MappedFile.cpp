@@ -0,0 +1,128 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: data_(nullptr), size_(0)
+#ifdef _WIN32
+	, file_handle_(INVALID_HANDLE_VALUE), mapping_handle_(nullptr)
+#else
+	, file_descriptor_(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const char* url)
+{
+	close();
+
+#ifdef _WIN32
+	file_handle_ = CreateFileA(url, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file_handle_ == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file_handle_, &file_size) || file_size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	mapping_handle_ = CreateFileMappingA(file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_handle_ == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	data_ = (const unsigned char*)MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0);
+	if (data_ == nullptr)
+	{
+		close();
+		return false;
+	}
+	size_ = (size_t)file_size.QuadPart;
+#else
+	file_descriptor_ = ::open(url, O_RDONLY);
+	if (file_descriptor_ < 0)
+	{
+		return false;
+	}
+
+	struct stat file_info;
+	if (fstat(file_descriptor_, &file_info) != 0 || file_info.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)file_info.st_size, PROT_READ, MAP_PRIVATE, file_descriptor_, 0);
+	if (data == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	data_ = (const unsigned char*)data;
+	size_ = (size_t)file_info.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (data_ != nullptr)
+	{
+		UnmapViewOfFile(data_);
+	}
+	if (mapping_handle_ != nullptr)
+	{
+		CloseHandle(mapping_handle_);
+		mapping_handle_ = nullptr;
+	}
+	if (file_handle_ != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file_handle_);
+		file_handle_ = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (data_ != nullptr)
+	{
+		munmap((void*)data_, size_);
+	}
+	if (file_descriptor_ >= 0)
+	{
+		::close(file_descriptor_);
+		file_descriptor_ = -1;
+	}
+#endif
+
+	data_ = nullptr;
+	size_ = 0;
+}
+
+const unsigned char* MappedFile::getData() const
+{
+	return data_;
+}
+
+size_t MappedFile::getSize() const
+{
+	return size_;
+}
@@ -0,0 +1,46 @@
+// Class Mapped File
+// It maps a file in memory (read only), so its content can be read as an array without copying it first into a buffer.
+// The operating system only loads the pages of the file which are read, and they are shared with the file cache.
+// It is used to upload the cached textures directly from the file.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include <stddef.h> // size_t
+
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+
+	// destructor, it unmaps the file if it is still open
+	~MappedFile();
+
+	// map the file, it returns false if the file doesn't exist or it cannot be mapped
+	bool open(const char* url);
+
+	// unmap the file
+	void close();
+
+	// return the content of the file (nullptr if it is not open) and its size in bytes
+	const unsigned char* getData() const;
+	size_t getSize() const;
+
+private:
+	// content of the file
+	const unsigned char* data_;
+	size_t size_;
+
+	// handles of the operating system
+#ifdef _WIN32
+	void* file_handle_;
+	void* mapping_handle_;
+#else
+	int file_descriptor_;
+#endif
+
+	// a mapped file cannot be copied (it would be unmapped twice)
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+};
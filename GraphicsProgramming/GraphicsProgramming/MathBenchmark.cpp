@@ -0,0 +1,248 @@
+#include "MathBenchmark.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h> // rand
+#include <float.h> // FLT_MAX
+
+using Clock = chrono::high_resolution_clock;
+
+MathBenchmark::MathBenchmark()
+	: num_passes_(50)
+{
+}
+
+void MathBenchmark::run(int num_elements)
+{
+	auto random = [](float min, float max) { return min + (max - min) * (rand() / (float)RAND_MAX); };
+
+	// random points, boxes and matrices (the matrices are transformations as the ones of the meshes)
+	srand(1);
+	points_.resize(num_elements);
+	other_points_.resize(num_elements);
+	boxes_.resize(num_elements);
+	for (int i = 0; i < num_elements; i++)
+	{
+		points_[i] = Vector3(random(-10.0f, 10.0f), random(-10.0f, 10.0f), random(-10.0f, 10.0f));
+		other_points_[i] = Vector3(random(-10.0f, 10.0f), random(-10.0f, 10.0f), random(-10.0f, 10.0f));
+		Vector3 box_min(random(-10.0f, 10.0f), random(-10.0f, 10.0f), random(-10.0f, 10.0f));
+		boxes_[i] = AABB(box_min, box_min + Vector3(random(0.1f, 5.0f), random(0.1f, 5.0f), random(0.1f, 5.0f)));
+	}
+	matrices_.resize(num_elements / 16 + 1);
+	for (Matrix4& matrix : matrices_)
+	{
+		matrix = Matrix4::fromTranslationRotationScale(Vector3(random(-10.0f, 10.0f), random(-10.0f, 10.0f), random(-10.0f, 10.0f)),
+			Vector3(random(0.0f, 360.0f), random(0.0f, 360.0f), random(0.0f, 360.0f)), Vector3(random(0.5f, 2.0f), random(0.5f, 2.0f), random(0.5f, 2.0f)));
+	}
+	transform_ = Matrix4::fromTranslationRotationScale(Vector3(1.0f, 2.0f, 3.0f), Vector3(30.0f, 45.0f, 60.0f), Vector3(1.0f, 2.0f, 0.5f));
+
+	printf("\n%-22s %14s %14s %9s %12s\n", "Test", "Vector3 ms", "SIMD ms", "Speedup", "Max error");
+
+	testTransformPoints();
+	testTransformNormals();
+	testTransformAABBs();
+	testCrossNormalise();
+	testMatrixProducts();
+
+	printf("\nTimes per pass over %i elements (%i matrix products), average of %i passes\n\n", num_elements, (int)matrices_.size() - 1, num_passes_);
+}
+
+void MathBenchmark::printResult(const char* test, double vector3_ms, double simd_ms, float max_error)
+{
+	printf("%-22s %14.3f %14.3f %8.2fx %12g\n", test, vector3_ms, simd_ms, vector3_ms / simd_ms, max_error);
+}
+
+void MathBenchmark::testTransformPoints()
+{
+	int count = (int)points_.size();
+	vector<Vector3> vector3_result(count), simd_result(count);
+
+	// the columns of the matrix as Vector3, the point is the sum of the columns scaled by its components
+	const float* m = transform_.data();
+	Vector3 column0(m[0], m[1], m[2]), column1(m[4], m[5], m[6]), column2(m[8], m[9], m[10]), translation(m[12], m[13], m[14]);
+
+	Clock::time_point start = Clock::now();
+	for (int pass = 0; pass < num_passes_; pass++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			vector3_result[i] = column0 * points_[i].x + column1 * points_[i].y + column2 * points_[i].z + translation;
+		}
+	}
+	double vector3_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_passes_;
+
+	start = Clock::now();
+	for (int pass = 0; pass < num_passes_; pass++)
+	{
+		transform_.transformPoints(points_.data(), simd_result.data(), count);
+	}
+	double simd_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_passes_;
+
+	float max_error = 0.0f;
+	for (int i = 0; i < count; i++)
+	{
+		max_error = fmaxf(max_error, (vector3_result[i] - simd_result[i]).length());
+	}
+	printResult("Transform points", vector3_ms, simd_ms, max_error);
+}
+
+void MathBenchmark::testTransformNormals()
+{
+	int count = (int)points_.size();
+	vector<Vector3> vector3_result(count), simd_result(count);
+
+	// inverse transpose of the 3x3 part (cross products of the columns, the determinant is positive)
+	const float* m = transform_.data();
+	Vector3 column0(m[0], m[1], m[2]), column1(m[4], m[5], m[6]), column2(m[8], m[9], m[10]);
+	Vector3 normal0 = column1.cross(column2), normal1 = column2.cross(column0), normal2 = column0.cross(column1);
+
+	Clock::time_point start = Clock::now();
+	for (int pass = 0; pass < num_passes_; pass++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			vector3_result[i] = (normal0 * points_[i].x + normal1 * points_[i].y + normal2 * points_[i].z).normalised();
+		}
+	}
+	double vector3_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_passes_;
+
+	start = Clock::now();
+	for (int pass = 0; pass < num_passes_; pass++)
+	{
+		transform_.transformNormals(points_.data(), simd_result.data(), count);
+	}
+	double simd_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_passes_;
+
+	float max_error = 0.0f;
+	for (int i = 0; i < count; i++)
+	{
+		max_error = fmaxf(max_error, (vector3_result[i] - simd_result[i]).length());
+	}
+	printResult("Transform normals", vector3_ms, simd_ms, max_error);
+}
+
+void MathBenchmark::testTransformAABBs()
+{
+	int count = (int)boxes_.size();
+	vector<AABB> vector3_result(count), simd_result(count);
+
+	const float* m = transform_.data();
+	Vector3 column0(m[0], m[1], m[2]), column1(m[4], m[5], m[6]), column2(m[8], m[9], m[10]), translation(m[12], m[13], m[14]);
+
+	// the 8 corners transformed and the box which contains them
+	Clock::time_point start = Clock::now();
+	for (int pass = 0; pass < num_passes_; pass++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			const AABB& box = boxes_[i];
+			Vector3 box_min(FLT_MAX, FLT_MAX, FLT_MAX), box_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+			for (int corner = 0; corner < 8; corner++)
+			{
+				Vector3 point = column0 * ((corner & 1) ? box.max.x : box.min.x) + column1 * ((corner & 2) ? box.max.y : box.min.y)
+					+ column2 * ((corner & 4) ? box.max.z : box.min.z) + translation;
+				box_min.set(fminf(box_min.x, point.x), fminf(box_min.y, point.y), fminf(box_min.z, point.z));
+				box_max.set(fmaxf(box_max.x, point.x), fmaxf(box_max.y, point.y), fmaxf(box_max.z, point.z));
+			}
+			vector3_result[i] = AABB(box_min, box_max);
+		}
+	}
+	double vector3_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_passes_;
+
+	start = Clock::now();
+	for (int pass = 0; pass < num_passes_; pass++)
+	{
+		transform_.transformAABBs(boxes_.data(), simd_result.data(), count);
+	}
+	double simd_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_passes_;
+
+	float max_error = 0.0f;
+	for (int i = 0; i < count; i++)
+	{
+		max_error = fmaxf(max_error, fmaxf((vector3_result[i].min - simd_result[i].min).length(), (vector3_result[i].max - simd_result[i].max).length()));
+	}
+	printResult("Transform AABBs", vector3_ms, simd_ms, max_error);
+}
+
+void MathBenchmark::testCrossNormalise()
+{
+	int count = (int)points_.size();
+	vector<Vector3> vector3_result(count), simd_result(count);
+
+	// one vector at a time, as the camera and the shadows use them
+	Clock::time_point start = Clock::now();
+	for (int pass = 0; pass < num_passes_; pass++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			vector3_result[i] = points_[i].cross(other_points_[i]).normalised();
+		}
+	}
+	double vector3_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_passes_;
+
+	start = Clock::now();
+	for (int pass = 0; pass < num_passes_; pass++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			simd_result[i] = Vector4(points_[i], 0.0f).cross3(Vector4(other_points_[i], 0.0f)).normalised3().toVector3();
+		}
+	}
+	double simd_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_passes_;
+
+	float max_error = 0.0f;
+	for (int i = 0; i < count; i++)
+	{
+		max_error = fmaxf(max_error, (vector3_result[i] - simd_result[i]).length());
+	}
+	printResult("Cross + normalise", vector3_ms, simd_ms, max_error);
+}
+
+void MathBenchmark::testMatrixProducts()
+{
+	int count = (int)matrices_.size() - 1;
+	vector<Matrix4> scalar_result(count), simd_result(count);
+
+	// each matrix by the next one, the scalar loop is the one the frustum used before
+	Clock::time_point start = Clock::now();
+	for (int pass = 0; pass < num_passes_; pass++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			const float* a = matrices_[i].m;
+			const float* b = matrices_[i + 1].m;
+			float* result = scalar_result[i].m;
+			for (int column = 0; column < 4; column++)
+			{
+				for (int row = 0; row < 4; row++)
+				{
+					result[column * 4 + row] = 0.0f;
+					for (int k = 0; k < 4; k++)
+					{
+						result[column * 4 + row] += a[k * 4 + row] * b[column * 4 + k];
+					}
+				}
+			}
+		}
+	}
+	double scalar_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_passes_;
+
+	start = Clock::now();
+	for (int pass = 0; pass < num_passes_; pass++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			simd_result[i] = matrices_[i] * matrices_[i + 1];
+		}
+	}
+	double simd_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_passes_;
+
+	float max_error = 0.0f;
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = 0; j < 16; j++)
+		{
+			max_error = fmaxf(max_error, fabsf(scalar_result[i].m[j] - simd_result[i].m[j]));
+		}
+	}
+	printResult("Matrix products", scalar_ms, simd_ms, max_error);
+}
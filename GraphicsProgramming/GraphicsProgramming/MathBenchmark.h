@@ -0,0 +1,44 @@
+// Class Math Benchmark
+// It compares the SIMD math (MathSIMD.h) against the same operations done with Vector3, over arrays of random data.
+// For each test it prints the time of a pass with Vector3 and with the SIMD functions, the speed up and the biggest difference
+// between both results: transforming points, normals and boxes (AABB) by a matrix, cross product plus normalise, and matrix products.
+// It is run from the command line with: GraphicsProgramming.exe --math-benchmark [number of elements]
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include "MathSIMD.h"
+#include <vector>
+
+using namespace std;
+
+class MathBenchmark
+{
+public:
+	// constructor
+	MathBenchmark();
+
+	// run all the tests with the number of elements passed and print the results
+	void run(int num_elements = 100000);
+
+private:
+	// number of passes of each test (the time printed is the average)
+	int num_passes_;
+
+	// random data of the tests
+	vector<Vector3> points_;
+	vector<Vector3> other_points_;
+	vector<AABB> boxes_;
+	vector<Matrix4> matrices_;
+	Matrix4 transform_;
+
+	// print a row of the results
+	void printResult(const char* test, double vector3_ms, double simd_ms, float max_error);
+
+	// the tests, each one prints its times and the biggest difference between the results of both ways
+	void testTransformPoints();
+	void testTransformNormals();
+	void testTransformAABBs();
+	void testCrossNormalise();
+	void testMatrixProducts();
+};
@@ -0,0 +1,380 @@
+#include "MathSIMD.h"
+#include <string.h> // memcpy
+
+static_assert(sizeof(Vector3) == 3 * sizeof(float), "the batch functions read the arrays of Vector3 as arrays of floats");
+
+/* MATRIX4 */
+
+Matrix4::Matrix4()
+{
+	for (int i = 0; i < 16; i++)
+	{
+		m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+	}
+}
+
+Matrix4::Matrix4(const float* values)
+{
+	memcpy(m, values, 16 * sizeof(float));
+}
+
+Matrix4 Matrix4::identity()
+{
+	return Matrix4();
+}
+
+Matrix4 Matrix4::translation(const Vector3& translation)
+{
+	Matrix4 result;
+	result.m[12] = translation.x;
+	result.m[13] = translation.y;
+	result.m[14] = translation.z;
+	return result;
+}
+
+Matrix4 Matrix4::scale(const Vector3& scale)
+{
+	Matrix4 result;
+	result.m[0] = scale.x;
+	result.m[5] = scale.y;
+	result.m[10] = scale.z;
+	return result;
+}
+
+Matrix4 Matrix4::rotation(const Vector3& rotation_angles)
+{
+	return fromTranslationRotationScale(Vector3(0.0f, 0.0f, 0.0f), rotation_angles, Vector3(1.0f, 1.0f, 1.0f));
+}
+
+Matrix4 Matrix4::fromTranslationRotationScale(const Vector3& translation, const Vector3& rotation_angles, const Vector3& scale)
+{
+	float angle_x = rotation_angles.x * (float)M_PI / 180.0f;
+	float angle_y = rotation_angles.y * (float)M_PI / 180.0f;
+	float angle_z = rotation_angles.z * (float)M_PI / 180.0f;
+	float cx = cosf(angle_x), sx = sinf(angle_x);
+	float cy = cosf(angle_y), sy = sinf(angle_y);
+	float cz = cosf(angle_z), sz = sinf(angle_z);
+
+	// columns (the axes) scaled, and the translation in the last one
+	Matrix4 result;
+	result.m[0] = cy * cz * scale.x;
+	result.m[1] = (cx * sz + sx * sy * cz) * scale.x;
+	result.m[2] = (sx * sz - cx * sy * cz) * scale.x;
+	result.m[4] = -cy * sz * scale.y;
+	result.m[5] = (cx * cz - sx * sy * sz) * scale.y;
+	result.m[6] = (sx * cz + cx * sy * sz) * scale.y;
+	result.m[8] = sy * scale.z;
+	result.m[9] = -sx * cy * scale.z;
+	result.m[10] = cx * cy * scale.z;
+	result.m[12] = translation.x;
+	result.m[13] = translation.y;
+	result.m[14] = translation.z;
+	return result;
+}
+
+Matrix4 Matrix4::shadow(const Vector4& plane, const Vector4& light)
+{
+	// shadow = light * plane^t - (plane . light) * identity, each column is the light scaled by a coefficient of the plane
+	__m128 light_column = simd::load(light);
+	float plane_dot_light = plane.dot(light);
+	const float coefficients[4] = { plane.x, plane.y, plane.z, plane.w };
+
+	Matrix4 result;
+	for (int column = 0; column < 4; column++)
+	{
+		_mm_storeu_ps(result.m + column * 4, _mm_mul_ps(light_column, _mm_set1_ps(coefficients[column])));
+		result.m[column * 5] -= plane_dot_light;
+	}
+	return result;
+}
+
+Matrix4 Matrix4::reflection(const Vector4& plane)
+{
+	// p' = p - 2 * (n.p + d) * n, so reflection = identity - 2 * n * n^t and the translation is -2 * d * n
+	__m128 normal_column = simd::maskXYZ(simd::load(plane));
+	const float coefficients[4] = { plane.x, plane.y, plane.z, plane.w };
+
+	Matrix4 result;
+	for (int column = 0; column < 4; column++)
+	{
+		__m128 identity_column = _mm_loadu_ps(result.m + column * 4);
+		__m128 scaled_normal = _mm_mul_ps(normal_column, _mm_set1_ps(2.0f * coefficients[column]));
+		_mm_storeu_ps(result.m + column * 4, _mm_sub_ps(identity_column, scaled_normal));
+	}
+	return result;
+}
+
+Matrix4 Matrix4::operator*(const Matrix4& m2) const
+{
+	// each column of the result is the combination of the columns of this matrix with the values of the column of m2
+	__m128 column0 = _mm_loadu_ps(m);
+	__m128 column1 = _mm_loadu_ps(m + 4);
+	__m128 column2 = _mm_loadu_ps(m + 8);
+	__m128 column3 = _mm_loadu_ps(m + 12);
+
+	Matrix4 result;
+	for (int column = 0; column < 4; column++)
+	{
+		const float* values = m2.m + column * 4;
+		__m128 sum = _mm_mul_ps(column0, _mm_set1_ps(values[0]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(column1, _mm_set1_ps(values[1])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(column2, _mm_set1_ps(values[2])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(column3, _mm_set1_ps(values[3])));
+		_mm_storeu_ps(result.m + column * 4, sum);
+	}
+	return result;
+}
+
+Vector3 Matrix4::transformNormal(const Vector3& normal) const
+{
+	float n[9];
+	getNormalMatrix(n);
+	Vector3 result(n[0] * normal.x + n[3] * normal.y + n[6] * normal.z,
+		n[1] * normal.x + n[4] * normal.y + n[7] * normal.z,
+		n[2] * normal.x + n[5] * normal.y + n[8] * normal.z);
+	result.normalise();
+	return result;
+}
+
+Matrix4 Matrix4::transposed() const
+{
+	__m128 column0 = _mm_loadu_ps(m);
+	__m128 column1 = _mm_loadu_ps(m + 4);
+	__m128 column2 = _mm_loadu_ps(m + 8);
+	__m128 column3 = _mm_loadu_ps(m + 12);
+	_MM_TRANSPOSE4_PS(column0, column1, column2, column3);
+
+	Matrix4 result;
+	_mm_storeu_ps(result.m, column0);
+	_mm_storeu_ps(result.m + 4, column1);
+	_mm_storeu_ps(result.m + 8, column2);
+	_mm_storeu_ps(result.m + 12, column3);
+	return result;
+}
+
+void Matrix4::getNormalMatrix(float normal_matrix[9]) const
+{
+	// the columns of the inverse transpose are the cross products of the other columns divided by the determinant,
+	// the division is not needed as the normals are normalised, but the sign is (mirrored matrices)
+	Vector3 column0(m[0], m[1], m[2]), column1(m[4], m[5], m[6]), column2(m[8], m[9], m[10]);
+	Vector3 cofactors[3] = { column1.cross(column2), column2.cross(column0), column0.cross(column1) };
+	float sign = (column0.dot(cofactors[0]) < 0.0f) ? -1.0f : 1.0f;
+
+	for (int column = 0; column < 3; column++)
+	{
+		normal_matrix[column * 3] = cofactors[column].x * sign;
+		normal_matrix[column * 3 + 1] = cofactors[column].y * sign;
+		normal_matrix[column * 3 + 2] = cofactors[column].z * sign;
+	}
+}
+
+void Matrix4::transformPoints(const Vector3* points, Vector3* result, int count) const
+{
+	// each value of the matrix in the 4 lanes
+	__m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+	__m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]);
+	__m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]);
+	__m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]);
+
+	// 4 points at a time
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x, y, z;
+		simd::loadPoints(&points[i].x, x, y, z);
+
+		__m128 result_x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)), _mm_add_ps(_mm_mul_ps(m8, z), m12));
+		__m128 result_y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)), _mm_add_ps(_mm_mul_ps(m9, z), m13));
+		__m128 result_z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, x), _mm_mul_ps(m6, y)), _mm_add_ps(_mm_mul_ps(m10, z), m14));
+
+		simd::storePoints(&result[i].x, result_x, result_y, result_z);
+	}
+
+	// the last points (less than 4)
+	for (; i < count; i++)
+	{
+		result[i] = transformPoint(points[i]);
+	}
+}
+
+void Matrix4::transformNormals(const Vector3* normals, Vector3* result, int count) const
+{
+	float n[9];
+	getNormalMatrix(n);
+
+	__m128 n0 = _mm_set1_ps(n[0]), n1 = _mm_set1_ps(n[1]), n2 = _mm_set1_ps(n[2]);
+	__m128 n3 = _mm_set1_ps(n[3]), n4 = _mm_set1_ps(n[4]), n5 = _mm_set1_ps(n[5]);
+	__m128 n6 = _mm_set1_ps(n[6]), n7 = _mm_set1_ps(n[7]), n8 = _mm_set1_ps(n[8]);
+	__m128 zero = _mm_setzero_ps();
+
+	// 4 normals at a time
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x, y, z;
+		simd::loadPoints(&normals[i].x, x, y, z);
+
+		__m128 result_x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n0, x), _mm_mul_ps(n3, y)), _mm_mul_ps(n6, z));
+		__m128 result_y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n1, x), _mm_mul_ps(n4, y)), _mm_mul_ps(n7, z));
+		__m128 result_z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n2, x), _mm_mul_ps(n5, y)), _mm_mul_ps(n8, z));
+
+		// normalise, the zero normals stay zero (the inverse of the length is masked to 0 instead of infinite)
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(result_x, result_x), _mm_mul_ps(result_y, result_y)), _mm_mul_ps(result_z, result_z)));
+		__m128 inverse_length = _mm_and_ps(_mm_cmpgt_ps(length, zero), _mm_div_ps(_mm_set1_ps(1.0f), length));
+
+		simd::storePoints(&result[i].x, _mm_mul_ps(result_x, inverse_length), _mm_mul_ps(result_y, inverse_length), _mm_mul_ps(result_z, inverse_length));
+	}
+
+	// the last normals (less than 4)
+	for (; i < count; i++)
+	{
+		Vector3 normal(n[0] * normals[i].x + n[3] * normals[i].y + n[6] * normals[i].z,
+			n[1] * normals[i].x + n[4] * normals[i].y + n[7] * normals[i].z,
+			n[2] * normals[i].x + n[5] * normals[i].y + n[8] * normals[i].z);
+		normal.normalise();
+		result[i] = normal;
+	}
+}
+
+void Matrix4::transformAABBs(const AABB* boxes, AABB* result, int count) const
+{
+	// the center is transformed as a point and the half size by the absolute values of the matrix (Arvo),
+	// it gives the same box as transforming the 8 corners
+	__m128 column0 = _mm_loadu_ps(m), column1 = _mm_loadu_ps(m + 4), column2 = _mm_loadu_ps(m + 8), column3 = _mm_loadu_ps(m + 12);
+	__m128 sign_mask = _mm_set1_ps(-0.0f);
+	__m128 abs_column0 = _mm_andnot_ps(sign_mask, column0);
+	__m128 abs_column1 = _mm_andnot_ps(sign_mask, column1);
+	__m128 abs_column2 = _mm_andnot_ps(sign_mask, column2);
+	__m128 half = _mm_set1_ps(0.5f);
+
+	for (int i = 0; i < count; i++)
+	{
+		// min and max in registers (x, y, z, w is not used)
+		__m128 min = _mm_setr_ps(boxes[i].min.x, boxes[i].min.y, boxes[i].min.z, 0.0f);
+		__m128 max = _mm_setr_ps(boxes[i].max.x, boxes[i].max.y, boxes[i].max.z, 0.0f);
+		__m128 center = _mm_mul_ps(_mm_add_ps(min, max), half);
+		__m128 extent = _mm_mul_ps(_mm_sub_ps(max, min), half);
+
+		__m128 new_center = _mm_add_ps(column3, _mm_mul_ps(column0, _mm_shuffle_ps(center, center, _MM_SHUFFLE(0, 0, 0, 0))));
+		new_center = _mm_add_ps(new_center, _mm_mul_ps(column1, _mm_shuffle_ps(center, center, _MM_SHUFFLE(1, 1, 1, 1))));
+		new_center = _mm_add_ps(new_center, _mm_mul_ps(column2, _mm_shuffle_ps(center, center, _MM_SHUFFLE(2, 2, 2, 2))));
+
+		__m128 new_extent = _mm_mul_ps(abs_column0, _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(0, 0, 0, 0)));
+		new_extent = _mm_add_ps(new_extent, _mm_mul_ps(abs_column1, _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(1, 1, 1, 1))));
+		new_extent = _mm_add_ps(new_extent, _mm_mul_ps(abs_column2, _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(2, 2, 2, 2))));
+
+		float new_min[4], new_max[4];
+		_mm_storeu_ps(new_min, _mm_sub_ps(new_center, new_extent));
+		_mm_storeu_ps(new_max, _mm_add_ps(new_center, new_extent));
+		result[i].min = Vector3(new_min[0], new_min[1], new_min[2]);
+		result[i].max = Vector3(new_max[0], new_max[1], new_max[2]);
+	}
+}
+
+/* QUATERNION */
+
+Quaternion::Quaternion(float x, float y, float z, float w)
+	: x(x), y(y), z(z), w(w)
+{
+}
+
+Quaternion Quaternion::fromAxisAngle(const Vector3& axis, float angle)
+{
+	Vector3 unit_axis = axis.normalised();
+	float half_angle = angle * (float)M_PI / 360.0f;
+	float s = sinf(half_angle);
+	return Quaternion(unit_axis.x * s, unit_axis.y * s, unit_axis.z * s, cosf(half_angle));
+}
+
+Quaternion Quaternion::fromEulerAngles(const Vector3& rotation_angles)
+{
+	return fromAxisAngle(Vector3(1.0f, 0.0f, 0.0f), rotation_angles.x)
+		* fromAxisAngle(Vector3(0.0f, 1.0f, 0.0f), rotation_angles.y)
+		* fromAxisAngle(Vector3(0.0f, 0.0f, 1.0f), rotation_angles.z);
+}
+
+Quaternion Quaternion::slerp(const Quaternion& a, const Quaternion& b, float t)
+{
+	// q and -q are the same rotation, the one closer to a is used
+	float cos_angle = a.dot(b);
+	float sign = 1.0f;
+	if (cos_angle < 0.0f)
+	{
+		cos_angle = -cos_angle;
+		sign = -1.0f;
+	}
+
+	// when they are very close the interpolation is linear (sin(angle) is almost 0)
+	float weight_a = 1.0f - t, weight_b = t;
+	if (cos_angle < 0.9995f)
+	{
+		float angle = acosf(cos_angle);
+		float sin_angle = sinf(angle);
+		weight_a = sinf((1.0f - t) * angle) / sin_angle;
+		weight_b = sinf(t * angle) / sin_angle;
+	}
+	weight_b *= sign;
+
+	Quaternion result(a.x * weight_a + b.x * weight_b, a.y * weight_a + b.y * weight_b, a.z * weight_a + b.z * weight_b, a.w * weight_a + b.w * weight_b);
+	return result.normalised();
+}
+
+Quaternion Quaternion::operator*(const Quaternion& q2) const
+{
+	// x = w1 x2 + x1 w2 + y1 z2 - z1 y2
+	// y = w1 y2 - x1 z2 + y1 w2 + z1 x2
+	// z = w1 z2 + x1 y2 - y1 x2 + z1 w2
+	// w = w1 w2 - x1 x2 - y1 y2 - z1 z2
+	__m128 b = _mm_loadu_ps(&q2.x);
+	__m128 result = _mm_mul_ps(_mm_set1_ps(w), b);
+	result = _mm_add_ps(result, _mm_xor_ps(_mm_mul_ps(_mm_set1_ps(x), _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3))), _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f)));
+	result = _mm_add_ps(result, _mm_xor_ps(_mm_mul_ps(_mm_set1_ps(y), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))), _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f)));
+	result = _mm_add_ps(result, _mm_xor_ps(_mm_mul_ps(_mm_set1_ps(z), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1))), _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f)));
+
+	Quaternion product;
+	_mm_storeu_ps(&product.x, result);
+	return product;
+}
+
+Quaternion Quaternion::conjugate() const
+{
+	return Quaternion(-x, -y, -z, w);
+}
+
+Quaternion Quaternion::normalised() const
+{
+	float length = sqrtf(dot(*this));
+	if (length == 0.0f)
+	{
+		return Quaternion();
+	}
+	return Quaternion(x / length, y / length, z / length, w / length);
+}
+
+float Quaternion::dot(const Quaternion& q2) const
+{
+	return _mm_cvtss_f32(simd::horizontalSum(_mm_mul_ps(_mm_loadu_ps(&x), _mm_loadu_ps(&q2.x))));
+}
+
+Vector3 Quaternion::rotate(const Vector3& v) const
+{
+	// v' = v + 2w (q x v) + 2 q x (q x v), with q the x, y, z part
+	Vector4 axis(x, y, z, 0.0f), vector(v, 0.0f);
+	Vector4 t = axis.cross3(vector) * 2.0f;
+	return (vector + t * w + axis.cross3(t)).toVector3();
+}
+
+Matrix4 Quaternion::toMatrix() const
+{
+	Matrix4 result;
+	result.m[0] = 1.0f - 2.0f * (y * y + z * z);
+	result.m[1] = 2.0f * (x * y + w * z);
+	result.m[2] = 2.0f * (x * z - w * y);
+	result.m[4] = 2.0f * (x * y - w * z);
+	result.m[5] = 1.0f - 2.0f * (x * x + z * z);
+	result.m[6] = 2.0f * (y * z + w * x);
+	result.m[8] = 2.0f * (x * z + w * y);
+	result.m[9] = 2.0f * (y * z - w * x);
+	result.m[10] = 1.0f - 2.0f * (x * x + y * y);
+	return result;
+}
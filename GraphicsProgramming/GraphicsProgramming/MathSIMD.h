@@ -0,0 +1,284 @@
+// SIMD Math
+// Math types for the transformations of the scene: Vector4, AABB, Matrix4 (column major as openGL) and Quaternion.
+// The operations are done with SSE (4 floats at a time) and the functions which do not modify the object are const.
+// The small functions are inline (at the end of this file) so they can be used in the loops without the cost of a call.
+// Matrix4 has batch functions which transform arrays of points, normals and boxes: the points are read 4 at a time and swizzled
+// into x, y and z registers (SoA), so they work directly over arrays of Vector3 (ex: the vertices of the meshes).
+// The loads and stores are unaligned on purpose: in C++14 "new" only aligns to 8 bytes in x86, so the classes which keep these types as
+// members (ex: the meshes) can't rely on an alignment of 16 bytes. Reading aligned data with an unaligned load costs the same in the current processors.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#define _USE_MATH_DEFINES // for using pi
+
+#include <cmath>
+#include <emmintrin.h> // SSE2
+
+#include "Vector3.h"
+
+class Matrix4;
+
+// x, y, z and w (w is 1 for the points and 0 for the directions)
+class Vector4
+{
+public:
+	Vector4(float x = 0, float y = 0, float z = 0, float w = 0);
+	Vector4(const Vector3& v, float w);
+
+	// x, y and z
+	Vector3 toVector3() const;
+
+	Vector4 operator+(const Vector4& v2) const;
+	Vector4 operator-(const Vector4& v2) const;
+	Vector4 operator*(float scale) const;
+
+	// dot product of the 4 components
+	float dot(const Vector4& v2) const;
+
+	// dot product of x, y and z
+	float dot3(const Vector4& v2) const;
+
+	// cross product of x, y and z (w is 0)
+	Vector4 cross3(const Vector4& v2) const;
+
+	// length of x, y and z
+	float length3() const;
+
+	// x, y and z normalised (w is kept), a zero vector is returned as it is
+	Vector4 normalised3() const;
+
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+// axis aligned bounding box
+struct AABB
+{
+	// default constructor
+	// (braces instead of parentheses, so the min/max macros of windows.h are not expanded)
+	AABB() : min{ 0.0f, 0.0f, 0.0f }, max{ 0.0f, 0.0f, 0.0f } {};
+	// constructor for passing data
+	AABB(Vector3 minimum, Vector3 maximum) : min{ minimum }, max{ maximum } {};
+
+	Vector3 min; // min x,y,z values of the box
+	Vector3 max; // max x,y,z values of the box
+};
+
+// 4x4 matrix, column major as openGL (m[column * 4 + row]), so it can be passed directly to glMultMatrixf/glLoadMatrixf
+class Matrix4
+{
+public:
+	// identity
+	Matrix4();
+
+	// 16 values, column major
+	explicit Matrix4(const float* values);
+
+	static Matrix4 identity();
+	static Matrix4 translation(const Vector3& translation);
+	static Matrix4 scale(const Vector3& scale);
+
+	// rotate x * rotate y * rotate z, angles in degrees (the same order as glRotatef in the render of the meshes)
+	static Matrix4 rotation(const Vector3& rotation_angles);
+
+	// translate * rotate x * rotate y * rotate z * scale, angles in degrees (the transformation of the meshes)
+	static Matrix4 fromTranslationRotationScale(const Vector3& translation, const Vector3& rotation_angles, const Vector3& scale);
+
+	// projection from the light (w = 1 point light, w = 0 directional) onto the plane ax + by + cz + d = 0 (planar shadows)
+	static Matrix4 shadow(const Vector4& plane, const Vector4& light);
+
+	// reflection by the plane ax + by + cz + d = 0, (a, b, c) must be normalised (mirrors)
+	static Matrix4 reflection(const Vector4& plane);
+
+	Matrix4 operator*(const Matrix4& m2) const;
+
+	// transform a vector of 4 components
+	Vector4 transform(const Vector4& v) const;
+
+	// transform a point (w = 1) or a direction (w = 0), the last row is ignored (affine matrices)
+	Vector3 transformPoint(const Vector3& point) const;
+	Vector3 transformVector(const Vector3& vector) const;
+
+	// transform a normal by the inverse transpose of the 3x3 part and normalise it (it works with non uniform scales)
+	Vector3 transformNormal(const Vector3& normal) const;
+
+	Matrix4 transposed() const;
+
+	// values, column major
+	const float* data() const;
+
+	/* BATCH FUNCTIONS (the result can be the same array as the input) */
+
+	// transform the points (w = 1, affine matrices)
+	void transformPoints(const Vector3* points, Vector3* result, int count) const;
+
+	// transform the normals by the inverse transpose of the 3x3 part and normalise them
+	void transformNormals(const Vector3* normals, Vector3* result, int count) const;
+
+	// transform the boxes, the result is the box which contains the transformed box (affine matrices)
+	void transformAABBs(const AABB* boxes, AABB* result, int count) const;
+
+	float m[16];
+
+private:
+	// columns of the inverse transpose of the 3x3 part multiplied by the absolute value of the determinant (the normals are normalised after)
+	void getNormalMatrix(float normal_matrix[9]) const;
+};
+
+// unit quaternion for the rotations (x, y, z is the axis * sin(angle / 2), w is cos(angle / 2))
+class Quaternion
+{
+public:
+	// identity
+	Quaternion(float x = 0, float y = 0, float z = 0, float w = 1);
+
+	// rotation of angle (degrees) around the axis
+	static Quaternion fromAxisAngle(const Vector3& axis, float angle);
+
+	// rotate x * rotate y * rotate z, angles in degrees (the same order as the meshes)
+	static Quaternion fromEulerAngles(const Vector3& rotation_angles);
+
+	// spherical interpolation from a (t = 0) to b (t = 1) by the shortest way
+	static Quaternion slerp(const Quaternion& a, const Quaternion& b, float t);
+
+	// rotation of q2 and then this one
+	Quaternion operator*(const Quaternion& q2) const;
+
+	Quaternion conjugate() const;
+	Quaternion normalised() const;
+	float dot(const Quaternion& q2) const;
+
+	// rotate a vector
+	Vector3 rotate(const Vector3& v) const;
+
+	// rotation matrix
+	Matrix4 toMatrix() const;
+
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+/* INLINE FUNCTIONS */
+
+namespace simd
+{
+	// the register is built from the components instead of a load of 16 bytes: the vectors are usually written component by component just before
+	// (ex: Vector4(Vector3, w)), and a wide load of them stalls until the small stores are done. This way the compiler keeps them in registers.
+	inline __m128 load(const Vector4& v) { return _mm_setr_ps(v.x, v.y, v.z, v.w); }
+	inline Vector4 store(__m128 v) { Vector4 result; _mm_storeu_ps(&result.x, v); return result; }
+
+	// sum of the 4 components in all of them
+	inline __m128 horizontalSum(__m128 v)
+	{
+		__m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)); // y x w z
+		__m128 sums = _mm_add_ps(v, shuffled); // x+y x+y z+w z+w
+		shuffled = _mm_shuffle_ps(sums, sums, _MM_SHUFFLE(1, 0, 3, 2));
+		return _mm_add_ps(sums, shuffled);
+	}
+
+	// x, y and z of v with w = 0
+	inline __m128 maskXYZ(__m128 v)
+	{
+		return _mm_and_ps(v, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1)));
+	}
+
+	// y z x w (used by the cross product)
+	inline __m128 shuffleYZX(__m128 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1)); }
+
+	// 4 points (12 floats: x0 y0 z0 x1 y1 z1 ...) to registers of x, y and z
+	inline void loadPoints(const float* points, __m128& x, __m128& y, __m128& z)
+	{
+		__m128 a = _mm_loadu_ps(points);     // x0 y0 z0 x1
+		__m128 b = _mm_loadu_ps(points + 4); // y1 z1 x2 y2
+		__m128 c = _mm_loadu_ps(points + 8); // z2 x3 y3 z3
+		x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+		y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+	}
+
+	// registers of x, y and z to 4 points (12 floats)
+	inline void storePoints(float* points, __m128 x, __m128 y, __m128 z)
+	{
+		_mm_storeu_ps(points, _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(points + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(points + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+}
+
+inline Vector4::Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+inline Vector4::Vector4(const Vector3& v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+inline Vector3 Vector4::toVector3() const { return Vector3(x, y, z); }
+
+inline Vector4 Vector4::operator+(const Vector4& v2) const { return simd::store(_mm_add_ps(simd::load(*this), simd::load(v2))); }
+inline Vector4 Vector4::operator-(const Vector4& v2) const { return simd::store(_mm_sub_ps(simd::load(*this), simd::load(v2))); }
+inline Vector4 Vector4::operator*(float scale) const { return simd::store(_mm_mul_ps(simd::load(*this), _mm_set1_ps(scale))); }
+
+inline float Vector4::dot(const Vector4& v2) const
+{
+	return _mm_cvtss_f32(simd::horizontalSum(_mm_mul_ps(simd::load(*this), simd::load(v2))));
+}
+
+inline float Vector4::dot3(const Vector4& v2) const
+{
+	return _mm_cvtss_f32(simd::horizontalSum(simd::maskXYZ(_mm_mul_ps(simd::load(*this), simd::load(v2)))));
+}
+
+inline Vector4 Vector4::cross3(const Vector4& v2) const
+{
+	// a x b = (a * b.yzx - a.yzx * b).yzx
+	__m128 a = simd::load(*this), b = simd::load(v2);
+	__m128 result = _mm_sub_ps(_mm_mul_ps(a, simd::shuffleYZX(b)), _mm_mul_ps(simd::shuffleYZX(a), b));
+	return simd::store(simd::maskXYZ(simd::shuffleYZX(result)));
+}
+
+inline float Vector4::length3() const
+{
+	return sqrtf(dot3(*this));
+}
+
+inline Vector4 Vector4::normalised3() const
+{
+	__m128 v = simd::load(*this);
+	__m128 length = _mm_sqrt_ps(simd::horizontalSum(simd::maskXYZ(_mm_mul_ps(v, v))));
+	if (_mm_cvtss_f32(length) == 0.0f)
+	{
+		return *this;
+	}
+	Vector4 result = simd::store(_mm_div_ps(v, length));
+	result.w = w;
+	return result;
+}
+
+inline Vector4 Matrix4::transform(const Vector4& v) const
+{
+	__m128 result = _mm_mul_ps(_mm_loadu_ps(m), _mm_set1_ps(v.x));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(m + 4), _mm_set1_ps(v.y)));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(m + 8), _mm_set1_ps(v.z)));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(v.w)));
+	return simd::store(result);
+}
+
+inline Vector3 Matrix4::transformPoint(const Vector3& point) const
+{
+	return Vector3(m[0] * point.x + m[4] * point.y + m[8] * point.z + m[12],
+		m[1] * point.x + m[5] * point.y + m[9] * point.z + m[13],
+		m[2] * point.x + m[6] * point.y + m[10] * point.z + m[14]);
+}
+
+inline Vector3 Matrix4::transformVector(const Vector3& vector) const
+{
+	return Vector3(m[0] * vector.x + m[4] * vector.y + m[8] * vector.z,
+		m[1] * vector.x + m[5] * vector.y + m[9] * vector.z,
+		m[2] * vector.x + m[6] * vector.y + m[10] * vector.z);
+}
+
+inline const float* Matrix4::data() const
+{
+	return m;
+}
@@ -101,6 +101,11 @@ void  MeshCone::setSideColour(Colour4 colour)
 
 void MeshCone::update(float dt)
 {
+	// the matrix is only calculated again if the cone rotates
+	if (is_rotating_[0] || is_rotating_[1] || is_rotating_[2])
+	{
+		markTransformDirty();
+	}
 
 	// move the side by the time if it is rotating (moving)
 	if (is_rotating_[0]) // on the x axis
@@ -131,6 +136,10 @@ void MeshCone::update(float dt)
 
 void MeshCone::render(bool is_shadow)
 {
+	// the geometry has been evicted by the residency manager, it is rendered again when it is restored
+	if (!geometry_resident_)
+		return;
+
 	// To Turn on Wireframe to draw the lines (for test proposed) 
 	if (*shared_context_->wireframe_mode)
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // draw lines
@@ -146,7 +155,7 @@ void MeshCone::render(bool is_shadow)
 	/* Apply texture_ if this object has one */
 	if (texture_ != nullptr && !is_shadow)
 	{
-		texture_->use();
+		bindTexture();
 	}
 
 	/* Enable Arrays of coords (vertices_, normals_, textures and index) and link them */
@@ -172,21 +181,11 @@ void MeshCone::render(bool is_shadow)
 	// remember where we are
 	glPushMatrix();
 
-		// translate the shape
-		glTranslatef(translation_.x, translation_.y, translation_.z);
-
-		// rotate on the x axis
-		glRotatef(rotation_angles_.x, 1.0f, 0.0f, 0.0f);
-		// rotate on the y axis
-		glRotatef(rotation_angles_.y, 0.0f, 1.0f, 0.0f);
-		// rotate on the z axis
-		glRotatef(rotation_angles_.z, 0.0f, 0.0f, 1.0f);
-
-		// scale the shape
-		glScalef(scale_.x, scale_.y, scale_.z);
+		// translate, rotate and scale the shape (cached matrix)
+		applyTransform();
 
 		/* DRAWING THE SIDE*/
-		glDrawElements(GL_TRIANGLES, (unsigned int)indices_.size(), GL_UNSIGNED_INT, indices_.data()); // method 3 of dereference
+		drawGeometry();
 
 		/* DRAWING THE BASE DISC*/
 		if (base_disc_ != nullptr)
@@ -217,7 +216,7 @@ void MeshCone::render(bool is_shadow)
 	/* Stop using the texture_ if this object has one*/
 	if (texture_ != nullptr && !is_shadow)
 	{
-		texture_->stopUsing();
+		unbindTexture();
 	}
 
 	/* reset to white colour */
@@ -243,6 +242,99 @@ void MeshCone::setSharedContext(SharedContext* shared_context)
 	shared_context_ = shared_context;
 }
 
+void MeshCone::remapTextureCoordsToAtlas()
+{
+	/* Remap the base disc*/
+	if (base_disc_ != nullptr)
+	{
+		base_disc_->remapTextureCoordsToAtlas();
+	}
+
+	/* Remap the top disc*/
+	if (top_disc_ != nullptr)
+	{
+		top_disc_->remapTextureCoordsToAtlas();
+	}
+
+	// remap the side
+	BaseMesh::remapTextureCoordsToAtlas();
+}
+
+void MeshCone::getTextures(vector<Texture*>& textures) const
+{
+	if (base_disc_ != nullptr)
+	{
+		base_disc_->getTextures(textures);
+	}
+	if (top_disc_ != nullptr)
+	{
+		top_disc_->getTextures(textures);
+	}
+	BaseMesh::getTextures(textures);
+}
+
+bool MeshCone::isGroupable() const
+{
+	return base_disc_ == nullptr && top_disc_ == nullptr;
+}
+
+bool MeshCone::getStaticParts(const Matrix4& parent_matrix, vector<StaticPart>& parts) const
+{
+	// the discs are rendered with the transformation of the cone
+	Matrix4 matrix = parent_matrix * Matrix4(getLocalMatrix());
+	if (!addStaticPart(matrix, GL_TRIANGLES, parts))
+	{
+		return false;
+	}
+	if (base_disc_ != nullptr && !base_disc_->getStaticParts(matrix, parts))
+	{
+		return false;
+	}
+	return top_disc_ == nullptr || top_disc_->getStaticParts(matrix, parts);
+}
+
+void MeshCone::drawGeometry() const
+{
+	glDrawElements(GL_TRIANGLES, (unsigned int)indices_.size(), GL_UNSIGNED_INT, indices_.data()); // method 3 of dereference
+	num_draws_++;
+}
+
+void MeshCone::getLocalTriangles(vector<float>& triangles) const
+{
+	if (base_disc_ != nullptr)
+	{
+		base_disc_->getTriangles(triangles);
+	}
+	if (top_disc_ != nullptr)
+	{
+		top_disc_->getTriangles(triangles);
+	}
+	BaseMesh::getLocalTriangles(triangles);
+}
+
+bool MeshCone::computeLocalBoundingSphere(Vector3& center, float& radius)
+{
+	vector<pair<Vector3, float>> spheres;
+	Vector3 disc_center;
+	float disc_radius;
+
+	if (base_disc_ != nullptr)
+		base_disc_->updateBounds();
+	if (top_disc_ != nullptr)
+		top_disc_->updateBounds();
+
+	if (base_disc_ != nullptr && base_disc_->getBoundingSphere(disc_center, disc_radius))
+	{
+		spheres.push_back(make_pair(disc_center, disc_radius));
+	}
+	if (top_disc_ != nullptr && top_disc_->getBoundingSphere(disc_center, disc_radius))
+	{
+		spheres.push_back(make_pair(disc_center, disc_radius));
+	}
+
+	return computeBoundingSphere(vertices_, spheres, center, radius);
+}
+
 void MeshCone::initVertexAndNormalCoords(bool has_top_disc, bool has_base_disc)
 {
 	float x, y=0, z; // x, y and z vertex coords
@@ -351,4 +443,11 @@ void MeshCone::initSideTextureCoords()
 		}
 	}
 
-}
\ No newline at end of file
+}
+
+void MeshCone::getShadowProxyTriangles(vector<float>& triangles) const
+{
+	int latitudinal_segments = (latitudinal_segments_ < 24) ? latitudinal_segments_ : 24;
+	MeshCone proxy(base_r_, top_r_, h_, 1, latitudinal_segments, top_disc_ != nullptr, base_disc_ != nullptr);
+	proxy.getLocalTriangles(triangles);
+}
@@ -68,14 +68,38 @@ public:
 	// set the shared context, which can be used for the input, wireframe_mode, etc
 	void setSharedContext(SharedContext* shared_context);
 
+	// remap the texture coords of the side, base and top parts into the texture atlas
+	void remapTextureCoordsToAtlas() override;
+
+	// textures of the side and the discs
+	void getTextures(vector<Texture*>& textures) const override;
+
+	// triangles of the side and the discs
+	void getLocalTriangles(vector<float>& triangles) const override;
+
+	// only the cones without discs can be drawn in a group (the discs have their own arrays)
+	bool isGroupable() const override;
+
+	// the side and the discs in world space
+	bool getStaticParts(const Matrix4& parent_matrix, vector<StaticPart>& parts) const override;
+
 
 private:
 
 	/** SPEFIFIC CHARACTERISTICS OF THIS MESH */
 
 	// base and top of this shape
-	MeshDisc* base_disc_;
-	MeshDisc* top_disc_;
+	MeshDisc* base_disc_ = nullptr;
+	MeshDisc* top_disc_ = nullptr;
+
+	// the bounds are the ones of the side and the discs
+	bool computeLocalBoundingSphere(Vector3& center, float& radius) override;
+
+	// the shadow proxy is the same cone with one segment along the height (the side is straight) and less segments around it
+	void getShadowProxyTriangles(vector<float>& triangles) const override;
+
+	// draw the side (indexed triangles)
+	void drawGeometry() const override;
 
 	// radius and number of segments of the sphere the shape
 	float base_r_, top_r_;
@@ -142,18 +142,8 @@ void MeshCube::render(bool is_shadow)
 	// remember where we are
 	glPushMatrix();
 
-		// translate the cube
-		glTranslatef(translation_.x, translation_.y, translation_.z);
-
-		// rotate on the x axis
-		glRotatef(rotation_angles_.x, 1.0f, 0.0f, 0.0f);
-		// rotate on the y axis
-		glRotatef(rotation_angles_.y, 0.0f, 1.0f, 0.0f);
-		// rotate on the z axis
-		glRotatef(rotation_angles_.z, 0.0f, 0.0f, 1.0f);
-
-		// scale the object
-		glScalef(scale_.x, scale_.y, scale_.z);
+		// translate, rotate and scale the shape (cached matrix)
+		applyTransform();
 
 		// remember where we are
 		glPushMatrix();
@@ -188,7 +178,86 @@ void MeshCube::setSharedContext(SharedContext* shared_context)
 	shared_context_ = shared_context;
 }
 
+void MeshCube::remapTextureCoordsToAtlas()
+{
+	// the faces have the coords, the cube is only a container
+	for (const std::pair<CubeFace, MeshPlane*> face : faces_)
+	{
+		face.second->remapTextureCoordsToAtlas();
+	}
+}
+
+void MeshCube::getTextures(vector<Texture*>& textures) const
+{
+	for (const std::pair<CubeFace, MeshPlane*> face : faces_)
+	{
+		face.second->getTextures(textures);
+	}
+}
+
+void MeshCube::getLocalTriangles(vector<float>& triangles) const
+{
+	size_t first = triangles.size();
+	for (const std::pair<CubeFace, MeshPlane*> face : faces_)
+	{
+		face.second->getTriangles(triangles);
+	}
+
+	// same translation as render()
+	if (is_rotating_[1])
+	{
+		for (size_t i = first; i + 2 < triangles.size(); i += 3)
+		{
+			triangles[i] -= dimension_ / 2.0f;
+			triangles[i + 2] += dimension_ / 2.0f;
+		}
+	}
+}
+
+bool MeshCube::computeLocalBoundingSphere(Vector3& center, float& radius)
+{
+	vector<pair<Vector3, float>> spheres;
+	for (const std::pair<CubeFace, MeshPlane*> face : faces_)
+	{
+		Vector3 face_center;
+		float face_radius;
+		face.second->updateBounds();
+		if (face.second->getBoundingSphere(face_center, face_radius))
+		{
+			// same translation as render()
+			if (is_rotating_[1])
+				face_center.add(Vector3(-dimension_ / 2.0f, 0.0f, dimension_ / 2.0f));
+
+			spheres.push_back(make_pair(face_center, face_radius));
+		}
+	}
+
+	return computeBoundingSphere(vertices_, spheres, center, radius);
+}
+
 BaseMesh* MeshCube::clone() const
 {
 	return new MeshCube(*this);
+}
+
+bool MeshCube::isGroupable() const
+{
+	return false;
+}
+
+bool MeshCube::getStaticParts(const Matrix4& parent_matrix, vector<StaticPart>& parts) const
+{
+	// same transformations as render()
+	Matrix4 matrix = parent_matrix * Matrix4(getLocalMatrix());
+	if (is_rotating_[1])
+	{
+		matrix = matrix * Matrix4::translation(Vector3(-dimension_ / 2.0f, 0.0f, dimension_ / 2.0f));
+	}
+
+	for (const std::pair<CubeFace, MeshPlane*> face : faces_)
+	{
+		if (!face.second->getStaticParts(matrix, parts))
+			return false;
+	}
+	return true;
 }
\ No newline at end of file
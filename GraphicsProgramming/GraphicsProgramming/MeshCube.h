@@ -56,9 +56,24 @@ public:
 	// set the shared context, which can be used for the input, wireframe_mode, etc
 	void setSharedContext(SharedContext* shared_context);
 
+	// remap the texture coords of all the faces into the texture atlas
+	void remapTextureCoordsToAtlas() override;
+
+	// the textures are in the faces
+	void getTextures(vector<Texture*>& textures) const override;
+
+	// the triangles are in the faces
+	void getLocalTriangles(vector<float>& triangles) const override;
+
 	// return a clone of this shape
 	BaseMesh* clone() const;
 
+	// the faces are drawn by themselves, so the cube cannot be drawn in a group
+	bool isGroupable() const override;
+
+	// the faces in world space
+	bool getStaticParts(const Matrix4& parent_matrix, vector<StaticPart>& parts) const override;
+
 
 private:
 	/** CHARACTERISTICS OF THE CUBE */
@@ -69,4 +84,7 @@ private:
 
 	// collection of six faces
 	map<CubeFace, MeshPlane*> faces_;
+
+	// the bounds are the ones of the faces (moved to the center if the cube is rotating in y-axis)
+	bool computeLocalBoundingSphere(Vector3& center, float& radius) override;
 };
@@ -20,6 +20,18 @@ MeshMirrorWorld::~MeshMirrorWorld()
 	// delete mirror component
 	delete mirror_obj_;
 	mirror_obj_ = nullptr;
+
+	// delete the reflection texture
+	if (reflection_texture_ != 0)
+	{
+		glDeleteTextures(1, &reflection_texture_);
+	}
+
+	// delete the occlusion query
+	if (occlusion_query_ != 0)
+	{
+		GLExtensions::deleteQueries(1, &occlusion_query_);
+	}
 }
 
 void MeshMirrorWorld::initPlaneMirror(Facing facing, int height, int width)
@@ -28,7 +40,9 @@ void MeshMirrorWorld::initPlaneMirror(Facing facing, int height, int width)
 	if (mirror_obj_ == nullptr)
 	{
 		facing_ = facing;
-		mirror_obj_ = new MeshPlane(facing, height, width);
+		MeshPlane* plane = new MeshPlane(facing, height, width);
+		local_normal_ = plane->getNormal();
+		mirror_obj_ = plane;
 	}
 }
 
@@ -41,6 +55,7 @@ void MeshMirrorWorld::initDiscMirror(Facing facing, float radius, int num_triang
 
 		// create the mirror
 		mirror_obj_ = new MeshDisc(radius, num_triangles);
+		local_normal_ = Vector3(0.0f, 0.0f, 1.0f); // the rotation of the disc is applied by its matrix
 
 		if (facing == Facing::kForward)
 		{
@@ -91,60 +106,68 @@ void MeshMirrorWorld::createReflection(BaseMesh* original_shape_to_copy, bool in
 	original_shape_container_.insert(make_pair(last_shape_copy_id_, original_shape_to_copy));
 }
 
+void MeshMirrorWorld::addReflectedShape(BaseMesh* original_shape)
+{
+	reflected_shapes_.push_back(original_shape);
+}
+
 void MeshMirrorWorld::update(float dt)
 {
 	float dist_mirror_to_original_shape; // distance between the mirror and the original shape, it has to be the same as the distance between the copy and the mirror
 
-	// update the 
+	// mirror world
+	Vector3 mirror_translation = mirror_obj_->getTranslation();
+
+	// update the copies (the shapes reflected with the matrix don't need it)
 	for (auto shape_copy : shape_copy_container_)
 	{
-		// update the position of the copy, copying the position of the original shape
-		shape_copy.second->copyMovementComponents(original_shape_container_[shape_copy.first]);
+		// the original of the copy, it is found only once
+		BaseMesh* original_shape = original_shape_container_[shape_copy.first];
 
-		// mirror world
-		Vector3 mirror_translation = mirror_obj_->getTranslation();
+		// update the position of the copy, copying the position of the original shape
+		shape_copy.second->copyMovementComponents(original_shape);
 
 		// set the position of the copy behind the mirror, the mirror is always looking at the original
 
 		// the original is up and the copy is down
 		if (facing_ == Facing::kUp)
 		{
-			dist_mirror_to_original_shape = abs(original_shape_container_[shape_copy.first]->getTranslation().y - mirror_translation.y);
+			dist_mirror_to_original_shape = abs(original_shape->getTranslation().y - mirror_translation.y);
 
 			shape_copy.second->setTranslationY(-dist_mirror_to_original_shape + mirror_translation.y ); // set the copy under the mirror
 		}
 		// the original is down and the copy is up
 		else if (facing_ == Facing::kDown)
 		{
-			dist_mirror_to_original_shape = abs(original_shape_container_[shape_copy.first]->getTranslation().y - mirror_translation.y);
+			dist_mirror_to_original_shape = abs(original_shape->getTranslation().y - mirror_translation.y);
 
 			shape_copy.second->setTranslationY(dist_mirror_to_original_shape + mirror_translation.y); // set the copy above the mirror
 		}
 		// the original is left and the copy is right
 		else if (facing_ == Facing::kLeft)
 		{
-			dist_mirror_to_original_shape = abs(original_shape_container_[shape_copy.first]->getTranslation().x - mirror_translation.x);
+			dist_mirror_to_original_shape = abs(original_shape->getTranslation().x - mirror_translation.x);
 
 			shape_copy.second->setTranslationX(dist_mirror_to_original_shape + mirror_translation.x); // set the copy rigth to the mirror
 		}
 		// the original is right and the copy is left
 		else if (facing_ == Facing::kRight)
 		{
-			dist_mirror_to_original_shape = abs(original_shape_container_[shape_copy.first]->getTranslation().x - mirror_translation.x);
+			dist_mirror_to_original_shape = abs(original_shape->getTranslation().x - mirror_translation.x);
 
 			shape_copy.second->setTranslationX(-dist_mirror_to_original_shape + mirror_translation.x); // set the copy under the mirror
 		}
 		// the original is front and the copy is back
 		else if (facing_ == Facing::kBackward)
 		{
-			dist_mirror_to_original_shape = abs(original_shape_container_[shape_copy.first]->getTranslation().z - mirror_translation.z);
+			dist_mirror_to_original_shape = abs(original_shape->getTranslation().z - mirror_translation.z);
 
 			shape_copy.second->setTranslationZ(-dist_mirror_to_original_shape + mirror_translation.z); // set the copy under the mirror
 		}
 		// the original is back and the copy is front
 		else if (facing_ == Facing::kForward)
 		{
-			dist_mirror_to_original_shape = abs(original_shape_container_[shape_copy.first]->getTranslation().z - mirror_translation.z);
+			dist_mirror_to_original_shape = abs(original_shape->getTranslation().z - mirror_translation.z);
 
 			shape_copy.second->setTranslationZ(dist_mirror_to_original_shape + mirror_translation.z); // set the copy under the mirror
 		}
@@ -170,6 +193,494 @@ void MeshMirrorWorld::setColour(Colour4 colour)
 	mirror_obj_->setColour(colour);
 }
 
+void MeshMirrorWorld::remapTextureCoordsToAtlas()
+{
+	for (auto shape_copy : shape_copy_container_)
+	{
+		shape_copy.second->remapTextureCoordsToAtlas();
+	}
+
+	mirror_obj_->remapTextureCoordsToAtlas();
+}
+
+void MeshMirrorWorld::setMode(MirrorMode mode)
+{
+	mode_ = mode;
+
+	// the texture is rendered again when the mode is set back to texture (it was not updated meanwhile)
+	has_reflection_ = false;
+}
+
+MirrorMode MeshMirrorWorld::getMode() const
+{
+	return mode_;
+}
+
+void MeshMirrorWorld::setReflectionTextureScale(float scale)
+{
+	reflection_scale_ = (scale < 0.05f) ? 0.05f : (scale > 1.0f) ? 1.0f : scale;
+}
+
+void MeshMirrorWorld::setReflectionUpdateInterval(int frames)
+{
+	update_interval_ = (frames < 1) ? 1 : frames;
+}
+
+int MeshMirrorWorld::getNumReflectionUpdates() const
+{
+	return num_reflection_updates_;
+}
+
+bool MeshMirrorWorld::hasReflectionChanged(unsigned int lights_version)
+{
+	bool changed = false;
+
+	// camera
+	float view[16], projection[16];
+	glGetFloatv(GL_MODELVIEW_MATRIX, view);
+	glGetFloatv(GL_PROJECTION_MATRIX, projection);
+	for (int i = 0; i < 16; i++)
+	{
+		if (view[i] != view_[i] || projection[i] != projection_[i])
+		{
+			changed = true;
+		}
+		view_[i] = view[i];
+		projection_[i] = projection[i];
+	}
+
+	// lights
+	if (lights_version != lights_version_)
+	{
+		changed = true;
+		lights_version_ = lights_version;
+	}
+
+	// mirror and copies (the matrix of each one, one after the other)
+	size_t num_floats = (shape_copy_container_.size() + reflected_shapes_.size() + 1) * 16;
+	if (transforms_.size() != num_floats)
+	{
+		transforms_.assign(num_floats, 0.0f);
+		changed = true;
+	}
+	float matrix[16];
+	size_t offset = 0;
+	mirror_obj_->getTransformMatrix(matrix);
+	for (int i = 0; i < 16; i++, offset++)
+	{
+		changed |= (transforms_[offset] != matrix[i]);
+		transforms_[offset] = matrix[i];
+	}
+	for (auto shape_copy : shape_copy_container_)
+	{
+		shape_copy.second->getTransformMatrix(matrix);
+		for (int i = 0; i < 16; i++, offset++)
+		{
+			changed |= (transforms_[offset] != matrix[i]);
+			transforms_[offset] = matrix[i];
+		}
+	}
+	for (BaseMesh* shape : reflected_shapes_)
+	{
+		shape->getTransformMatrix(matrix);
+		for (int i = 0; i < 16; i++, offset++)
+		{
+			changed |= (transforms_[offset] != matrix[i]);
+			transforms_[offset] = matrix[i];
+		}
+	}
+
+	return changed;
+}
+
+bool MeshMirrorWorld::updateReflectionTexture(unsigned int lights_version)
+{
+	// the texture is kept while the reflections can't be seen
+	if (mode_ != MirrorMode::kRenderToTexture || mirror_obj_ == nullptr || !reflections_visible_)
+	{
+		return false;
+	}
+
+	// the changes are always checked (and saved), so a change during the interval is not lost
+	frames_since_update_++;
+	bool changed = hasReflectionChanged(lights_version);
+
+	/* Size of the reflection, it is a part of the window */
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	int width = (int)(viewport[2] * reflection_scale_);
+	int height = (int)(viewport[3] * reflection_scale_);
+	width = (width > 1) ? width : 1;
+	height = (height > 1) ? height : 1;
+
+	if (width != reflection_width_ || height != reflection_height_)
+	{
+		// the texture must be a power of two (openGL 1.1)
+		int texture_width = 1, texture_height = 1;
+		while (texture_width < width) texture_width *= 2;
+		while (texture_height < height) texture_height *= 2;
+
+		if (reflection_texture_ == 0)
+		{
+			glGenTextures(1, &reflection_texture_);
+		}
+		if (texture_width != texture_width_ || texture_height != texture_height_)
+		{
+			Texture::bindTextureObject(reflection_texture_);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, texture_width, texture_height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+			texture_width_ = texture_width;
+			texture_height_ = texture_height;
+		}
+		reflection_width_ = width;
+		reflection_height_ = height;
+		has_reflection_ = false;
+	}
+
+	// keep the last reflection if nothing has moved or it was updated recently
+	if (has_reflection_ && (!changed || frames_since_update_ < update_interval_))
+	{
+		if (changed)
+		{
+			// render it as soon as the interval finishes, even if nothing moves then
+			transforms_.clear();
+		}
+		return false;
+	}
+
+	/* Render the copies with the camera in a smaller viewport and copy them into the texture */
+
+	glViewport(0, 0, reflection_width_, reflection_height_);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	renderReflections();
+
+	Texture::bindTextureObject(reflection_texture_);
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, reflection_width_, reflection_height_);
+
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+	/* texture matrix = scale * bias * projection * view, the bias moves the coords from [-1, 1] to [0, 1]
+	   and the scale to the part of the texture which has the reflection */
+
+	float scale_s = (float)reflection_width_ / texture_width_;
+	float scale_t = (float)reflection_height_ / texture_height_;
+	float scale_bias[16] = { 0.5f * scale_s, 0.0f, 0.0f, 0.0f,
+		0.0f, 0.5f * scale_t, 0.0f, 0.0f,
+		0.0f, 0.0f, 0.5f, 0.0f,
+		0.5f * scale_s, 0.5f * scale_t, 0.5f, 1.0f };
+	float scale_bias_projection[16];
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			scale_bias_projection[column * 4 + row] = 0.0f;
+			texture_matrix_[column * 4 + row] = 0.0f;
+			for (int k = 0; k < 4; k++)
+			{
+				scale_bias_projection[column * 4 + row] += scale_bias[k * 4 + row] * projection_[column * 4 + k];
+			}
+		}
+	}
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			for (int k = 0; k < 4; k++)
+			{
+				texture_matrix_[column * 4 + row] += scale_bias_projection[k * 4 + row] * view_[column * 4 + k];
+			}
+		}
+	}
+
+	has_reflection_ = true;
+	frames_since_update_ = 0;
+	num_reflection_updates_++;
+	return true;
+}
+
+void MeshMirrorWorld::getReflectionPlane(float plane[4])
+{
+	// move the normal and the origin of the mirror to the world
+	float matrix[16];
+	mirror_obj_->getTransformMatrix(matrix);
+	Vector3 normal(matrix[0] * local_normal_.x + matrix[4] * local_normal_.y + matrix[8] * local_normal_.z,
+		matrix[1] * local_normal_.x + matrix[5] * local_normal_.y + matrix[9] * local_normal_.z,
+		matrix[2] * local_normal_.x + matrix[6] * local_normal_.y + matrix[10] * local_normal_.z);
+	normal = normal.normalised();
+
+	plane[0] = normal.x;
+	plane[1] = normal.y;
+	plane[2] = normal.z;
+	plane[3] = -(normal.x * matrix[12] + normal.y * matrix[13] + normal.z * matrix[14]);
+}
+
+void MeshMirrorWorld::setUseOcclusionQuery(bool use_occlusion_query)
+{
+	use_occlusion_query_ = use_occlusion_query;
+}
+
+bool MeshMirrorWorld::isMirrorVisible() const
+{
+	return mirror_visible_;
+}
+
+bool MeshMirrorWorld::areReflectionsVisible() const
+{
+	return mirror_visible_ && reflections_visible_;
+}
+
+int MeshMirrorWorld::getNumCulledShapes() const
+{
+	return num_culled_shapes_;
+}
+
+bool MeshMirrorWorld::computeLocalCorners()
+{
+	vector<float> triangles;
+	mirror_obj_->getLocalTriangles(triangles);
+	if (triangles.empty())
+	{
+		return false;
+	}
+
+	// two axes in the plane of the mirror
+	Vector3 normal = local_normal_;
+	Vector3 axis = (fabsf(normal.x) < 0.9f) ? Vector3(1.0f, 0.0f, 0.0f) : Vector3(0.0f, 1.0f, 0.0f);
+	Vector3 u = normal.cross(axis).normalised();
+	Vector3 v = normal.cross(u);
+
+	// rectangle which contains all the vertices (for a disc it is the square around it)
+	float min_u = 1e30f, max_u = -1e30f, min_v = 1e30f, max_v = -1e30f;
+	for (size_t i = 0; i + 2 < triangles.size(); i += 3)
+	{
+		Vector3 vertex(triangles[i], triangles[i + 1], triangles[i + 2]);
+		float vertex_u = vertex.dot(u), vertex_v = vertex.dot(v);
+		min_u = fminf(min_u, vertex_u);
+		max_u = fmaxf(max_u, vertex_u);
+		min_v = fminf(min_v, vertex_v);
+		max_v = fmaxf(max_v, vertex_v);
+	}
+
+	// in order around the rectangle
+	local_corners_[0] = u * min_u + v * min_v;
+	local_corners_[1] = u * max_u + v * min_v;
+	local_corners_[2] = u * max_u + v * max_v;
+	local_corners_[3] = u * min_u + v * max_v;
+	has_local_corners_ = true;
+	return true;
+}
+
+void MeshMirrorWorld::updateBounds()
+{
+	if (mirror_obj_ != nullptr)
+	{
+		mirror_obj_->updateBounds();
+	}
+	for (auto shape_copy : shape_copy_container_)
+	{
+		shape_copy.second->updateBounds();
+	}
+}
+
+bool MeshMirrorWorld::getBoundingSphere(Vector3& center, float& radius) const
+{
+	return mirror_obj_ != nullptr && mirror_obj_->getBoundingSphere(center, radius);
+}
+
+const vector<BaseMesh*>& MeshMirrorWorld::getReflectedShapes() const
+{
+	return reflected_shapes_;
+}
+
+void MeshMirrorWorld::cull(const Frustum& frustum)
+{
+	num_culled_shapes_ = 0;
+	has_reflection_frustum_ = false;
+
+	/* The mirror is in the view */
+
+	Vector3 center;
+	float radius;
+	bool has_bounds = mirror_obj_->getBoundingSphere(center, radius);
+	mirror_visible_ = !has_bounds || frustum.isSphereVisible(center, radius);
+	reflections_visible_ = mirror_visible_;
+	if (!mirror_visible_)
+	{
+		return;
+	}
+
+	/* The camera is in front of the mirror and the mirror is big enough on the screen */
+
+	float plane[4];
+	getReflectionPlane(plane);
+	Vector3 eye = frustum.getEyePosition();
+	if (plane[0] * eye.x + plane[1] * eye.y + plane[2] * eye.z + plane[3] <= 0.01f)
+	{
+		reflections_visible_ = false;
+		return;
+	}
+	if (has_bounds && frustum.getProjectedSize(center, radius) < min_projected_size_)
+	{
+		reflections_visible_ = false;
+		return;
+	}
+
+	/* Frustum from the camera through the borders of the mirror, only the reflections inside it can be seen */
+
+	if (!has_local_corners_ && !computeLocalCorners())
+	{
+		return;
+	}
+
+	float matrix[16];
+	mirror_obj_->getTransformMatrix(matrix);
+	Vector3 corners[4];
+	Vector3 corners_center;
+	for (int i = 0; i < 4; i++)
+	{
+		Vector3& local = local_corners_[i];
+		corners[i] = Vector3(matrix[0] * local.x + matrix[4] * local.y + matrix[8] * local.z + matrix[12],
+			matrix[1] * local.x + matrix[5] * local.y + matrix[9] * local.z + matrix[13],
+			matrix[2] * local.x + matrix[6] * local.y + matrix[10] * local.z + matrix[14]);
+		corners_center += corners[i] * 0.25f;
+	}
+
+	// a plane through the camera and each border, the center of the mirror is inside
+	for (int i = 0; i < 4; i++)
+	{
+		Vector3 normal = (corners[i] - eye).cross(corners[(i + 1) % 4] - eye).normalised();
+		float d = -normal.dot(eye);
+		if (normal.dot(corners_center) + d < 0.0f)
+		{
+			normal = normal * -1.0f;
+			d = -d;
+		}
+		reflection_frustum_[i][0] = normal.x;
+		reflection_frustum_[i][1] = normal.y;
+		reflection_frustum_[i][2] = normal.z;
+		reflection_frustum_[i][3] = d;
+	}
+
+	// the reflections are behind the mirror
+	for (int i = 0; i < 4; i++)
+	{
+		reflection_frustum_[4][i] = -plane[i];
+	}
+	has_reflection_frustum_ = true;
+}
+
+bool MeshMirrorWorld::isInReflectionFrustum(const Vector3& center, float radius) const
+{
+	if (!has_reflection_frustum_)
+	{
+		return true;
+	}
+
+	for (int i = 0; i < 5; i++)
+	{
+		const float* plane = reflection_frustum_[i];
+		if (plane[0] * center.x + plane[1] * center.y + plane[2] * center.z + plane[3] < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void MeshMirrorWorld::renderReflections()
+{
+	Vector3 center;
+	float radius;
+
+	// draw the copies (they are already behind the mirror)
+	for (auto shape_copy : shape_copy_container_)
+	{
+		if (shape_copy.second->getBoundingSphere(center, radius) && !isInReflectionFrustum(center, radius))
+		{
+			num_culled_shapes_++;
+			continue;
+		}
+		shape_copy.second->render();
+	}
+
+	if (reflected_shapes_.empty())
+	{
+		return;
+	}
+
+	float plane[4];
+	getReflectionPlane(plane);
+
+	// only the parts behind the mirror are kept (the clip plane is in world coords, as the modelview is the camera)
+	GLdouble clip_plane[4] = { -plane[0], -plane[1], -plane[2], -plane[3] };
+	glClipPlane(GL_CLIP_PLANE0, clip_plane);
+	glEnable(GL_CLIP_PLANE0);
+
+	// reflection matrix: p' = p - 2 * (n.p + d) * n
+	Matrix4 reflection = Matrix4::reflection(Vector4(plane[0], plane[1], plane[2], plane[3]));
+
+	glPushMatrix();
+	glMultMatrixf(reflection.data());
+
+	// the reflection changes the order of the vertices, so the front faces are clockwise
+	glFrontFace(GL_CW);
+	for (BaseMesh* shape : reflected_shapes_)
+	{
+		// the bounds of the original are reflected too
+		if (shape->getBoundingSphere(center, radius))
+		{
+			float distance = plane[0] * center.x + plane[1] * center.y + plane[2] * center.z + plane[3];
+			Vector3 reflected_center(center.x - 2.0f * distance * plane[0], center.y - 2.0f * distance * plane[1], center.z - 2.0f * distance * plane[2]);
+			if (!isInReflectionFrustum(reflected_center, radius))
+			{
+				num_culled_shapes_++;
+				continue;
+			}
+		}
+		shape->render();
+	}
+	glFrontFace(GL_CCW);
+
+	glPopMatrix();
+	glDisable(GL_CLIP_PLANE0);
+}
+
+void MeshMirrorWorld::renderWithReflectionTexture()
+{
+	Texture::bindTextureObject(reflection_texture_);
+	glEnable(GL_TEXTURE_2D);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+	// generate the coords from the eye coords, the planes are the rows of the texture matrix
+	// openGL multiplies them by the inverse of the current modelview (the camera), so the coords are calculated from the world coords
+	// and the texture is projected as the camera was when the reflection was rendered (it can be some frames old)
+	GLenum coords[4] = { GL_S, GL_T, GL_R, GL_Q };
+	GLenum gen_coords[4] = { GL_TEXTURE_GEN_S, GL_TEXTURE_GEN_T, GL_TEXTURE_GEN_R, GL_TEXTURE_GEN_Q };
+	for (int i = 0; i < 4; i++)
+	{
+		float plane[4] = { texture_matrix_[i], texture_matrix_[4 + i], texture_matrix_[8 + i], texture_matrix_[12 + i] };
+		glTexGeni(coords[i], GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
+		glTexGenfv(coords[i], GL_EYE_PLANE, plane);
+		glEnable(gen_coords[i]);
+	}
+
+	// the mirror is not lit (100% reflective object), its colour tints the reflection
+	glDisable(GL_LIGHTING);
+	mirror_obj_->render();
+	glEnable(GL_LIGHTING);
+
+	for (int i = 0; i < 4; i++)
+	{
+		glDisable(gen_coords[i]);
+	}
+	glDisable(GL_TEXTURE_2D);
+}
+
 void MeshMirrorWorld::removeShapeCopy(int shape_copy_id)
 {
 	// remove the shape copy, the pointer object and from the collection
@@ -196,44 +707,81 @@ void MeshMirrorWorld::removeShapeCopy(int shape_copy_id)
 
 void MeshMirrorWorld::render()
 {
-	// disable the depth test (we don't want to store depths values while writing to the stencil buffer)
-	glDisable(GL_DEPTH_TEST);
+	// the mirror is out of the view
+	if (!mirror_visible_)
+	{
+		return;
+	}
 
-	//  turn off writing to the frame buffer. Don't update colour
-	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	// the reflection is already in the texture
+	if (mode_ == MirrorMode::kRenderToTexture && has_reflection_ && reflections_visible_)
+	{
+		renderWithReflectionTexture();
+		return;
+	}
 
-	// enable the stencil test
-	glEnable(GL_STENCIL_TEST);
+	if (reflections_visible_)
+	{
+		// don't store depths values while writing to the stencil buffer (the depth test is kept, so only the pixels of the mirror which can be seen are written)
+		glDepthMask(GL_FALSE);
 
-	// set the stencil operation to replace values when the test passes
-	glStencilOp(GL_REPLACE, GL_REPLACE, GL_REPLACE);
+		//  turn off writing to the frame buffer. Don't update colour
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 
-	// set the stencil function to always pass
-	glStencilFunc(GL_ALWAYS, 1, 0xffffffff);
+		// enable the stencil test
+		glEnable(GL_STENCIL_TEST);
 
-	// render the mirror shape, mirror pixels just get their stencil set to 1
-	mirror_obj_->render();
+		// set the stencil operation to replace values when the depth test passes
+		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+
+		// set the stencil function to always pass
+		glStencilFunc(GL_ALWAYS, 1, 0xffffffff);
 
-	// turn on rendering to the frame buffer
-	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		// count the pixels written (if the graphics card can't do it the reflections are always rendered)
+		if (use_occlusion_query_ && !GLExtensions::hasOcclusionQueries())
+		{
+			use_occlusion_query_ = false;
+		}
+		if (use_occlusion_query_)
+		{
+			if (occlusion_query_ == 0)
+			{
+				GLExtensions::genQueries(1, &occlusion_query_);
+			}
+			GLExtensions::beginQuery(GL_SAMPLES_PASSED_ARB, occlusion_query_);
+		}
 
-	// enable depth test
-	glEnable(GL_DEPTH_TEST);
+		// render the mirror shape, mirror pixels just get their stencil set to 1
+		mirror_obj_->render();
 
-	// set stencil function to test if the value is equal to 1
-	glStencilFunc(GL_EQUAL, 1, 0xffffffff);
+		if (use_occlusion_query_)
+		{
+			// the result is needed now, it waits for the mirror (the stencil pass is cheap, so the wait is short)
+			GLExtensions::endQuery(GL_SAMPLES_PASSED_ARB);
+			GLuint num_pixels = 0;
+			GLExtensions::getQueryObjectuiv(occlusion_query_, GL_QUERY_RESULT_ARB, &num_pixels);
+			reflections_visible_ = num_pixels >= min_visible_pixels_;
+		}
 
-	// set the stencil operation to keep all values (we don't want to change the stencil)
-	glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+		// turn on rendering to the frame buffer
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDepthMask(GL_TRUE);
 
-	// draw the copies (reflections) 
-	for (auto shape_copy : shape_copy_container_)
-	{
-		shape_copy.second->render(); // draw the copies
-	}
+		if (reflections_visible_)
+		{
+			// set stencil function to test if the value is equal to 1
+			glStencilFunc(GL_EQUAL, 1, 0xffffffff);
+
+			// set the stencil operation to keep all values (we don't want to change the stencil)
+			glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 
-	// disable stencil test (no longer needed)
-	glDisable(GL_STENCIL_TEST);
+			// draw the copies and the shapes reflected with the matrix (reflections)
+			renderReflections();
+		}
+
+		// disable stencil test (no longer needed)
+		glDisable(GL_STENCIL_TEST);
+	}
 
 	// enable alpha blending (to combine the floor object with the copy shape
 	glEnable(GL_BLEND);
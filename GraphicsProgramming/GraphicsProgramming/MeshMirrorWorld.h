@@ -4,6 +4,14 @@
 // The copies are made copying the original object by using the copy() function of the mesh which return a copy of the object. It is created faster than the original as it doesn't have to create vertices or load model again.
 // The advantage of using copies for renderng instead of the original copy itself it is that we could move the copy when the original is not moving and play with this
 // The copy also can also use different texture from the original.
+// The reflection can be rendered with the stencil (the copies are rendered each frame in the pixels of the mirror) or in a texture: the copies are
+// rendered in a smaller part of the window, copied into a texture and this texture is projected onto the mirror. The texture is only rendered again
+// when the camera, the lights, the mirror or the copies have moved, and not more often than each N frames.
+// The shapes can also be reflected without copies: the original is rendered again with the reflection matrix of the plane of the mirror
+// (any orientation) and a clip plane removes the parts which would be in front of the mirror. These shapes can't have a special texture.
+// The mirror is culled each frame: it is not rendered out of the view, the reflections are not rendered if the camera is behind the mirror, the mirror
+// is too small on the screen or (with occlusion queries) no pixel of the mirror passed the depth test, and each reflected shape is checked with the
+// smaller frustum which goes from the camera through the borders of the mirror.
 // @author Francisco Diaz (FMGameDev)
 
 #pragma once
@@ -16,11 +24,21 @@
 #include "Model.h"
 #include "MeshTorus.h"
 
+// culling
+#include "Frustum.h"
+#include "GLExtensions.h"
+
 // includes for using in the containers
 #include <unordered_map>
 #include <vector>
 #include <functional>
 
+// how the reflection is rendered
+enum class MirrorMode
+{
+	kStencil, // the copies are rendered each frame in the pixels of the mirror
+	kRenderToTexture // the copies are rendered in a texture which is projected onto the mirror
+};
 
 class MeshMirrorWorld
 {
@@ -41,6 +59,9 @@ public:
 	// function to make a copy of the shape passed as a parameter
 	void createReflection(BaseMesh* shape_to_copy, bool invert_z = false, Texture* special_texture_for_copy = nullptr);
 
+	// reflect the shape without copying it, the original is rendered with the reflection matrix of the mirror
+	void addReflectedShape(BaseMesh* original_shape);
+
 	// update the mirror world
 	void update(float dt);
 
@@ -53,12 +74,118 @@ public:
 	// set colour to the mirror
 	void setColour(Colour4 colour);
 
+	// remap the texture coords of the mirror and the copies into the texture atlas
+	// the copies have their own coords (they can use a special texture) so they are remapped separately from the originals
+	void remapTextureCoordsToAtlas();
+
+	// set how the reflection is rendered
+	void setMode(MirrorMode mode);
+	MirrorMode getMode() const;
+
+	// size of the reflection texture respect the window (0.5 is half of the width and height)
+	void setReflectionTextureScale(float scale);
+
+	// minimum number of frames between two updates of the reflection texture (1 allows to update it each frame)
+	void setReflectionUpdateInterval(int frames);
+
+	// render the copies in the reflection texture if something has moved (only in kRenderToTexture mode)
+	// it must be called with the camera and the lights set and before rendering the scene, as it uses the window and clears it
+	// lights_version: number which changes when a light moves (so the copies are lit in a different way)
+	// return true if the texture has been rendered (the window has to be cleared and the lights rendered again)
+	bool updateReflectionTexture(unsigned int lights_version);
+
+	// number of times the reflection texture has been rendered
+	int getNumReflectionUpdates() const;
+
+	// check if the mirror and its reflections can be seen, it must be called after updating the frustum and before rendering
+	void cull(const Frustum& frustum);
+
+	// use occlusion queries to skip the reflections when the mirror is hidden by other objects (if the graphics card supports them)
+	void setUseOcclusionQuery(bool use_occlusion_query);
+
+	// stats of the last frame
+	bool isMirrorVisible() const; // the mirror is in the view
+	bool areReflectionsVisible() const; // the reflections have been rendered
+	int getNumCulledShapes() const; // reflected shapes out of the frustum of the mirror
+
+	// calculate the bounds of the mirror and its copies of the shapes (BaseMesh::updateBounds()), in a serial step after update()
+	void updateBounds();
+
+	// sphere of the mirror in world coords, it returns false if it has no bounds yet
+	bool getBoundingSphere(Vector3& center, float& radius) const;
+
+	// shapes reflected with the reflection matrix (they are rendered again, so they use the geometry of the original)
+	const vector<BaseMesh*>& getReflectedShapes() const;
+
 	// render mirror
 	void render();
 
 private:
 	Facing facing_; // position real objet respect the mirror world and normal facing 
-	BaseMesh* mirror_obj_;
+	BaseMesh* mirror_obj_ = nullptr;
+	Vector3 local_normal_; // normal of the mirror before moving it (the mirror passes by its origin)
+
+	// shapes reflected without copies
+	vector<BaseMesh*> reflected_shapes_;
+
+	// plane of the mirror in world coords (a, b, c, d: a*x + b*y + c*z + d = 0, the normal is facing the reflected shapes)
+	void getReflectionPlane(float plane[4]);
+
+	// render the copies and the shapes reflected with the reflection matrix
+	void renderReflections();
+
+	/* Culling */
+
+	bool mirror_visible_ = true;
+	bool reflections_visible_ = true;
+	int num_culled_shapes_ = 0;
+	float min_projected_size_ = 4.0f; // pixels, smaller mirrors are not reflecting
+	GLuint min_visible_pixels_ = 8; // pixels of the mirror which must pass the depth test to render the reflections
+
+	// occlusion query of the pixels of the mirror
+	bool use_occlusion_query_ = true;
+	GLuint occlusion_query_ = 0;
+
+	// corners of the mirror (before moving it), they are calculated once from the triangles of the mirror
+	bool has_local_corners_ = false;
+	Vector3 local_corners_[4];
+
+	// frustum from the camera through the corners of the mirror (planes with the normal pointing inside, the last one is the mirror)
+	bool has_reflection_frustum_ = false;
+	float reflection_frustum_[5][4];
+
+	// calculate the corners of the mirror (the rectangle in its plane which contains all its vertices)
+	bool computeLocalCorners();
+
+	// return true if the sphere is inside or intersects the frustum of the mirror
+	bool isInReflectionFrustum(const Vector3& center, float radius) const;
+
+	/* Render to texture */
+
+	MirrorMode mode_ = MirrorMode::kStencil;
+	GLuint reflection_texture_ = 0;
+	int texture_width_ = 0, texture_height_ = 0; // size of the texture (power of two)
+	int reflection_width_ = 0, reflection_height_ = 0; // size of the part of the texture which has the reflection
+	float reflection_scale_ = 0.5f;
+	int update_interval_ = 1;
+	int frames_since_update_ = 0;
+	int num_reflection_updates_ = 0;
+	bool has_reflection_ = false;
+
+	// camera, lights, mirror and copies of the last check, to know if the texture is still valid
+	float view_[16];
+	float projection_[16];
+	unsigned int lights_version_ = 0;
+	vector<float> transforms_;
+
+	// matrix which moves the world coords to the coords of the reflection texture (scale * bias * projection * view)
+	float texture_matrix_[16];
+
+	// return true if the camera, the lights, the mirror or the copies have changed since the last reflection (and save them)
+	bool hasReflectionChanged(unsigned int lights_version);
+
+	// render the mirror with the reflection texture projected onto it
+	void renderWithReflectionTexture();
 
 	// container with all the shapes with linked to its id
 	using ShapeContainer = unordered_map<int, BaseMesh*>; // <shape ID, Copy>
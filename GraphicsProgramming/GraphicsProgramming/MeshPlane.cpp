@@ -125,18 +125,8 @@ void MeshPlane::render(bool is_shadow)
 	// remember where we are
 	glPushMatrix();
 
-		// translate the plane
-		glTranslatef(translation_.x, translation_.y, translation_.z);
-
-		// rotate on the x axis
-		glRotatef(rotation_angles_.x, 1.0f, 0.0f, 0.0f);
-		// rotate on the y axis
-		glRotatef(rotation_angles_.y, 0.0f, 1.0f, 0.0f);
-		// rotate on the z axis
-		glRotatef(rotation_angles_.z, 0.0f, 0.0f, 1.0f);
-
-		// scale the object
-		glScalef(scale_.x, scale_.y, scale_.z);
+		// translate, rotate and scale the shape (cached matrix)
+		applyTransform();
 
 		// render the rectangle itself
 		rectangle_->render(is_shadow);
@@ -145,6 +135,16 @@ void MeshPlane::render(bool is_shadow)
 	glPopMatrix();
 }
 
+bool MeshPlane::isGroupable() const
+{
+	return false;
+}
+
+bool MeshPlane::getStaticParts(const Matrix4& parent_matrix, vector<StaticPart>& parts) const
+{
+	return rectangle_->getStaticParts(parent_matrix * Matrix4(getLocalMatrix()), parts);
+}
+
 void MeshPlane::setSharedContext(SharedContext* shared_context)
 {
 	/* Set shared context in the rectangle*/
@@ -164,6 +164,27 @@ void MeshPlane::setColour(Colour4 colour)
 	rectangle_->setColour(colour);
 }
 
+void MeshPlane::remapTextureCoordsToAtlas()
+{
+	rectangle_->remapTextureCoordsToAtlas();
+}
+
+void MeshPlane::getTextures(vector<Texture*>& textures) const
+{
+	rectangle_->getTextures(textures);
+}
+
+void MeshPlane::getLocalTriangles(vector<float>& triangles) const
+{
+	rectangle_->getTriangles(triangles);
+}
+
+bool MeshPlane::computeLocalBoundingSphere(Vector3& center, float& radius)
+{
+	rectangle_->updateBounds();
+	return rectangle_->getBoundingSphere(center, radius);
+}
+
 vector<float> MeshPlane::getPQRVertices()
 {
 	vector<float> PQRVectices;
@@ -203,4 +224,24 @@ vector<float> MeshPlane::getPQRVertices()
 		break;
 	}
 	return PQRVectices;
-}
\ No newline at end of file
+}
+
+Vector3 MeshPlane::getNormal() const
+{
+	switch (facing_)
+	{
+	case Facing::kDown:
+		return Vector3(0.0f, -1.0f, 0.0f);
+	case Facing::kBackward:
+		return Vector3(0.0f, 0.0f, 1.0f);
+	case Facing::kForward:
+		return Vector3(0.0f, 0.0f, -1.0f);
+	case Facing::kLeft:
+		return Vector3(-1.0f, 0.0f, 0.0f);
+	case Facing::kRight:
+		return Vector3(1.0f, 0.0f, 0.0f);
+	case Facing::kUp:
+	default:
+		return Vector3(0.0f, 1.0f, 0.0f);
+	}
+}
@@ -33,6 +33,12 @@ public:
 	// render the real plane
 	void render(bool is_shadow = false) override;
 
+	// the plane is drawn by its rectangle, so it cannot be drawn in a group
+	bool isGroupable() const override;
+
+	// the rectangle in world space
+	bool getStaticParts(const Matrix4& parent_matrix, vector<StaticPart>& parts) const override;
+
 	// set the shared context, which can be used for the input, wireframe_mode, etc
 	void setSharedContext(SharedContext* shared_context);
 
@@ -42,14 +48,29 @@ public:
 	// set the colour (red, green, blue, alpha) in the rectangle object
 	void setColour(Colour4 colour);
 
+	// remap the texture coords of the rectangle object into the texture atlas
+	void remapTextureCoordsToAtlas() override;
+
+	// the texture is in the rectangle
+	void getTextures(vector<Texture*>& textures) const override;
+
+	// the triangles are in the rectangle
+	void getLocalTriangles(vector<float>& triangles) const override;
+
 	// return the PQR vertices of the rectangle component
 	// it set the vertices depending on the translation and the facing component
 	// if the plane mesh plane (not rectangle) is rotate then this function will need to be updated to take into account the plane rotation
 	vector<float> getPQRVertices();
 
+	// return the normal of the plane (world coords), it depends on the facing component
+	Vector3 getNormal() const;
+
 protected:
 	/** CHARACTERISTICS OF THE MeshPlane */
 	Facing facing_; // component to detect/set the orientation of the plane (by the normal facing)
 	MeshRectangle* rectangle_; // it contain the plane/rectangle itself
+
+	// the bounds are the ones of the rectangle
+	bool computeLocalBoundingSphere(Vector3& center, float& radius) override;
 };
 
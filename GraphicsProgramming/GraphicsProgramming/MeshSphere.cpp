@@ -98,4 +98,12 @@ void MeshSphere::initTextureCoords()
 			addTexCoord(u, v);
 		}
 	}
-}
\ No newline at end of file
+}
+
+void MeshSphere::getShadowProxyTriangles(vector<float>& triangles) const
+{
+	int longitudinal_segments = (longitudinal_segments_ < 16) ? longitudinal_segments_ : 16;
+	int latitudinal_segments = (latitudinal_segments_ < 16) ? latitudinal_segments_ : 16;
+	MeshSphere proxy(r_, longitudinal_segments, latitudinal_segments);
+	proxy.getLocalTriangles(triangles);
+}
@@ -43,6 +43,9 @@ private:
 
 	// initialise arrays of textures coords
 	void initTextureCoords();
+
+	// the shadow proxy is the same sphere with less segments
+	void getShadowProxyTriangles(vector<float>& triangles) const override;
 };
 
 #endif
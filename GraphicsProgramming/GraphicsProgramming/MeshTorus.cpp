@@ -15,6 +15,10 @@ MeshTorus::~MeshTorus()
 
 void MeshTorus::render(bool is_shadow)
 {
+	// the geometry has been evicted by the residency manager, it is rendered again when it is restored
+	if (!geometry_resident_)
+		return;
+
 	// To Turn on Wireframe to draw the lines (for test proposed) 
 	if (*shared_context_->wireframe_mode)
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // draw lines
@@ -30,7 +34,7 @@ void MeshTorus::render(bool is_shadow)
 	/* Apply texture_ if this object has one */
 	if (texture_ != nullptr && !is_shadow)
 	{
-		texture_->use();
+		bindTexture();
 	}
 
 	/* Enable Arrays of coords (vertices_, normals_, textures and index) and link them */
@@ -56,21 +60,11 @@ void MeshTorus::render(bool is_shadow)
 	// remember where we are
 	glPushMatrix();
 
-		// translate the shape
-		glTranslatef(translation_.x, translation_.y, translation_.z);
-
-		// rotate on the x axis
-		glRotatef(rotation_angles_.x, 1.0f, 0.0f, 0.0f);
-		// rotate on the y axis
-		glRotatef(rotation_angles_.y, 0.0f, 1.0f, 0.0f);
-		// rotate on the z axis
-		glRotatef(rotation_angles_.z, 0.0f, 0.0f, 1.0f);
-
-		// scale the shape
-		glScalef(scale_.x, scale_.y, scale_.z);
+		// translate, rotate and scale the shape (cached matrix)
+		applyTransform();
 
 		/* DRAW */
-		glDrawElements(GL_TRIANGLES, (unsigned int)indices_.size(), GL_UNSIGNED_INT, indices_.data()); // method 3 of dereference
+		drawGeometry();
 
 	// go back where we were
 	glPopMatrix();
@@ -89,7 +83,7 @@ void MeshTorus::render(bool is_shadow)
 	/* Stop using the texture_ if this object has one*/
 	if (texture_ != nullptr && !is_shadow)
 	{
-		texture_->stopUsing();
+		unbindTexture();
 	}
 
 	/* reset to white colour */
@@ -115,6 +109,10 @@ void MeshTorus::initVertexAndNormalCoords()
 	float u,v;
 	float s,t;
 
+	// set the type of dereference to use and the mode depending on how the vertices, normals and indices are set in this function
+	dereference_method_ = DereferenceMethod::kMethod3;
+	mode_ = GL_TRIANGLES;
+
 	unsigned int v0, v1;
 
 	// Each latitudinal Segment is made of two triangles:
@@ -211,4 +209,18 @@ void MeshTorus::initTextureCoords()
 			addTexCoord(u, v);
 		}
 	}
-}
\ No newline at end of file
+}
+
+void MeshTorus::drawGeometry() const
+{
+	glDrawElements(GL_TRIANGLES, (unsigned int)indices_.size(), GL_UNSIGNED_INT, indices_.data()); // method 3 of dereference
+	num_draws_++;
+}
+
+void MeshTorus::getShadowProxyTriangles(vector<float>& triangles) const
+{
+	int num_tube_faces = (num_tube_faces_ < 12) ? num_tube_faces_ : 12;
+	int num_rings = (num_rings_ < 24) ? num_rings_ : 24;
+	MeshTorus proxy(r_, R_, num_tube_faces, num_rings);
+	proxy.getLocalTriangles(triangles);
+}
@@ -47,6 +47,12 @@ private:
 
 	// initialise arrays of textures coords
 	void initTextureCoords();
+
+	// the shadow proxy is the same torus with less rings and tube faces
+	void getShadowProxyTriangles(vector<float>& triangles) const override;
+
+	// the torus is drawn as indexed triangles
+	void drawGeometry() const override;
 };
 
 #endif
\ No newline at end of file
@@ -4,7 +4,8 @@
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
-#include "model.h"
+#include "Model.h"
+#include <cstring> // strcmp
 
 
 Model::Model(char* modelFilename)
@@ -16,7 +17,11 @@ Model::Model(char* modelFilename)
 	result = loadModel(modelFilename);
 	if (!result)
 	{
+#ifdef _WIN32
 		MessageBox(NULL, "Model failed to load", "Error", MB_OK);
+#else
+		printf("Model failed to load: %s\n", modelFilename);
+#endif
 	}
 }
 
@@ -206,6 +211,10 @@ bool Model::loadModel(char* model_file_name)
 
 void Model::render(bool is_shadow)
 {
+	// the geometry has been evicted by the residency manager, it is rendered again when it is restored
+	if (!geometry_resident_)
+		return;
+
 	// To Turn on Wireframe to draw the lines (for test proposed) 
 	if (*shared_context_->wireframe_mode)
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // draw lines
@@ -221,7 +230,7 @@ void Model::render(bool is_shadow)
 	/* Apply texture_ if this object has one */
 	if (texture_ != nullptr && !is_shadow)
 	{
-		texture_->use();
+		bindTexture();
 	}
 
 	/* Enable Arrays of coords (vertices_, normals_, textures and index) and link them */
@@ -247,35 +256,12 @@ void Model::render(bool is_shadow)
 	// remember where we are
 	glPushMatrix();
 
-		// translate the square
-		glTranslatef(translation_.x, translation_.y, translation_.z);
-
-		// rotate on the x axis
-		glRotatef(rotation_angles_.x, 1.0f, 0.0f, 0.0f);
-		// rotate on the y axis
-		glRotatef(rotation_angles_.y, 0.0f, 1.0f, 0.0f);
-		// rotate on the z axis
-		glRotatef(rotation_angles_.z, 0.0f, 0.0f, 1.0f);
-
-		// scale the object
-		glScalef(scale_.x, scale_.y, scale_.z);
+		// translate, rotate and scale the shape (cached matrix)
+		applyTransform();
 
 
 		/* DRAW */
-		if (dereference_method_ == DereferenceMethod::kMethod2)
-		{
-			int start_vertex = 0;
-			for (auto order : vertices_tracker_)
-			{
-				glDrawArrays(order.first, start_vertex, order.second - start_vertex);
-				start_vertex = order.second;			
-			}
-		}
-		// Method 3
-		else if (dereference_method_ == DereferenceMethod::kMethod3)
-		{
-			glDrawElements(mode_, (unsigned int)indices_.size(), GL_UNSIGNED_INT, indices_.data()); // method 3 of dereference
-		}
+		drawGeometry();
 
 	// go back where we were
 	glPopMatrix();
@@ -294,7 +280,7 @@ void Model::render(bool is_shadow)
 	/* Stop using the texture_ if this object has one*/
 	if (texture_ != nullptr && !is_shadow)
 	{
-		texture_->stopUsing();
+		unbindTexture();
 	}
 
 	/* reset to white colour */
@@ -306,7 +292,74 @@ void Model::setTexture(Texture* texture)
 	texture_ = texture;
 }
 
+void Model::getLocalTriangles(vector<float>& triangles) const
+{
+	if (dereference_method_ != DereferenceMethod::kMethod2)
+	{
+		BaseMesh::getLocalTriangles(triangles);
+		return;
+	}
+
+	// each range of vertices has its own mode (same as render())
+	int start_vertex = 0;
+	for (auto order : vertices_tracker_)
+	{
+		int vertices_per_face = (order.first == GL_TRIANGLES) ? 3 : (order.first == GL_QUADS) ? 4 : 0;
+		for (int face = start_vertex; vertices_per_face > 0 && face + vertices_per_face <= order.second; face += vertices_per_face)
+		{
+			// triangle 0, 1, 2 and for the quads also 0, 2, 3
+			int order_in_face[6] = { 0, 1, 2, 0, 2, 3 };
+			for (int i = 0; i < (vertices_per_face - 2) * 3; i++)
+			{
+				int vertex = face + order_in_face[i];
+				triangles.push_back(vertices_[vertex * 3]);
+				triangles.push_back(vertices_[vertex * 3 + 1]);
+				triangles.push_back(vertices_[vertex * 3 + 2]);
+			}
+		}
+		start_vertex = order.second;
+	}
+}
+
 BaseMesh* Model::clone()
 {
 	return new Model(*this);
+}
+
+bool Model::getStaticParts(const Matrix4& parent_matrix, vector<StaticPart>& parts) const
+{
+	if (dereference_method_ != DereferenceMethod::kMethod2)
+	{
+		return BaseMesh::getStaticParts(parent_matrix, parts);
+	}
+
+	Matrix4 matrix = parent_matrix * Matrix4(getLocalMatrix());
+	int start_vertex = 0;
+	for (auto order : vertices_tracker_)
+	{
+		if (!addStaticPart(matrix, order.first, parts, start_vertex, order.second))
+			return false;
+		start_vertex = order.second;
+	}
+	return true;
+}
+
+void Model::drawGeometry() const
+{
+	if (dereference_method_ == DereferenceMethod::kMethod2)
+	{
+		int start_vertex = 0;
+		for (auto order : vertices_tracker_)
+		{
+			glDrawArrays(order.first, start_vertex, order.second - start_vertex);
+			num_draws_++;
+			start_vertex = order.second;
+		}
+	}
+	// Method 3
+	else if (dereference_method_ == DereferenceMethod::kMethod3)
+	{
+		glDrawElements(mode_, (unsigned int)indices_.size(), GL_UNSIGNED_INT, indices_.data()); // method 3 of dereference
+		num_draws_++;
+	}
 }
\ No newline at end of file
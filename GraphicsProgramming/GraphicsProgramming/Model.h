@@ -37,6 +37,16 @@ public:
 	// return a clone of this shape
 	BaseMesh* clone() override;
 
+	// the model can mix triangles and quads (see vertices_tracker_)
+	void getLocalTriangles(vector<float>& triangles) const override;
+
+	// each range of vertices of vertices_tracker_ with its mode in world space
+	bool getStaticParts(const Matrix4& parent_matrix, vector<StaticPart>& parts) const override;
+
+protected:
+	// draw each part of the arrays with its mode (see vertices_tracker_)
+	void drawGeometry() const override;
+
 private:
 	// Load the model using the url parameter and save the vertices, tex coords and indices in the right format to be rendered
 	// Modified from a multi-threaded version by Mark Ropper.
@@ -0,0 +1,222 @@
+#include "MotionBenchmark.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h> // rand
+#include <math.h>
+
+MotionBenchmark::MotionBenchmark(ThreadPool* thread_pool)
+	: thread_pool_(thread_pool), num_frames_(200), dt_(1.0f / 60.0f)
+{
+}
+
+void MotionBenchmark::run(int max_objects)
+{
+	printf("\n%-10s %14s %14s %14s %14s %9s %12s\n", "Objects", "update() ms", "SoA pass ms", "SoA+write ms", "Pipelined ms", "Speedup",
+		"Max error");
+
+	for (int num_objects : { 1000, 10000, max_objects })
+	{
+		if (num_objects <= max_objects)
+		{
+			runObjects(num_objects);
+		}
+	}
+	printf("\nTimes per frame, average of %i frames, with %i thread(s)\n", num_frames_, thread_pool_ != nullptr ? thread_pool_->getNumThreads() : 1);
+	printf("Pipelined: the path of the scene (one step simulated in a worker and written back interpolated), the speedup is against it\n");
+	printf("The scene uses it from %i moving objects, with less of them it calls update() of each mesh\n\n", MotionSystem::kMinMovingObjects);
+}
+
+void MotionBenchmark::setRandomMovement(BaseMesh* mesh)
+{
+	auto random = [](float min, float max) { return min + (max - min) * (rand() / (float)RAND_MAX); };
+
+	// most of the objects rotate around one axis and half of them move along one axis (some along two), as the meshes of the scene
+	mesh->setIsRotating(rand() % 4 == 0, rand() % 4 != 0, rand() % 8 == 0);
+	vector<bool> is_moving = { false, false, false };
+	if (rand() % 2 == 0)
+	{
+		is_moving[rand() % 3] = true;
+		if (rand() % 8 == 0)
+		{
+			is_moving[rand() % 3] = true;
+		}
+	}
+	mesh->setIsMoving(is_moving);
+
+	Vector3 min(random(-50.0f, 0.0f), random(0.0f, 5.0f), random(-50.0f, 0.0f));
+	Vector3 max(min.x + random(1.0f, 20.0f), min.y + random(1.0f, 5.0f), min.z + random(1.0f, 20.0f));
+	mesh->setAxisLimits(AxisLimits(max, min));
+	mesh->setTranslation(Vector3(random(min.x, max.x), random(min.y, max.y), random(min.z, max.z)));
+	mesh->setRotationAngles(Vector3(0.0f, random(0.0f, 360.0f), 0.0f));
+	mesh->setDirection(Vector3(is_moving[0] ? (rand() % 2 ? 1.0f : -1.0f) : 0.0f, is_moving[1] ? (rand() % 2 ? 1.0f : -1.0f) : 0.0f,
+		is_moving[2] ? (rand() % 2 ? 1.0f : -1.0f) : 0.0f));
+	mesh->setSpeed(random(1.0f, 20.0f));
+}
+
+BaseMesh* MotionBenchmark::copyMovement(const BaseMesh* mesh)
+{
+	BaseMesh* copy = new BaseMesh();
+	copy->setIsRotating(mesh->getIsRotating());
+	copy->setIsMoving(mesh->getIsMoving());
+	copy->setAxisLimits(mesh->getAxisLimits());
+	copy->setTranslation(mesh->getTranslation());
+	copy->setRotationAngles(mesh->getRotationAngles());
+	copy->setDirection(mesh->getDirection());
+	copy->setSpeed(mesh->getSpeed());
+	return copy;
+}
+
+bool MotionBenchmark::runPipelineCheck(int num_objects, int num_frames)
+{
+	// two groups of meshes with the same components: one is simulated one frame ahead in a worker (as the scene does) and the other step by step
+	vector<BaseMesh*> pipelined_meshes(num_objects), synchronous_meshes(num_objects);
+	MotionSystem pipelined_system(thread_pool_), synchronous_system(thread_pool_);
+	srand(1);
+	for (int i = 0; i < num_objects; i++)
+	{
+		pipelined_meshes[i] = new BaseMesh();
+		setRandomMovement(pipelined_meshes[i]);
+		synchronous_meshes[i] = copyMovement(pipelined_meshes[i]);
+		pipelined_system.add(pipelined_meshes[i]);
+		synchronous_system.add(synchronous_meshes[i]);
+	}
+
+	// frames of random length (some of them longer than the steps allowed, so steps are dropped), both clocks get the same ones
+	FixedTimestep pipelined_timestep, synchronous_timestep;
+	int num_steps_run = 0;
+	for (int frame = 0; frame < num_frames; frame++)
+	{
+		float dt = 0.001f + 0.2f * (rand() / (float)RAND_MAX);
+
+		// the same order as Scene::update(): finish the last frame, write it back and start the next one
+		pipelined_system.finishSimulation();
+		pipelined_system.writeBackInterpolated();
+		int num_steps = pipelined_timestep.advance(dt);
+		pipelined_system.startSimulation(num_steps, pipelined_timestep.getStep(), pipelined_timestep.getAlpha());
+
+		int num_synchronous_steps = synchronous_timestep.advance(dt);
+		for (int step = 0; step < num_synchronous_steps; step++)
+		{
+			synchronous_system.update(synchronous_timestep.getStep());
+		}
+		num_steps_run += num_synchronous_steps;
+	}
+
+	// the state after the last step (not interpolated)
+	pipelined_system.finishSimulation();
+	pipelined_system.writeBack();
+
+	float max_error = 0.0f;
+	for (int i = 0; i < num_objects; i++)
+	{
+		Vector3 translation = pipelined_meshes[i]->getTranslation() - synchronous_meshes[i]->getTranslation();
+		Vector3 rotation = pipelined_meshes[i]->getRotationAngles() - synchronous_meshes[i]->getRotationAngles();
+		max_error = fmaxf(max_error, fmaxf(translation.length(), rotation.length()));
+	}
+
+	bool same = (max_error == 0.0f);
+	printf("\nPipelined simulation check: %i objects, %i frames (%i steps), max difference with the synchronous simulation %g: %s\n\n",
+		num_objects, num_frames, num_steps_run, max_error, same ? "OK" : "FAILED");
+
+	for (int i = 0; i < num_objects; i++)
+	{
+		delete pipelined_meshes[i];
+		delete synchronous_meshes[i];
+	}
+	return same;
+}
+
+void MotionBenchmark::runObjects(int num_objects)
+{
+	using Clock = chrono::high_resolution_clock;
+
+	// three groups of meshes with the same components: one is updated by update(), one by the motion system and one by its pipelined simulation
+	vector<BaseMesh*> meshes(num_objects), system_meshes(num_objects), pipelined_meshes(num_objects);
+	MotionSystem motion_system(thread_pool_), pass_system(thread_pool_), pipelined_system(thread_pool_);
+	srand(1);
+	for (int i = 0; i < num_objects; i++)
+	{
+		meshes[i] = new BaseMesh();
+		setRandomMovement(meshes[i]);
+		system_meshes[i] = copyMovement(meshes[i]);
+		motion_system.add(system_meshes[i]);
+		pipelined_meshes[i] = copyMovement(meshes[i]);
+		pipelined_system.add(pipelined_meshes[i]);
+
+		// the pass alone is measured in objects without meshes
+		const vector<bool>& is_rotating = meshes[i]->getIsRotating();
+		const vector<bool>& is_moving = meshes[i]->getIsMoving();
+		int flags = (is_rotating[0] ? kMotionRotatingX : 0) | (is_rotating[1] ? kMotionRotatingY : 0) | (is_rotating[2] ? kMotionRotatingZ : 0)
+			| (is_moving[0] ? kMotionMovingX : 0) | (is_moving[1] ? kMotionMovingY : 0) | (is_moving[2] ? kMotionMovingZ : 0);
+		pass_system.add(meshes[i]->getTranslation(), meshes[i]->getRotationAngles(), meshes[i]->getSpeed(), meshes[i]->getDirection(),
+			meshes[i]->getAxisLimits(), flags);
+	}
+
+	/* update() of each mesh */
+
+	Clock::time_point start = Clock::now();
+	for (int frame = 0; frame < num_frames_; frame++)
+	{
+		for (BaseMesh* mesh : meshes)
+		{
+			mesh->update(dt_);
+		}
+	}
+	double update_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_frames_;
+
+	/* SSE2 pass alone */
+
+	start = Clock::now();
+	for (int frame = 0; frame < num_frames_; frame++)
+	{
+		pass_system.integrate(dt_);
+	}
+	double pass_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_frames_;
+
+	/* SSE2 pass and the result written to the meshes */
+
+	start = Clock::now();
+	for (int frame = 0; frame < num_frames_; frame++)
+	{
+		motion_system.update(dt_);
+	}
+	double system_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_frames_;
+
+	/* Pipelined simulation, in the same order as Scene::update() (the simulation of each frame is written back in the next one) */
+
+	start = Clock::now();
+	for (int frame = 0; frame < num_frames_; frame++)
+	{
+		pipelined_system.finishSimulation();
+		pipelined_system.writeBackInterpolated();
+		pipelined_system.startSimulation(1, dt_, 0.5f);
+	}
+	pipelined_system.finishSimulation();
+	double pipelined_ms = chrono::duration<double, milli>(Clock::now() - start).count() / num_frames_;
+
+	// the state after the last step (not interpolated) to compare it
+	pipelined_system.writeBack();
+
+	/* Difference between the ways */
+
+	float max_error = 0.0f;
+	for (int i = 0; i < num_objects; i++)
+	{
+		for (const BaseMesh* other : { system_meshes[i], pipelined_meshes[i] })
+		{
+			Vector3 translation = meshes[i]->getTranslation() - other->getTranslation();
+			Vector3 rotation = meshes[i]->getRotationAngles() - other->getRotationAngles();
+			max_error = fmaxf(max_error, fmaxf(translation.length(), rotation.length()));
+		}
+	}
+
+	printf("%-10i %14.3f %14.3f %14.3f %14.3f %8.2fx %12g\n", num_objects, update_ms, pass_ms, system_ms, pipelined_ms, update_ms / pipelined_ms,
+		max_error);
+
+	for (int i = 0; i < num_objects; i++)
+	{
+		delete meshes[i];
+		delete system_meshes[i];
+		delete pipelined_meshes[i];
+	}
+}
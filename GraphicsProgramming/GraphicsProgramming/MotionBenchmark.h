@@ -0,0 +1,52 @@
+// Class Motion Benchmark
+// It compares the motion system against calling the virtual update() of each mesh, with the same objects moving and rotating
+// (random axes, speeds and limits, so the objects turn around at the limits during the test).
+// For each number of objects it prints the time per frame of update() of the meshes, the SSE2 pass of the motion system alone and with
+// the result written back to the meshes, the pipelined simulation as the scene runs it (a step in a worker and the last one written back
+// interpolated, the speedup is the one of this path against update()), and the biggest difference between the meshes updated by update()
+// and by the motion system (it should be 0).
+// It is run from the command line with: GraphicsProgramming.exe --motion-benchmark [number of objects]
+// It also checks the pipelined simulation of the scene: the same objects are simulated in fixed steps one frame ahead in a worker (with
+// frames of random length) and synchronously step by step, and after the last step both must be the same. It is run with:
+// GraphicsProgramming.exe --motion-pipeline-check [number of objects] [frames]
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include "MotionSystem.h"
+#include "FixedTimestep.h"
+#include <vector>
+
+using namespace std;
+
+class MotionBenchmark
+{
+public:
+	// constructor
+	MotionBenchmark(ThreadPool* thread_pool);
+
+	// run the benchmark with 1k, 10k and max_objects objects and print the results
+	void run(int max_objects = 100000);
+
+	// compare the pipelined simulation with the synchronous one, it prints the biggest difference and returns true if there is none
+	bool runPipelineCheck(int num_objects = 20000, int num_frames = 300);
+
+private:
+	// thread pool given to the motion systems tested
+	ThreadPool* thread_pool_;
+
+	// number of frames updated for each test
+	int num_frames_;
+
+	// time step of each frame (s)
+	float dt_;
+
+	// run the benchmark with the number of objects passed
+	void runObjects(int num_objects);
+
+	// set random movement components to the mesh (the same seed gives the same components)
+	void setRandomMovement(BaseMesh* mesh);
+
+	// create a mesh with the same movement components as the one passed
+	static BaseMesh* copyMovement(const BaseMesh* mesh);
+};
@@ -0,0 +1,469 @@
+#include "MotionSystem.h"
+#include <algorithm> // copy
+#include <emmintrin.h> // SSE2
+
+MotionSystem::MotionSystem(ThreadPool* thread_pool)
+	: thread_pool_(thread_pool), num_objects_(0), render_read_index_(0), render_version_(0), written_version_(0), simulating_(false),
+	simulation_started_(false)
+{
+}
+
+MotionSystem::~MotionSystem()
+{
+	// the worker could still be using the arrays
+	finishSimulation();
+}
+
+int MotionSystem::add(BaseMesh* mesh)
+{
+	const vector<bool>& is_rotating = mesh->getIsRotating();
+	const vector<bool>& is_moving = mesh->getIsMoving();
+	int flags = (is_rotating[0] ? kMotionRotatingX : 0) | (is_rotating[1] ? kMotionRotatingY : 0) | (is_rotating[2] ? kMotionRotatingZ : 0)
+		| (is_moving[0] ? kMotionMovingX : 0) | (is_moving[1] ? kMotionMovingY : 0) | (is_moving[2] ? kMotionMovingZ : 0);
+
+	int index = add(mesh->getTranslation(), mesh->getRotationAngles(), mesh->getSpeed(), mesh->getDirection(), mesh->getAxisLimits(), flags);
+	meshes_[index] = mesh;
+	return index;
+}
+
+int MotionSystem::add(const Vector3& translation, const Vector3& rotation_angles, float speed, const Vector3& direction, const AxisLimits& axis_limits, int flags)
+{
+	int index = num_objects_;
+	num_objects_++;
+
+	// the arrays grow 4 objects at a time, the new ones are padding until they are added
+	if ((size_t)num_objects_ > flags_.size())
+	{
+		size_t size = flags_.size() + 4;
+		for (vector<float>* components : { &translation_x_, &translation_y_, &translation_z_, &rotation_x_, &rotation_y_, &rotation_z_,
+			&direction_x_, &direction_y_, &direction_z_, &min_x_, &min_y_, &min_z_, &max_x_, &max_y_, &max_z_, &speed_ })
+		{
+			components->resize(size, 0.0f);
+		}
+		flags_.resize(size, 0);
+		meshes_.resize(size, nullptr);
+	}
+
+	translation_x_[index] = translation.x;
+	translation_y_[index] = translation.y;
+	translation_z_[index] = translation.z;
+	rotation_x_[index] = rotation_angles.x;
+	rotation_y_[index] = rotation_angles.y;
+	rotation_z_[index] = rotation_angles.z;
+	direction_x_[index] = direction.x;
+	direction_y_[index] = direction.y;
+	direction_z_[index] = direction.z;
+	min_x_[index] = axis_limits.min.x;
+	min_y_[index] = axis_limits.min.y;
+	min_z_[index] = axis_limits.min.z;
+	max_x_[index] = axis_limits.max.x;
+	max_y_[index] = axis_limits.max.y;
+	max_z_[index] = axis_limits.max.z;
+	speed_[index] = speed;
+	flags_[index] = flags;
+	meshes_[index] = nullptr;
+	return index;
+}
+
+void MotionSystem::update(float dt)
+{
+	integrate(dt);
+	writeBack();
+}
+
+// mask (all the bits set) of the lanes which have the flag
+static inline __m128 flagMask(__m128i flags, int flag)
+{
+	__m128i bit = _mm_set1_epi32(flag);
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, bit), bit));
+}
+
+// a where the mask is set, b where it is not
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+void MotionSystem::forEachBlock(const function<void(int, int)>& job)
+{
+	int size = (int)flags_.size();
+	int num_blocks = (size + kBlockSize - 1) / kBlockSize;
+	function<void(int, int)> blocks = [&job, size](int begin, int end)
+	{
+		job(begin * kBlockSize, (end * kBlockSize < size) ? end * kBlockSize : size);
+	};
+
+	if (thread_pool_ != nullptr && num_blocks > 1)
+		thread_pool_->parallelFor(0, num_blocks, blocks);
+	else
+		blocks(0, num_blocks);
+}
+
+void MotionSystem::integrate(float dt)
+{
+	forEachBlock([this, dt](int begin, int end) { integrateRange(dt, begin, end); });
+}
+
+void MotionSystem::integrateRange(float dt, int begin, int end)
+{
+	__m128 delta_time = _mm_set1_ps(dt);
+	__m128 plus_one = _mm_set1_ps(1.0f);
+	__m128 minus_one = _mm_set1_ps(-1.0f);
+	__m128 half_turn = _mm_set1_ps(180.0f);
+
+	for (int i = begin; i < end; i += 4)
+	{
+		__m128i flags = _mm_loadu_si128((const __m128i*)&flags_[i]);
+		__m128 step = _mm_mul_ps(_mm_loadu_ps(&speed_[i]), delta_time);
+
+		__m128 tx = _mm_loadu_ps(&translation_x_[i]);
+		__m128 ty = _mm_loadu_ps(&translation_y_[i]);
+		__m128 tz = _mm_loadu_ps(&translation_z_[i]);
+		__m128 rx = _mm_loadu_ps(&rotation_x_[i]);
+		__m128 ry = _mm_loadu_ps(&rotation_y_[i]);
+		__m128 rz = _mm_loadu_ps(&rotation_z_[i]);
+		__m128 dx = _mm_loadu_ps(&direction_x_[i]);
+		__m128 dy = _mm_loadu_ps(&direction_y_[i]);
+		__m128 dz = _mm_loadu_ps(&direction_z_[i]);
+
+		/* rotate around x, y and/or z axis */
+
+		rx = _mm_add_ps(rx, _mm_and_ps(flagMask(flags, kMotionRotatingX), step));
+		ry = _mm_add_ps(ry, _mm_and_ps(flagMask(flags, kMotionRotatingY), step));
+		rz = _mm_add_ps(rz, _mm_and_ps(flagMask(flags, kMotionRotatingZ), step));
+
+		/* move along x, y and/or z axis, in order, turning around at the limits */
+
+		// the translation of each axis adds the whole direction (as BaseMesh::update)
+		__m128 step_x, step_y, step_z;
+
+		// along x-axis (it turns around the y axis)
+		__m128 moving = flagMask(flags, kMotionMovingX);
+		__m128 at_max = _mm_and_ps(moving, _mm_and_ps(_mm_cmpge_ps(tx, _mm_loadu_ps(&max_x_[i])), _mm_cmpeq_ps(dx, plus_one)));
+		__m128 at_min = _mm_andnot_ps(at_max, _mm_and_ps(moving, _mm_and_ps(_mm_cmple_ps(tx, _mm_loadu_ps(&min_x_[i])), _mm_cmpeq_ps(dx, minus_one))));
+		ry = _mm_add_ps(_mm_sub_ps(ry, _mm_and_ps(at_max, half_turn)), _mm_and_ps(at_min, half_turn));
+		dx = select(at_max, minus_one, select(at_min, plus_one, dx));
+		step_x = _mm_and_ps(moving, step);
+		tx = _mm_add_ps(tx, _mm_mul_ps(dx, step_x));
+		ty = _mm_add_ps(ty, _mm_mul_ps(dy, step_x));
+		tz = _mm_add_ps(tz, _mm_mul_ps(dz, step_x));
+
+		// along y-axis (it turns around the z axis)
+		moving = flagMask(flags, kMotionMovingY);
+		at_max = _mm_and_ps(moving, _mm_and_ps(_mm_cmpge_ps(ty, _mm_loadu_ps(&max_y_[i])), _mm_cmpeq_ps(dy, plus_one)));
+		at_min = _mm_andnot_ps(at_max, _mm_and_ps(moving, _mm_and_ps(_mm_cmple_ps(ty, _mm_loadu_ps(&min_y_[i])), _mm_cmpeq_ps(dy, minus_one))));
+		rz = _mm_add_ps(_mm_sub_ps(rz, _mm_and_ps(at_max, half_turn)), _mm_and_ps(at_min, half_turn));
+		dy = select(at_max, minus_one, select(at_min, plus_one, dy));
+		step_y = _mm_and_ps(moving, step);
+		tx = _mm_add_ps(tx, _mm_mul_ps(dx, step_y));
+		ty = _mm_add_ps(ty, _mm_mul_ps(dy, step_y));
+		tz = _mm_add_ps(tz, _mm_mul_ps(dz, step_y));
+
+		// along z-axis (it turns around the y axis)
+		moving = flagMask(flags, kMotionMovingZ);
+		at_max = _mm_and_ps(moving, _mm_and_ps(_mm_cmpge_ps(tz, _mm_loadu_ps(&max_z_[i])), _mm_cmpeq_ps(dz, plus_one)));
+		at_min = _mm_andnot_ps(at_max, _mm_and_ps(moving, _mm_and_ps(_mm_cmple_ps(tz, _mm_loadu_ps(&min_z_[i])), _mm_cmpeq_ps(dz, minus_one))));
+		ry = _mm_add_ps(_mm_sub_ps(ry, _mm_and_ps(at_max, half_turn)), _mm_and_ps(at_min, half_turn));
+		dz = select(at_max, minus_one, select(at_min, plus_one, dz));
+		step_z = _mm_and_ps(moving, step);
+		tx = _mm_add_ps(tx, _mm_mul_ps(dx, step_z));
+		ty = _mm_add_ps(ty, _mm_mul_ps(dy, step_z));
+		tz = _mm_add_ps(tz, _mm_mul_ps(dz, step_z));
+
+		_mm_storeu_ps(&translation_x_[i], tx);
+		_mm_storeu_ps(&translation_y_[i], ty);
+		_mm_storeu_ps(&translation_z_[i], tz);
+		_mm_storeu_ps(&rotation_x_[i], rx);
+		_mm_storeu_ps(&rotation_y_[i], ry);
+		_mm_storeu_ps(&rotation_z_[i], rz);
+		_mm_storeu_ps(&direction_x_[i], dx);
+		_mm_storeu_ps(&direction_y_[i], dy);
+		_mm_storeu_ps(&direction_z_[i], dz);
+	}
+}
+
+void MotionSystem::integrateScalar(float dt)
+{
+	for (int i = 0; i < num_objects_; i++)
+	{
+		int flags = flags_[i];
+		float step = speed_[i] * dt;
+
+		/* rotate around x, y and/or z axis */
+
+		if (flags & kMotionRotatingX) rotation_x_[i] += step;
+		if (flags & kMotionRotatingY) rotation_y_[i] += step;
+		if (flags & kMotionRotatingZ) rotation_z_[i] += step;
+
+		/* move along x, y and/or z axis */
+
+		if (flags & kMotionMovingX)
+		{
+			if (translation_x_[i] >= max_x_[i] && direction_x_[i] == +1.0f)
+			{
+				rotation_y_[i] -= 180.0f;
+				direction_x_[i] = -1.0f;
+			}
+			else if (translation_x_[i] <= min_x_[i] && direction_x_[i] == -1.0f)
+			{
+				rotation_y_[i] += 180.0f;
+				direction_x_[i] = 1.0f;
+			}
+			translation_x_[i] += direction_x_[i] * step;
+			translation_y_[i] += direction_y_[i] * step;
+			translation_z_[i] += direction_z_[i] * step;
+		}
+		if (flags & kMotionMovingY)
+		{
+			if (translation_y_[i] >= max_y_[i] && direction_y_[i] == +1.0f)
+			{
+				rotation_z_[i] -= 180.0f;
+				direction_y_[i] = -1.0f;
+			}
+			else if (translation_y_[i] <= min_y_[i] && direction_y_[i] == -1.0f)
+			{
+				rotation_z_[i] += 180.0f;
+				direction_y_[i] = 1.0f;
+			}
+			translation_x_[i] += direction_x_[i] * step;
+			translation_y_[i] += direction_y_[i] * step;
+			translation_z_[i] += direction_z_[i] * step;
+		}
+		if (flags & kMotionMovingZ)
+		{
+			if (translation_z_[i] >= max_z_[i] && direction_z_[i] == +1.0f)
+			{
+				rotation_y_[i] -= 180.0f;
+				direction_z_[i] = -1.0f;
+			}
+			else if (translation_z_[i] <= min_z_[i] && direction_z_[i] == -1.0f)
+			{
+				rotation_y_[i] += 180.0f;
+				direction_z_[i] = 1.0f;
+			}
+			translation_x_[i] += direction_x_[i] * step;
+			translation_y_[i] += direction_y_[i] * step;
+			translation_z_[i] += direction_z_[i] * step;
+		}
+	}
+}
+
+void MotionSystem::writeBack()
+{
+	forEachBlock([this](int begin, int end)
+	{
+		end = (end < num_objects_) ? end : num_objects_;
+		for (int i = begin; i < end; i++)
+		{
+			int ahead = i + kPrefetchDistance;
+			if (ahead < end && meshes_[ahead] != nullptr && flags_[ahead] != 0)
+			{
+				meshes_[ahead]->prefetchMovementState();
+			}
+
+			// the objects which don't move keep the same components
+			if (meshes_[i] != nullptr && flags_[i] != 0)
+			{
+				meshes_[i]->setMovementState(Vector3(translation_x_[i], translation_y_[i], translation_z_[i]),
+					Vector3(rotation_x_[i], rotation_y_[i], rotation_z_[i]), Vector3(direction_x_[i], direction_y_[i], direction_z_[i]));
+			}
+		}
+	});
+}
+
+void MotionSystem::startSimulation(int num_steps, float step, float alpha)
+{
+	{
+		lock_guard<mutex> lock(simulation_mutex_);
+		simulating_ = true;
+	}
+	simulation_started_ = true;
+
+	function<void()> task = [this, num_steps, step, alpha]()
+	{
+		simulate(num_steps, step, alpha);
+
+		// tell the thread waiting in finishSimulation()
+		{
+			lock_guard<mutex> lock(simulation_mutex_);
+			simulating_ = false;
+		}
+		simulation_condition_.notify_all();
+	};
+
+	if (thread_pool_ != nullptr)
+		thread_pool_->submitToWorkers(task); // never run by the GL thread while it waits for the frame tasks
+	else
+		task();
+}
+
+void MotionSystem::finishSimulation()
+{
+	if (!simulation_started_)
+	{
+		return;
+	}
+
+	{
+		unique_lock<mutex> lock(simulation_mutex_);
+		simulation_condition_.wait(lock, [this]() { return !simulating_; });
+	}
+	simulation_started_ = false;
+
+	// the buffer written by the worker is the one read from now on
+	render_read_index_ = 1 - render_read_index_;
+}
+
+void MotionSystem::simulate(int num_steps, float step, float alpha)
+{
+	// the first time (or after adding objects) the state before the last step is the current one
+	bool added = previous_translation_x_.size() != translation_x_.size();
+	if (added)
+	{
+		previous_translation_x_ = translation_x_;
+		previous_translation_y_ = translation_y_;
+		previous_translation_z_ = translation_z_;
+		previous_rotation_x_ = rotation_x_;
+		previous_rotation_y_ = rotation_y_;
+		previous_rotation_z_ = rotation_z_;
+	}
+
+	// the result is interpolated into the buffer which is not being read (the read index only changes when the simulation has finished)
+	const RenderState& last_state = render_states_[render_read_index_];
+	RenderState& state = render_states_[1 - render_read_index_];
+	size_t size = translation_x_.size();
+	for (vector<float>* components : { &state.translation_x, &state.translation_y, &state.translation_z, &state.rotation_x, &state.rotation_y,
+		&state.rotation_z, &state.direction_x, &state.direction_y, &state.direction_z })
+	{
+		components->resize(size, 0.0f);
+	}
+
+	for (int i = 0; i < num_steps - 1; i++)
+	{
+		integrate(step);
+	}
+
+	// the last step is done block by block with the copy of the state before it and the interpolation, so each block is read only once
+	forEachBlock([this, num_steps, step, alpha, &state](int begin, int end)
+	{
+		if (num_steps > 0)
+		{
+			for (pair<vector<float>*, vector<float>*> components : { make_pair(&translation_x_, &previous_translation_x_),
+				make_pair(&translation_y_, &previous_translation_y_), make_pair(&translation_z_, &previous_translation_z_),
+				make_pair(&rotation_x_, &previous_rotation_x_), make_pair(&rotation_y_, &previous_rotation_y_), make_pair(&rotation_z_, &previous_rotation_z_) })
+			{
+				copy(components.first->begin() + begin, components.first->begin() + end, components.second->begin() + begin);
+			}
+			integrateRange(step, begin, end);
+		}
+		interpolateRange(alpha, state, begin, end);
+	});
+
+	// without steps and with the same alpha it is the state already written to the meshes
+	state.alpha = alpha;
+	state.version = (num_steps > 0 || added || alpha != last_state.alpha) ? ++render_version_ : last_state.version;
+}
+
+void MotionSystem::interpolateRange(float alpha, RenderState& state, int begin, int end)
+{
+	__m128 fraction = _mm_set1_ps(alpha);
+	__m128 quarter_turn = _mm_set1_ps(90.0f);
+	__m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	for (int i = begin; i < end; i += 4)
+	{
+		/* translation */
+
+		__m128 px = _mm_loadu_ps(&previous_translation_x_[i]);
+		__m128 py = _mm_loadu_ps(&previous_translation_y_[i]);
+		__m128 pz = _mm_loadu_ps(&previous_translation_z_[i]);
+		_mm_storeu_ps(&state.translation_x[i], _mm_add_ps(px, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&translation_x_[i]), px), fraction)));
+		_mm_storeu_ps(&state.translation_y[i], _mm_add_ps(py, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&translation_y_[i]), py), fraction)));
+		_mm_storeu_ps(&state.translation_z[i], _mm_add_ps(pz, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&translation_z_[i]), pz), fraction)));
+
+		/* rotation */
+
+		// when an object turns around at a limit it rotates 180 degrees in one step, this rotation is not interpolated (it would spin)
+		__m128 previous[3] = { _mm_loadu_ps(&previous_rotation_x_[i]), _mm_loadu_ps(&previous_rotation_y_[i]), _mm_loadu_ps(&previous_rotation_z_[i]) };
+		__m128 current[3] = { _mm_loadu_ps(&rotation_x_[i]), _mm_loadu_ps(&rotation_y_[i]), _mm_loadu_ps(&rotation_z_[i]) };
+		float* rotation[3] = { &state.rotation_x[i], &state.rotation_y[i], &state.rotation_z[i] };
+		for (int axis = 0; axis < 3; axis++)
+		{
+			__m128 delta = _mm_sub_ps(current[axis], previous[axis]);
+			__m128 not_turning = _mm_cmplt_ps(_mm_and_ps(delta, abs_mask), quarter_turn);
+			_mm_storeu_ps(rotation[axis], select(not_turning, _mm_add_ps(previous[axis], _mm_mul_ps(delta, fraction)), current[axis]));
+		}
+
+		/* direction (it is not interpolated) */
+
+		_mm_storeu_ps(&state.direction_x[i], _mm_loadu_ps(&direction_x_[i]));
+		_mm_storeu_ps(&state.direction_y[i], _mm_loadu_ps(&direction_y_[i]));
+		_mm_storeu_ps(&state.direction_z[i], _mm_loadu_ps(&direction_z_[i]));
+	}
+}
+
+void MotionSystem::writeBackInterpolated()
+{
+	const RenderState& state = render_states_[render_read_index_];
+
+	// the meshes have already this state (or there is none yet)
+	if (state.version == written_version_)
+	{
+		return;
+	}
+	written_version_ = state.version;
+
+	int count = (int)state.translation_x.size();
+	count = (count < num_objects_) ? count : num_objects_;
+	forEachBlock([this, &state, count](int begin, int end)
+	{
+		end = (end < count) ? end : count;
+		for (int i = begin; i < end; i++)
+		{
+			int ahead = i + kPrefetchDistance;
+			if (ahead < end && meshes_[ahead] != nullptr && flags_[ahead] != 0)
+			{
+				meshes_[ahead]->prefetchMovementState();
+			}
+
+			if (meshes_[i] != nullptr && flags_[i] != 0)
+			{
+				meshes_[i]->setMovementState(Vector3(state.translation_x[i], state.translation_y[i], state.translation_z[i]),
+					Vector3(state.rotation_x[i], state.rotation_y[i], state.rotation_z[i]), Vector3(state.direction_x[i], state.direction_y[i], state.direction_z[i]));
+			}
+		}
+	});
+}
+
+int MotionSystem::getNumObjects() const
+{
+	return num_objects_;
+}
+
+int MotionSystem::getNumMovingObjects() const
+{
+	int num_moving = 0;
+	for (int i = 0; i < num_objects_; i++)
+	{
+		if (flags_[i] != 0)
+		{
+			num_moving++;
+		}
+	}
+	return num_moving;
+}
+
+Vector3 MotionSystem::getTranslation(int index) const
+{
+	return Vector3(translation_x_[index], translation_y_[index], translation_z_[index]);
+}
+
+Vector3 MotionSystem::getRotationAngles(int index) const
+{
+	return Vector3(rotation_x_[index], rotation_y_[index], rotation_z_[index]);
+}
+
+Vector3 MotionSystem::getDirection(int index) const
+{
+	return Vector3(direction_x_[index], direction_y_[index], direction_z_[index]);
+}
@@ -0,0 +1,158 @@
+// Class Motion System
+// It moves and rotates all the animated meshes together instead of calling the update() of each mesh.
+// The movement components (translation, rotation, speed, direction, axis limits and the flags of the axes) of all the meshes are kept
+// in separated arrays (SoA), so they are updated in one pass, 4 meshes at a time with SSE2 and without branches (the flags are masks).
+// The result is the same as BaseMesh::update(): the meshes rotate speed * dt degrees in the axes they are rotating, and when they reach
+// a limit of an axis they are moving along they turn around (180 degrees) and go back. The axes are checked in order x, y and z.
+// The components are copied when the mesh is added, after that the system owns them and writes the translation, rotation and direction back
+// to the meshes after each update (only to the meshes which are moving or rotating).
+// With many objects the pass and the writing back are split in blocks which are done in parallel in the thread pool.
+// The scene runs the simulation pipelined: startSimulation() runs the fixed steps of the next frame in a worker while the GL thread renders
+// the result of the last one. When it finishes, the worker interpolates the state of its last two steps (SSE2) into a double buffer, so the
+// GL thread only copies it to the meshes (writeBackInterpolated()) without reading the arrays which are being simulated. If nothing has
+// moved since the last copy (no step and the same alpha) the meshes are not written.
+// Writing back is what costs the most with many meshes (each mesh is in its own memory), so the meshes are prefetched some objects ahead.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include "BaseMesh.h"
+#include "ThreadPool.h"
+#include "Vector3.h"
+
+using namespace std;
+
+// bits of the flags of each object
+enum MotionFlags
+{
+	kMotionRotatingX = 1 << 0,
+	kMotionRotatingY = 1 << 1,
+	kMotionRotatingZ = 1 << 2,
+	kMotionMovingX = 1 << 3,
+	kMotionMovingY = 1 << 4,
+	kMotionMovingZ = 1 << 5
+};
+
+class MotionSystem
+{
+public:
+	// with fewer moving objects the update() of each mesh is faster than the system (see --motion-benchmark: writing the result back to
+	// the meshes costs as much as update() and the pass and the worker only pay off with many objects), so the scene uses update() below it
+	static const int kMinMovingObjects = 8192;
+
+	// constructor
+	// thread_pool: it is used when there are many objects (nullptr to update them always in the calling thread)
+	MotionSystem(ThreadPool* thread_pool = nullptr);
+
+	// destructor, it waits for the simulation running in the worker
+	~MotionSystem();
+
+	// add a mesh, its movement components are copied (it returns the index of the object)
+	int add(BaseMesh* mesh);
+
+	// add an object without mesh (ex: for the benchmark), flags: bits of MotionFlags
+	int add(const Vector3& translation, const Vector3& rotation_angles, float speed, const Vector3& direction, const AxisLimits& axis_limits, int flags);
+
+	// move all the objects and write the result back to the meshes
+	void update(float dt);
+
+	// move all the objects (SSE2)
+	void integrate(float dt);
+
+	// same as integrate() one object at a time, it is used to check the SSE2 version
+	void integrateScalar(float dt);
+
+	// write the translation, rotation and direction of each object back to its mesh
+	void writeBack();
+
+	/* PIPELINED SIMULATION */
+
+	// run num_steps steps of step seconds in a worker of the thread pool (in this thread if there is no pool), it doesn't wait for them
+	// alpha: fraction of a step the render is ahead of the last step, it is kept with the result to interpolate it
+	// no object must be added and no other function of the system called until finishSimulation()
+	void startSimulation(int num_steps, float step, float alpha);
+
+	// wait for the simulation started and make its result the one written by writeBackInterpolated()
+	void finishSimulation();
+
+	// write to the meshes the result of the last simulation finished, interpolated between its last two steps
+	// (nothing is written if it is the same as the one written before)
+	void writeBackInterpolated();
+
+	// components of an object
+	int getNumObjects() const;
+	int getNumMovingObjects() const; // the ones which move or rotate
+	Vector3 getTranslation(int index) const;
+	Vector3 getRotationAngles(int index) const;
+	Vector3 getDirection(int index) const;
+
+private:
+	// objects in each block done in parallel (a multiple of 4)
+	static const int kBlockSize = 4096;
+
+	// the mesh prefetched while writing back is the one of this number of objects ahead
+	static const int kPrefetchDistance = 8;
+
+	ThreadPool* thread_pool_;
+
+	// number of objects, the arrays have a multiple of 4 elements (the padding objects have no flags, so they never move)
+	int num_objects_;
+
+	// components of each object
+	vector<float> translation_x_, translation_y_, translation_z_;
+	vector<float> rotation_x_, rotation_y_, rotation_z_;
+	vector<float> direction_x_, direction_y_, direction_z_;
+	vector<float> min_x_, min_y_, min_z_;
+	vector<float> max_x_, max_y_, max_z_;
+	vector<float> speed_;
+	vector<int> flags_;
+
+	// mesh of each object (nullptr if it has no mesh)
+	vector<BaseMesh*> meshes_;
+
+	/* PIPELINED SIMULATION */
+
+	// components of the objects written back to the meshes, interpolated between the last two steps of a simulation (same arrays as above)
+	struct RenderState
+	{
+		vector<float> translation_x, translation_y, translation_z;
+		vector<float> rotation_x, rotation_y, rotation_z;
+		vector<float> direction_x, direction_y, direction_z;
+		float alpha = 0.0f;
+		unsigned int version = 0; // it changes when the state is not the same as the one before
+	};
+
+	// translation and rotation before the last step
+	vector<float> previous_translation_x_, previous_translation_y_, previous_translation_z_;
+	vector<float> previous_rotation_x_, previous_rotation_y_, previous_rotation_z_;
+
+	// double buffer of the states: the worker writes one while the GL thread reads the other
+	RenderState render_states_[2];
+	int render_read_index_;
+
+	// version of the last state simulated (only changed by the worker) and of the last one written to the meshes (only by the GL thread)
+	unsigned int render_version_;
+	unsigned int written_version_;
+
+	// the simulation running in the worker (simulation_started_ is only used by the thread which starts and finishes them)
+	bool simulating_;
+	bool simulation_started_;
+	mutex simulation_mutex_;
+	condition_variable simulation_condition_;
+
+	// run the steps and interpolate the result into the render state which is not being read
+	void simulate(int num_steps, float step, float alpha);
+
+	// call job(begin, end) for the blocks of objects, in parallel if there are several blocks
+	void forEachBlock(const function<void(int, int)>& job);
+
+	// move the objects [begin, end), begin and end are multiples of 4
+	void integrateRange(float dt, int begin, int end);
+
+	// interpolate the objects [begin, end) between the last two steps into the render state, begin and end are multiples of 4
+	void interpolateRange(float alpha, RenderState& state, int begin, int end);
+};
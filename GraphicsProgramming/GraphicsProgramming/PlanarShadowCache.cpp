@@ -0,0 +1,129 @@
+#include "PlanarShadowCache.h"
+#include <string.h> // memcmp, memcpy
+
+PlanarShadowCache::PlanarShadowCache()
+	: num_reused_(0), num_flattened_(0), num_fallbacks_(0), bytes_(0)
+{
+}
+
+void PlanarShadowCache::beginFrame()
+{
+	num_reused_ = 0;
+	num_flattened_ = 0;
+	num_fallbacks_ = 0;
+}
+
+void PlanarShadowCache::render(GLenum light_id, MeshPlane* receiver, BaseMesh* caster, const float shadow_matrix[16], const float colour[4])
+{
+	// the geometry has been evicted by the residency manager, the mesh wouldn't render its shadow either
+	if (!caster->isGeometryResident())
+	{
+		return;
+	}
+
+	// the caster has no proxy yet, render it through the shadow matrix (with the colour of render(true))
+	if (!caster->hasShadowProxy())
+	{
+		glPushMatrix();
+			glMultMatrixf(shadow_matrix);
+			caster->render(true);
+		glPopMatrix();
+
+		num_fallbacks_++;
+		return;
+	}
+
+	/* Flatten the shadow again only if the light, the receiver or the caster have moved */
+
+	float caster_matrix[16];
+	caster->getTransformMatrix(caster_matrix);
+
+	tuple<GLenum, MeshPlane*, BaseMesh*> key(light_id, receiver, caster);
+	map<tuple<GLenum, MeshPlane*, BaseMesh*>, Entry>::iterator it = entries_.find(key);
+	if (it != entries_.end() && memcmp(it->second.shadow_matrix, shadow_matrix, sizeof(it->second.shadow_matrix)) == 0 &&
+		memcmp(it->second.caster_matrix, caster_matrix, sizeof(caster_matrix)) == 0)
+	{
+		num_reused_++;
+	}
+	else
+	{
+		if (it == entries_.end())
+		{
+			it = entries_.insert(make_pair(key, Entry())).first;
+		}
+		Entry& entry = it->second;
+		memcpy(entry.shadow_matrix, shadow_matrix, sizeof(entry.shadow_matrix));
+		memcpy(entry.caster_matrix, caster_matrix, sizeof(entry.caster_matrix));
+
+		// matrix = shadow * caster (column major)
+		float matrix[16];
+		for (int column = 0; column < 4; column++)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				matrix[column * 4 + row] = 0.0f;
+				for (int k = 0; k < 4; k++)
+				{
+					matrix[column * 4 + row] += shadow_matrix[k * 4 + row] * caster_matrix[column * 4 + k];
+				}
+			}
+		}
+
+		bytes_ -= entry.vertices.size() * sizeof(float);
+		flatten(matrix, caster->getShadowProxyVertices(), entry.vertices);
+		bytes_ += entry.vertices.size() * sizeof(float);
+
+		num_flattened_++;
+	}
+
+	/* Render the flattened shadow */
+
+	const vector<unsigned int>& indices = caster->getShadowProxyIndices();
+	glColor4fv(colour);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(4, GL_FLOAT, 0, it->second.vertices.data());
+	glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, indices.data());
+	BaseMesh::countDraw();
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void PlanarShadowCache::clear()
+{
+	entries_.clear();
+	bytes_ = 0;
+}
+
+void PlanarShadowCache::flatten(const float matrix[16], const vector<float>& positions, vector<float>& vertices)
+{
+	size_t num_vertices = positions.size() / 3;
+	vertices.resize(num_vertices * 4);
+
+	for (size_t i = 0; i < num_vertices; i++)
+	{
+		float x = positions[i * 3], y = positions[i * 3 + 1], z = positions[i * 3 + 2];
+		vertices[i * 4] = matrix[0] * x + matrix[4] * y + matrix[8] * z + matrix[12];
+		vertices[i * 4 + 1] = matrix[1] * x + matrix[5] * y + matrix[9] * z + matrix[13];
+		vertices[i * 4 + 2] = matrix[2] * x + matrix[6] * y + matrix[10] * z + matrix[14];
+		vertices[i * 4 + 3] = matrix[3] * x + matrix[7] * y + matrix[11] * z + matrix[15];
+	}
+}
+
+int PlanarShadowCache::getNumReused() const
+{
+	return num_reused_;
+}
+
+int PlanarShadowCache::getNumFlattened() const
+{
+	return num_flattened_;
+}
+
+int PlanarShadowCache::getNumFallbacks() const
+{
+	return num_fallbacks_;
+}
+
+size_t PlanarShadowCache::getBytes() const
+{
+	return bytes_;
+}
@@ -0,0 +1,66 @@
+// Class Planar Shadow Cache
+// It keeps the planar shadow of each caster from each light on each receiver already flattened (the vertices of the shadow proxy of the caster multiplied by its matrix
+// and by the shadow matrix) so the shadow is drawn with only one glDrawElements instead of rendering the full mesh through the shadow matrix.
+// The shadow of a caster on a receiver is only flattened again when the shadow matrix (the light or the receiver have moved) or the matrix of the caster
+// have changed, so the static casters (and all of them while the scene is paused) reuse the same shadow every frame.
+// The vertices are kept with their w (x, y, z, w) because the shadow matrix is a projection, so openGL does the division as it would do with the mesh.
+// The casters which have no proxy yet are rendered through the shadow matrix as before.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+// Include GLUT, openGL, input.
+#include "glut.h"
+#include <gl/GL.h>
+#include <gl/GLU.h>
+#include <vector>
+#include <map>
+#include <tuple>
+
+#include "BaseMesh.h"
+#include "MeshPlane.h"
+
+using namespace std;
+
+class PlanarShadowCache
+{
+public:
+	// constructor
+	PlanarShadowCache();
+
+	// reset the stats of the frame
+	void beginFrame();
+
+	// render the shadow of the caster from the light on the receiver (in world coords, so without the shadow matrix applied) with the colour passed
+	// it is flattened again only if something has moved
+	void render(GLenum light_id, MeshPlane* receiver, BaseMesh* caster, const float shadow_matrix[16], const float colour[4]);
+
+	// remove all the shadows kept (ex: the meshes have been changed)
+	void clear();
+
+	// stats
+	int getNumReused() const; // shadows reused in this frame
+	int getNumFlattened() const; // shadows flattened again in this frame
+	int getNumFallbacks() const; // shadows rendered through the shadow matrix in this frame
+	size_t getBytes() const; // memory used by the shadows kept
+
+private:
+	// shadow of a caster on a receiver and the matrices it was flattened with, the indices are the ones of the proxy
+	struct Entry
+	{
+		float shadow_matrix[16];
+		float caster_matrix[16];
+		vector<float> vertices; // x, y, z, w
+	};
+
+	map<tuple<GLenum, MeshPlane*, BaseMesh*>, Entry> entries_;
+
+	// stats
+	int num_reused_;
+	int num_flattened_;
+	int num_fallbacks_;
+	size_t bytes_;
+
+	// flatten the vertices (x, y, z) with the matrix (shadow * caster), keeping the w of each vertex
+	static void flatten(const float matrix[16], const vector<float>& positions, vector<float>& vertices);
+};
@@ -0,0 +1,220 @@
+#include "PlanarShadowPairing.h"
+#include <math.h>
+
+PlanarShadowPairing::PlanarShadowPairing()
+	: num_draws_(0), num_skipped_(0), num_full_casters_(0), num_blob_casters_(0)
+{
+}
+
+void PlanarShadowPairing::addReceiver(MeshPlane* receiver)
+{
+	receivers_.push_back(receiver);
+	draw_lists_.push_back(vector<BaseMesh*>());
+	blob_lists_.push_back(vector<BlobShadowPlacement>());
+}
+
+void PlanarShadowPairing::addCaster(BaseMesh* caster)
+{
+	casters_.push_back(caster);
+	blob_casters_.push_back(false);
+}
+
+void PlanarShadowPairing::setLODPolicy(const ShadowLODPolicy& lod_policy)
+{
+	lod_policy_ = lod_policy;
+}
+
+void PlanarShadowPairing::update(const float light_position[4], const Frustum& frustum)
+{
+	num_draws_ = 0;
+	num_skipped_ = 0;
+	num_full_casters_ = 0;
+	num_blob_casters_ = 0;
+
+	/* Detail of the shadow of each caster, by its distance to the camera and its size on the screen */
+
+	Vector3 eye = frustum.getEyePosition();
+	for (size_t c = 0; c < casters_.size(); c++)
+	{
+		Vector3 center;
+		float radius;
+		blob_casters_[c] = false;
+		if (casters_[c]->getBoundingSphere(center, radius))
+		{
+			float distance = (center - eye).length();
+			blob_casters_[c] = distance > lod_policy_.blob_distance || frustum.getProjectedSize(center, radius) < lod_policy_.blob_projected_size;
+		}
+
+		if (blob_casters_[c])
+			num_blob_casters_++;
+		else
+			num_full_casters_++;
+	}
+
+	for (size_t r = 0; r < receivers_.size(); r++)
+	{
+		draw_lists_[r].clear();
+		blob_lists_[r].clear();
+
+		/* Plane and rectangle of the receiver */
+
+		Vector3 normal, rectangle_min, rectangle_max;
+		float distance;
+		getReceiverPlane(receivers_[r], normal, distance, rectangle_min, rectangle_max);
+
+		/* Casters whose shadow lands on it */
+
+		for (size_t c = 0; c < casters_.size(); c++)
+		{
+			Vector3 center;
+			float radius;
+			// the meshes without bounds (not loaded yet) are always drawn
+			if (!casters_[c]->getBoundingSphere(center, radius))
+			{
+				draw_lists_[r].push_back(casters_[c]);
+				continue;
+			}
+
+			Vector3 shadow_min, shadow_max;
+			if (canCastShadow(light_position, normal, distance, rectangle_min, rectangle_max, center, radius, shadow_min, shadow_max))
+			{
+				// the blob needs the box of the shadow (it is infinite if the caster reaches the height of the light)
+				if (blob_casters_[c] && shadow_max.x < 1e29f)
+				{
+					BlobShadowPlacement blob = { shadow_min, shadow_max };
+					blob_lists_[r].push_back(blob);
+				}
+				else
+				{
+					draw_lists_[r].push_back(casters_[c]);
+				}
+			}
+		}
+
+		int num_receiver_draws = (int)(draw_lists_[r].size() + blob_lists_[r].size());
+		num_draws_ += num_receiver_draws;
+		num_skipped_ += (int)casters_.size() - num_receiver_draws;
+	}
+}
+
+bool PlanarShadowPairing::canCastShadow(const float light_position[4], Vector3 normal, float distance, const Vector3& rectangle_min, const Vector3& rectangle_max,
+	Vector3 center, float radius, Vector3& shadow_min, Vector3& shadow_max)
+{
+	Vector3 light(light_position[0], light_position[1], light_position[2]);
+	bool is_directional = (light_position[3] == 0.0f);
+
+	// height of the light over the plane (for directional lights, the cosine between the direction and the normal)
+	float light_height = is_directional ? normal.dot(light.normalised()) : normal.dot(light) - distance;
+
+	// the light is behind the plane, the receiver is not lit so it has no shadows
+	if (light_height <= 0.0f)
+	{
+		return false;
+	}
+
+	// the caster is behind the plane
+	float center_height = normal.dot(center) - distance;
+	if (center_height < -radius)
+	{
+		return false;
+	}
+
+	// the caster is over the light, its projection would go through the light
+	if (!is_directional && center_height - radius >= light_height)
+	{
+		return false;
+	}
+
+	/* Project the corners of the bounding box of the sphere onto the plane */
+
+	const float kEpsilon = 0.001f;
+	shadow_min = Vector3(1e30f, 1e30f, 1e30f);
+	shadow_max = Vector3(-1e30f, -1e30f, -1e30f);
+	for (int i = 0; i < 8; i++)
+	{
+		Vector3 corner(center.x + ((i & 1) ? radius : -radius), center.y + ((i & 2) ? radius : -radius), center.z + ((i & 4) ? radius : -radius));
+		float corner_height = normal.dot(corner) - distance;
+
+		Vector3 projected;
+		if (is_directional)
+		{
+			// move the corner along the direction of the light until it reaches the plane
+			projected = corner - light.normalised() * (corner_height / light_height);
+		}
+		else
+		{
+			// the corner is as high as the light, its shadow has no limit so the caster is drawn
+			if (light_height - corner_height <= kEpsilon)
+			{
+				shadow_min = Vector3(-1e30f, -1e30f, -1e30f);
+				shadow_max = Vector3(1e30f, 1e30f, 1e30f);
+				return true;
+			}
+			// point of the line from the light through the corner which is on the plane
+			projected = light + (corner - light) * (light_height / (light_height - corner_height));
+		}
+
+		shadow_min = Vector3(fminf(shadow_min.x, projected.x), fminf(shadow_min.y, projected.y), fminf(shadow_min.z, projected.z));
+		shadow_max = Vector3(fmaxf(shadow_max.x, projected.x), fmaxf(shadow_max.y, projected.y), fmaxf(shadow_max.z, projected.z));
+	}
+
+	// the shadow touches the rectangle (the projected points are on the plane, so the axis of the normal always overlaps)
+	return shadow_min.x <= rectangle_max.x + kEpsilon && shadow_max.x >= rectangle_min.x - kEpsilon &&
+		shadow_min.y <= rectangle_max.y + kEpsilon && shadow_max.y >= rectangle_min.y - kEpsilon &&
+		shadow_min.z <= rectangle_max.z + kEpsilon && shadow_max.z >= rectangle_min.z - kEpsilon;
+}
+
+void PlanarShadowPairing::getReceiverPlane(MeshPlane* receiver, Vector3& normal, float& distance, Vector3& rectangle_min, Vector3& rectangle_max)
+{
+	// the planes are aligned with the axes, so the box of the PQR vertices is the rectangle
+	vector<float> PQR_vertices = receiver->getPQRVertices();
+	rectangle_min = Vector3(PQR_vertices[0], PQR_vertices[1], PQR_vertices[2]);
+	rectangle_max = rectangle_min;
+	for (int i = 3; i < 9; i += 3)
+	{
+		rectangle_min = Vector3(fminf(rectangle_min.x, PQR_vertices[i]), fminf(rectangle_min.y, PQR_vertices[i + 1]), fminf(rectangle_min.z, PQR_vertices[i + 2]));
+		rectangle_max = Vector3(fmaxf(rectangle_max.x, PQR_vertices[i]), fmaxf(rectangle_max.y, PQR_vertices[i + 1]), fmaxf(rectangle_max.z, PQR_vertices[i + 2]));
+	}
+	normal = receiver->getNormal();
+	distance = normal.dot(rectangle_min);
+}
+
+int PlanarShadowPairing::getNumReceivers() const
+{
+	return (int)receivers_.size();
+}
+
+MeshPlane* PlanarShadowPairing::getReceiver(int receiver) const
+{
+	return receivers_[receiver];
+}
+
+const vector<BaseMesh*>& PlanarShadowPairing::getCasters(int receiver) const
+{
+	return draw_lists_[receiver];
+}
+
+const vector<BlobShadowPlacement>& PlanarShadowPairing::getBlobs(int receiver) const
+{
+	return blob_lists_[receiver];
+}
+
+int PlanarShadowPairing::getNumDraws() const
+{
+	return num_draws_;
+}
+
+int PlanarShadowPairing::getNumSkipped() const
+{
+	return num_skipped_;
+}
+
+int PlanarShadowPairing::getNumFullCasters() const
+{
+	return num_full_casters_;
+}
+
+int PlanarShadowPairing::getNumBlobCasters() const
+{
+	return num_blob_casters_;
+}
@@ -0,0 +1,98 @@
+// Class Planar Shadow Pairing
+// It decides which casters have to be rendered (flattened with the shadow matrix) on each receiver plane, so the shadows which can't be seen are not drawn.
+// For each receiver: if the light is behind the plane no caster is drawn on it. For each caster: if its bounding sphere is behind the plane or over the light
+// (the shadow matrix would project it through the light) it is skipped, otherwise the corners of its bounding box are projected from the light onto the plane
+// and the caster is only drawn if the box of the projected corners touches the rectangle of the receiver.
+// The pairing is done once per frame, before the shadows are rendered, and it gives a list of casters for each receiver.
+// It also chooses the detail of each shadow (LOD): the casters far from the camera or small on the screen get a blob shadow (a quad with a soft
+// round texture placed on the box of the projected corners) instead of the full mesh flattened with the shadow matrix.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+// Include GLUT, openGL, input.
+#include "glut.h"
+#include <gl/GL.h>
+#include <gl/GLU.h>
+#include <vector>
+
+#include "BaseMesh.h"
+#include "MeshPlane.h"
+#include "Vector3.h"
+#include "Frustum.h"
+
+using namespace std;
+
+// when a caster gets a blob shadow instead of the full shadow
+struct ShadowLODPolicy
+{
+	float blob_distance = 25.0f; // distance from the camera (world units) from which the shadows are blobs
+	float blob_projected_size = 16.0f; // size on the screen (pixels) under which the shadows are blobs
+};
+
+// blob shadow of a caster on a receiver: box of the shadow on the plane
+struct BlobShadowPlacement
+{
+	Vector3 shadow_min;
+	Vector3 shadow_max;
+};
+
+class PlanarShadowPairing
+{
+public:
+	// constructor
+	PlanarShadowPairing();
+
+	// add a plane which receives shadows or a mesh which casts shadows
+	void addReceiver(MeshPlane* receiver);
+	void addCaster(BaseMesh* caster);
+
+	// set when the shadows are replaced by blobs
+	void setLODPolicy(const ShadowLODPolicy& lod_policy);
+
+	// build the lists of casters and blobs of each receiver for the light (world coords, w = 0 for directional lights)
+	// the frustum of the camera is used to choose the detail of the shadows
+	void update(const float light_position[4], const Frustum& frustum);
+
+	// receivers, in the order they were added
+	int getNumReceivers() const;
+	MeshPlane* getReceiver(int receiver) const;
+
+	// casters whose full shadow can land on the receiver and the blob shadows on it
+	const vector<BaseMesh*>& getCasters(int receiver) const;
+	const vector<BlobShadowPlacement>& getBlobs(int receiver) const;
+
+	// stats of the last update
+	int getNumDraws() const; // shadows drawn (full and blobs)
+	int getNumSkipped() const; // shadows not drawn (receivers x casters - draws)
+	int getNumFullCasters() const; // casters with full shadows
+	int getNumBlobCasters() const; // casters with blob shadows
+
+	// return false if the shadow of the sphere from the light can't land on the rectangle (the box min and max of the receiver in world coords)
+	// normal and distance: plane of the receiver (normal . point = distance) with the normal looking at its front
+	// shadow_min and shadow_max: box of the shadow on the plane, it is infinite if the sphere reaches the height of the light
+	static bool canCastShadow(const float light_position[4], Vector3 normal, float distance, const Vector3& rectangle_min, const Vector3& rectangle_max,
+		Vector3 center, float radius, Vector3& shadow_min, Vector3& shadow_max);
+
+	// plane (normal . point = distance) and rectangle (box min and max in world coords) of a receiver, as canCastShadow() needs them
+	static void getReceiverPlane(MeshPlane* receiver, Vector3& normal, float& distance, Vector3& rectangle_min, Vector3& rectangle_max);
+
+private:
+	vector<MeshPlane*> receivers_;
+	vector<BaseMesh*> casters_;
+
+	ShadowLODPolicy lod_policy_;
+
+	// casters and blobs to draw of each receiver, the lists are reused each frame
+	vector<vector<BaseMesh*>> draw_lists_;
+	vector<vector<BlobShadowPlacement>> blob_lists_;
+
+	// if each caster gets a blob shadow in this frame
+	vector<bool> blob_casters_;
+
+	// stats
+	int num_draws_;
+	int num_skipped_;
+	int num_full_casters_;
+	int num_blob_casters_;
+};
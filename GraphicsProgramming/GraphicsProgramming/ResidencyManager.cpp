@@ -0,0 +1,473 @@
+#include "ResidencyManager.h"
+#include "PlanarShadowPairing.h" // canCastShadow
+#include <unordered_set>
+#include <algorithm> // sort
+#include <math.h>
+#include <cstdio> // remove
+#ifdef _WIN32
+#include <process.h> // _getpid
+#else
+#include <unistd.h> // getpid
+#endif
+
+// number of managers created in this process, part of the names of their files
+static atomic<int> num_managers(0);
+
+ResidencyManager::ResidencyManager(ThreadPool* thread_pool, ResidencyBudget budget, const char* cache_directory)
+	: thread_pool_(thread_pool), budget_(budget), cache_directory_(cache_directory), static_bytes_(0)
+{
+#ifdef _WIN32
+	int process_id = _getpid();
+#else
+	int process_id = (int)getpid();
+#endif
+	cache_prefix_ = cache_directory_ + "geometry_" + to_string(process_id) + "_" + to_string(num_managers++) + "_";
+}
+
+ResidencyManager::~ResidencyManager()
+{
+	// the loads still running read the files, they are waited before deleting them (they keep their own copy of the data)
+	auto loads_finished = [this]()
+	{
+		for (const MeshEntry& entry : meshes_)
+		{
+			if (entry.load_state != nullptr && entry.load_state->load() == kLoading)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+	if (thread_pool_ != nullptr)
+	{
+		thread_pool_->waitUntil(loads_finished);
+	}
+
+	// the geometry saved is only valid for this run
+	for (const MeshEntry& entry : meshes_)
+	{
+		remove(entry.cache_url.c_str());
+	}
+}
+
+void ResidencyManager::addMesh(BaseMesh* mesh)
+{
+	MeshEntry entry;
+	entry.mesh = mesh;
+	entry.cache_url = cache_prefix_ + to_string(meshes_.size()) + ".bin";
+
+	// textures of the mesh and its parts, a texture used twice by the same mesh is only added once
+	vector<Texture*> textures;
+	mesh->getTextures(textures);
+	for (Texture* texture : textures)
+	{
+		if (find(entry.textures.begin(), entry.textures.end(), texture) == entry.textures.end())
+		{
+			addTexture(texture);
+			entry.textures.push_back(texture);
+		}
+	}
+
+	mesh_indices_[mesh] = (int)meshes_.size();
+	meshes_.push_back(entry);
+}
+
+void ResidencyManager::addShadowCaster(BaseMesh* caster)
+{
+	auto index = mesh_indices_.find(caster);
+	if (index != mesh_indices_.end())
+	{
+		meshes_[index->second].casts_shadow = true;
+	}
+}
+
+void ResidencyManager::addShadowReceiver(MeshPlane* receiver)
+{
+	shadow_receivers_.push_back(receiver);
+}
+
+void ResidencyManager::addMirror(MeshMirrorWorld* mirror)
+{
+	mirrors_.push_back(mirror);
+}
+
+void ResidencyManager::addStaticBytes(size_t bytes)
+{
+	static_bytes_ += bytes;
+}
+
+void ResidencyManager::setShadowLights(const vector<vector<GLfloat>>& light_positions)
+{
+	shadow_lights_ = light_positions;
+}
+
+void ResidencyManager::addTexture(Texture* texture)
+{
+	if (texture == nullptr || texture_indices_.find(texture) != texture_indices_.end())
+	{
+		return;
+	}
+
+	TextureEntry entry;
+	entry.texture = texture;
+	texture_indices_[texture] = (int)textures_.size();
+	textures_.push_back(entry);
+}
+
+void ResidencyManager::update(const Frustum& frustum)
+{
+	// set the geometry loaded by the workers since the last frame
+	finishPendingLoads();
+
+	// reset the size of the textures, it is the biggest size of their users in this frame
+	for (TextureEntry& texture_entry : textures_)
+	{
+		texture_entry.projected_size = 0.0f;
+		texture_entry.num_users = 0;
+	}
+
+	/* Receivers and mirrors in the frustum, the meshes out of it can still be seen in them */
+
+	visible_receivers_.clear();
+	for (MeshPlane* receiver : shadow_receivers_)
+	{
+		Vector3 center;
+		float radius;
+		if (!receiver->getBoundingSphere(center, radius) || frustum.isSphereVisible(center, radius))
+		{
+			ReceiverPlane plane;
+			PlanarShadowPairing::getReceiverPlane(receiver, plane.normal, plane.distance, plane.rectangle_min, plane.rectangle_max);
+			visible_receivers_.push_back(plane);
+		}
+	}
+
+	unordered_set<const BaseMesh*> reflected_meshes;
+	for (MeshMirrorWorld* mirror : mirrors_)
+	{
+		Vector3 center;
+		float radius;
+		if (!mirror->getBoundingSphere(center, radius) || frustum.isSphereVisible(center, radius))
+		{
+			reflected_meshes.insert(mirror->getReflectedShapes().begin(), mirror->getReflectedShapes().end());
+		}
+	}
+
+	/* Visibility of the meshes */
+	for (MeshEntry& entry : meshes_)
+	{
+		Vector3 center;
+		float radius;
+		bool has_bounds = entry.mesh->getBoundingSphere(center, radius);
+
+		// the meshes without bounds are always considered visible, and the reflected ones are seen in the mirror (with their textures)
+		bool visible = !has_bounds || frustum.isSphereVisible(center, radius) || reflected_meshes.count(entry.mesh) > 0;
+		float projected_size = has_bounds ? frustum.getProjectedSize(center, radius) : 1e30f;
+
+		// the shadows only need the geometry, the textures are not given more detail for them
+		bool geometry_needed = visible || (entry.casts_shadow && isShadowVisible(center, radius));
+
+		for (Texture* texture : entry.textures)
+		{
+			TextureEntry& texture_entry = textures_[texture_indices_[texture]];
+			texture_entry.num_users++;
+			if (visible && projected_size > texture_entry.projected_size)
+			{
+				texture_entry.projected_size = projected_size;
+			}
+		}
+
+		if (geometry_needed)
+		{
+			entry.frames_not_visible = 0;
+
+			// it is seen again, load its geometry
+			if (!entry.mesh->isGeometryResident() && entry.load_state == nullptr)
+			{
+				startLoad(entry);
+			}
+		}
+		else
+		{
+			entry.frames_not_visible++;
+		}
+	}
+
+	evictMeshes();
+	updateTextures();
+}
+
+bool ResidencyManager::isShadowVisible(const Vector3& center, float radius) const
+{
+	for (const vector<GLfloat>& light_position : shadow_lights_)
+	{
+		for (const ReceiverPlane& plane : visible_receivers_)
+		{
+			Vector3 shadow_min, shadow_max;
+			if (PlanarShadowPairing::canCastShadow(light_position.data(), plane.normal, plane.distance, plane.rectangle_min, plane.rectangle_max,
+				center, radius, shadow_min, shadow_max))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void ResidencyManager::finishPendingLoads()
+{
+	for (MeshEntry& entry : meshes_)
+	{
+		if (entry.load_state == nullptr || entry.load_state->load() == kLoading)
+		{
+			continue;
+		}
+
+		if (entry.load_state->load() == kLoaded)
+		{
+			entry.mesh->restoreGeometry(*entry.pending_geometry);
+		}
+		else
+		{
+			printf("Error: the geometry of a mesh could not be loaded from %s\n", entry.cache_url.c_str());
+		}
+
+		entry.pending_geometry = nullptr;
+		entry.load_state = nullptr;
+	}
+}
+
+void ResidencyManager::startLoad(MeshEntry& entry)
+{
+	entry.pending_geometry = make_shared<GeometryData>();
+	entry.load_state = make_shared<atomic<int>>(kLoading);
+
+	// the task only uses its copies, not the mesh (it is rendered while the file is read)
+	shared_ptr<GeometryData> geometry = entry.pending_geometry;
+	shared_ptr<atomic<int>> load_state = entry.load_state;
+	string cache_url = entry.cache_url;
+	function<void()> load = [geometry, load_state, cache_url]()
+	{
+		load_state->store(BaseMesh::readGeometry(cache_url, *geometry) ? kLoaded : kFailed);
+	};
+
+	if (thread_pool_ != nullptr)
+	{
+		thread_pool_->submitToWorkers(load); // the GL thread doesn't read the file while it waits for the frame tasks
+	}
+	else
+	{
+		load();
+	}
+}
+
+void ResidencyManager::evictMeshes()
+{
+	// free the meshes which have not been seen for a while
+	for (MeshEntry& entry : meshes_)
+	{
+		if (entry.mesh->isGeometryResident() && entry.load_state == nullptr && entry.frames_not_visible >= budget_.frames_to_evict && entry.mesh->getGeometryBytes() > 0)
+		{
+			if (!entry.mesh->evictGeometry(entry.cache_url))
+			{
+				printf("Error: the geometry of a mesh could not be saved in %s\n", entry.cache_url.c_str());
+			}
+		}
+	}
+
+	// if the memory is still over the budget, free the meshes not seen for longer first (even if they have not reached the frames to evict)
+	while (getCPUBytes() > budget_.cpu_bytes)
+	{
+		MeshEntry* oldest = nullptr;
+		for (MeshEntry& entry : meshes_)
+		{
+			if (entry.mesh->isGeometryResident() && entry.load_state == nullptr && entry.frames_not_visible > 0 && entry.mesh->getGeometryBytes() > 0
+				&& (oldest == nullptr || entry.frames_not_visible > oldest->frames_not_visible))
+			{
+				oldest = &entry;
+			}
+		}
+
+		// all the meshes left are visible
+		if (oldest == nullptr || !oldest->mesh->evictGeometry(oldest->cache_url))
+		{
+			break;
+		}
+	}
+}
+
+void ResidencyManager::updateTextures()
+{
+	/* Choose the first level of each texture */
+
+	vector<int> desired_levels(textures_.size());
+	size_t total_bytes = 0;
+	for (size_t i = 0; i < textures_.size(); i++)
+	{
+		Texture* texture = textures_[i].texture;
+
+		// the textures which can't be streamed or are not used by any mesh (ex: used directly by the scene) keep their levels
+		if (!texture->isStreamable() || textures_[i].num_users == 0)
+		{
+			desired_levels[i] = texture->getFirstLevel();
+		}
+		else
+		{
+			float size = (textures_[i].projected_size > 0.0f) ? textures_[i].projected_size : (float)budget_.unused_texture_size;
+			desired_levels[i] = getLevelForSize(texture, size);
+		}
+		total_bytes += texture->getGPUBytes(desired_levels[i]);
+	}
+
+	// over the budget: remove a level of the biggest texture until it fits
+	while (total_bytes > budget_.gpu_bytes)
+	{
+		int biggest = -1;
+		size_t biggest_bytes = 0;
+		for (size_t i = 0; i < textures_.size(); i++)
+		{
+			Texture* texture = textures_[i].texture;
+			if (texture->isStreamable() && textures_[i].num_users > 0 && desired_levels[i] < texture->getNumLevels() - 1
+				&& texture->getGPUBytes(desired_levels[i]) > biggest_bytes)
+			{
+				biggest = (int)i;
+				biggest_bytes = texture->getGPUBytes(desired_levels[i]);
+			}
+		}
+
+		// all the textures are in their smallest level
+		if (biggest == -1)
+		{
+			break;
+		}
+
+		desired_levels[biggest]++;
+		total_bytes -= biggest_bytes - textures_[biggest].texture->getGPUBytes(desired_levels[biggest]);
+	}
+
+	/* Upload the textures which must change */
+
+	bool over_budget = getGPUBytes() > budget_.gpu_bytes;
+
+	// index of the texture and if it is needed to free memory
+	vector<pair<int, bool>> changes;
+	for (size_t i = 0; i < textures_.size(); i++)
+	{
+		int current_level = textures_[i].texture->getFirstLevel();
+		if (desired_levels[i] < current_level)
+		{
+			// more detail is needed, it is uploaded as soon as possible
+			textures_[i].frames_wanting_less = 0;
+			changes.push_back(make_pair((int)i, false));
+		}
+		else if (desired_levels[i] > current_level)
+		{
+			// less detail is needed, wait some frames in case it is needed again (ex: the camera turns around) unless the memory is over the budget
+			textures_[i].frames_wanting_less++;
+			if (over_budget || textures_[i].frames_wanting_less >= budget_.frames_to_reduce)
+			{
+				changes.push_back(make_pair((int)i, over_budget));
+			}
+		}
+		else
+		{
+			textures_[i].frames_wanting_less = 0;
+		}
+	}
+
+	// first the changes to free memory, then the biggest textures on the screen
+	sort(changes.begin(), changes.end(), [this](const pair<int, bool>& a, const pair<int, bool>& b)
+	{
+		if (a.second != b.second)
+		{
+			return a.second;
+		}
+		return textures_[a.first].projected_size > textures_[b.first].projected_size;
+	});
+
+	// upload only some textures per frame
+	for (int i = 0; i < (int)changes.size() && i < budget_.max_texture_changes_per_frame; i++)
+	{
+		int index = changes[i].first;
+		if (textures_[index].texture->setFirstLevel(desired_levels[index]))
+		{
+			textures_[index].frames_wanting_less = 0;
+		}
+	}
+}
+
+int ResidencyManager::getLevelForSize(const Texture* texture, float size) const
+{
+	// each level is half the size of the previous one, so the level which fits the size is log2(texture size / screen size)
+	int largest_side = (texture->getWidth() > texture->getHeight()) ? texture->getWidth() : texture->getHeight();
+	if (size < 1.0f)
+	{
+		size = 1.0f;
+	}
+
+	int level = (int)floorf(log2f((float)largest_side / size));
+	if (level < 0)
+	{
+		level = 0;
+	}
+	if (level > texture->getNumLevels() - 1)
+	{
+		level = texture->getNumLevels() - 1;
+	}
+	return level;
+}
+
+void ResidencyManager::setBudget(ResidencyBudget budget)
+{
+	budget_ = budget;
+}
+
+ResidencyBudget ResidencyManager::getBudget() const
+{
+	return budget_;
+}
+
+size_t ResidencyManager::getGPUBytes() const
+{
+	size_t bytes = 0;
+	for (const TextureEntry& entry : textures_)
+	{
+		bytes += entry.texture->getGPUBytes();
+	}
+	return bytes;
+}
+
+size_t ResidencyManager::getCPUBytes() const
+{
+	size_t bytes = static_bytes_;
+	for (const MeshEntry& entry : meshes_)
+	{
+		bytes += entry.mesh->getGeometryBytes();
+	}
+	return bytes;
+}
+
+int ResidencyManager::getNumEvictedMeshes() const
+{
+	int num_evicted = 0;
+	for (const MeshEntry& entry : meshes_)
+	{
+		if (!entry.mesh->isGeometryResident())
+		{
+			num_evicted++;
+		}
+	}
+	return num_evicted;
+}
+
+int ResidencyManager::getNumPendingLoads() const
+{
+	int num_pending = 0;
+	for (const MeshEntry& entry : meshes_)
+	{
+		if (entry.load_state != nullptr)
+		{
+			num_pending++;
+		}
+	}
+	return num_pending;
+}
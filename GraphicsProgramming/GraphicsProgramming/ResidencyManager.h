@@ -0,0 +1,161 @@
+// Class Residency Manager
+// It keeps the memory used by the textures (graphics card) and the meshes (arrays of coords) under a budget.
+// Each frame it checks which meshes are inside the frustum of the camera and how big they are on the screen:
+// - Textures: only the mip levels needed for the size of their biggest user on the screen are uploaded (the rest stay in the texture cache),
+//   if the total is over the budget the biggest textures lose detail first.
+// - Meshes: the arrays of coords of the meshes not seen for some frames are saved in the disk and freed,
+//   when the mesh is seen again they are read in a worker thread and set back in the mesh once they are loaded.
+//   A mesh out of the frustum is still kept if its shadow can land on a floor/wall which is in the frustum (for the shadow lights) or
+//   if a mirror in the frustum reflects it by rendering it again.
+// update() must be called once per frame after updating the frustum.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include "BaseMesh.h"
+#include "Texture.h"
+#include "Frustum.h"
+#include "ThreadPool.h"
+#include "MeshPlane.h"
+#include "MeshMirrorWorld.h"
+
+#include <vector>
+#include <unordered_map>
+#include <memory> // shared_ptr
+#include <atomic>
+#include <string>
+
+using namespace std;
+
+// memory limits and behaviour of the residency manager
+struct ResidencyBudget
+{
+	size_t gpu_bytes = 64 * 1024 * 1024; // memory for the textures
+	size_t cpu_bytes = 32 * 1024 * 1024; // memory for the arrays of coords of the meshes
+	int frames_to_evict = 300; // frames a mesh must be out of the frustum before freeing its geometry
+	int frames_to_reduce = 60; // frames a texture must be needing less detail before removing its levels (avoid reloading it constantly)
+	int max_texture_changes_per_frame = 2; // textures uploaded again each frame (avoid stalls)
+	int unused_texture_size = 64; // size in pixels of the textures which are not seen
+};
+
+class ResidencyManager
+{
+public:
+	// constructor
+	// cache_directory: folder where the geometry of the evicted meshes is saved (the one of the texture cache, already created)
+	ResidencyManager(ThreadPool* thread_pool, ResidencyBudget budget = ResidencyBudget(), const char* cache_directory = "cache/");
+
+	// destructor, it waits for the loads running and deletes the files of the geometry saved
+	~ResidencyManager();
+
+	// add a mesh to be managed, its textures (and the ones of its parts) are also added
+	void addMesh(BaseMesh* mesh);
+
+	// add a texture to be managed, only the textures loaded from the texture cache and not packed in the atlas can be streamed
+	void addTexture(Texture* texture);
+
+	// the shadow of a managed mesh (caster) can be seen on the receivers even when the mesh is out of the frustum
+	void addShadowCaster(BaseMesh* caster);
+	void addShadowReceiver(MeshPlane* receiver);
+
+	// the managed meshes reflected by the mirror with its reflection matrix are needed while the mirror is in the frustum
+	void addMirror(MeshMirrorWorld* mirror);
+
+	// memory of arrays which are never freed (ex: the static batches), it is counted in the CPU memory so the meshes are freed sooner
+	void addStaticBytes(size_t bytes);
+
+	// positions of the lights which cast shadows this frame (world coords, w = 0 for directional lights), it must be set before update()
+	void setShadowLights(const vector<vector<GLfloat>>& light_positions);
+
+	// check the visibility of the meshes and update the residency of the textures and meshes
+	void update(const Frustum& frustum);
+
+	// change the memory limits
+	void setBudget(ResidencyBudget budget);
+	ResidencyBudget getBudget() const;
+
+	// memory currently used by the managed textures and meshes (and the static memory added)
+	size_t getGPUBytes() const;
+	size_t getCPUBytes() const;
+
+	// number of meshes with their geometry freed and number of meshes being loaded
+	int getNumEvictedMeshes() const;
+	int getNumPendingLoads() const;
+
+private:
+	// states of the load of the geometry of an evicted mesh
+	enum LoadState
+	{
+		kNotLoading = 0,
+		kLoading,
+		kLoaded,
+		kFailed
+	};
+
+	// information of a managed mesh
+	struct MeshEntry
+	{
+		BaseMesh* mesh;
+		string cache_url; // file where its geometry is saved
+		vector<Texture*> textures;
+		int frames_not_visible = 0;
+		bool casts_shadow = false;
+
+		// components of the load in the worker, they are shared with the task so they are alive until it finishes
+		shared_ptr<GeometryData> pending_geometry;
+		shared_ptr<atomic<int>> load_state;
+	};
+
+	// information of a managed texture
+	struct TextureEntry
+	{
+		Texture* texture;
+		float projected_size = 0.0f; // biggest size in pixels of its users in this frame
+		int num_users = 0; // managed meshes which use it
+		int frames_wanting_less = 0;
+	};
+
+	ThreadPool* thread_pool_;
+	ResidencyBudget budget_;
+	string cache_directory_;
+	string cache_prefix_; // start of the names of the files, unique for each process and manager (two runs can share the folder)
+	size_t static_bytes_; // memory added with addStaticBytes()
+
+	vector<MeshEntry> meshes_;
+	vector<TextureEntry> textures_;
+	unordered_map<BaseMesh*, int> mesh_indices_; // index of each mesh in meshes_
+	unordered_map<Texture*, int> texture_indices_; // index of each texture in textures_
+
+	// components to know which meshes out of the frustum are still seen in the shadows and mirrors
+	vector<MeshPlane*> shadow_receivers_;
+	vector<MeshMirrorWorld*> mirrors_;
+	vector<vector<GLfloat>> shadow_lights_;
+
+	// planes of the shadow receivers in the frustum, they are found once per frame
+	struct ReceiverPlane
+	{
+		Vector3 normal;
+		float distance;
+		Vector3 rectangle_min;
+		Vector3 rectangle_max;
+	};
+	vector<ReceiverPlane> visible_receivers_;
+
+	// return true if the shadow of the sphere can land on a receiver in the frustum
+	bool isShadowVisible(const Vector3& center, float radius) const;
+
+	// finish the loads done by the workers, setting the geometry in the meshes
+	void finishPendingLoads();
+
+	// start loading the geometry of the mesh in a worker
+	void startLoad(MeshEntry& entry);
+
+	// free the geometry of the meshes not seen (and more if the memory is over the budget)
+	void evictMeshes();
+
+	// choose and upload the mip levels of the textures
+	void updateTextures();
+
+	// first mip level of the texture needed for a size in pixels on the screen
+	int getLevelForSize(const Texture* texture, float size) const;
+};
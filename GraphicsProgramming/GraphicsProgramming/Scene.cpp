@@ -1,8 +1,23 @@
 ﻿#include "Scene.h"
 
 // Scene constructor, initilises OpenGL
-Scene::Scene(SharedContext* shared_context)
-	: shared_context_(shared_context)
+Scene::Scene(SharedContext* shared_context, const char* scene_url)
+	: shared_context_(shared_context), frame_tasks_(shared_context->thread_pool), static_receivers_(shared_context), static_objects_(shared_context)
+{
+	// content of the scene (the binary file in the cache is mapped if the text has not changed since it was compiled)
+	SceneDescription scene_description;
+	scene_description.load(scene_url);
+
+	initialise(scene_description);
+}
+
+Scene::Scene(SharedContext* shared_context, const SceneDescription& scene_description)
+	: shared_context_(shared_context), frame_tasks_(shared_context->thread_pool), static_receivers_(shared_context), static_objects_(shared_context)
+{
+	initialise(scene_description);
+}
+
+void Scene::initialise(const SceneDescription& scene_description)
 {
 	initialiseOpenGL();
 
@@ -13,19 +28,135 @@ Scene::Scene(SharedContext* shared_context)
 	// Set the position of the mouse in the middle of the window
 
 	// camera
-	camera_mgr_ = new CameraManager(shared_context_);
+	camera_mgr_ = new CameraManager(shared_context_, scene_description);
 
 	// light manager
-	light_mgr_ = new LightManager(shared_context_);
+	light_mgr_ = new LightManager(shared_context_, scene_description);
+
+	// shadow map, the planar shadows are used if it is not supported
+	shadow_map_ = ShadowMap::isSupported() ? new ShadowMap() : nullptr;
 
 	// create textures
-	initialiseTextures();
+	initialiseTextures(scene_description);
 
 	// create material
 	//initialiseMaterials();
 
 	// create meshes
-	initialiseMeshes();
+	initialiseMeshes(scene_description);
+
+	// once the meshes have their textures, remap their texture coords into the atlas
+	for (std::pair<string, BaseMesh*> mesh : my_geometry_)
+	{
+		mesh.second->remapTextureCoordsToAtlas();
+	}
+	for (std::pair<string, Model*> model : models_)
+	{
+		model.second->remapTextureCoordsToAtlas();
+	}
+	for (std::pair<string, MeshPlane*> floor_wall : floor_and_walls_)
+	{
+		floor_wall.second->remapTextureCoordsToAtlas();
+	}
+	for (std::pair<string, MeshMirrorWorld*> mirror_world : mirror_worlds_)
+	{
+		mirror_world.second->remapTextureCoordsToAtlas();
+	}
+
+	// motion system, the meshes and models are added once their movement components have been set
+	motion_system_ = new MotionSystem(shared_context_->thread_pool);
+	for (std::pair<string, BaseMesh*> mesh : my_geometry_)
+	{
+		motion_system_->add(mesh.second);
+	}
+	for (std::pair<string, Model*> model : models_)
+	{
+		motion_system_->add(model.second);
+	}
+	use_motion_system_ = motion_system_->getNumMovingObjects() >= MotionSystem::kMinMovingObjects;
+
+	// bounds of the meshes, the static batches cull with them
+	updateBounds();
+
+	// static batches, the meshes and models which never move are merged in world space (once their texture coords are in the atlas)
+	for (std::pair<string, MeshPlane*> floor_wall : floor_and_walls_)
+	{
+		static_receivers_.addMesh(floor_wall.second);
+	}
+
+	// grouped draws, the rest of meshes and models with the same geometry and texture are drawn together
+	for (std::pair<string, BaseMesh*> mesh : my_geometry_)
+	{
+		if (!static_objects_.addMesh(mesh.second))
+			grouped_draws_.addMesh(mesh.second);
+	}
+	for (std::pair<string, Model*> model : models_)
+	{
+		if (!static_objects_.addMesh(model.second))
+			grouped_draws_.addMesh(model.second);
+	}
+
+	// residency manager, it manages the meshes (and their textures) and the rest of the textures of the scene
+	residency_mgr_ = new ResidencyManager(shared_context_->thread_pool);
+	// the meshes and models cast shadows on the floor and walls and the mirrors render some of them again, so they are kept while they are seen there
+	for (std::pair<string, BaseMesh*> mesh : my_geometry_)
+	{
+		residency_mgr_->addMesh(mesh.second);
+		residency_mgr_->addShadowCaster(mesh.second);
+	}
+	for (std::pair<string, Model*> model : models_)
+	{
+		residency_mgr_->addMesh(model.second);
+		residency_mgr_->addShadowCaster(model.second);
+	}
+	for (std::pair<string, MeshPlane*> floor_wall : floor_and_walls_)
+	{
+		residency_mgr_->addMesh(floor_wall.second);
+		residency_mgr_->addShadowReceiver(floor_wall.second);
+	}
+	for (std::pair<string, MeshMirrorWorld*> mirror_world : mirror_worlds_)
+	{
+		residency_mgr_->addMirror(mirror_world.second);
+	}
+	for (std::pair<string, Texture*> texture : textures)
+	{
+		residency_mgr_->addTexture(texture.second);
+	}
+	// the static batches are copies of their meshes which are never freed, the meshes are still managed (the batches don't use their arrays)
+	residency_mgr_->addStaticBytes(static_receivers_.getBytes() + static_objects_.getBytes());
+
+	// shadow volumes of the meshes and models (the edges are found the first time they are used)
+	shadow_volumes_ = new ShadowVolumeBatch(shared_context_->thread_pool);
+	for (std::pair<string, BaseMesh*> mesh : my_geometry_)
+	{
+		shadow_volumes_->addCaster(mesh.second);
+	}
+	for (std::pair<string, Model*> model : models_)
+	{
+		shadow_volumes_->addCaster(model.second);
+	}
+
+	// planar shadows: the casters are paired with the floor and walls each frame (once for each light casting shadows)
+	if ((int)floor_and_walls_.size() > kMaxReceiverStencilIds)
+	{
+		printf("Scene: %i floors/walls, the stencil only has ids for %i of them at once, it will be cleared between groups of them\n",
+			(int)floor_and_walls_.size(), kMaxReceiverStencilIds);
+	}
+	for (int l = 0; l < kMaxShadowLights; l++)
+	{
+		for (std::pair<string, MeshPlane*> floor_wall : floor_and_walls_)
+		{
+			shadow_pairings_[l].addReceiver(floor_wall.second);
+		}
+		for (std::pair<string, BaseMesh*> mesh : my_geometry_)
+		{
+			shadow_pairings_[l].addCaster(mesh.second);
+		}
+		for (std::pair<string, Model*> model : models_)
+		{
+			shadow_pairings_[l].addCaster(model.second);
+		}
+	}
 }
 
 Scene::~Scene()
@@ -37,11 +168,50 @@ Scene::~Scene()
 	delete light_mgr_ ;
 	light_mgr_ = nullptr;
 
-	for (std::pair<TextureName, Texture*> texture : textures)
+	for (std::pair<string, Texture*> texture : textures)
 	{
 		delete texture.second;
 		texture.second = nullptr;
 	}
+
+	delete texture_atlas_;
+	texture_atlas_ = nullptr;
+
+	delete residency_mgr_;
+	residency_mgr_ = nullptr;
+
+	delete shadow_map_;
+	shadow_map_ = nullptr;
+
+	delete shadow_volumes_;
+	shadow_volumes_ = nullptr;
+
+	delete motion_system_;
+	motion_system_ = nullptr;
+
+	delete texture_cache_;
+	texture_cache_ = nullptr;
+
+	delete texture_preprocessor_;
+	texture_preprocessor_ = nullptr;
+
+	// the mirror worlds first, they point to the meshes they reflect
+	for (std::pair<string, MeshMirrorWorld*> mirror_world : mirror_worlds_)
+	{
+		delete mirror_world.second;
+	}
+	for (std::pair<string, BaseMesh*> mesh : my_geometry_)
+	{
+		delete mesh.second;
+	}
+	for (std::pair<string, Model*> model : models_)
+	{
+		delete model.second;
+	}
+	for (std::pair<string, MeshPlane*> floor_wall : floor_and_walls_)
+	{
+		delete floor_wall.second;
+	}
 }
 
 void Scene::handleInput(float dt)
@@ -102,37 +272,149 @@ void Scene::handleInput(float dt)
 				paused = true;
 
 		}
+		// change between planar shadows, shadow map and shadow volumes
+		else if (shared_context_->input->isKeyDown((int)'o'))
+		{
+			shared_context_->input->setKeyUp((int)'o');
+
+			if (shadow_mode_ == ShadowMode::kPlanar)
+			{
+				if (shadow_map_ != nullptr)
+					shadow_mode_ = ShadowMode::kShadowMap;
+				else
+				{
+					printf("Shadow maps are not supported by the graphics card, skipping them\n");
+					shadow_mode_ = ShadowMode::kShadowVolume;
+				}
+			}
+			else if (shadow_mode_ == ShadowMode::kShadowMap)
+				shadow_mode_ = ShadowMode::kShadowVolume;
+			else
+				shadow_mode_ = ShadowMode::kPlanar;
+		}
+		// change the mirrors between stencil reflections and render to texture reflections
+		else if (shared_context_->input->isKeyDown((int)'r'))
+		{
+			shared_context_->input->setKeyUp((int)'r');
+
+			for (pair<string, MeshMirrorWorld*> mirror_world : mirror_worlds_)
+			{
+				if (mirror_world.second->getMode() == MirrorMode::kStencil)
+					mirror_world.second->setMode(MirrorMode::kRenderToTexture);
+				else
+					mirror_world.second->setMode(MirrorMode::kStencil);
+			}
+		}
+		// draw the meshes with the same geometry in groups (arrays and texture set once) or each one by itself
+		else if (shared_context_->input->isKeyDown((int)'t'))
+		{
+			shared_context_->input->setKeyUp((int)'t');
+
+			grouping_ = !grouping_;
+		}
+		// draw the meshes which never move from the static batches or each one by itself
+		else if (shared_context_->input->isKeyDown((int)'l'))
+		{
+			shared_context_->input->setKeyUp((int)'l');
+
+			static_batching_ = !static_batching_;
+		}
+		// print the tasks of the next frame (which thread ran each one and when)
+		else if (shared_context_->input->isKeyDown((int)'g'))
+		{
+			shared_context_->input->setKeyUp((int)'g');
+
+			dump_frame_tasks_ = true;
+		}
 	}	
 }
 
 void Scene::update(float dt)
 {
+	chrono::steady_clock::time_point update_start = chrono::steady_clock::now();
+
+	// how much of the threads of the pool was used in the last frame (all their tasks: the frame tasks, the simulation, the textures...)
+	ThreadPool* thread_pool = shared_context_->thread_pool;
+	if (thread_pool != nullptr && dt > 0.0f)
+	{
+		double busy_time = thread_pool->getBusyTime();
+		workers_utilization_ = (float)((busy_time - last_busy_time_) / (thread_pool->getNumThreads() * dt));
+		last_busy_time_ = busy_time;
+	}
+
+	// the tasks of this frame start here (the update ones and then the culling ones in render())
+	frame_tasks_.clear();
+
+	// wait for the movement simulated while the last frame was rendered, it is the one rendered in this frame
+	motion_system_->finishSimulation();
+
 	if (!paused)
 	{
-		// update the camera
-		camera_mgr_->update(dt);
+		// the simulation advances in fixed steps, whatever the frame rate is
+		int num_steps = fixed_timestep_.advance(dt);
+		float step = fixed_timestep_.getStep();
 
-		// update the lights
-		light_mgr_->update(dt);
+		// update the lights, they don't depend on the meshes
+		frame_tasks_.addTask("lights", [this, num_steps, step]()
+		{
+			for (int i = 0; i < num_steps; i++)
+			{
+				light_mgr_->update(step);
+			}
+		});
 
-		// update all the meshes
-		for (pair<MeshesType, BaseMesh*> mesh : my_geometry_)
+		// move and rotate all the meshes and models: interpolated between the last two steps simulated by the motion system or, with few
+		// of them, by the update() of each one in this frame (the steps are not interpolated)
+		int motion_task;
+		if (use_motion_system_)
+		{
+			motion_task = frame_tasks_.addTask("motion write back", [this]() { motion_system_->writeBackInterpolated(); });
+		}
+		else
 		{
-			mesh.second->update(dt);
+			motion_task = frame_tasks_.addTask("meshes update", [this, num_steps, step]()
+			{
+				for (int i = 0; i < num_steps; i++)
+				{
+					for (pair<string, BaseMesh*> mesh : my_geometry_)
+					{
+						mesh.second->update(step);
+					}
+					for (pair<string, Model*> model : models_)
+					{
+						model.second->update(step);
+					}
+				}
+			});
 		}
-		for (pair<MeshesType, Model*> model : models_)
+
+		// update the camera (after the meshes, as it can be following one of them)
+		frame_tasks_.addTask("camera", [this, dt]() { camera_mgr_->update(dt); }, { motion_task });
+
+		// update the mirror worlds (they copy the meshes, each one its own copies)
+		for (auto& mirror_world : mirror_worlds_)
 		{
-			model.second->update(dt);
+			MeshMirrorWorld* mirror = mirror_world.second;
+			frame_tasks_.addTask("mirror " + mirror_world.first, [mirror, dt]() { mirror->update(dt); }, { motion_task });
 		}
-		// update the mirror worlds
-		for (pair<MeshesType, MeshMirrorWorld*> mirror_world : mirror_worlds_)
+
+		frame_tasks_.run();
+
+		// the meshes have moved, their bounds are calculated here in the GL thread before the tasks of render() read them
+		updateBounds();
+
+		// simulate the steps of this frame in a worker while the GL thread renders
+		if (use_motion_system_)
 		{
-			mirror_world.second->update(dt);
+			motion_system_->startSimulation(num_steps, step, fixed_timestep_.getAlpha());
 		}
 	}
 
-	// Calculate FPS for output
-	calculateFPS();
+	frame_stats_.update_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - update_start).count();
+
+	// Calculate FPS for output (the glut timer is not there without a window)
+	if (!shared_context_->headless)
+		calculateFPS();
 }
 
 void Scene::render() {
@@ -140,6 +422,14 @@ void Scene::render() {
 	// Clear Color and Depth Buffers
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT); // ==> CLEAN BUFFER each frame
 
+	// start counting the texture binds and draws of this frame
+	Texture::resetNumBinds();
+	BaseMesh::resetNumDraws();
+
+	// the shadow map uses the depth buffer, so it is rendered before the scene
+	if (shadow_mode_ == ShadowMode::kShadowMap)
+		renderShadowMapDepth();
+
 	// Reset transformations
 	glLoadIdentity();
 
@@ -153,97 +443,120 @@ void Scene::render() {
 		look_at.x, look_at.y, look_at.z, // look at (center)
 		up.x, up.y, up.z); // up
 
+	// update the frustum with the camera and the residency of the meshes and textures (before rendering them)
+	chrono::steady_clock::time_point part_start = chrono::steady_clock::now();
+	frustum_.update();
+
+	// any light turned on can cast the shadows (planar shadows choose some of them later, the shadow map and volumes use the light 0)
+	vector<vector<GLfloat>> shadow_light_positions;
+	for (int i = 0; i < 8; i++)
+	{
+		if (light_mgr_->getLight(GL_LIGHT0 + i) != nullptr && glIsEnabled(GL_LIGHT0 + i))
+		{
+			shadow_light_positions.push_back(light_mgr_->getLightPosition(GL_LIGHT0 + i));
+		}
+	}
+	residency_mgr_->setShadowLights(shadow_light_positions);
+	residency_mgr_->update(frustum_);
+
+	// check which mirrors and reflections can be seen, each mirror in a task (they read the bounds calculated in update())
+	for (pair<string, MeshMirrorWorld*> mirror_world : mirror_worlds_)
+	{
+		MeshMirrorWorld* mirror = mirror_world.second;
+		frame_tasks_.addTask("cull mirror " + mirror_world.first, [this, mirror]() { mirror->cull(frustum_); });
+	}
+	// and the meshes of each draw group which can be seen
+	if (grouping_)
+	{
+		frame_tasks_.addTask("cull groups", [this]() { grouped_draws_.cull(frustum_); });
+	}
+	// and the parts of the static batches
+	if (static_batching_)
+	{
+		frame_tasks_.addTask("cull static", [this]()
+		{
+			static_receivers_.cull(frustum_);
+			static_objects_.cull(frustum_);
+		});
+	}
+	frame_tasks_.run();
+	frame_stats_.culling_ms = timePart(part_start);
 
 	// Render geometry/scene here -------------------------------------
 
 	/* Render lights */
 	light_mgr_->render();
 
-	/* Generate shadow matrix */
-	float shadow_matrix[16]; // shadow
-	int i = 0; // it is used for changing the stencil test value dinamicallly
-
-	for (pair<MeshesType, MeshPlane*> floor_wall : floor_and_walls_)
+	/* Render the reflections of the mirrors which use a texture (they use the window, so it is cleared and the lights are rendered again) */
+	unsigned int lights_version = 0;
+	for (int i = 0; i < 8; i++)
 	{
-		Shadow::generateShadowMatrix(shadow_matrix, light_mgr_->getLightPosition(GL_LIGHT0).data(), floor_wall.second->getPQRVertices().data());
-
-		/* Render floor seting it stencil buffer */
-		glEnable(GL_STENCIL_TEST); // enable stencil
-		glStencilFunc(GL_ALWAYS, 2+i, 0xffffffff);
-		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-
-		floor_wall.second->render();
-
-		// Now, only render where stencil is set above 2 (ie, 3 where the top floor is).
-		// Update stencil with 2 where the shadow gets drawn so we don't redraw (and accidently reblend) the shadow.
-		glStencilFunc(GL_LESS, 1+i, 0xffffffff);
-		glStencilOp(GL_REPLACE, GL_REPLACE, GL_REPLACE);
-
-
-		/* Render shadow */
-
-		// disable depth test, lighting and texture
-		glDisable(GL_DEPTH_TEST);
-		glDisable(GL_LIGHTING);
-		glDisable(GL_TEXTURE_2D);
-
-		// Apply shadow's colour
-		//glColor3f(0.1f, 0.1f, 0.1f); 
-
-		glPushMatrix();
-
-			// apply shadow matrix transform
-			glMultMatrixf((GLfloat*)shadow_matrix);
-
-			// create the shadows
-			for (pair<MeshesType, BaseMesh*> mesh : my_geometry_)
-			{
-				mesh.second->render(true);
-			}
-			for (pair<MeshesType, Model*> model : models_)
-			{
-				model.second->render(true);
-			}
-
-		glPopMatrix();
-
-		// reset colour
-		//glColor3f(1.0f, 1.0f, 1.0f);
-
-		// enable depth test, lighting and texture
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_LIGHTING);
-		glEnable(GL_TEXTURE_2D);
-
-		glDisable(GL_STENCIL_TEST); // disable stencil
-
-		i++; // for next stencil
+		Light* light = light_mgr_->getLight(GL_LIGHT0 + i);
+		if (light != nullptr)
+			lights_version += light->getPositionVersion();
 	}
-
-	// render actual meshes/models with their texture
-	for (pair<MeshesType, BaseMesh*> mesh : my_geometry_)
+	bool reflections_rendered = false;
+	for (pair<string, MeshMirrorWorld*> mirror_world : mirror_worlds_)
+	{
+		reflections_rendered |= mirror_world.second->updateReflectionTexture(lights_version);
+	}
+	if (reflections_rendered)
 	{
-		mesh.second->render();
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		light_mgr_->render();
 	}
-	for (pair<MeshesType, Model*> model : models_)
+	frame_stats_.reflections_ms = timePart(part_start);
+
+	/* Render the meshes with their shadows */
+	// depth fail counts the faces of the shadow volumes behind the scene, so their far caps must not be clipped by the far plane (ex: a camera
+	// at the edge of a big scene): the meshes, volumes and mirrors use the projection without far plane, so all their depths can be compared
+	bool infinite_projection = shadow_mode_ == ShadowMode::kShadowVolume;
+	if (infinite_projection)
 	{
-		model.second->render();
+		glMatrixMode(GL_PROJECTION);
+		glPushMatrix();
+		loadInfiniteProjection();
+		glMatrixMode(GL_MODELVIEW);
 	}
+	if (shadow_mode_ == ShadowMode::kShadowMap)
+		renderWithShadowMap();
+	else if (shadow_mode_ == ShadowMode::kShadowVolume)
+		renderWithShadowVolumes();
+	else
+		renderWithPlanarShadows();
+	frame_stats_.meshes_ms = timePart(part_start);
 
 	// render the mirror worlds
-	for (pair<MeshesType, MeshMirrorWorld*> mirror_world : mirror_worlds_)
+	for (pair<string, MeshMirrorWorld*> mirror_world : mirror_worlds_)
 	{
 		mirror_world.second->render();
 	}
+	if (infinite_projection)
+	{
+		glMatrixMode(GL_PROJECTION);
+		glPopMatrix();
+		glMatrixMode(GL_MODELVIEW);
+	}
+	frame_stats_.mirrors_ms = timePart(part_start);
+	frame_stats_.num_draws = BaseMesh::getNumDraws();
+	frame_stats_.num_texture_binds = Texture::getNumBinds();
 
 
 	// End render geometry --------------------------------------
 
-	// Render text, should be last object rendered.
-	renderTextOutput();
+	// Render text, should be last object rendered (the glut fonts need a window).
+	if (!shared_context_->headless)
+		renderTextOutput();
+
+	if (dump_frame_tasks_)
+	{
+		frame_tasks_.printDump();
+		dump_frame_tasks_ = false;
+	}
 
-	// Swap buffers, after all objects are rendered.
-	glutSwapBuffers();
+	// Swap buffers, after all objects are rendered (without a window the frame stays in the offscreen buffer).
+	if (!shared_context_->headless)
+		glutSwapBuffers();
 }
 
 
@@ -259,189 +572,158 @@ void Scene::initialiseOpenGL()
 	glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);	// Really Nice Perspective Calculations
 	glLightModelf(GL_LIGHT_MODEL_LOCAL_VIEWER, 1);
 	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE); // How textures are applied
+
+	// load the openGL functions which are not in the 1.1 header (ex: compressed textures)
+	GLExtensions::load();
 }
 
-void Scene::initialiseTextures()
+void Scene::initialiseTextures(const SceneDescription& scene_description)
 {
-	// For my meshes
-	textures[TextureName::kDonut] = new Texture("gfx/donut.png");
-	textures[TextureName::kEarth] = new Texture( "gfx/earth.png");
-	textures[TextureName::kDiceMap] = new Texture("gfx/dicemap.png", TextureCoordsType::kMapped);
-	textures[TextureName::kDarkGrayWood] = new Texture("gfx/dark_gray_wood.jpg");
-	textures[TextureName::kDarkGrayWood]->setWrapST(GL_REPEAT, GL_REPEAT);
-	textures[TextureName::kMetal] = new Texture("gfx/metal.jpg");
-	textures[TextureName::kMetal]->setWrapST(GL_REPEAT, GL_REPEAT);
-
-	// For models
-	textures[TextureName::kSword] = new Texture("gfx/sword_texture.jpg", TextureCoordsType::kDefault, true);
-	textures[TextureName::kBronzeSword] = new Texture("gfx/sword_bronze_texture.jpg", TextureCoordsType::kDefault, true);
-	textures[TextureName::kSpaceship] = new Texture("gfx/spaceship.jpg",TextureCoordsType::kDefault, true);
-	textures[TextureName::kSpaceship2] = new Texture("gfx/spaceship2_texture.png");
+	// the images are processed in the thread pool the first time, the next times they are read from the cache
+	texture_preprocessor_ = new TexturePreprocessor(shared_context_->thread_pool);
+	texture_cache_ = new TextureCache(texture_preprocessor_);
+
+	// the textures of the scene, by their name
+	for (int i = 0; i < scene_description.getNumTextures(); i++)
+	{
+		const SceneTextureDesc& texture = scene_description.getTexture(i);
+		Texture* new_texture = new Texture(scene_description.getString(texture.url), texture.mapped ? TextureCoordsType::kMapped : TextureCoordsType::kDefault,
+			texture.y_inverted != 0, texture_cache_);
+		if (texture.repeat)
+			new_texture->setWrapST(GL_REPEAT, GL_REPEAT);
+		textures[scene_description.getString(texture.name)] = new_texture;
+	}
+
+	// warm loads come from the cache, cold loads have been processed (first run or the image has changed)
+	texture_cache_->printStats();
+
+	// pack the textures into the atlas (the repeated ones are rejected by the atlas and they keep using their own texture object)
+	texture_atlas_ = new TextureAtlas();
+	for (std::pair<string, Texture*> texture : textures)
+	{
+		texture_atlas_->addTexture(texture.second);
+	}
+	texture_atlas_->build();
+	printf("Texture atlas: %i textures packed in %i page(s)\n", texture_atlas_->getNumTexturesPacked(), texture_atlas_->getNumPages());
 }
 
-void Scene::initialiseMeshes()
+void Scene::initialiseMeshes(const SceneDescription& scene_description)
 {
-	/* Models */
-
-	// spaceship (it works as a model) moving along z-axis
-	models_[MeshesType::kSpaceship] = new Model("models/spaceship.obj");
-	models_[MeshesType::kSpaceship]->setSharedContext(shared_context_);
-	models_[MeshesType::kSpaceship]->setTexture(textures[TextureName::kSpaceship]);
-	models_[MeshesType::kSpaceship]->setTranslation({ 1.0f, 0.13f, -2.0f });
-	models_[MeshesType::kSpaceship]->setScale({ 0.90f, 0.90f, 0.90f });
-	models_[MeshesType::kSpaceship]->setIsMoving({false, false, true });
-	models_[MeshesType::kSpaceship]->setAxisLimits(AxisLimits{ {1.0f, 0.13f,-2.0f}, {1.0f, 0.13f,-22.0f} });
-	models_[MeshesType::kSpaceship]->setDirection({0.0f,0.0f,-1.0f});
-	models_[MeshesType::kSpaceship]->setSpeed(2.5f);
-	camera_mgr_->linkObjToCamera(7, models_[MeshesType::kSpaceship], {0.0f, 0.3f, 0.0f}); // link the camera to the object setting the translation to set it in the eye object
-
-	// spaceship 2 (it works as a model) moving along x-axis
-	models_[MeshesType::kSpaceship2] = new Model("models/spaceship2.obj");
-	models_[MeshesType::kSpaceship2]->setSharedContext(shared_context_);
-	models_[MeshesType::kSpaceship2]->setTexture(textures[TextureName::kSpaceship2]);
-	models_[MeshesType::kSpaceship2]->setTranslation({ 2.0f, 0.5f, -1.0f });
-	models_[MeshesType::kSpaceship2]->setScale({ 0.1f, 0.1f, 0.1f });
-	models_[MeshesType::kSpaceship2]->setRotationAngles({ 0.0f, 90.0f, 0.0f });
-	models_[MeshesType::kSpaceship2]->setIsMoving({ true, false, false });
-	models_[MeshesType::kSpaceship2]->setAxisLimits(AxisLimits{ {18.0f, 0.8f, -1.6f}, {2.0f, 0.8f, -1.6f} });
-	models_[MeshesType::kSpaceship2]->setDirection({ 1.0f, 0.0f, 0.0f });
-	models_[MeshesType::kSpaceship2]->setSpeed(2.5f);
-	camera_mgr_->linkObjToCamera(8, models_[MeshesType::kSpaceship2], { 0.0f, 0.2f, 0.0f }); // link the camera to the object setting the translation to set it in the eye object
-
-	// sword
-	models_[MeshesType::kSword] = new Model("models/sword.obj");
-	models_[MeshesType::kSword]->setSharedContext(shared_context_);
-	models_[MeshesType::kSword]->setTexture(textures[TextureName::kSword]);
-	models_[MeshesType::kSword]->setTranslation({ 10.0f, 2.30f, -10.0f });
-	models_[MeshesType::kSword]->setScale({ 0.4f, 0.4f, 0.4f });
-	models_[MeshesType::kSword]->setIsRotating({ false, true, false });
-	models_[MeshesType::kSword]->setSpeed(15.0f);
-
-
-	/* My Geometry */
-	// To see how the world would be if it was a... =)
-
-	// sphere
-	my_geometry_[MeshesType::kSphere] = new MeshSphere(0.8, 90, 90);
-	my_geometry_[MeshesType::kSphere]->setSharedContext(shared_context_);
-	my_geometry_[MeshesType::kSphere]->setTexture(textures[TextureName::kEarth]);
-	my_geometry_[MeshesType::kSphere]->setTranslation({ 3.0f, 1.6f, -21.0f });
-	my_geometry_[MeshesType::kSphere]->setRotationAngles({ 0.0f, 0.0f, 23.5f }); // set the rotation of a earth
-	my_geometry_[MeshesType::kSphere]->setIsRotating(false, true, false);
-	my_geometry_[MeshesType::kSphere]->setSpeed(-15.0f);
-
-	// cone
-	my_geometry_[MeshesType::kCone] = new MeshCone(2, 0, 4, 200, 200, false, true);
-	my_geometry_[MeshesType::kCone]->setSharedContext(shared_context_);
-	my_geometry_[MeshesType::kCone]->setTexture(textures[TextureName::kEarth]);
-	my_geometry_[MeshesType::kCone]->setScale({0.3f, 0.3f, 0.3f});
-	my_geometry_[MeshesType::kCone]->setTranslation({ 6.5f, 1.0f, -21.0f });
-	my_geometry_[MeshesType::kCone]->setIsRotating(false, true, false);
-	my_geometry_[MeshesType::kCone]->setSpeed(+15.0f);
-
-	// cylinder
-	my_geometry_[MeshesType::kCylinder] = new MeshCone(2, 2, 4, 100, 100, true, true);
-	my_geometry_[MeshesType::kCylinder]->setSharedContext(shared_context_);
-	my_geometry_[MeshesType::kCylinder]->setTexture(textures[TextureName::kEarth]);
-	my_geometry_[MeshesType::kCylinder]->setScale({ 0.3f, 0.3f, 0.3f });
-	my_geometry_[MeshesType::kCylinder]->setTranslation({ 10.05f, 1.0f, -21.0f });
-	my_geometry_[MeshesType::kCylinder]->setIsRotating(false, true, false);
-	my_geometry_[MeshesType::kCylinder]->setSpeed(-15.0f);
-
-	// pyramid
-	my_geometry_[MeshesType::kPyramid] = new MeshCone(2, 0, 4, 400, 3, false, true);
-	my_geometry_[MeshesType::kPyramid]->setSharedContext(shared_context_);
-	my_geometry_[MeshesType::kPyramid]->setTexture(textures[TextureName::kEarth]);
-	my_geometry_[MeshesType::kPyramid]->setScale({ 0.3f, 0.3f, 0.3f });
-	my_geometry_[MeshesType::kPyramid]->setTranslation({ 13.5f, 1.0f, -21.0f });
-	my_geometry_[MeshesType::kPyramid]->setIsRotating(false, true, false);
-	my_geometry_[MeshesType::kPyramid]->setSpeed(+15.0f);
-
-	// pentagonal
-	my_geometry_[MeshesType::kPentagonal] = new MeshCone(2, 2, 4, 100, 5, true, true);
-	my_geometry_[MeshesType::kPentagonal]->setSharedContext(shared_context_);
-	my_geometry_[MeshesType::kPentagonal]->setTexture(textures[TextureName::kEarth]);
-	my_geometry_[MeshesType::kPentagonal]->setScale({ 0.3f, 0.3f, 0.3f });
-	my_geometry_[MeshesType::kPentagonal]->setTranslation({ 17.0f, 1.0f, -21.0f });
-	my_geometry_[MeshesType::kPentagonal]->setIsRotating(false, true, false);
-	my_geometry_[MeshesType::kPentagonal]->setSpeed(-15.0f);
-
-	// hexagonal
-	my_geometry_[MeshesType::kHexagonal] = new MeshCone(2, 2, 4, 100, 6, true, true);
-	my_geometry_[MeshesType::kHexagonal]->setSharedContext(shared_context_);
-	my_geometry_[MeshesType::kHexagonal]->setTexture(textures[TextureName::kEarth]);
-	my_geometry_[MeshesType::kHexagonal]->setScale({ 0.3f, 0.3f, 0.3f });
-	my_geometry_[MeshesType::kHexagonal]->setTranslation({ 17.0f, 1.0f, -17.0f });
-	my_geometry_[MeshesType::kHexagonal]->setIsRotating(false, true, false);
-	my_geometry_[MeshesType::kHexagonal]->setSpeed(+15.0f);
-
-	// octagonal
-	my_geometry_[MeshesType::kOctagonal] = new MeshCone(2, 2, 4, 100, 8, true, true);
-	my_geometry_[MeshesType::kOctagonal]->setSharedContext(shared_context_);
-	my_geometry_[MeshesType::kOctagonal]->setTexture(textures[TextureName::kEarth]);
-	my_geometry_[MeshesType::kOctagonal]->setScale({ 0.3f, 0.3f, 0.3f });
-	my_geometry_[MeshesType::kOctagonal]->setTranslation({ 17.0f, 1.0f, -13.0f });
-	my_geometry_[MeshesType::kOctagonal]->setIsRotating(false, true, false);
-	my_geometry_[MeshesType::kOctagonal]->setSpeed(-15.0f);
-
-	// cube
-	my_geometry_[MeshesType::kCube] = new MeshCube(4,false,RectangleBehaviourType::kUnit); // set it as a unit for the dice
-	my_geometry_[MeshesType::kCube]->setSharedContext(shared_context_);
-	my_geometry_[MeshesType::kCube]->setTexture(textures[TextureName::kDiceMap]);
-	my_geometry_[MeshesType::kCube]->setScale({ 0.25f, 0.25f, 0.25f });
-	my_geometry_[MeshesType::kCube]->setTranslation({ 17.0f, 1.0f, -9.0f });
-	my_geometry_[MeshesType::kCube]->setIsRotating(false, true, false);
-	my_geometry_[MeshesType::kCube]->setSpeed(+15.0f);
-
-	// torus
-	my_geometry_[MeshesType::kTorus] = new MeshTorus(1, 2, 100, 200);
-	my_geometry_[MeshesType::kTorus]->setSharedContext(shared_context_);
-	my_geometry_[MeshesType::kTorus]->setTexture(textures[TextureName::kDonut]);
-	my_geometry_[MeshesType::kTorus]->setScale({ 0.3f, 0.3f, 0.3f });
-	my_geometry_[MeshesType::kTorus]->setTranslation({ 17.0f, 1.6f, -5.0f });
-	my_geometry_[MeshesType::kTorus]->setIsRotating(false, true, false);
-	my_geometry_[MeshesType::kTorus]->setSpeed(+15.0f);
-
-
-	/* Floor and walls where it will be printed the shadows */
-	// floor
-	floor_and_walls_[MeshesType::kFloor] = new MeshPlane(Facing::kUp, 24, 20);
-	floor_and_walls_[MeshesType::kFloor]->setSharedContext(shared_context_);
-	floor_and_walls_[MeshesType::kFloor]->setTexture(textures[TextureName::kDarkGrayWood]);
-
-	// back wall
-	floor_and_walls_[MeshesType::kWallBack] = new MeshPlane(Facing::kBackward, 10, 20);
-	floor_and_walls_[MeshesType::kWallBack]->setSharedContext(shared_context_);
-	floor_and_walls_[MeshesType::kWallBack]->setTranslation({ 0.0f, 0.0f, -24 }); // translate it down and forward (back)
-	floor_and_walls_[MeshesType::kWallBack]->setTexture(textures[TextureName::kMetal]);
-
-	// right wall
-	floor_and_walls_[MeshesType::kWallRight] = new MeshPlane(Facing::kLeft, 10, 24);
-	floor_and_walls_[MeshesType::kWallRight]->setSharedContext(shared_context_);
-	floor_and_walls_[MeshesType::kWallRight]->setTranslation({ +20.0f, +10.0f, 0.0f }); // translate it down and forward (back)
-	floor_and_walls_[MeshesType::kWallRight]->setTexture(textures[TextureName::kMetal]);
+	// texture of an index of the description (nullptr if it is not valid)
+	auto get_texture = [this, &scene_description](int index) -> Texture*
+	{
+		if (index < 0 || index >= scene_description.getNumTextures())
+			return nullptr;
+		return textures[scene_description.getString(scene_description.getTexture(index).name)];
+	};
+
+	/* Meshes, models and floors/walls */
+
+	// the objects by their index in the description, the cameras and mirrors refer to them by it
+	vector<BaseMesh*> objects(scene_description.getNumObjects(), nullptr);
+	for (int i = 0; i < scene_description.getNumObjects(); i++)
+	{
+		const SceneObjectDesc& object = scene_description.getObject(i);
+		const float* params = object.params;
+		string name = scene_description.getString(object.name);
+
+		switch ((SceneShape)object.shape)
+		{
+		case SceneShape::kSphere:
+			my_geometry_[name] = objects[i] = new MeshSphere(params[0], (int)params[1], (int)params[2]);
+			break;
+		case SceneShape::kCone:
+			my_geometry_[name] = objects[i] = new MeshCone(params[0], params[1], params[2], (int)params[3], (int)params[4], params[5] != 0.0f, params[6] != 0.0f);
+			break;
+		case SceneShape::kCube:
+			my_geometry_[name] = objects[i] = new MeshCube((int)params[0], false, params[1] != 0.0f ? RectangleBehaviourType::kUnit : RectangleBehaviourType::kSplitted);
+			break;
+		case SceneShape::kTorus:
+			my_geometry_[name] = objects[i] = new MeshTorus(params[0], params[1], (int)params[2], (int)params[3]);
+			break;
+		case SceneShape::kPlane:
+			floor_and_walls_[name] = new MeshPlane((Facing)(int)params[0], (int)params[1], (int)params[2]);
+			objects[i] = floor_and_walls_[name];
+			break;
+		case SceneShape::kModel:
+		{
+			string model_url = scene_description.getString(object.url); // the model needs a modifiable string
+			models_[name] = new Model(&model_url[0]);
+			objects[i] = models_[name];
+			break;
+		}
+		default:
+			printf("Scene: object '%s' has an unknown shape (%i), skipped\n", name.c_str(), object.shape);
+			continue;
+		}
+
+		BaseMesh* mesh = objects[i];
+		mesh->setSharedContext(shared_context_);
+
+		// the objects with the same shape and parameters (or the same model file) have the same geometry, so they can be drawn in one group
+		string geometry_key = ((SceneShape)object.shape == SceneShape::kModel) ? scene_description.getString(object.url) : to_string(object.shape);
+		for (int p = 0; p < 8; p++)
+		{
+			geometry_key += " " + to_string(params[p]);
+		}
+		mesh->setGeometryKey(geometry_key);
+		if (get_texture(object.texture) != nullptr)
+			mesh->setTexture(get_texture(object.texture));
+		mesh->setScale({ object.scale[0], object.scale[1], object.scale[2] });
+		mesh->setTranslation({ object.translation[0], object.translation[1], object.translation[2] });
+		mesh->setRotationAngles({ object.rotation[0], object.rotation[1], object.rotation[2] });
+		mesh->setIsMoving({ object.moving[0] != 0, object.moving[1] != 0, object.moving[2] != 0 });
+		mesh->setIsRotating(object.rotating[0] != 0, object.rotating[1] != 0, object.rotating[2] != 0);
+		mesh->setAxisLimits(AxisLimits({ object.limits_max[0], object.limits_max[1], object.limits_max[2] },
+			{ object.limits_min[0], object.limits_min[1], object.limits_min[2] }));
+		mesh->setDirection({ object.direction[0], object.direction[1], object.direction[2] });
+		mesh->setSpeed(object.speed);
+	}
+
+	// link the tracking cameras to the objects they follow
+	for (int i = 0; i < scene_description.getNumCameras(); i++)
+	{
+		const SceneCameraDesc& camera = scene_description.getCamera(i);
+		if (camera.followed_object >= 0 && camera.followed_object < (int)objects.size() && objects[camera.followed_object] != nullptr)
+		{
+			camera_mgr_->linkObjToCamera(i + 1, objects[camera.followed_object], { camera.eye_offset[0], camera.eye_offset[1], camera.eye_offset[2] });
+		}
+	}
 
 
 	/* Mirror Worlds */
 
-	// plane mirror world
-	mirror_worlds_[MeshesType::kPlaneMirror] = new MeshMirrorWorld();
-	mirror_worlds_[MeshesType::kPlaneMirror]->initPlaneMirror(Facing::kRight, 10, 24); // create a rectangle mirror (plane)
-	mirror_worlds_[MeshesType::kPlaneMirror]->setSharedContext(shared_context_);
-	mirror_worlds_[MeshesType::kPlaneMirror]->setTranslation({ 0.0f, +10.0f, -24.0f }); // translate it down and forward (back)
-	mirror_worlds_[MeshesType::kPlaneMirror]->setColour({ 0.8f, 0.8f, 1.0f, 0.3f }); // imitating a pane glass
-	mirror_worlds_[MeshesType::kPlaneMirror]->createReflection(models_[MeshesType::kSpaceship]);
-	mirror_worlds_[MeshesType::kPlaneMirror]->createReflection(models_[MeshesType::kSpaceship2], true);
-
-	// disc mirror world
-	mirror_worlds_[MeshesType::kDiscMirror] = new MeshMirrorWorld();
-	mirror_worlds_[MeshesType::kDiscMirror]->initDiscMirror(Facing::kForward, 3, 200); // create a rectangle mirror (plane)
-	mirror_worlds_[MeshesType::kDiscMirror]->setSharedContext(shared_context_);
-	mirror_worlds_[MeshesType::kDiscMirror]->setTranslation({ 10.0f, 3.0f, 0.0f }); // translate it down and forward (back)
-	mirror_worlds_[MeshesType::kDiscMirror]->setColour({ 0.8f, 0.8f, 1.0f, 0.3f }); // imitating a pane glass
-	mirror_worlds_[MeshesType::kDiscMirror]->createReflection(models_[MeshesType::kSword],false, textures[TextureName::kBronzeSword]); // set another texture for the object reflected
-	mirror_worlds_[MeshesType::kDiscMirror]->createReflection(models_[MeshesType::kSpaceship2]);
+	vector<MeshMirrorWorld*> mirrors(scene_description.getNumMirrors(), nullptr);
+	for (int i = 0; i < scene_description.getNumMirrors(); i++)
+	{
+		const SceneMirrorDesc& mirror = scene_description.getMirror(i);
+		mirrors[i] = new MeshMirrorWorld();
+		if (mirror.disc)
+			mirrors[i]->initDiscMirror((Facing)mirror.facing, mirror.size[0], (int)mirror.size[1]); // create a disc mirror
+		else
+			mirrors[i]->initPlaneMirror((Facing)mirror.facing, (int)mirror.size[0], (int)mirror.size[1]); // create a rectangle mirror (plane)
+		mirrors[i]->setSharedContext(shared_context_);
+		mirrors[i]->setTranslation({ mirror.translation[0], mirror.translation[1], mirror.translation[2] });
+		mirrors[i]->setColour({ mirror.colour[0], mirror.colour[1], mirror.colour[2], mirror.colour[3] });
+		mirrors[i]->setReflectionTextureScale(mirror.texture_scale); // size of the reflection in render to texture mode, relative to the window
+		mirrors[i]->setReflectionUpdateInterval(mirror.update_interval); // frames between the updates of the reflection
+		mirror_worlds_[scene_description.getString(mirror.name)] = mirrors[i];
+	}
 
+	// the objects reflected in each mirror, with the matrix of the mirror or with a copy behind it
+	for (int i = 0; i < scene_description.getNumReflections(); i++)
+	{
+		const SceneReflectionDesc& reflection = scene_description.getReflection(i);
+		if (reflection.mirror < 0 || reflection.mirror >= (int)mirrors.size() || reflection.object < 0 || reflection.object >= (int)objects.size() ||
+			objects[reflection.object] == nullptr)
+		{
+			continue;
+		}
+		if (reflection.copy)
+			mirrors[reflection.mirror]->createReflection(objects[reflection.object], reflection.invert_z != 0, get_texture(reflection.texture));
+		else
+			mirrors[reflection.mirror]->addReflectedShape(objects[reflection.object]);
+	}
 }
 
 void Scene::initialiseMaterials()
@@ -509,6 +791,369 @@ void Scene::resize(int w, int h)
 	glMatrixMode(GL_MODELVIEW);
 }
 
+const SceneFrameStats& Scene::getFrameStats() const
+{
+	return frame_stats_;
+}
+
+double Scene::timePart(chrono::steady_clock::time_point& start)
+{
+	chrono::steady_clock::time_point end = chrono::steady_clock::now();
+	double part_ms = chrono::duration<double, milli>(end - start).count();
+	start = end;
+	return part_ms;
+}
+
+void Scene::renderWithPlanarShadows()
+{
+	/* Lights which cast shadows in this frame: the ones which light the scene the most, up to the budget */
+
+	Vector3 scene_center;
+	float scene_radius;
+	getSceneBoundingSphere(scene_center, scene_radius);
+	float total_contribution = light_mgr_->getMostContributingLights(scene_center, max_shadow_lights_, shadow_lights_);
+
+	// find the casters whose shadow can land on each floor/wall for each light, a task per light (each one has its own pairing)
+	for (size_t l = 0; l < shadow_lights_.size(); l++)
+	{
+		frame_tasks_.addTask("shadow pairing light " + to_string((int)l), [this, l]()
+		{
+			shadow_pairings_[l].update(shadow_lights_[l]->getWorldPosition().data(), frustum_);
+		});
+	}
+	frame_tasks_.run();
+	shadow_matrices_.beginFrame();
+	shadow_cache_.beginFrame();
+
+	int num_stencil_ids = 0; // ids of the stencil given to the floors/walls with shadows, each one has its own so the shadows don't go to the others
+	for (int i = 0; i < shadow_pairings_[0].getNumReceivers(); i++)
+	{
+		MeshPlane* floor_wall = shadow_pairings_[0].getReceiver(i);
+
+		// no shadow lands on it (the lights are behind it or the shadows fall outside), so it is rendered without the stencil
+		bool has_shadows = false;
+		for (size_t l = 0; l < shadow_lights_.size(); l++)
+		{
+			has_shadows = has_shadows || !shadow_pairings_[l].getCasters(i).empty() || !shadow_pairings_[l].getBlobs(i).empty();
+		}
+		if (!has_shadows)
+		{
+			renderReceiver(floor_wall);
+			continue;
+		}
+
+		/* Render floor seting it stencil buffer */
+		// the low bits are for the floor/wall (2 + id) and the next ones are set where the shadow of each light has been drawn
+		// when the ids run out the stencil is cleared, the shadows of the floors/walls already rendered are done
+		if (num_stencil_ids == kMaxReceiverStencilIds)
+		{
+			glClear(GL_STENCIL_BUFFER_BIT);
+			num_stencil_ids = 0;
+		}
+		GLint stencil_id = 2 + num_stencil_ids++;
+		const GLuint kReceiverMask = (1 << kReceiverStencilBits) - 1;
+
+		glEnable(GL_STENCIL_TEST); // enable stencil
+		glStencilFunc(GL_ALWAYS, stencil_id, 0xffffffff);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+
+		renderReceiver(floor_wall);
+
+
+		/* Render shadow */
+
+		// disable depth test, lighting and texture
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_LIGHTING);
+		glDisable(GL_TEXTURE_2D);
+
+		// the shadows darken the floor/wall by the part of the light they block, so where the shadows of two lights overlap it is darker
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		for (size_t l = 0; l < shadow_lights_.size(); l++)
+		{
+			const vector<BaseMesh*>& casters = shadow_pairings_[l].getCasters(i);
+			const vector<BlobShadowPlacement>& blobs = shadow_pairings_[l].getBlobs(i);
+			if (casters.empty() && blobs.empty())
+			{
+				continue;
+			}
+
+			// only render on this floor/wall where the shadow of this light hasn't been drawn yet, and set its bit, so it isn't blended twice
+			GLuint light_bit = 1 << (kReceiverStencilBits + l);
+			glStencilFunc(GL_EQUAL, stencil_id, kReceiverMask | light_bit);
+			glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+			glStencilMask(light_bit);
+
+			float shadow_colour[4] = { 0.0f, 0.0f, 0.0f, 0.9f * shadow_lights_[l]->getContribution(scene_center) / total_contribution };
+
+			// the shadow matrix is only calculated again if the light has moved
+			const float* shadow_matrix = shadow_matrices_.getShadowMatrix(shadow_lights_[l], floor_wall);
+
+			// create the shadows of the casters paired with this floor/wall (they are flattened again only if the light or the caster have moved)
+			for (BaseMesh* caster : casters)
+			{
+				shadow_cache_.render(shadow_lights_[l]->getLightId(), floor_wall, caster, shadow_matrix, shadow_colour);
+			}
+
+			// the far and small casters have a blob instead
+			blob_shadow_.render(blobs, floor_wall->getNormal(), shadow_colour);
+		}
+
+		glStencilMask(0xffffffff);
+		glDisable(GL_BLEND);
+
+		// enable depth test, lighting and texture
+		glEnable(GL_DEPTH_TEST);
+		glEnable(GL_LIGHTING);
+		glEnable(GL_TEXTURE_2D);
+
+		glDisable(GL_STENCIL_TEST); // disable stencil
+	}
+
+	// render actual meshes/models with their texture
+	renderObjects();
+}
+
+void Scene::renderShadowMapDepth()
+{
+	// sphere which contains all the meshes, the light frustum is fitted to it
+	Vector3 scene_center;
+	float scene_radius;
+	getSceneBoundingSphere(scene_center, scene_radius);
+
+	// the casters are rendered once (not once per receiver as the planar shadows)
+	shadow_map_->renderDepth(light_mgr_->getLightPosition(GL_LIGHT0).data(), scene_center, scene_radius, [this]()
+	{
+		// only the depth is needed, so the shadow proxies are rendered
+		for (pair<string, BaseMesh*> mesh : my_geometry_)
+		{
+			mesh.second->renderShadow();
+		}
+		for (pair<string, Model*> model : models_)
+		{
+			model.second->renderShadow();
+		}
+	});
+}
+
+void Scene::renderWithShadowMap()
+{
+	// the light 0 may have been turned off, then there are no shadows to render
+	bool light_enabled = glIsEnabled(GL_LIGHT0) == GL_TRUE;
+
+	// first pass: everything without the light 0, it is the colour of the parts in shadow
+	glDisable(GL_LIGHT0);
+	renderMeshes();
+
+	// second pass: everything with the light 0 only where it is not in shadow (the depth is the same, so it is drawn over the first pass)
+	if (light_enabled)
+	{
+		glEnable(GL_LIGHT0);
+		shadow_map_->enable();
+		renderMeshes();
+		shadow_map_->disable();
+	}
+}
+
+void Scene::renderWithShadowVolumes()
+{
+	// the light 0 may have been turned off, then there are no shadows to render
+	bool light_enabled = glIsEnabled(GL_LIGHT0) == GL_TRUE;
+
+	// first pass: everything without the light 0, it is the colour of the parts in shadow (it also fills the depth buffer)
+	glDisable(GL_LIGHT0);
+	renderMeshes();
+
+	if (!light_enabled)
+	{
+		return;
+	}
+
+	/* Build the volumes (only the ones whose caster or light have moved) */
+
+	// the volumes must reach any receiver of the scene
+	Vector3 scene_center;
+	float scene_radius;
+	getSceneBoundingSphere(scene_center, scene_radius);
+	shadow_volumes_->update(light_mgr_->getLightPosition(GL_LIGHT0).data(), scene_radius * 2.0f);
+
+	/* Render the volumes in the stencil (depth fail): +1 for the back faces behind the scene, -1 for the front faces behind the scene */
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_TEXTURE_2D);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	glClear(GL_STENCIL_BUFFER_BIT);
+	glEnable(GL_STENCIL_TEST);
+	glStencilFunc(GL_ALWAYS, 0, 0xffffffff);
+
+	bool cull_enabled = glIsEnabled(GL_CULL_FACE) == GL_TRUE;
+	glEnable(GL_CULL_FACE);
+
+	// back faces first, so the stencil never goes under 0
+	glCullFace(GL_FRONT);
+	glStencilOp(GL_KEEP, GL_INCR, GL_KEEP);
+	shadow_volumes_->render();
+
+	glCullFace(GL_BACK);
+	glStencilOp(GL_KEEP, GL_DECR, GL_KEEP);
+	shadow_volumes_->render();
+
+	if (!cull_enabled)
+		glDisable(GL_CULL_FACE);
+
+	glEnable(GL_TEXTURE_2D);
+	glEnable(GL_LIGHTING);
+	glDepthMask(GL_TRUE);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+	/* Second pass: everything with the light 0 only where the stencil is 0 (outside of all the volumes) */
+
+	glStencilFunc(GL_EQUAL, 0, 0xffffffff);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+	glEnable(GL_LIGHT0);
+	renderMeshes();
+
+	glDisable(GL_STENCIL_TEST);
+	glClear(GL_STENCIL_BUFFER_BIT); // the mirrors use the stencil after
+}
+
+void Scene::loadInfiniteProjection()
+{
+	// gluPerspective() with the far plane at the infinite: the depth of a point tends to 1 but never reaches it
+	float ratio = (float)*shared_context_->window_width / (float)max(*shared_context_->window_height, 1);
+	float f = 1.0f / tanf(camera_mgr_->getCurrentCameraFov() * 0.5f * 3.14159265f / 180.0f);
+	GLfloat projection[16] = {
+		f / ratio, 0.0f, 0.0f, 0.0f,
+		0.0f, f, 0.0f, 0.0f,
+		0.0f, 0.0f, -1.0f, -1.0f,
+		0.0f, 0.0f, -2.0f * nearPlane, 0.0f };
+	glLoadMatrixf(projection);
+}
+
+void Scene::renderMeshes()
+{
+	// any surface can receive the shadows, so the floor and walls are rendered as the rest of meshes
+	if (static_batching_)
+	{
+		static_receivers_.render();
+	}
+	else
+	{
+		for (pair<string, MeshPlane*> floor_wall : floor_and_walls_)
+		{
+			floor_wall.second->render();
+		}
+	}
+	renderObjects();
+}
+
+void Scene::renderObjects()
+{
+	// the meshes which never move, from their batch or each one by itself
+	if (static_batching_)
+	{
+		static_objects_.render();
+	}
+	else
+	{
+		for (BaseMesh* mesh : static_objects_.getMeshes())
+		{
+			mesh->render();
+		}
+	}
+
+	if (grouping_)
+	{
+		grouped_draws_.render();
+		return;
+	}
+
+	// the meshes which are not in the static batch
+	for (pair<string, BaseMesh*> mesh : my_geometry_)
+	{
+		if (!static_objects_.contains(mesh.second))
+			mesh.second->render();
+	}
+	for (pair<string, Model*> model : models_)
+	{
+		if (!static_objects_.contains(model.second))
+			model.second->render();
+	}
+}
+
+void Scene::renderReceiver(MeshPlane* floor_wall)
+{
+	if (static_batching_ && static_receivers_.contains(floor_wall))
+		static_receivers_.renderMesh(floor_wall);
+	else
+		floor_wall->render();
+}
+
+void Scene::updateBounds()
+{
+	for (pair<string, MeshPlane*> floor_wall : floor_and_walls_)
+	{
+		floor_wall.second->updateBounds();
+	}
+	for (pair<string, BaseMesh*> mesh : my_geometry_)
+	{
+		mesh.second->updateBounds();
+	}
+	for (pair<string, Model*> model : models_)
+	{
+		model.second->updateBounds();
+	}
+	for (pair<string, MeshMirrorWorld*> mirror_world : mirror_worlds_)
+	{
+		mirror_world.second->updateBounds();
+	}
+}
+
+void Scene::getSceneBoundingSphere(Vector3& center, float& radius)
+{
+	// bounding box of the spheres of all the meshes
+	Vector3 box_min(1e30f, 1e30f, 1e30f), box_max(-1e30f, -1e30f, -1e30f);
+	vector<pair<Vector3, float>> spheres;
+	Vector3 mesh_center;
+	float mesh_radius;
+
+	for (pair<string, MeshPlane*> floor_wall : floor_and_walls_)
+	{
+		if (floor_wall.second->getBoundingSphere(mesh_center, mesh_radius))
+			spheres.push_back(make_pair(mesh_center, mesh_radius));
+	}
+	for (pair<string, BaseMesh*> mesh : my_geometry_)
+	{
+		if (mesh.second->getBoundingSphere(mesh_center, mesh_radius))
+			spheres.push_back(make_pair(mesh_center, mesh_radius));
+	}
+	for (pair<string, Model*> model : models_)
+	{
+		if (model.second->getBoundingSphere(mesh_center, mesh_radius))
+			spheres.push_back(make_pair(mesh_center, mesh_radius));
+	}
+
+	if (spheres.empty())
+	{
+		center.set(0.0f, 0.0f, 0.0f);
+		radius = 1.0f;
+		return;
+	}
+
+	for (pair<Vector3, float> sphere : spheres)
+	{
+		box_min.set(fminf(box_min.x, sphere.first.x - sphere.second), fminf(box_min.y, sphere.first.y - sphere.second), fminf(box_min.z, sphere.first.z - sphere.second));
+		box_max.set(fmaxf(box_max.x, sphere.first.x + sphere.second), fmaxf(box_max.y, sphere.first.y + sphere.second), fmaxf(box_max.z, sphere.first.z + sphere.second));
+	}
+	center.set((box_min.x + box_max.x) * 0.5f, (box_min.y + box_max.y) * 0.5f, (box_min.z + box_max.z) * 0.5f);
+	radius = (box_max - center).length();
+}
+
 // Calculates FPS
 void Scene::calculateFPS()
 {
@@ -516,7 +1161,7 @@ void Scene::calculateFPS()
 	time = glutGet(GLUT_ELAPSED_TIME);
 
 	if (time - timebase > 1000) {
-		sprintf_s(fps, " FPS: %4.2f", frame*1000.0 / (time - timebase));
+		snprintf(fps, sizeof(fps), " FPS: %4.2f (%.2f ms)", frame*1000.0 / (time - timebase), (time - timebase) / (double)frame);
 		timebase = time;
 		frame = 0;
 	}
@@ -527,13 +1172,70 @@ void Scene::renderTextOutput()
 {
 	//glEnable(GL_COLOR_MATERIAL);
 	// Render current mouse position, frames per second and camera id is being used.
-	sprintf_s(mouseText, " Mouse: %i, %i", shared_context_->input->getMouseX(), shared_context_->input->getMouseY());
-	sprintf_s(cameraText, " Cam %i", camera_mgr_->getCurrentCameraId());
+	snprintf(mouseText, sizeof(mouseText), " Mouse: %i, %i", shared_context_->input->getMouseX(), shared_context_->input->getMouseY());
+	snprintf(cameraText, sizeof(cameraText), " Cam %i", camera_mgr_->getCurrentCameraId());
+	snprintf(bindsText, sizeof(bindsText), " Texture binds: %i Draws: %i", frame_stats_.num_texture_binds, frame_stats_.num_draws);
+	snprintf(residencyText, sizeof(residencyText), " GPU: %.1f MB CPU: %.1f MB Evicted: %i", residency_mgr_->getGPUBytes() / (1024.0f * 1024.0f),
+		residency_mgr_->getCPUBytes() / (1024.0f * 1024.0f), residency_mgr_->getNumEvictedMeshes());
 	displayText(-1.f, 0.96f, 1.f, 0.f, 0.f, mouseText);
 	displayText(-1.f, 0.90f, 1.f, 0.f, 0.f, fps);
 	displayText(-1.f, 0.84f, 1.f, 0.f, 0.f, cameraText);
+	displayText(-1.f, 0.78f, 1.f, 0.f, 0.f, bindsText);
+	if (shadow_mode_ == ShadowMode::kShadowMap)
+		snprintf(shadowText, sizeof(shadowText), " Shadows: shadow map %ix%i", shadow_map_->getSize(), shadow_map_->getSize());
+	else if (shadow_mode_ == ShadowMode::kShadowVolume)
+		snprintf(shadowText, sizeof(shadowText), " Shadows: volumes %i tris, %.2f ms (%i/%i rebuilt)", shadow_volumes_->getNumTriangles(), shadow_volumes_->getBuildTime(),
+			shadow_volumes_->getNumRebuilt(), shadow_volumes_->getNumCasters());
+	else
+	{
+		// stats of all the lights casting shadows
+		int num_draws = 0, num_skipped = 0, num_full_casters = 0, num_blob_casters = 0;
+		for (size_t l = 0; l < shadow_lights_.size(); l++)
+		{
+			num_draws += shadow_pairings_[l].getNumDraws();
+			num_skipped += shadow_pairings_[l].getNumSkipped();
+			num_full_casters += shadow_pairings_[l].getNumFullCasters();
+			num_blob_casters += shadow_pairings_[l].getNumBlobCasters();
+		}
+		snprintf(shadowText, sizeof(shadowText), " Shadows: planar %i lights, %i full/%i blob, %i draws (%i skipped), %i cached, %i flattened, %.1f MB, %i matrices",
+			(int)shadow_lights_.size(), num_full_casters, num_blob_casters, num_draws, num_skipped,
+			shadow_cache_.getNumReused(), shadow_cache_.getNumFlattened(), shadow_cache_.getBytes() / (1024.0f * 1024.0f), shadow_matrices_.getNumRecalculated());
+	}
+	displayText(-1.f, 0.72f, 1.f, 0.f, 0.f, residencyText);
+	displayText(-1.f, 0.66f, 1.f, 0.f, 0.f, shadowText);
+	int num_reflection_updates = 0, num_reflecting = 0, num_culled_shapes = 0;
+	bool texture_mirrors = false;
+	for (pair<string, MeshMirrorWorld*> mirror_world : mirror_worlds_)
+	{
+		num_reflection_updates += mirror_world.second->getNumReflectionUpdates();
+		texture_mirrors |= (mirror_world.second->getMode() == MirrorMode::kRenderToTexture);
+		num_reflecting += mirror_world.second->areReflectionsVisible() ? 1 : 0;
+		num_culled_shapes += mirror_world.second->getNumCulledShapes();
+	}
+	if (texture_mirrors)
+		snprintf(mirrorText, sizeof(mirrorText), " Mirrors: render to texture (%i updates), %i/%i reflecting, %i culled", num_reflection_updates,
+			num_reflecting, (int)mirror_worlds_.size(), num_culled_shapes);
+	else
+		snprintf(mirrorText, sizeof(mirrorText), " Mirrors: stencil, %i/%i reflecting, %i culled", num_reflecting, (int)mirror_worlds_.size(), num_culled_shapes);
+	displayText(-1.f, 0.60f, 1.f, 0.f, 0.f, mirrorText);
 	if(paused) // if it is paused then show text
-		displayText(-1.f, 0.78f, 1.f, 0.f, 0.f, pausedText);
+		displayText(-1.f, 0.54f, 1.f, 0.f, 0.f, pausedText);
+	snprintf(jobsText, sizeof(jobsText), " Jobs: %i frame tasks, %.2f ms (%.0f%% of the threads), workers %.0f%% busy", frame_tasks_.getNumTasks(),
+		frame_tasks_.getRunTime(), frame_tasks_.getUtilization() * 100.0f, workers_utilization_ * 100.0f);
+	displayText(-1.f, 0.48f, 1.f, 0.f, 0.f, jobsText);
+	if (grouping_)
+		snprintf(groupedText, sizeof(groupedText), " Grouped draws: %i groups, %i meshes drawn in groups, %i culled", grouped_draws_.getNumGroups(),
+			grouped_draws_.getNumGrouped(), grouped_draws_.getNumCulled());
+	else
+		snprintf(groupedText, sizeof(groupedText), " Grouped draws: off");
+	displayText(-1.f, 0.42f, 1.f, 0.f, 0.f, groupedText);
+	if (static_batching_)
+		snprintf(staticText, sizeof(staticText), " Static: %i meshes in %i groups (%.1f MB), %i culled", (int)(static_receivers_.getMeshes().size() + static_objects_.getMeshes().size()),
+			static_receivers_.getNumGroups() + static_objects_.getNumGroups(), (static_receivers_.getBytes() + static_objects_.getBytes()) / (1024.0f * 1024.0f),
+			static_receivers_.getNumCulled() + static_objects_.getNumCulled());
+	else
+		snprintf(staticText, sizeof(staticText), " Static batching: off");
+	displayText(-1.f, 0.36f, 1.f, 0.f, 0.f, staticText);
 	//glDisable(GL_COLOR_MATERIAL);
 }
 
@@ -29,6 +29,22 @@
 // shadow
 #include "Shadow.h"
 #include "MeshMirrorWorld.h"
+#include "TextureAtlas.h"
+#include "TextureCache.h"
+#include "ResidencyManager.h"
+#include "Frustum.h"
+#include "ShadowMap.h"
+#include "ShadowVolumeBatch.h"
+#include "PlanarShadowPairing.h"
+#include "PlanarShadowCache.h"
+#include "BlobShadow.h"
+#include "ShadowMatrixCache.h"
+#include "MotionSystem.h"
+#include "FixedTimestep.h"
+#include "TaskGraph.h"
+#include "SceneDescription.h"
+#include "GroupedDraws.h"
+#include "StaticBatch.h"
 
 // others
 #include "CameraManager.h"
@@ -36,50 +52,37 @@
 #include "Material.h"
 
 #include <unordered_map>
+#include <chrono>
 
 using namespace std;
 
-// enum with all the meshes/models of this class, it is used to easily identify and access to the right mesh
-enum class MeshesType
+// way the shadows of the light 0 are rendered
+enum class ShadowMode
 {
-	kSphere,
-	kFloor,
-	kCube,
-	kCone,
-	kCylinder,
-	kPyramid,
-	kPentagonal,
-	kHexagonal,
-	kOctagonal,
-	kTorus,
-	kSword,
-	kSpaceship,
-	kSpaceship2,
-	kWallBack,
-	kWallRight,
-	kPlaneMirror,
-	kDiscMirror
+	kPlanar, // the meshes are flattened on each plane of floor_and_walls_ (casters x receivers draws)
+	kShadowMap, // the casters are rendered once in a depth texture and any surface can receive the shadows
+	kShadowVolume, // the silhouettes of the casters are extruded into stencil volumes (depth fail), any surface can receive the shadows
 };
 
-// enum with all the textures names of this class, it is used to easily identify and access to the right texture
-enum class TextureName
+// CPU time (ms) of each part of the last frame and the calls done, to find which part grows with the size of the scene (stress benchmark)
+struct SceneFrameStats
 {
-	kDiceMap,
-	kEarth,
-	kDonut,
-	kDarkGrayWood,
-	kMetal,
-	kSword,
-	kBronzeSword,
-	kSpaceship,
-	kSpaceship2,
+	double update_ms = 0.0; // simulation, lights, camera and mirror worlds
+	double culling_ms = 0.0; // frustum, residency and mirror culling
+	double reflections_ms = 0.0; // reflection textures of the mirrors
+	double meshes_ms = 0.0; // meshes and models with their shadows
+	double mirrors_ms = 0.0; // mirrors and their reflections
+	int num_draws = 0;
+	int num_texture_binds = 0;
 };
 
 class Scene{
 
 public:
-	// constructor
-	Scene(SharedContext *shared_context);
+	// constructor, it creates the scene of the file
+	Scene(SharedContext *shared_context, const char* scene_url = "scenes/main.scene");
+	// constructor, it creates a scene already described (ex: a generated one)
+	Scene(SharedContext *shared_context, const SceneDescription& scene_description);
 	// destructor
 	~Scene();
 	// Main render function
@@ -90,14 +93,18 @@ public:
 	void update(float dt);
 	// Resizes the OpenGL output based on new window size.
 	void resize(int w, int h);
+	// times and calls of the last frame
+	const SceneFrameStats& getFrameStats() const;
 
 protected:
+	// create the content of the scene description (managers, textures, meshes, mirrors) and the systems using it
+	void initialise(const SceneDescription& scene_description);
 	// configure opengl render pipeline
 	void initialiseOpenGL();
-	// initiliase the meshes of this scene
-	void initialiseMeshes();
-	// initiliase the textures for the scene
-	void initialiseTextures();
+	// initiliase the meshes, models, floors/walls and mirrors of the scene description
+	void initialiseMeshes(const SceneDescription& scene_description);
+	// initiliase the textures of the scene description
+	void initialiseTextures(const SceneDescription& scene_description);
 	// initialise material for walls
 	void initialiseMaterials();
 
@@ -107,6 +114,29 @@ protected:
 	void renderTextOutput();
 	void calculateFPS();
 
+	// render the meshes with planar shadows in each plane of the floor and walls
+	void renderWithPlanarShadows();
+	// render the depth of the casters in the shadow map, it must be done before setting the camera
+	void renderShadowMapDepth();
+	// render the meshes with the shadows of the shadow map (two passes)
+	void renderWithShadowMap();
+	// build the shadow volumes and render the meshes with the shadows of the volumes (two passes and the volumes in the stencil)
+	void renderWithShadowVolumes();
+	// replace the projection by the one of the camera without far plane (the far caps of the shadow volumes are never clipped)
+	void loadInfiniteProjection();
+	// render the floor, walls, meshes and models
+	void renderMeshes();
+	// render the meshes and models, the static ones from their batch and the ones with the same geometry in groups (if they are on)
+	void renderObjects();
+	// render a floor/wall by itself, from the static batch if it is on
+	void renderReceiver(MeshPlane* floor_wall);
+	// return the sphere which contains all the meshes of the scene
+	void getSceneBoundingSphere(Vector3& center, float& radius);
+	// calculate the bounds and matrices of the meshes, models, floor/walls and mirrors after moving them (the culling tasks only read them)
+	void updateBounds();
+	// time (ms) since start, start is moved to now for the next part of the frame
+	static double timePart(chrono::steady_clock::time_point& start);
+
 	// For access to user input.
 	SharedContext *shared_context_;
 		
@@ -123,6 +153,13 @@ protected:
 	char mouseText[40];
 	char cameraText[40]; // text to print the id of the camera is being used
 	char pausedText[40] = " PAUSED"; // text to print the id of the camera is being used
+	char bindsText[64]; // text to print the number of texture binds and draw calls done in the last frame
+	char residencyText[80]; // text to print the memory used by the textures and meshes
+	char shadowText[160]; // text to print the shadow mode
+	char mirrorText[96]; // text to print the mode of the mirrors
+	char jobsText[112]; // text to print the tasks of the frame and how busy the threads of the pool are
+	char groupedText[96]; // text to print the draw groups
+	char staticText[96]; // text to print the groups of the static batches
 
 	// camera and light managers
 	CameraManager* camera_mgr_;
@@ -130,15 +167,86 @@ protected:
 	Material* metal_material_;
 
 	// collection of the shapes/meshes I have created
-	unordered_map<MeshesType, BaseMesh*> my_geometry_; // meshes created by me (not loaded from a model)
-	unordered_map<MeshesType, MeshPlane*> floor_and_walls_; // collection of planes which we will use for printing the shadows of the rest of meshes/models 
-	unordered_map<MeshesType, MeshMirrorWorld*> mirror_worlds_;
+	unordered_map<string, BaseMesh*> my_geometry_; // meshes created by me (not loaded from a model)
+	unordered_map<string, MeshPlane*> floor_and_walls_; // collection of planes which we will use for printing the shadows of the rest of meshes/models 
+	unordered_map<string, MeshMirrorWorld*> mirror_worlds_;
 
 	// collection of models (meshes loaded from a file)
-	unordered_map<MeshesType, Model*> models_;
+	unordered_map<string, Model*> models_;
 
 	// collection of textures, each scene have different textures in that all the scenes have the same textures them this object would be passed throught the SharedContext
-	unordered_map<TextureName, Texture*> textures;
+	unordered_map<string, Texture*> textures;
+
+	// atlas where the textures which are not repeated are packed, so the meshes using them share the same texture object
+	TextureAtlas* texture_atlas_;
+
+	// it processes the images of the textures (invert y, NTSC safe, mipmaps, DXT) in the thread pool instead of SOIL
+	TexturePreprocessor* texture_preprocessor_;
+
+	// it saves the processed textures in the disk, so they are processed only the first time the game is run
+	TextureCache* texture_cache_;
+
+	// frustum of the camera, it is updated each frame after setting the camera
+	Frustum frustum_;
+
+	// it keeps the memory of the textures and meshes under a budget (streaming mip levels and freeing the meshes not seen)
+	ResidencyManager* residency_mgr_;
+
+	// shadows: planar or shadow map (nullptr if the graphics card doesn't support it)
+	ShadowMode shadow_mode_ = ShadowMode::kPlanar;
+	ShadowMap* shadow_map_;
+
+	// shadow volumes of the meshes and models, they are built in parallel in the thread pool
+	ShadowVolumeBatch* shadow_volumes_;
+
+	// movement and rotation of the meshes and models (all of them are updated together)
+	MotionSystem* motion_system_;
+	bool use_motion_system_; // false if there are too few moving meshes and models, they are updated by their update() (it is faster)
+
+	// clock of the simulation (steps of 1/60 s), the movement of the meshes is simulated one frame ahead of the render
+	FixedTimestep fixed_timestep_;
+
+	// lights casting planar shadows in this frame (the ones which light the scene the most), at most max_shadow_lights_
+	// the stencil has a bit for each light, so there can't be more than kMaxShadowLights
+	static const int kMaxShadowLights = 4;
+	// the rest of the 8 bits of the stencil are the id of the floor/wall (2 + n), when they run out the stencil is cleared and they start again
+	static const int kReceiverStencilBits = 8 - kMaxShadowLights;
+	static const int kMaxReceiverStencilIds = (1 << kReceiverStencilBits) - 2;
+	int max_shadow_lights_ = 2;
+	vector<Light*> shadow_lights_;
+
+	// list of the casters whose planar shadow can land on each floor/wall for each light, they are built each frame
+	PlanarShadowPairing shadow_pairings_[kMaxShadowLights];
+
+	// planar shadow matrix of each light on each floor/wall, they are only calculated again when the light moves
+	ShadowMatrixCache shadow_matrices_;
+
+	// planar shadows already flattened, they are reused while the light, the floor/wall and the caster don't move
+	PlanarShadowCache shadow_cache_;
+
+	// soft round shadows of the casters which are far or small (chosen by the shadow pairing)
+	BlobShadow blob_shadow_;
+
+	// CPU work of the frame (updates and culling) run by the thread pool, the openGL work stays in the GL thread
+	TaskGraph frame_tasks_;
+	bool dump_frame_tasks_ = false; // print the tasks of the frame ('g')
+
+	// time the threads of the pool had been busy at the last frame (s) and the fraction of them busy during the last frame
+	double last_busy_time_ = 0.0;
+	float workers_utilization_ = 0.0f;
+
+	// times and calls of the last frame
+	SceneFrameStats frame_stats_;
+
+	// the meshes and models grouped by geometry and texture, each group is drawn setting its arrays once ('t' turns it on and off)
+	GroupedDraws grouped_draws_;
+	bool grouping_ = true;
+
+	// the meshes and models which never move, merged in world space by texture and colour ('l' turns it on and off)
+	// the floor and walls are in their own batch, so each one can still be drawn by itself with the stencil of its planar shadows
+	StaticBatch static_receivers_;
+	StaticBatch static_objects_;
+	bool static_batching_ = true;
 
 };
 
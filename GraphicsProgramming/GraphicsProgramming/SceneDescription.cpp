@@ -0,0 +1,995 @@
+#include "SceneDescription.h"
+#include <cstdio> // fopen, remove
+#include <cstring> // memcpy, strcmp
+#include <cstdlib> // strtof
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h> // _mkdir
+#endif
+
+/* BINARY FILE FORMAT */
+// header + the arrays one after another (each one starts at a multiple of 8 bytes) + the strings
+
+static const unsigned int SCENE_MAGIC = 0x424E4353; // "SCNB"
+static const unsigned int SCENE_VERSION = 1;
+
+// arrays of the file
+enum SceneTable
+{
+	kTextureTable,
+	kObjectTable,
+	kMirrorTable,
+	kReflectionTable,
+	kLightTable,
+	kCameraTable,
+	kStringTable,
+	kNumTables
+};
+
+struct SceneFileTable
+{
+	unsigned int count; // number of elements (bytes for the strings)
+	unsigned int offset; // from the start of the file
+};
+
+struct SceneFileHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	long long source_modification_time;
+	unsigned int element_sizes[kNumTables]; // size of the structs, a file saved by a build with other structs is not valid
+	SceneFileTable tables[kNumTables];
+};
+
+// size of the struct of each table
+static const unsigned int element_sizes[kNumTables] = { sizeof(SceneTextureDesc), sizeof(SceneObjectDesc), sizeof(SceneMirrorDesc),
+	sizeof(SceneReflectionDesc), sizeof(SceneLightDesc), sizeof(SceneCameraDesc), sizeof(char) };
+
+/* NAMES OF THE VALUES IN THE TEXT */
+
+// same order as Facing
+static const char* facing_names[] = { "up", "down", "backward", "forward", "left", "right" };
+
+// same order as CameraType
+static const char* camera_type_names[] = { "fixed", "rotating", "scrolling", "moveable", "floating", "tracking", "pusable", "first_person" };
+
+// keys of the parameters of each shape (same order as SceneShape): key, first param and number of values
+struct SceneShapeKey
+{
+	const char* key;
+	int param;
+	int num_values;
+};
+static const SceneShapeKey shape_keys[][5] = {
+	{ { "radius", 0, 1 }, { "segments", 1, 2 } },
+	{ { "base_radius", 0, 1 }, { "top_radius", 1, 1 }, { "height", 2, 1 }, { "segments", 3, 2 }, { "discs", 5, 2 } },
+	{ { "dimension", 0, 1 }, { "unit", 1, 1 } },
+	{ { "minor_radius", 0, 1 }, { "major_radius", 1, 1 }, { "tube_faces", 2, 1 }, { "rings", 3, 1 } },
+	{ { "size", 1, 2 } },
+	{ },
+};
+static const char* shape_names[] = { "sphere", "cone", "cube", "torus", "plane", "model" };
+
+// return the index of the name in the list, -1 if it is not there
+static int findName(const string& name, const char* const* names, int num_names)
+{
+	for (int i = 0; i < num_names; i++)
+	{
+		if (name == names[i])
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+SceneDescription::SceneDescription()
+{
+	clear();
+}
+
+bool SceneDescription::load(const char* url, const char* cache_directory)
+{
+	long long modification_time = getModificationTime(url);
+	if (modification_time == 0)
+	{
+		printf("Scene: %s cannot be read\n", url);
+		return false;
+	}
+
+	// the binary file is named by the url of the text (ex: scenes/main.scene -> cache/scenes_main.scene.bin)
+	string binary_url = url;
+	for (char& character : binary_url)
+	{
+		if (character == '/' || character == '\\' || character == ':')
+		{
+			character = '_';
+		}
+	}
+	binary_url = string(cache_directory) + binary_url + ".bin";
+
+	if (loadBinary(binary_url.c_str(), modification_time))
+	{
+		printf("Scene: %s mapped from %s (%i objects, %i mirrors, %i lights, %i cameras)\n", url, binary_url.c_str(), num_objects_,
+			num_mirrors_, num_lights_, num_cameras_);
+		return true;
+	}
+
+	// parse the text and save it for the next time
+	if (!loadText(url))
+	{
+		return false;
+	}
+	string directory = cache_directory;
+	if (!directory.empty() && (directory.back() == '/' || directory.back() == '\\'))
+	{
+		directory.pop_back();
+	}
+#ifdef _WIN32
+	_mkdir(directory.c_str());
+#else
+	mkdir(directory.c_str(), 0755);
+#endif
+	if (!saveBinary(binary_url.c_str(), modification_time))
+	{
+		printf("Scene: %s cannot be saved, the text will be parsed again the next time\n", binary_url.c_str());
+	}
+	printf("Scene: %s parsed (%i objects, %i mirrors, %i lights, %i cameras)\n", url, num_objects_, num_mirrors_, num_lights_, num_cameras_);
+	return true;
+}
+
+bool SceneDescription::loadText(const char* url)
+{
+	FILE* file = nullptr;
+#ifdef _WIN32
+	fopen_s(&file, url, "rb");
+#else
+	file = fopen(url, "rb");
+#endif
+	if (file == nullptr)
+	{
+		printf("Scene: %s cannot be read\n", url);
+		return false;
+	}
+
+	clear();
+
+	char line[1024];
+	int line_number = 0;
+	while (fgets(line, sizeof(line), file) != nullptr)
+	{
+		line_number++;
+
+		// split the line in tokens (the comments start with #)
+		vector<string> tokens;
+		string token;
+		for (char* character = line; *character != '\0' && *character != '#'; character++)
+		{
+			if (*character == ' ' || *character == '\t' || *character == '\r' || *character == '\n')
+			{
+				if (!token.empty())
+				{
+					tokens.push_back(token);
+					token.clear();
+				}
+			}
+			else
+			{
+				token += *character;
+			}
+		}
+		if (!token.empty())
+		{
+			tokens.push_back(token);
+		}
+		if (tokens.empty())
+		{
+			continue;
+		}
+
+		string kind = tokens[0];
+		tokens.erase(tokens.begin());
+		if (tokens.empty())
+		{
+			printf("Scene: %s:%i: '%s' without name, skipped\n", url, line_number, kind.c_str());
+			continue;
+		}
+		if (!parseElement(kind, tokens, url, line_number))
+		{
+			printf("Scene: %s:%i: '%s %s' has values not valid, they are skipped\n", url, line_number, kind.c_str(), tokens[0].c_str());
+		}
+	}
+	fclose(file);
+
+	return true;
+}
+
+bool SceneDescription::parseElement(const string& kind, const vector<string>& tokens, const char* url, int line_number)
+{
+	const string& name = tokens[0];
+	bool valid = true;
+
+	// split the key=value pairs, the values are checked by each kind
+	vector<pair<string, string>> values;
+	for (size_t i = 1; i < tokens.size(); i++)
+	{
+		size_t equal = tokens[i].find('=');
+		if (equal == string::npos)
+		{
+			values.push_back({ tokens[i], "" });
+		}
+		else
+		{
+			values.push_back({ tokens[i].substr(0, equal), tokens[i].substr(equal + 1) });
+		}
+	}
+
+	// return the index of a name in the map, -1 if it is not there
+	auto find_index = [&](const unordered_map<string, int>& indices, const string& index_name, const char* element) -> int
+	{
+		auto index = indices.find(index_name);
+		if (index == indices.end())
+		{
+			printf("Scene: %s:%i: unknown %s '%s' (it must be before)\n", url, line_number, element, index_name.c_str());
+			return -1;
+		}
+		return index->second;
+	};
+
+	/* Textures */
+
+	if (kind == "texture")
+	{
+		string texture_url;
+		bool mapped = false, y_inverted = false, repeat = false;
+		for (const pair<string, string>& value : values)
+		{
+			float flag = 0.0f;
+			if (value.first == "url")
+				texture_url = value.second;
+			else if (value.first == "mapped" && parseValues(value.second, &flag, 1))
+				mapped = flag != 0.0f;
+			else if (value.first == "y_inverted" && parseValues(value.second, &flag, 1))
+				y_inverted = flag != 0.0f;
+			else if (value.first == "repeat" && parseValues(value.second, &flag, 1))
+				repeat = flag != 0.0f;
+			else
+				valid = false;
+		}
+		if (texture_url.empty())
+		{
+			printf("Scene: %s:%i: texture '%s' without url, skipped\n", url, line_number, name.c_str());
+			return true;
+		}
+		addTexture(name, texture_url, mapped, y_inverted, repeat);
+		return valid;
+	}
+
+	/* Meshes, models and floors/walls */
+
+	int shape = findName(kind, shape_names, 6);
+	if (shape >= 0)
+	{
+		SceneObjectDesc object = getDefaultObject((SceneShape)shape);
+		string model_url;
+		for (const pair<string, string>& value : values)
+		{
+			bool parsed = false;
+			const string& key = value.first;
+
+			// parameters of the shape
+			for (const SceneShapeKey& shape_key : shape_keys[shape])
+			{
+				if (shape_key.key != nullptr && key == shape_key.key)
+				{
+					parsed = parseValues(value.second, &object.params[shape_key.param], shape_key.num_values);
+				}
+			}
+			if (parsed)
+				continue;
+
+			if (key == "url" && shape == (int)SceneShape::kModel)
+			{
+				model_url = value.second;
+				parsed = true;
+			}
+			else if (key == "facing" && shape == (int)SceneShape::kPlane)
+			{
+				// an unknown name keeps the default facing (up), the plane cannot be built with a facing of -1
+				int facing = findName(value.second, facing_names, 6);
+				if (facing >= 0)
+					object.params[0] = (float)facing;
+				parsed = facing >= 0;
+			}
+			else if (key == "texture")
+			{
+				object.texture = find_index(texture_indices_, value.second, "texture");
+				parsed = object.texture >= 0;
+			}
+			else if (key == "translation")
+				parsed = parseValues(value.second, object.translation, 3);
+			else if (key == "rotation")
+				parsed = parseValues(value.second, object.rotation, 3);
+			else if (key == "scale")
+				parsed = parseValues(value.second, object.scale, 3);
+			else if (key == "limits_max")
+				parsed = parseValues(value.second, object.limits_max, 3);
+			else if (key == "limits_min")
+				parsed = parseValues(value.second, object.limits_min, 3);
+			else if (key == "direction")
+				parsed = parseValues(value.second, object.direction, 3);
+			else if (key == "speed")
+				parsed = parseValues(value.second, &object.speed, 1);
+			else if (key == "moving" || key == "rotating")
+			{
+				float axes[3];
+				parsed = parseValues(value.second, axes, 3);
+				int* flags = (key == "moving") ? object.moving : object.rotating;
+				for (int i = 0; parsed && i < 3; i++)
+				{
+					flags[i] = (axes[i] != 0.0f) ? 1 : 0;
+				}
+			}
+			valid = valid && parsed;
+		}
+		if (shape == (int)SceneShape::kModel && model_url.empty())
+		{
+			printf("Scene: %s:%i: model '%s' without url, skipped\n", url, line_number, name.c_str());
+			return true;
+		}
+		if (object_indices_.count(name) > 0)
+		{
+			printf("Scene: %s:%i: there is already an object '%s', skipped\n", url, line_number, name.c_str());
+			return true;
+		}
+		addObject(name, model_url, object);
+		return valid;
+	}
+
+	/* Mirrors and the objects they reflect */
+
+	if (kind == "mirror")
+	{
+		SceneMirrorDesc mirror = getDefaultMirror();
+		for (const pair<string, string>& value : values)
+		{
+			bool parsed = false;
+			const string& key = value.first;
+			if (key == "shape")
+			{
+				mirror.disc = (value.second == "disc") ? 1 : 0;
+				parsed = value.second == "disc" || value.second == "plane";
+			}
+			else if (key == "facing")
+			{
+				mirror.facing = findName(value.second, facing_names, 6);
+				parsed = mirror.facing >= 0;
+			}
+			else if (key == "size")
+				parsed = parseValues(value.second, mirror.size, 2);
+			else if (key == "radius")
+				parsed = parseValues(value.second, &mirror.size[0], 1);
+			else if (key == "triangles")
+				parsed = parseValues(value.second, &mirror.size[1], 1);
+			else if (key == "translation")
+				parsed = parseValues(value.second, mirror.translation, 3);
+			else if (key == "colour")
+				parsed = parseValues(value.second, mirror.colour, 4);
+			else if (key == "texture_scale")
+				parsed = parseValues(value.second, &mirror.texture_scale, 1);
+			else if (key == "update_interval")
+			{
+				float interval = 0.0f;
+				parsed = parseValues(value.second, &interval, 1);
+				mirror.update_interval = (int)interval;
+			}
+			valid = valid && parsed;
+		}
+		if (mirror.facing < 0)
+		{
+			mirror.facing = 0;
+		}
+		addMirror(name, mirror);
+		return valid;
+	}
+	if (kind == "reflect" || kind == "copy")
+	{
+		// reflect/copy <mirror> <object> [texture=<texture>] [invert_z=1]
+		if (tokens.size() < 2)
+		{
+			printf("Scene: %s:%i: '%s' needs a mirror and an object, skipped\n", url, line_number, kind.c_str());
+			return true;
+		}
+		SceneReflectionDesc reflection;
+		reflection.mirror = find_index(mirror_indices_, tokens[0], "mirror");
+		reflection.object = find_index(object_indices_, tokens[1], "object");
+		reflection.copy = (kind == "copy") ? 1 : 0;
+		reflection.invert_z = 0;
+		reflection.texture = -1;
+		if (reflection.mirror < 0 || reflection.object < 0)
+		{
+			return true; // the unknown names are already printed
+		}
+		for (size_t i = 2; i < tokens.size(); i++)
+		{
+			size_t equal = tokens[i].find('=');
+			string key = tokens[i].substr(0, equal);
+			string value = (equal == string::npos) ? "" : tokens[i].substr(equal + 1);
+			float flag = 0.0f;
+			if (key == "texture" && reflection.copy)
+			{
+				reflection.texture = find_index(texture_indices_, value, "texture");
+				valid = valid && reflection.texture >= 0;
+			}
+			else if (key == "invert_z" && reflection.copy && parseValues(value, &flag, 1))
+				reflection.invert_z = (flag != 0.0f) ? 1 : 0;
+			else
+				valid = false;
+		}
+		addReflection(reflection);
+		return valid;
+	}
+
+	/* Lights */
+
+	if (kind == "light")
+	{
+		if (num_lights_ >= 8)
+		{
+			printf("Scene: %s:%i: openGL only has 8 lights, '%s' skipped\n", url, line_number, name.c_str());
+			return true;
+		}
+		SceneLightDesc light = getDefaultLight();
+		for (const pair<string, string>& value : values)
+		{
+			bool parsed = false;
+			const string& key = value.first;
+			if (key == "ambient")
+				parsed = parseValues(value.second, light.ambient, 4);
+			else if (key == "diffuse")
+				parsed = parseValues(value.second, light.diffuse, 4);
+			else if (key == "specular")
+				parsed = parseValues(value.second, light.specular, 4);
+			else if (key == "position")
+				parsed = parseValues(value.second, light.position, 4);
+			else if (key == "spot_direction")
+			{
+				parsed = parseValues(value.second, light.spot_direction, 3);
+				light.spot = 1;
+			}
+			else if (key == "spot_cutoff")
+				parsed = parseValues(value.second, &light.spot_cutoff, 1);
+			else if (key == "spot_exponent")
+				parsed = parseValues(value.second, &light.spot_exponent, 1);
+			else if (key == "attenuation")
+			{
+				parsed = parseValues(value.second, light.attenuation, 3);
+				light.has_attenuation = 1;
+			}
+			else if (key == "speed")
+				parsed = parseValues(value.second, &light.speed, 1);
+			else if (key == "changing_colour")
+			{
+				float flag = 0.0f;
+				parsed = parseValues(value.second, &flag, 1);
+				light.changing_colour = (flag != 0.0f) ? 1 : 0;
+			}
+			valid = valid && parsed;
+		}
+		addLight(name, light);
+		return valid;
+	}
+
+	/* Cameras */
+
+	if (kind == "camera")
+	{
+		SceneCameraDesc camera = getDefaultCamera();
+		for (const pair<string, string>& value : values)
+		{
+			bool parsed = false;
+			const string& key = value.first;
+			if (key == "type")
+			{
+				int type = findName(value.second, camera_type_names, 8);
+				parsed = type >= 0;
+				if (parsed)
+					camera.type = type;
+			}
+			else if (key == "position")
+				parsed = parseValues(value.second, camera.position, 3);
+			else if (key == "rotation")
+				parsed = parseValues(value.second, camera.rotation, 3);
+			else if (key == "rotation_speed")
+				parsed = parseValues(value.second, &camera.rotation_speed, 1);
+			else if (key == "movement_speed")
+				parsed = parseValues(value.second, &camera.movement_speed, 1);
+			else if (key == "zoom_speed")
+				parsed = parseValues(value.second, &camera.zoom_speed, 1);
+			else if (key == "pitch_limits")
+				parsed = parseValues(value.second, camera.pitch_limits, 2);
+			else if (key == "yaw_limits")
+				parsed = parseValues(value.second, camera.yaw_limits, 2);
+			else if (key == "follow")
+			{
+				camera.followed_object = find_index(object_indices_, value.second, "object");
+				parsed = camera.followed_object >= 0;
+			}
+			else if (key == "eye")
+				parsed = parseValues(value.second, camera.eye_offset, 3);
+			valid = valid && parsed;
+		}
+		addCamera(name, camera);
+		return valid;
+	}
+
+	printf("Scene: %s:%i: unknown element '%s', skipped\n", url, line_number, kind.c_str());
+	return true;
+}
+
+bool SceneDescription::parseValues(const string& value, float* values, int num_values)
+{
+	// the values are only written if all of them are valid
+	float parsed_values[8];
+	const char* text = value.c_str();
+	for (int i = 0; i < num_values; i++)
+	{
+		char* end = nullptr;
+		parsed_values[i] = strtof(text, &end);
+		if (end == text || (i + 1 < num_values && *end != ','))
+		{
+			return false;
+		}
+		text = end + 1;
+	}
+	if (text[-1] != '\0')
+	{
+		return false;
+	}
+
+	for (int i = 0; i < num_values; i++)
+	{
+		values[i] = parsed_values[i];
+	}
+	return true;
+}
+
+bool SceneDescription::loadBinary(const char* url, long long source_modification_time)
+{
+	clear();
+
+	if (!mapped_file_.open(url))
+	{
+		return false;
+	}
+	const unsigned char* data = mapped_file_.getData();
+	size_t size = mapped_file_.getSize();
+
+	/* Check the header and that the arrays are inside the file */
+
+	SceneFileHeader header;
+	if (size < sizeof(SceneFileHeader))
+	{
+		mapped_file_.close();
+		return false;
+	}
+	memcpy(&header, data, sizeof(SceneFileHeader));
+	bool valid = header.magic == SCENE_MAGIC && header.version == SCENE_VERSION &&
+		(source_modification_time == 0 || header.source_modification_time == source_modification_time);
+	for (int i = 0; valid && i < kNumTables; i++)
+	{
+		valid = header.element_sizes[i] == element_sizes[i] && header.tables[i].offset % 8 == 0 &&
+			(unsigned long long)header.tables[i].offset + (unsigned long long)header.tables[i].count * element_sizes[i] <= size;
+	}
+	// the last string must end in the table
+	const SceneFileTable& strings = header.tables[kStringTable];
+	valid = valid && (strings.count == 0 || data[strings.offset + strings.count - 1] == '\0');
+	if (!valid)
+	{
+		mapped_file_.close();
+		return false;
+	}
+
+	/* The arrays are used where they are in the mapped file */
+
+	texture_table_ = (const SceneTextureDesc*)(data + header.tables[kTextureTable].offset);
+	object_table_ = (const SceneObjectDesc*)(data + header.tables[kObjectTable].offset);
+	mirror_table_ = (const SceneMirrorDesc*)(data + header.tables[kMirrorTable].offset);
+	reflection_table_ = (const SceneReflectionDesc*)(data + header.tables[kReflectionTable].offset);
+	light_table_ = (const SceneLightDesc*)(data + header.tables[kLightTable].offset);
+	camera_table_ = (const SceneCameraDesc*)(data + header.tables[kCameraTable].offset);
+	string_table_ = (const char*)(data + strings.offset);
+	num_textures_ = (int)header.tables[kTextureTable].count;
+	num_objects_ = (int)header.tables[kObjectTable].count;
+	num_mirrors_ = (int)header.tables[kMirrorTable].count;
+	num_reflections_ = (int)header.tables[kReflectionTable].count;
+	num_lights_ = (int)header.tables[kLightTable].count;
+	num_cameras_ = (int)header.tables[kCameraTable].count;
+	strings_size_ = strings.count;
+
+	return true;
+}
+
+bool SceneDescription::saveBinary(const char* url, long long source_modification_time) const
+{
+	/* Header, the arrays are placed one after another */
+
+	SceneFileHeader header;
+	memset(&header, 0, sizeof(SceneFileHeader));
+	header.magic = SCENE_MAGIC;
+	header.version = SCENE_VERSION;
+	header.source_modification_time = source_modification_time;
+
+	const void* tables[kNumTables] = { texture_table_, object_table_, mirror_table_, reflection_table_, light_table_, camera_table_, string_table_ };
+	unsigned int counts[kNumTables] = { (unsigned int)num_textures_, (unsigned int)num_objects_, (unsigned int)num_mirrors_,
+		(unsigned int)num_reflections_, (unsigned int)num_lights_, (unsigned int)num_cameras_, strings_size_ };
+	unsigned int offset = sizeof(SceneFileHeader);
+	for (int i = 0; i < kNumTables; i++)
+	{
+		offset = (offset + 7) & ~7u;
+		header.element_sizes[i] = element_sizes[i];
+		header.tables[i].count = counts[i];
+		header.tables[i].offset = offset;
+		offset += counts[i] * element_sizes[i];
+	}
+
+	/* Write the file, first with a temporary name so a file half written is never read */
+
+	string temporary_url = string(url) + ".tmp";
+	FILE* file = nullptr;
+#ifdef _WIN32
+	fopen_s(&file, temporary_url.c_str(), "wb");
+#else
+	file = fopen(temporary_url.c_str(), "wb");
+#endif
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	bool written = fwrite(&header, sizeof(SceneFileHeader), 1, file) == 1;
+	unsigned int position = sizeof(SceneFileHeader);
+	const char padding[8] = {};
+	for (int i = 0; i < kNumTables; i++)
+	{
+		written = written && fwrite(padding, 1, header.tables[i].offset - position, file) == header.tables[i].offset - position;
+		size_t table_size = (size_t)counts[i] * element_sizes[i];
+		written = written && (table_size == 0 || fwrite(tables[i], 1, table_size, file) == table_size);
+		position = header.tables[i].offset + (unsigned int)table_size;
+	}
+	fclose(file);
+
+	std::remove(url); // rename fails on windows if the file exists
+	if (!written || std::rename(temporary_url.c_str(), url) != 0)
+	{
+		std::remove(temporary_url.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void SceneDescription::clear()
+{
+	mapped_file_.close();
+
+	textures_.clear();
+	objects_.clear();
+	mirrors_.clear();
+	reflections_.clear();
+	lights_.clear();
+	cameras_.clear();
+	strings_.clear();
+	texture_indices_.clear();
+	object_indices_.clear();
+	mirror_indices_.clear();
+
+	// the offset 0 is the empty string
+	strings_.push_back('\0');
+
+	useVectors();
+}
+
+int SceneDescription::addTexture(const string& name, const string& url, bool mapped, bool y_inverted, bool repeat)
+{
+	makeEditable();
+
+	SceneTextureDesc texture;
+	texture.name = addString(name);
+	texture.url = addString(url);
+	texture.mapped = mapped ? 1 : 0;
+	texture.y_inverted = y_inverted ? 1 : 0;
+	texture.repeat = repeat ? 1 : 0;
+	textures_.push_back(texture);
+	texture_indices_[name] = (int)textures_.size() - 1;
+
+	useVectors();
+	return num_textures_ - 1;
+}
+
+int SceneDescription::addObject(const string& name, const string& url, SceneObjectDesc object)
+{
+	makeEditable();
+
+	object.name = addString(name);
+	object.url = addString(url);
+	objects_.push_back(object);
+	object_indices_[name] = (int)objects_.size() - 1;
+
+	useVectors();
+	return num_objects_ - 1;
+}
+
+int SceneDescription::addMirror(const string& name, SceneMirrorDesc mirror)
+{
+	makeEditable();
+
+	mirror.name = addString(name);
+	mirrors_.push_back(mirror);
+	mirror_indices_[name] = (int)mirrors_.size() - 1;
+
+	useVectors();
+	return num_mirrors_ - 1;
+}
+
+void SceneDescription::addReflection(const SceneReflectionDesc& reflection)
+{
+	makeEditable();
+
+	reflections_.push_back(reflection);
+
+	useVectors();
+}
+
+int SceneDescription::addLight(const string& name, SceneLightDesc light)
+{
+	makeEditable();
+
+	light.name = addString(name);
+	lights_.push_back(light);
+
+	useVectors();
+	return num_lights_ - 1;
+}
+
+int SceneDescription::addCamera(const string& name, SceneCameraDesc camera)
+{
+	makeEditable();
+
+	camera.name = addString(name);
+	cameras_.push_back(camera);
+
+	useVectors();
+	return num_cameras_ - 1;
+}
+
+SceneObjectDesc SceneDescription::getDefaultObject(SceneShape shape)
+{
+	SceneObjectDesc object;
+	memset(&object, 0, sizeof(SceneObjectDesc));
+	object.shape = (int)shape;
+	object.texture = -1;
+	object.scale[0] = object.scale[1] = object.scale[2] = 1.0f;
+
+	// the default parameters of the constructors of the meshes
+	switch (shape)
+	{
+	case SceneShape::kSphere:
+		object.params[0] = 1.0f; object.params[1] = 50.0f; object.params[2] = 50.0f;
+		break;
+	case SceneShape::kCone:
+		object.params[0] = 1.0f; object.params[1] = 0.0f; object.params[2] = 1.0f; object.params[3] = 200.0f; object.params[4] = 200.0f;
+		object.params[5] = 1.0f; object.params[6] = 1.0f;
+		break;
+	case SceneShape::kCube:
+		object.params[0] = 1.0f;
+		break;
+	case SceneShape::kTorus:
+		object.params[0] = 1.1f; object.params[1] = 2.1f; object.params[2] = 200.0f; object.params[3] = 400.0f;
+		break;
+	case SceneShape::kPlane:
+		object.params[1] = 2.0f; object.params[2] = 2.0f;
+		break;
+	default:
+		break;
+	}
+	return object;
+}
+
+SceneMirrorDesc SceneDescription::getDefaultMirror()
+{
+	SceneMirrorDesc mirror;
+	memset(&mirror, 0, sizeof(SceneMirrorDesc));
+	mirror.size[0] = 20.0f;
+	mirror.size[1] = 20.0f;
+	mirror.colour[0] = mirror.colour[1] = mirror.colour[2] = mirror.colour[3] = 1.0f;
+	mirror.texture_scale = 1.0f;
+	mirror.update_interval = 1;
+	return mirror;
+}
+
+SceneLightDesc SceneDescription::getDefaultLight()
+{
+	// a white point light (the default values of openGL for GL_LIGHT0)
+	SceneLightDesc light;
+	memset(&light, 0, sizeof(SceneLightDesc));
+	light.ambient[3] = 1.0f;
+	light.diffuse[0] = light.diffuse[1] = light.diffuse[2] = light.diffuse[3] = 1.0f;
+	light.specular[3] = 1.0f;
+	light.position[2] = 1.0f;
+	light.position[3] = 1.0f;
+	light.spot_direction[2] = -1.0f;
+	light.spot_cutoff = 180.0f;
+	light.attenuation[0] = 1.0f;
+	return light;
+}
+
+SceneCameraDesc SceneDescription::getDefaultCamera()
+{
+	// the default values of the constructor of the camera
+	SceneCameraDesc camera;
+	memset(&camera, 0, sizeof(SceneCameraDesc));
+	camera.type = 4; // floating
+	camera.position[2] = 8.0f;
+	camera.pitch_limits[0] = 360.0f;
+	camera.pitch_limits[1] = -360.0f;
+	camera.yaw_limits[0] = 360.0f;
+	camera.yaw_limits[1] = -360.0f;
+	camera.followed_object = -1;
+	return camera;
+}
+
+int SceneDescription::getNumTextures() const
+{
+	return num_textures_;
+}
+
+const SceneTextureDesc& SceneDescription::getTexture(int index) const
+{
+	return texture_table_[index];
+}
+
+int SceneDescription::getNumObjects() const
+{
+	return num_objects_;
+}
+
+const SceneObjectDesc& SceneDescription::getObject(int index) const
+{
+	return object_table_[index];
+}
+
+int SceneDescription::getNumMirrors() const
+{
+	return num_mirrors_;
+}
+
+const SceneMirrorDesc& SceneDescription::getMirror(int index) const
+{
+	return mirror_table_[index];
+}
+
+int SceneDescription::getNumReflections() const
+{
+	return num_reflections_;
+}
+
+const SceneReflectionDesc& SceneDescription::getReflection(int index) const
+{
+	return reflection_table_[index];
+}
+
+int SceneDescription::getNumLights() const
+{
+	return num_lights_;
+}
+
+const SceneLightDesc& SceneDescription::getLight(int index) const
+{
+	return light_table_[index];
+}
+
+int SceneDescription::getNumCameras() const
+{
+	return num_cameras_;
+}
+
+const SceneCameraDesc& SceneDescription::getCamera(int index) const
+{
+	return camera_table_[index];
+}
+
+const char* SceneDescription::getString(unsigned int offset) const
+{
+	return (offset < strings_size_) ? string_table_ + offset : "";
+}
+
+bool SceneDescription::isMapped() const
+{
+	return mapped_file_.getData() != nullptr;
+}
+
+unsigned int SceneDescription::addString(const string& text)
+{
+	if (text.empty())
+	{
+		return 0;
+	}
+	unsigned int offset = (unsigned int)strings_.size();
+	strings_.insert(strings_.end(), text.begin(), text.end());
+	strings_.push_back('\0');
+	return offset;
+}
+
+void SceneDescription::useVectors()
+{
+	texture_table_ = textures_.data();
+	object_table_ = objects_.data();
+	mirror_table_ = mirrors_.data();
+	reflection_table_ = reflections_.data();
+	light_table_ = lights_.data();
+	camera_table_ = cameras_.data();
+	string_table_ = strings_.data();
+	num_textures_ = (int)textures_.size();
+	num_objects_ = (int)objects_.size();
+	num_mirrors_ = (int)mirrors_.size();
+	num_reflections_ = (int)reflections_.size();
+	num_lights_ = (int)lights_.size();
+	num_cameras_ = (int)cameras_.size();
+	strings_size_ = (unsigned int)strings_.size();
+}
+
+void SceneDescription::makeEditable()
+{
+	if (!isMapped())
+	{
+		return;
+	}
+
+	textures_.assign(texture_table_, texture_table_ + num_textures_);
+	objects_.assign(object_table_, object_table_ + num_objects_);
+	mirrors_.assign(mirror_table_, mirror_table_ + num_mirrors_);
+	reflections_.assign(reflection_table_, reflection_table_ + num_reflections_);
+	lights_.assign(light_table_, light_table_ + num_lights_);
+	cameras_.assign(camera_table_, camera_table_ + num_cameras_);
+	strings_.assign(string_table_, string_table_ + strings_size_);
+
+	// the names are indexed again, so the new elements can refer to the old ones
+	texture_indices_.clear();
+	object_indices_.clear();
+	mirror_indices_.clear();
+	for (int i = 0; i < num_textures_; i++)
+	{
+		texture_indices_[getString(textures_[i].name)] = i;
+	}
+	for (int i = 0; i < num_objects_; i++)
+	{
+		object_indices_[getString(objects_[i].name)] = i;
+	}
+	for (int i = 0; i < num_mirrors_; i++)
+	{
+		mirror_indices_[getString(mirrors_[i].name)] = i;
+	}
+
+	mapped_file_.close();
+	useVectors();
+}
+
+long long SceneDescription::getModificationTime(const char* url)
+{
+#ifdef _WIN32
+	struct _stat64 file_info;
+	if (_stat64(url, &file_info) != 0)
+	{
+		return 0;
+	}
+#else
+	struct stat file_info;
+	if (stat(url, &file_info) != 0)
+	{
+		return 0;
+	}
+#endif
+	return (long long)file_info.st_mtime;
+}
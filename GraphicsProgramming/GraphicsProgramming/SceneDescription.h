@@ -0,0 +1,222 @@
+// Class Scene Description
+// Content of a scene (textures, meshes and models, floors/walls receiving the shadows, mirrors, lights and cameras) read from a file,
+// so the layout of the scene can be changed without compiling the game again.
+// The scene is written in a text file, one element per line: its kind, its name and its values as key=value (ex: the main scene is
+// scenes/main.scene, which explains all the keys). The elements are kept in contiguous arrays of plain structs, the references between
+// them (ex: the texture of a mesh, the object followed by a camera) are indices and the strings are offsets in a table of strings.
+// The first time the text is parsed those arrays are saved as they are in a binary file in the cache. The next times (if the text has
+// not been modified) the binary file is memory mapped and the arrays are used directly from the mapped memory, without parsing anything.
+// The elements can also be added by code (ex: a generated scene).
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+// shape of an object, it tells the meaning of its params
+enum class SceneShape
+{
+	kSphere, // params: radius, longitudinal segments, latitudinal segments
+	kCone, // params: base radius, top radius, height, longitudinal segments, latitudinal segments, top disc, base disc (prisms, pyramids, cylinders)
+	kCube, // params: dimension, unit (the texture covers each face once instead of each square)
+	kTorus, // params: minor radius, major radius, tube faces, rings
+	kPlane, // params: facing, height, width (floors and walls, they receive the shadows)
+	kModel, // the url is the .obj file
+};
+
+// texture loaded from an image
+struct SceneTextureDesc
+{
+	unsigned int name; // offset in the strings
+	unsigned int url;
+	int mapped; // the texture coords of the meshes take only a part of the image (TextureCoordsType::kMapped)
+	int y_inverted;
+	int repeat; // GL_REPEAT instead of clamping
+};
+
+// mesh, model or floor/wall, with its transform and its movement
+struct SceneObjectDesc
+{
+	unsigned int name;
+	unsigned int url; // only for the models
+	int shape; // SceneShape
+	float params[8]; // parameters of the generator of the shape
+	int texture; // index of the texture, -1 if it doesn't have
+	float translation[3];
+	float rotation[3]; // degrees
+	float scale[3];
+	int moving[3]; // it moves along x, y, z
+	int rotating[3]; // it rotates around x, y, z
+	float limits_max[3]; // limits of the movement
+	float limits_min[3];
+	float direction[3];
+	float speed;
+};
+
+// mirror (a plane or a disc) with its own world of reflections
+struct SceneMirrorDesc
+{
+	unsigned int name;
+	int disc; // a disc instead of a plane
+	int facing;
+	float size[2]; // height and width of the plane, or radius and number of triangles of the disc
+	float translation[3];
+	float colour[4];
+	float texture_scale; // size of the reflection texture relative to the window
+	int update_interval; // frames between the updates of the reflection texture
+};
+
+// object reflected in a mirror
+struct SceneReflectionDesc
+{
+	int mirror; // index of the mirror
+	int object; // index of the object
+	int copy; // a copy of the object is rendered behind the mirror (otherwise the object is rendered with the matrix of the mirror)
+	int invert_z; // only for the copies
+	int texture; // other texture for the copy, -1 to keep the one of the object
+};
+
+// light, its id is GL_LIGHT0 plus its index
+struct SceneLightDesc
+{
+	unsigned int name;
+	float ambient[4];
+	float diffuse[4];
+	float specular[4];
+	float position[4];
+	int spot;
+	float spot_direction[3];
+	float spot_cutoff;
+	float spot_exponent;
+	int has_attenuation;
+	float attenuation[3]; // constant, linear and quadratic
+	float speed;
+	int changing_colour;
+};
+
+// camera, its id is its index plus one (the key which selects it)
+struct SceneCameraDesc
+{
+	unsigned int name;
+	int type; // CameraType
+	float position[3];
+	float rotation[3]; // pitch, yaw and roll (degrees)
+	float rotation_speed;
+	float movement_speed;
+	float zoom_speed;
+	float pitch_limits[2]; // max and min
+	float yaw_limits[2];
+	int followed_object; // index of the object followed by a tracking camera, -1 if it doesn't follow any
+	float eye_offset[3]; // translation from the followed object to the camera
+};
+
+class SceneDescription
+{
+public:
+	// constructor
+	SceneDescription();
+
+	// load the scene of the text file, from its binary file in the cache if it is up to date (otherwise the text is parsed and the binary
+	// file is saved for the next time), it returns false if the text file cannot be read
+	bool load(const char* url, const char* cache_directory = "cache/");
+
+	// parse the text file, it returns false if it cannot be read (the lines with errors are printed and skipped)
+	bool loadText(const char* url);
+
+	// map a binary file, it returns false if it doesn't exist, it is not valid or it was saved from another version of the text
+	// source_modification_time: modification time of the text file, 0 to not check it
+	bool loadBinary(const char* url, long long source_modification_time = 0);
+
+	// save the arrays in a binary file
+	bool saveBinary(const char* url, long long source_modification_time = 0) const;
+
+	// remove all the elements
+	void clear();
+
+	// add elements by code, they return the index of the element
+	int addTexture(const string& name, const string& url, bool mapped = false, bool y_inverted = false, bool repeat = false);
+	int addObject(const string& name, const string& url, SceneObjectDesc object);
+	int addMirror(const string& name, SceneMirrorDesc mirror);
+	void addReflection(const SceneReflectionDesc& reflection);
+	int addLight(const string& name, SceneLightDesc light);
+	int addCamera(const string& name, SceneCameraDesc camera);
+
+	// descriptions with the default values (nothing moving, scale 1, etc)
+	static SceneObjectDesc getDefaultObject(SceneShape shape);
+	static SceneMirrorDesc getDefaultMirror();
+	static SceneLightDesc getDefaultLight();
+	static SceneCameraDesc getDefaultCamera();
+
+	// elements of the scene
+	int getNumTextures() const;
+	const SceneTextureDesc& getTexture(int index) const;
+	int getNumObjects() const;
+	const SceneObjectDesc& getObject(int index) const;
+	int getNumMirrors() const;
+	const SceneMirrorDesc& getMirror(int index) const;
+	int getNumReflections() const;
+	const SceneReflectionDesc& getReflection(int index) const;
+	int getNumLights() const;
+	const SceneLightDesc& getLight(int index) const;
+	int getNumCameras() const;
+	const SceneCameraDesc& getCamera(int index) const;
+
+	// return a string of the table ("" if the offset is not valid)
+	const char* getString(unsigned int offset) const;
+
+	// true if it was loaded from the binary file
+	bool isMapped() const;
+
+private:
+	// arrays of the scene when it is parsed or built by code
+	vector<SceneTextureDesc> textures_;
+	vector<SceneObjectDesc> objects_;
+	vector<SceneMirrorDesc> mirrors_;
+	vector<SceneReflectionDesc> reflections_;
+	vector<SceneLightDesc> lights_;
+	vector<SceneCameraDesc> cameras_;
+	vector<char> strings_;
+
+	// binary file, when it is open the arrays are read from it
+	MappedFile mapped_file_;
+
+	// arrays used by the getters (in the vectors or in the mapped file)
+	const SceneTextureDesc* texture_table_;
+	const SceneObjectDesc* object_table_;
+	const SceneMirrorDesc* mirror_table_;
+	const SceneReflectionDesc* reflection_table_;
+	const SceneLightDesc* light_table_;
+	const SceneCameraDesc* camera_table_;
+	const char* string_table_;
+	int num_textures_, num_objects_, num_mirrors_, num_reflections_, num_lights_, num_cameras_;
+	unsigned int strings_size_;
+
+	// indices of the names, to resolve the references of the text
+	unordered_map<string, int> texture_indices_;
+	unordered_map<string, int> object_indices_;
+	unordered_map<string, int> mirror_indices_;
+
+	// add a string to the table and return its offset
+	unsigned int addString(const string& text);
+
+	// point the tables to the vectors (after adding elements)
+	void useVectors();
+
+	// copy the arrays of the mapped file to the vectors (before adding elements to a scene loaded from the binary file)
+	void makeEditable();
+
+	// parse an element of the text (the tokens of a line after the kind), it returns false if some values are not valid
+	// (the elements which cannot be added are printed and skipped)
+	bool parseElement(const string& kind, const vector<string>& tokens, const char* url, int line_number);
+
+	// read the values of a key (comma separated, at most 8), it returns false if there are not num_values
+	static bool parseValues(const string& value, float* values, int num_values);
+
+	// return the modification time of the file (0 if it doesn't exist)
+	static long long getModificationTime(const char* url);
+};
@@ -1,5 +1,5 @@
 // Shadow class
-// This class contain functions to create Planar Shadows and Shadow Volume.
+// This class contain functions to create Planar Shadows (the shadow volumes are created by the class ShadowVolume).
 // The function "generateShadowMatrix" which is to create a planar shadow has been modified so instead of taking a full floor vertices it takes
 // the PRQ coords (vertices) of a plane surface (the corners). This allow a more dynamic use of this function
 // Proportioned by Paul Robertson and modifed by Francisco Diaz (@FMGameDev)
@@ -11,14 +11,12 @@
 #include <gl/GLU.h>
 #include <vector>
 #include "Vector3.h"
+#include "MathSIMD.h"
+#include <string.h> // memcpy
 
 class Shadow
 {
 public:
 	// Function to create a Planar Shadow
 	static void generateShadowMatrix(float* shadowMatrix, float light_pos[4], GLfloat PRQ_vertices[9]);
-
-	// Create a Shadow Volume
-	static std::vector<float> buildShadowVolume(float lightPosit[4], std::vector<float> verts);
-	static void extendVertex(float newVert[3], float lightPosit[4], float x, float y, float z, float ext); // used in shadow volume function
 };
\ No newline at end of file
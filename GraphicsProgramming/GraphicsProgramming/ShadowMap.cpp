@@ -0,0 +1,217 @@
+#include "ShadowMap.h"
+#include <math.h>
+
+ShadowMap::ShadowMap(int max_size)
+	: depth_texture_(0), max_size_(max_size), size_(0)
+{
+	for (int i = 0; i < 16; i++)
+	{
+		light_matrix_[i] = (i % 5 == 0) ? 1.0f : 0.0f; // identity
+	}
+}
+
+ShadowMap::~ShadowMap()
+{
+	if (depth_texture_ != 0)
+	{
+		glDeleteTextures(1, &depth_texture_);
+	}
+}
+
+bool ShadowMap::isSupported()
+{
+	return GLExtensions::hasShadowMaps();
+}
+
+void ShadowMap::createDepthTexture(int size)
+{
+	if (depth_texture_ == 0)
+	{
+		glGenTextures(1, &depth_texture_);
+	}
+
+	// the texture is in the unit 1, so the texture bound in the unit 0 (tracked by the Texture class) is not changed
+	GLExtensions::activeTexture(GL_TEXTURE1_ARB);
+	glBindTexture(GL_TEXTURE_2D, depth_texture_);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, size, size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, nullptr);
+
+	// linear filter smooths the edges of the shadows in most graphics cards (the comparison is done in the 4 texels)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// compare the distance to the light (r coord) with the depth saved, the result (0 or 1) is given as intensity (so also as alpha)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE_ARB, GL_COMPARE_R_TO_TEXTURE_ARB);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC_ARB, GL_LEQUAL);
+	glTexParameteri(GL_TEXTURE_2D, GL_DEPTH_TEXTURE_MODE_ARB, GL_INTENSITY);
+
+	GLExtensions::activeTexture(GL_TEXTURE0_ARB);
+
+	size_ = size;
+}
+
+void ShadowMap::renderDepth(const float light_position[4], const Vector3& scene_center, float scene_radius, const function<void()>& render_casters)
+{
+	// the depth is rendered in the window, so the shadow map can't be bigger than it
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	int size = 1;
+	while (size * 2 <= max_size_ && size * 2 <= viewport[2] && size * 2 <= viewport[3])
+	{
+		size *= 2;
+	}
+	if (size != size_)
+	{
+		createDepthTexture(size);
+	}
+
+	/* Set the camera in the light looking at the scene */
+
+	Vector3 center = scene_center;
+	Vector3 light(light_position[0], light_position[1], light_position[2]);
+	Vector3 eye;
+	float radius = (scene_radius > 0.01f) ? scene_radius : 0.01f;
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	if (light_position[3] == 0.0f)
+	{
+		// directional light: orthographic projection along the direction of the light
+		eye = center + light.normalised() * (radius * 2.0f);
+		glOrtho(-radius, radius, -radius, radius, radius, radius * 3.0f);
+	}
+	else
+	{
+		// point light: perspective projection with the angle which contains the sphere of the scene
+		eye = light;
+		float distance = (light - center).length();
+		float fov = (distance > radius * 1.01f) ? 2.0f * asinf(radius / distance) * 180.0f / 3.14159265f : 170.0f;
+		float near_plane = (distance - radius > 0.1f) ? distance - radius : 0.1f;
+		gluPerspective(fov < 170.0f ? fov : 170.0f, 1.0f, near_plane, distance + radius);
+	}
+	float projection[16];
+	glGetFloatv(GL_PROJECTION_MATRIX, projection);
+
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	// the up vector can't be parallel to the view direction
+	Vector3 direction = (center - eye).normalised();
+	Vector3 up = (fabsf(direction.y) > 0.99f) ? Vector3(0.0f, 0.0f, 1.0f) : Vector3(0.0f, 1.0f, 0.0f);
+	gluLookAt(eye.x, eye.y, eye.z, center.x, center.y, center.z, up.x, up.y, up.z);
+	float view[16];
+	glGetFloatv(GL_MODELVIEW_MATRIX, view);
+
+	/* Render the depth of the casters */
+
+	glViewport(0, 0, size_, size_);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	// only the depth is needed, the offset avoids the surfaces shadowing themselves (shadow acne)
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_TEXTURE_2D);
+
+	render_casters();
+
+	glEnable(GL_TEXTURE_2D);
+	glEnable(GL_LIGHTING);
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+	// copy the depth buffer into the shadow map
+	GLExtensions::activeTexture(GL_TEXTURE1_ARB);
+	glBindTexture(GL_TEXTURE_2D, depth_texture_);
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, size_, size_);
+	GLExtensions::activeTexture(GL_TEXTURE0_ARB);
+
+	/* Go back to the camera of the scene */
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	/* light matrix = bias * projection * view, the bias moves the coords from [-1, 1] to [0, 1] */
+
+	float bias[16] = { 0.5f, 0.0f, 0.0f, 0.0f,
+		0.0f, 0.5f, 0.0f, 0.0f,
+		0.0f, 0.0f, 0.5f, 0.0f,
+		0.5f, 0.5f, 0.5f, 1.0f };
+	float bias_projection[16];
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			bias_projection[column * 4 + row] = 0.0f;
+			light_matrix_[column * 4 + row] = 0.0f;
+			for (int k = 0; k < 4; k++)
+			{
+				bias_projection[column * 4 + row] += bias[k * 4 + row] * projection[column * 4 + k];
+			}
+		}
+	}
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			for (int k = 0; k < 4; k++)
+			{
+				light_matrix_[column * 4 + row] += bias_projection[k * 4 + row] * view[column * 4 + k];
+			}
+		}
+	}
+}
+
+void ShadowMap::enable()
+{
+	GLExtensions::activeTexture(GL_TEXTURE1_ARB);
+	glBindTexture(GL_TEXTURE_2D, depth_texture_);
+	glEnable(GL_TEXTURE_2D);
+
+	// generate the coords of the shadow map from the eye coords, the planes are the rows of the light matrix
+	// openGL multiplies them by the inverse of the current modelview (the camera), so the coords are calculated from the world coords
+	GLenum coords[4] = { GL_S, GL_T, GL_R, GL_Q };
+	GLenum gen_coords[4] = { GL_TEXTURE_GEN_S, GL_TEXTURE_GEN_T, GL_TEXTURE_GEN_R, GL_TEXTURE_GEN_Q };
+	for (int i = 0; i < 4; i++)
+	{
+		float plane[4] = { light_matrix_[i], light_matrix_[4 + i], light_matrix_[8 + i], light_matrix_[12 + i] };
+		glTexGeni(coords[i], GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
+		glTexGenfv(coords[i], GL_EYE_PLANE, plane);
+		glEnable(gen_coords[i]);
+	}
+
+	// the alpha of the fragment is multiplied by the result of the comparison
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+	GLExtensions::activeTexture(GL_TEXTURE0_ARB);
+
+	// only the lit fragments are rendered
+	glEnable(GL_ALPHA_TEST);
+	glAlphaFunc(GL_GEQUAL, 0.99f);
+}
+
+void ShadowMap::disable()
+{
+	GLExtensions::activeTexture(GL_TEXTURE1_ARB);
+	glDisable(GL_TEXTURE_GEN_S);
+	glDisable(GL_TEXTURE_GEN_T);
+	glDisable(GL_TEXTURE_GEN_R);
+	glDisable(GL_TEXTURE_GEN_Q);
+	glDisable(GL_TEXTURE_2D);
+	GLExtensions::activeTexture(GL_TEXTURE0_ARB);
+
+	glDisable(GL_ALPHA_TEST);
+}
+
+int ShadowMap::getSize() const
+{
+	return size_;
+}
@@ -0,0 +1,57 @@
+// Class Shadow Map
+// It is the alternative to the planar shadows (see Shadow): the depth of the casters seen from the light is rendered once in a depth texture,
+// and then any surface can receive shadows by comparing its distance to the light with the depth saved in the texture.
+// It uses the fixed pipeline: the shadow map is in the texture unit 1 (the unit 0 is used by the textures of the meshes) with its coords generated
+// from the eye coords (texgen) and the comparison of GL_ARB_shadow, which gives 0 (in shadow) or 1 (lit) as alpha, so an alpha test keeps only the lit parts.
+// The scene is rendered twice: first without the light (shadowed colour) and then with the light only where the alpha test passes.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+// Include GLUT, openGL, input.
+#include "glut.h"
+#include <gl/GL.h>
+#include <gl/GLU.h>
+#include <functional>
+
+#include "GLExtensions.h"
+#include "Vector3.h"
+
+using namespace std;
+
+class ShadowMap
+{
+public:
+	// constructor
+	// max_size: size of the depth texture, it is rendered in the window so it is reduced to the biggest power of two which fits the window
+	ShadowMap(int max_size = 1024);
+
+	// destructor
+	~ShadowMap();
+
+	// return true if the graphics card supports the shadow maps (GLExtensions must be loaded)
+	static bool isSupported();
+
+	// render the depth of the casters seen from the light into the shadow map, the light frustum contains the sphere of the scene passed
+	// it uses the depth buffer of the window, so it must be called before rendering the scene (the depth buffer is cleared at the end)
+	void renderDepth(const float light_position[4], const Vector3& scene_center, float scene_radius, const function<void()>& render_casters);
+
+	// use the shadow map in the texture unit 1, only the lit parts are rendered until disable() is called
+	// the camera must have been set (the coords are generated from the eye coords)
+	void enable();
+	void disable();
+
+	// size of the depth texture
+	int getSize() const;
+
+private:
+	// depth texture and its size
+	GLuint depth_texture_;
+	int max_size_, size_;
+
+	// matrix which transforms the world coords into the coords of the shadow map (bias * light projection * light view)
+	float light_matrix_[16];
+
+	// create the depth texture with the size
+	void createDepthTexture(int size);
+};
@@ -0,0 +1,40 @@
+#include "ShadowMatrixCache.h"
+
+ShadowMatrixCache::ShadowMatrixCache()
+	: num_recalculated_(0)
+{
+}
+
+void ShadowMatrixCache::beginFrame()
+{
+	num_recalculated_ = 0;
+}
+
+const float* ShadowMatrixCache::getShadowMatrix(Light* light, MeshPlane* receiver)
+{
+	pair<Light*, MeshPlane*> key(light, receiver);
+	map<pair<Light*, MeshPlane*>, Entry>::iterator it = entries_.find(key);
+
+	if (it == entries_.end() || it->second.position_version != light->getPositionVersion())
+	{
+		if (it == entries_.end())
+		{
+			it = entries_.insert(make_pair(key, Entry())).first;
+		}
+
+		// generateShadowMatrix doesn't change the light position and the PQR vertices, but it doesn't take them as const
+		vector<GLfloat> light_position = light->getWorldPosition();
+		vector<float> PQR_vertices = receiver->getPQRVertices();
+		Shadow::generateShadowMatrix(it->second.matrix, light_position.data(), PQR_vertices.data());
+		it->second.position_version = light->getPositionVersion();
+
+		num_recalculated_++;
+	}
+
+	return it->second.matrix;
+}
+
+int ShadowMatrixCache::getNumRecalculated() const
+{
+	return num_recalculated_;
+}
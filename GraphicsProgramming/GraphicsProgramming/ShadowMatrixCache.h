@@ -0,0 +1,47 @@
+// Class Shadow Matrix Cache
+// It keeps the planar shadow matrix of each light on each receiver, so it is only calculated again when the light moves (the version of its position
+// changes), instead of every frame. The floor and walls which receive the shadows don't move, so the receiver only chooses the matrix.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+// Include GLUT, openGL, input.
+#include "glut.h"
+#include <gl/GL.h>
+#include <gl/GLU.h>
+#include <vector>
+#include <map>
+
+#include "Light.h"
+#include "MeshPlane.h"
+#include "Shadow.h"
+
+using namespace std;
+
+class ShadowMatrixCache
+{
+public:
+	// constructor
+	ShadowMatrixCache();
+
+	// reset the stats of the frame
+	void beginFrame();
+
+	// return the shadow matrix (column major) of the light on the receiver, it is calculated again only if the light has moved
+	const float* getShadowMatrix(Light* light, MeshPlane* receiver);
+
+	// number of matrices calculated in this frame
+	int getNumRecalculated() const;
+
+private:
+	// matrix and version of the light position it was calculated with
+	struct Entry
+	{
+		unsigned int position_version;
+		float matrix[16];
+	};
+
+	map<pair<Light*, MeshPlane*>, Entry> entries_;
+
+	int num_recalculated_;
+};
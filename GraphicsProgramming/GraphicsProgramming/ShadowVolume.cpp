@@ -0,0 +1,298 @@
+#include "ShadowVolume.h"
+#include <emmintrin.h> // SSE2
+#include <unordered_map>
+#include <string.h> // memcmp, memcpy
+#include <math.h>
+
+ShadowVolume::ShadowVolume(BaseMesh* caster)
+	: caster_(caster), num_positions_(0), num_volume_vertices_(0), adjacency_built_(false), has_volume_(false), extrusion_(0.0f)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		light_[i] = 0.0f;
+	}
+	for (int i = 0; i < 16; i++)
+	{
+		matrix_[i] = 0.0f;
+	}
+}
+
+bool ShadowVolume::buildAdjacency()
+{
+	// the geometry can be evicted by the residency manager, the adjacency is built once it is in memory
+	if (!caster_->isGeometryResident())
+	{
+		return false;
+	}
+
+	// the volume is built from the shadow proxy of the caster (its vertices are already merged and it has less triangles)
+	if (!caster_->hasShadowProxy())
+	{
+		return false;
+	}
+	const vector<float>& vertices = caster_->getShadowProxyVertices();
+	const vector<unsigned int>& indices = caster_->getShadowProxyIndices();
+
+	for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+	{
+		xs_.push_back(vertices[i]);
+		ys_.push_back(vertices[i + 1]);
+		zs_.push_back(vertices[i + 2]);
+	}
+	triangles_.assign(indices.begin(), indices.end());
+
+	// fill until a multiple of 4 for the SSE2 kernels
+	num_positions_ = (int)xs_.size();
+	int padded_size = (num_positions_ + 3) & ~3;
+	xs_.resize(padded_size, 0.0f);
+	ys_.resize(padded_size, 0.0f);
+	zs_.resize(padded_size, 0.0f);
+
+	/* Find the edges and the two triangles of each edge */
+
+	unordered_map<unsigned long long, int> edge_indices; // key: the two vertices (smallest first)
+	int num_triangles = (int)triangles_.size() / 3;
+	for (int t = 0; t < num_triangles; t++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			int v0 = triangles_[t * 3 + j];
+			int v1 = triangles_[t * 3 + (j + 1) % 3];
+			unsigned long long key = (v0 < v1) ? ((unsigned long long)v0 << 32) | (unsigned int)v1 : ((unsigned long long)v1 << 32) | (unsigned int)v0;
+
+			auto found = edge_indices.find(key);
+			if (found != edge_indices.end() && edges_[found->second].triangle1 == -1)
+			{
+				// second triangle of the edge
+				edges_[found->second].triangle1 = t;
+			}
+			else
+			{
+				// new edge (if an edge has more than two triangles the next ones are added as open edges)
+				Edge edge = { v0, v1, t, -1 };
+				edge_indices[key] = (int)edges_.size();
+				edges_.push_back(edge);
+			}
+		}
+	}
+
+	/* Reserve the buffers, the biggest volume has the two caps of all the triangles and two triangles per edge */
+
+	world_xs_.resize(padded_size);
+	world_ys_.resize(padded_size);
+	world_zs_.resize(padded_size);
+	extruded_xs_.resize(padded_size);
+	extruded_ys_.resize(padded_size);
+	extruded_zs_.resize(padded_size);
+	facing_light_.resize(num_triangles);
+	volume_.resize((size_t)(num_triangles * 2 + edges_.size() * 2) * 3 * 3);
+
+	return true;
+}
+
+bool ShadowVolume::needsUpdate(const float light_position[4], float extrusion_distance)
+{
+	if (!adjacency_built_)
+	{
+		adjacency_built_ = buildAdjacency();
+		if (!adjacency_built_)
+		{
+			return false;
+		}
+	}
+
+	float matrix[16];
+	caster_->getTransformMatrix(matrix);
+
+	// nothing has moved, the current volume is still right
+	if (has_volume_ && memcmp(matrix, matrix_, sizeof(matrix_)) == 0 && memcmp(light_position, light_, sizeof(light_)) == 0 && extrusion_distance == extrusion_)
+	{
+		return false;
+	}
+
+	memcpy(matrix_, matrix, sizeof(matrix_));
+	memcpy(light_, light_position, sizeof(light_));
+	extrusion_ = extrusion_distance;
+
+	return true;
+}
+
+void ShadowVolume::build()
+{
+	int padded_size = (int)xs_.size();
+
+	/* Vertices in world coords and extruded (SSE2) */
+
+	transformPoints(matrix_, xs_.data(), ys_.data(), zs_.data(), padded_size, world_xs_.data(), world_ys_.data(), world_zs_.data());
+	extrudePoints(light_, extrusion_, world_xs_.data(), world_ys_.data(), world_zs_.data(), padded_size, extruded_xs_.data(), extruded_ys_.data(), extruded_zs_.data());
+
+	/* Triangles facing the light */
+
+	bool is_directional = light_[3] == 0.0f;
+	int num_triangles = (int)triangles_.size() / 3;
+	for (int t = 0; t < num_triangles; t++)
+	{
+		int i0 = triangles_[t * 3], i1 = triangles_[t * 3 + 1], i2 = triangles_[t * 3 + 2];
+
+		// normal of the triangle (in world coords, the scale can be negative)
+		float e1x = world_xs_[i1] - world_xs_[i0], e1y = world_ys_[i1] - world_ys_[i0], e1z = world_zs_[i1] - world_zs_[i0];
+		float e2x = world_xs_[i2] - world_xs_[i0], e2y = world_ys_[i2] - world_ys_[i0], e2z = world_zs_[i2] - world_zs_[i0];
+		float nx = e1y * e2z - e1z * e2y, ny = e1z * e2x - e1x * e2z, nz = e1x * e2y - e1y * e2x;
+
+		float dot;
+		if (is_directional)
+			dot = nx * light_[0] + ny * light_[1] + nz * light_[2];
+		else
+			dot = nx * (light_[0] - world_xs_[i0]) + ny * (light_[1] - world_ys_[i0]) + nz * (light_[2] - world_zs_[i0]);
+		facing_light_[t] = dot > 0.0f;
+	}
+
+	/* Write the volume (all the triangles facing out of the volume) */
+
+	num_volume_vertices_ = 0;
+
+	// caps: the triangles facing the light and the same triangles extruded with the opposite order
+	for (int t = 0; t < num_triangles; t++)
+	{
+		if (!facing_light_[t])
+		{
+			continue;
+		}
+		const int* triangle = &triangles_[t * 3];
+		writeVertex(world_xs_.data(), world_ys_.data(), world_zs_.data(), triangle[0]);
+		writeVertex(world_xs_.data(), world_ys_.data(), world_zs_.data(), triangle[1]);
+		writeVertex(world_xs_.data(), world_ys_.data(), world_zs_.data(), triangle[2]);
+
+		writeVertex(extruded_xs_.data(), extruded_ys_.data(), extruded_zs_.data(), triangle[0]);
+		writeVertex(extruded_xs_.data(), extruded_ys_.data(), extruded_zs_.data(), triangle[2]);
+		writeVertex(extruded_xs_.data(), extruded_ys_.data(), extruded_zs_.data(), triangle[1]);
+	}
+
+	// sides: a quad for each silhouette edge, in the order the edge has in the triangle facing the light
+	for (const Edge& edge : edges_)
+	{
+		bool facing0 = facing_light_[edge.triangle0] != 0;
+		bool facing1 = (edge.triangle1 != -1) && facing_light_[edge.triangle1] != 0;
+		if (facing0 == facing1)
+		{
+			continue; // not a silhouette edge (an open edge is a silhouette if its triangle faces the light)
+		}
+
+		int a = facing0 ? edge.v0 : edge.v1;
+		int b = facing0 ? edge.v1 : edge.v0;
+
+		writeVertex(world_xs_.data(), world_ys_.data(), world_zs_.data(), b);
+		writeVertex(world_xs_.data(), world_ys_.data(), world_zs_.data(), a);
+		writeVertex(extruded_xs_.data(), extruded_ys_.data(), extruded_zs_.data(), a);
+
+		writeVertex(world_xs_.data(), world_ys_.data(), world_zs_.data(), b);
+		writeVertex(extruded_xs_.data(), extruded_ys_.data(), extruded_zs_.data(), a);
+		writeVertex(extruded_xs_.data(), extruded_ys_.data(), extruded_zs_.data(), b);
+	}
+
+	has_volume_ = true;
+}
+
+void ShadowVolume::writeVertex(const float* xs, const float* ys, const float* zs, int index)
+{
+	float* destination = &volume_[num_volume_vertices_ * 3];
+	destination[0] = xs[index];
+	destination[1] = ys[index];
+	destination[2] = zs[index];
+	num_volume_vertices_++;
+}
+
+void ShadowVolume::transformPoints(const float matrix[16], const float* xs, const float* ys, const float* zs, int count, float* out_xs, float* out_ys, float* out_zs)
+{
+	// out = column0 * x + column1 * y + column2 * z + column3, for 4 points at a time
+	__m128 m[12];
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			m[column * 3 + row] = _mm_set1_ps(matrix[column * 4 + row]);
+		}
+	}
+
+	for (int i = 0; i < count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(xs + i);
+		__m128 y = _mm_loadu_ps(ys + i);
+		__m128 z = _mm_loadu_ps(zs + i);
+
+		__m128 out_x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0], x), _mm_mul_ps(m[3], y)), _mm_add_ps(_mm_mul_ps(m[6], z), m[9]));
+		__m128 out_y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[1], x), _mm_mul_ps(m[4], y)), _mm_add_ps(_mm_mul_ps(m[7], z), m[10]));
+		__m128 out_z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[2], x), _mm_mul_ps(m[5], y)), _mm_add_ps(_mm_mul_ps(m[8], z), m[11]));
+
+		_mm_storeu_ps(out_xs + i, out_x);
+		_mm_storeu_ps(out_ys + i, out_y);
+		_mm_storeu_ps(out_zs + i, out_z);
+	}
+}
+
+void ShadowVolume::extrudePoints(const float light_position[4], float extrusion, const float* xs, const float* ys, const float* zs, int count, float* out_xs, float* out_ys, float* out_zs)
+{
+	__m128 distance = _mm_set1_ps(extrusion);
+
+	// directional light: all the points are moved along the same direction (away from the light)
+	if (light_position[3] == 0.0f)
+	{
+		float length = sqrtf(light_position[0] * light_position[0] + light_position[1] * light_position[1] + light_position[2] * light_position[2]);
+		float scale = (length > 0.0f) ? -extrusion / length : 0.0f;
+		__m128 dx = _mm_set1_ps(light_position[0] * scale);
+		__m128 dy = _mm_set1_ps(light_position[1] * scale);
+		__m128 dz = _mm_set1_ps(light_position[2] * scale);
+		for (int i = 0; i < count; i += 4)
+		{
+			_mm_storeu_ps(out_xs + i, _mm_add_ps(_mm_loadu_ps(xs + i), dx));
+			_mm_storeu_ps(out_ys + i, _mm_add_ps(_mm_loadu_ps(ys + i), dy));
+			_mm_storeu_ps(out_zs + i, _mm_add_ps(_mm_loadu_ps(zs + i), dz));
+		}
+		return;
+	}
+
+	// point light: out = point + normalise(point - light) * extrusion
+	__m128 light_x = _mm_set1_ps(light_position[0]);
+	__m128 light_y = _mm_set1_ps(light_position[1]);
+	__m128 light_z = _mm_set1_ps(light_position[2]);
+	__m128 min_length_squared = _mm_set1_ps(1e-12f);
+	for (int i = 0; i < count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(xs + i);
+		__m128 y = _mm_loadu_ps(ys + i);
+		__m128 z = _mm_loadu_ps(zs + i);
+
+		__m128 dx = _mm_sub_ps(x, light_x);
+		__m128 dy = _mm_sub_ps(y, light_y);
+		__m128 dz = _mm_sub_ps(z, light_z);
+
+		// extrusion / length (the points in the light are not moved)
+		__m128 length_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		__m128 valid = _mm_cmpgt_ps(length_squared, min_length_squared);
+		__m128 scale = _mm_and_ps(valid, _mm_div_ps(distance, _mm_sqrt_ps(_mm_max_ps(length_squared, min_length_squared))));
+
+		_mm_storeu_ps(out_xs + i, _mm_add_ps(x, _mm_mul_ps(dx, scale)));
+		_mm_storeu_ps(out_ys + i, _mm_add_ps(y, _mm_mul_ps(dy, scale)));
+		_mm_storeu_ps(out_zs + i, _mm_add_ps(z, _mm_mul_ps(dz, scale)));
+	}
+}
+
+const float* ShadowVolume::getVertices() const
+{
+	return volume_.data();
+}
+
+int ShadowVolume::getNumVertices() const
+{
+	return has_volume_ ? num_volume_vertices_ : 0;
+}
+
+int ShadowVolume::getNumTriangles() const
+{
+	return getNumVertices() / 3;
+}
+
+BaseMesh* ShadowVolume::getCaster() const
+{
+	return caster_;
+}
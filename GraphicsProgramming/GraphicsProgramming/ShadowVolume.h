@@ -0,0 +1,92 @@
+// Class Shadow Volume
+// It creates the stencil shadow volume of a mesh (caster) for a light.
+// The edges of the mesh and the two triangles which share each edge (adjacency) are found only once, when the volume is built the first time.
+// Then, for the position of the light, the triangles facing the light are found and only the silhouette edges (edges between a triangle facing the light
+// and one which is not) are extruded away from the light. The volume is closed with the triangles facing the light (front cap) and the same triangles
+// extruded (back cap), so it can be used with the depth fail method (the shadow is right even if the camera is inside the volume).
+// The vertices are kept as separated arrays of x, y and z (SoA) so they are moved into the world and extruded 4 at a time with SSE2.
+// The volume is only built again when the light or the mesh moves, and it is written in a buffer which is reused.
+// The volumes are built and rendered together by ShadowVolumeBatch: needsUpdate() must be called in the main thread and then build() in any thread.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+// Include GLUT, openGL, input.
+#include "glut.h"
+#include <gl/GL.h>
+#include <gl/GLU.h>
+#include <vector>
+
+#include "BaseMesh.h"
+#include "Vector3.h"
+
+using namespace std;
+
+class ShadowVolume
+{
+public:
+	// constructor
+	ShadowVolume(BaseMesh* caster);
+
+	// return true if the light or the caster have moved since the volume was built, it keeps the light and the caster matrix for build()
+	// extrusion_distance: distance the silhouette is extruded (in world units), it must reach the receivers
+	bool needsUpdate(const float light_position[4], float extrusion_distance);
+
+	// build the volume (in world coords) for the light passed to needsUpdate(), it only uses the data of this volume so it can be run in a worker
+	void build();
+
+	// vertices (x, y, z in world coords) and triangles of the current volume
+	const float* getVertices() const;
+	int getNumVertices() const;
+	int getNumTriangles() const;
+
+	// return the caster of this volume
+	BaseMesh* getCaster() const;
+
+	// SSE2 kernels, the arrays are x, y and z separated and count is a multiple of 4
+	// transform the points by the matrix (column major as openGL)
+	static void transformPoints(const float matrix[16], const float* xs, const float* ys, const float* zs, int count, float* out_xs, float* out_ys, float* out_zs);
+	// move the points 'extrusion' units away from the light (from the point light, or along the direction if w is 0)
+	static void extrudePoints(const float light_position[4], float extrusion, const float* xs, const float* ys, const float* zs, int count, float* out_xs, float* out_ys, float* out_zs);
+
+private:
+	// an edge and the two triangles which share it, v0 to v1 is the order of the vertices in the triangle 0
+	// the triangle 1 is -1 if the edge is only in one triangle (the mesh is open)
+	struct Edge
+	{
+		int v0, v1;
+		int triangle0, triangle1;
+	};
+
+	BaseMesh* caster_;
+
+	// vertices of the caster in its space (the vertices in the same position are merged), the size is a multiple of 4 for the SSE2 kernels
+	vector<float> xs_, ys_, zs_;
+	int num_positions_;
+
+	// 3 vertices of each triangle and the edges
+	vector<int> triangles_;
+	vector<Edge> edges_;
+
+	// vertices in world coords and extruded, and if each triangle is facing the light, they are reused each time the volume is built
+	vector<float> world_xs_, world_ys_, world_zs_;
+	vector<float> extruded_xs_, extruded_ys_, extruded_zs_;
+	vector<char> facing_light_;
+
+	// triangles of the volume, the buffer has the maximum size (all the caps and edges) so it is never reallocated
+	vector<float> volume_;
+	int num_volume_vertices_;
+
+	// light (world coords), caster matrix and distance of the current volume
+	bool adjacency_built_;
+	bool has_volume_;
+	float light_[4];
+	float matrix_[16];
+	float extrusion_;
+
+	// find the edges and the triangles which share them (it returns false if the caster has no triangles yet)
+	bool buildAdjacency();
+
+	// write a vertex (from the separated arrays) in the volume buffer
+	void writeVertex(const float* xs, const float* ys, const float* zs, int index);
+};
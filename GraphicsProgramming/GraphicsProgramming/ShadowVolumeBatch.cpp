@@ -0,0 +1,120 @@
+#include "ShadowVolumeBatch.h"
+#include <chrono>
+#include <string.h> // memcpy
+
+ShadowVolumeBatch::ShadowVolumeBatch(ThreadPool* thread_pool)
+	: thread_pool_(thread_pool), num_merged_vertices_(0), num_rebuilt_(0), build_ms_(0.0)
+{
+}
+
+ShadowVolumeBatch::~ShadowVolumeBatch()
+{
+	for (ShadowVolume* volume : volumes_)
+	{
+		delete volume;
+	}
+	volumes_.clear();
+}
+
+void ShadowVolumeBatch::addCaster(BaseMesh* caster)
+{
+	volumes_.push_back(new ShadowVolume(caster));
+}
+
+void ShadowVolumeBatch::update(const float light_position[4], float extrusion_distance)
+{
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+
+	/* Find the volumes to build (it reads the casters, so it is done in the main thread) */
+
+	volumes_to_build_.clear();
+	for (ShadowVolume* volume : volumes_)
+	{
+		if (volume->needsUpdate(light_position, extrusion_distance))
+		{
+			volumes_to_build_.push_back(volume);
+		}
+	}
+	num_rebuilt_ = (int)volumes_to_build_.size();
+
+	if (!volumes_to_build_.empty())
+	{
+		/* Build them in parallel, each one in its own buffer */
+
+		function<void(int, int)> build = [this](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				volumes_to_build_[i]->build();
+			}
+		};
+		if (thread_pool_ != nullptr)
+			thread_pool_->parallelFor(0, (int)volumes_to_build_.size(), build);
+		else
+			build(0, (int)volumes_to_build_.size());
+
+		/* Merge all the volumes into one array */
+
+		first_vertices_.resize(volumes_.size());
+		num_merged_vertices_ = 0;
+		for (size_t i = 0; i < volumes_.size(); i++)
+		{
+			first_vertices_[i] = num_merged_vertices_;
+			num_merged_vertices_ += volumes_[i]->getNumVertices();
+		}
+		if (merged_vertices_.size() < (size_t)num_merged_vertices_ * 3)
+		{
+			merged_vertices_.resize((size_t)num_merged_vertices_ * 3);
+		}
+
+		// each volume is copied into its own range
+		function<void(int, int)> merge = [this](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				memcpy(&merged_vertices_[first_vertices_[i] * 3], volumes_[i]->getVertices(), volumes_[i]->getNumVertices() * 3 * sizeof(float));
+			}
+		};
+		if (thread_pool_ != nullptr)
+			thread_pool_->parallelFor(0, (int)volumes_.size(), merge, 16);
+		else
+			merge(0, (int)volumes_.size());
+	}
+
+	build_ms_ = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+}
+
+void ShadowVolumeBatch::render()
+{
+	if (num_merged_vertices_ == 0)
+	{
+		return;
+	}
+
+	// the volumes are in world coords
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, merged_vertices_.data());
+	glDrawArrays(GL_TRIANGLES, 0, num_merged_vertices_);
+	BaseMesh::countDraw();
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+int ShadowVolumeBatch::getNumCasters() const
+{
+	return (int)volumes_.size();
+}
+
+int ShadowVolumeBatch::getNumTriangles() const
+{
+	return num_merged_vertices_ / 3;
+}
+
+int ShadowVolumeBatch::getNumRebuilt() const
+{
+	return num_rebuilt_;
+}
+
+double ShadowVolumeBatch::getBuildTime() const
+{
+	return build_ms_;
+}
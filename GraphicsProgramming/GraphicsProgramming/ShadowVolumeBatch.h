@@ -0,0 +1,61 @@
+// Class Shadow Volume Batch
+// It keeps the shadow volumes of all the casters of a light and builds them together:
+// first it checks in the main thread which casters (or the light) have moved, then the volumes of those casters are built in parallel
+// in the thread pool (each volume writes in its own buffer, so the threads never share memory) and finally all the volumes are merged
+// into one array of vertices, so they are sent to openGL with only one draw.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+// Include GLUT, openGL, input.
+#include "glut.h"
+#include <gl/GL.h>
+#include <gl/GLU.h>
+#include <vector>
+
+#include "ShadowVolume.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+class ShadowVolumeBatch
+{
+public:
+	// constructor
+	ShadowVolumeBatch(ThreadPool* thread_pool);
+
+	// destructor
+	~ShadowVolumeBatch();
+
+	// add a mesh which casts shadows
+	void addCaster(BaseMesh* caster);
+
+	// build the volumes of the casters which have moved (all of them if the light has moved) and merge them
+	// extrusion_distance: distance the silhouettes are extruded (in world units), it must reach the receivers
+	void update(const float light_position[4], float extrusion_distance);
+
+	// render all the volumes with one draw
+	void render();
+
+	// stats of the last update
+	int getNumCasters() const;
+	int getNumTriangles() const;
+	int getNumRebuilt() const;
+	double getBuildTime() const; // ms
+
+private:
+	ThreadPool* thread_pool_;
+
+	// volume of each caster and the ones to build in this update
+	vector<ShadowVolume*> volumes_;
+	vector<ShadowVolume*> volumes_to_build_;
+
+	// vertices of all the volumes together and the first vertex of each volume in it
+	vector<float> merged_vertices_;
+	vector<int> first_vertices_;
+	int num_merged_vertices_;
+
+	// stats
+	int num_rebuilt_;
+	double build_ms_;
+};
@@ -6,13 +6,14 @@
 
 #pragma once
 #include "Input.h"
+#include "ThreadPool.h"
 
 // All the components that are shared between the game scenes
 // They must been initialise in the main.cpp
 struct SharedContext
 {
 	// constructor
-	SharedContext() : input(nullptr), wireframe_mode(nullptr), game_focused(false), window_width(nullptr), window_height(nullptr){}
+	SharedContext() : input(nullptr), wireframe_mode(nullptr), game_focused(nullptr), window_width(nullptr), window_height(nullptr), thread_pool(nullptr), headless(false){}
 
 	// components
 	Input* input; // input component
@@ -21,5 +22,7 @@ struct SharedContext
 	bool* first_mouse_click; // to control the camera doesn't rotate when the user click for first time after recuperating the focus the game
 	int* window_width; // window x value
 	int* window_height; // window y value
+	ThreadPool* thread_pool; // worker threads for the heavy CPU work (ex: preprocessing the textures)
+	bool headless; // the scene is rendered in an offscreen context (there is no window: no input, text, cursor or swap of buffers)
 
 };
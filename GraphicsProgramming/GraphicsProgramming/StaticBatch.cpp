@@ -0,0 +1,223 @@
+#include "StaticBatch.h"
+
+StaticBatch::StaticBatch(SharedContext* shared_context)
+	: shared_context_(shared_context), num_culled_(0)
+{
+}
+
+bool StaticBatch::addMesh(BaseMesh* mesh)
+{
+	vector<StaticPart> parts;
+	if (!mesh->isStatic() || !mesh->getStaticParts(Matrix4::identity(), parts))
+	{
+		return false;
+	}
+
+	// all the ranges of the mesh are culled with the sphere of the whole mesh
+	Vector3 center;
+	float radius = -1.0f; // negative: no bounds, it is never culled
+	if (!mesh->getBoundingSphere(center, radius))
+	{
+		radius = -1.0f;
+	}
+
+	// the mesh is known by the batch even if it has no faces
+	vector<pair<int, int>>& ranges = mesh_ranges_[mesh];
+	for (const StaticPart& part : parts)
+	{
+		int group_index = getGroup(part);
+		StaticGroup& group = groups_[group_index];
+
+		// the indices of the part start at the first vertex it adds to the group
+		unsigned int first_vertex = (unsigned int)group.vertices.size() / 3;
+		StaticRange range = { mesh, (unsigned int)group.indices.size(), (unsigned int)part.indices.size(), center, radius, true };
+		group.vertices.insert(group.vertices.end(), part.vertices.begin(), part.vertices.end());
+		group.normals.insert(group.normals.end(), part.normals.begin(), part.normals.end());
+		group.texture_coords.insert(group.texture_coords.end(), part.texture_coords.begin(), part.texture_coords.end());
+		for (unsigned int index : part.indices)
+		{
+			group.indices.push_back(first_vertex + index);
+		}
+
+		ranges.push_back(make_pair(group_index, (int)group.ranges.size()));
+		group.ranges.push_back(range);
+	}
+	meshes_.push_back(mesh);
+	return true;
+}
+
+int StaticBatch::getGroup(const StaticPart& part)
+{
+	for (size_t i = 0; i < groups_.size(); i++)
+	{
+		const StaticGroup& group = groups_[i];
+		bool same_colour = true;
+		for (int c = 0; c < 4; c++)
+		{
+			same_colour = same_colour && group.colour.rgba[c] == part.colour.rgba[c];
+		}
+		if (group.texture == part.texture && group.uses_atlas == part.uses_atlas && same_colour)
+		{
+			return (int)i;
+		}
+	}
+
+	StaticGroup group;
+	group.texture = part.texture;
+	group.uses_atlas = part.uses_atlas;
+	group.colour = part.colour;
+	groups_.push_back(group);
+	return (int)groups_.size() - 1;
+}
+
+void StaticBatch::clear()
+{
+	groups_.clear();
+	meshes_.clear();
+	mesh_ranges_.clear();
+	num_culled_ = 0;
+}
+
+void StaticBatch::cull(const Frustum& frustum)
+{
+	// the meshes are counted once, not once for each of their ranges
+	unordered_map<const BaseMesh*, bool> culled_meshes;
+	for (StaticGroup& group : groups_)
+	{
+		for (StaticRange& range : group.ranges)
+		{
+			range.visible = range.radius < 0.0f || frustum.isSphereVisible(range.center, range.radius);
+			if (!range.visible)
+			{
+				culled_meshes[range.mesh] = true;
+			}
+		}
+	}
+	num_culled_ = (int)culled_meshes.size();
+}
+
+void StaticBatch::render()
+{
+	for (const StaticGroup& group : groups_)
+	{
+		beginGroup(group);
+
+		// the visible ranges next to each other are drawn together
+		unsigned int first_index = 0, num_indices = 0;
+		for (const StaticRange& range : group.ranges)
+		{
+			if (!range.visible)
+			{
+				continue;
+			}
+			if (num_indices > 0 && first_index + num_indices == range.first_index)
+			{
+				num_indices += range.num_indices;
+				continue;
+			}
+			drawIndices(group, first_index, num_indices);
+			first_index = range.first_index;
+			num_indices = range.num_indices;
+		}
+		drawIndices(group, first_index, num_indices);
+
+		endGroup(group);
+	}
+}
+
+void StaticBatch::renderMesh(const BaseMesh* mesh)
+{
+	auto ranges = mesh_ranges_.find(mesh);
+	if (ranges == mesh_ranges_.end())
+	{
+		return;
+	}
+
+	for (const pair<int, int>& group_range : ranges->second)
+	{
+		const StaticGroup& group = groups_[group_range.first];
+		const StaticRange& range = group.ranges[group_range.second];
+		beginGroup(group);
+		drawIndices(group, range.first_index, range.num_indices);
+		endGroup(group);
+	}
+}
+
+void StaticBatch::beginGroup(const StaticGroup& group)
+{
+	// same state as the render() of the meshes
+	if (*shared_context_->wireframe_mode)
+		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	else
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	glColor4fv(group.colour.rgba);
+	if (group.texture != nullptr)
+	{
+		if (group.uses_atlas)
+			group.texture->useAtlas();
+		else
+			group.texture->use();
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(2, GL_FLOAT, 0, group.texture_coords.data());
+	}
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, group.vertices.data());
+	glNormalPointer(GL_FLOAT, 0, group.normals.data());
+}
+
+void StaticBatch::endGroup(const StaticGroup& group)
+{
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	if (group.texture != nullptr)
+	{
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		if (group.uses_atlas)
+			group.texture->stopUsingAtlas();
+		else
+			group.texture->stopUsing();
+	}
+	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+void StaticBatch::drawIndices(const StaticGroup& group, unsigned int first_index, unsigned int num_indices)
+{
+	if (num_indices == 0)
+	{
+		return;
+	}
+	glDrawElements(GL_TRIANGLES, (GLsizei)num_indices, GL_UNSIGNED_INT, group.indices.data() + first_index);
+	BaseMesh::countDraw();
+}
+
+const vector<BaseMesh*>& StaticBatch::getMeshes() const
+{
+	return meshes_;
+}
+
+bool StaticBatch::contains(const BaseMesh* mesh) const
+{
+	return mesh_ranges_.find(mesh) != mesh_ranges_.end();
+}
+
+int StaticBatch::getNumGroups() const
+{
+	return (int)groups_.size();
+}
+
+int StaticBatch::getNumCulled() const
+{
+	return num_culled_;
+}
+
+size_t StaticBatch::getBytes() const
+{
+	size_t bytes = 0;
+	for (const StaticGroup& group : groups_)
+	{
+		bytes += (group.vertices.size() + group.normals.size() + group.texture_coords.size()) * sizeof(float) + group.indices.size() * sizeof(unsigned int);
+	}
+	return bytes;
+}
@@ -0,0 +1,94 @@
+// Class Static Batch
+// The meshes which never move (the floor and walls, the props which don't move or rotate) are transformed to world space once and merged in
+// a few big arrays, one for each texture and colour, so they are drawn without their own matrix and the state of each group is set once.
+// Each mesh keeps its range of indices in the arrays of its group with its bounding sphere: cull() skips the ranges out of the frustum (the
+// visible ranges next to each other are drawn with one draw call) and a mesh can still be drawn by itself (ex: a floor/wall with the stencil of
+// its planar shadows). cull() doesn't use openGL, so it can be a task.
+// The meshes must be added once their textures have been packed in the atlas, the texture coords are copied as they are.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include "BaseMesh.h"
+#include "Frustum.h"
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+class StaticBatch
+{
+public:
+	// constructor
+	StaticBatch(SharedContext* shared_context);
+
+	// merge the mesh in world space, it returns false (and the mesh is not added) if it moves or some part cannot be merged
+	bool addMesh(BaseMesh* mesh);
+
+	// remove all the meshes and the arrays
+	void clear();
+
+	// choose the ranges inside the frustum
+	void cull(const Frustum& frustum);
+
+	// draw the visible ranges of all the groups
+	void render();
+
+	// draw the ranges of a mesh added (the culling is not checked)
+	void renderMesh(const BaseMesh* mesh);
+
+	// meshes added, to render them by themselves
+	const vector<BaseMesh*>& getMeshes() const;
+	bool contains(const BaseMesh* mesh) const;
+
+	// stats
+	int getNumGroups() const;
+	int getNumCulled() const; // meshes out of the frustum in the last cull()
+	size_t getBytes() const; // memory of the merged arrays
+
+private:
+	// indices of a mesh in the arrays of its group
+	struct StaticRange
+	{
+		const BaseMesh* mesh;
+		unsigned int first_index;
+		unsigned int num_indices;
+		Vector3 center; // bounding sphere in world space
+		float radius;
+		bool visible;
+	};
+
+	// arrays of the parts with the same texture and colour
+	struct StaticGroup
+	{
+		Texture* texture;
+		bool uses_atlas;
+		Colour4 colour;
+		vector<float> vertices;
+		vector<float> normals;
+		vector<float> texture_coords;
+		vector<unsigned int> indices;
+		vector<StaticRange> ranges;
+	};
+
+	// shared context, for the wireframe mode
+	SharedContext* shared_context_;
+
+	vector<StaticGroup> groups_;
+	vector<BaseMesh*> meshes_;
+
+	// group and range of each part of the meshes
+	unordered_map<const BaseMesh*, vector<pair<int, int>>> mesh_ranges_;
+
+	int num_culled_;
+
+	// return the group of the texture and colour of the part (it is created if there isn't)
+	int getGroup(const StaticPart& part);
+
+	// set the arrays, texture and colour of a group
+	void beginGroup(const StaticGroup& group);
+	void endGroup(const StaticGroup& group);
+
+	// draw the indices of a group
+	void drawIndices(const StaticGroup& group, unsigned int first_index, unsigned int num_indices);
+};
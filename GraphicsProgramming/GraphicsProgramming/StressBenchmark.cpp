@@ -0,0 +1,389 @@
+#include "StressBenchmark.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h> // rand, atoi, strtoul
+#include <string.h> // strcmp, strncmp
+#include <math.h>
+#include <algorithm> // max, min
+
+StressBenchmark::StressBenchmark(SharedContext* shared_context)
+	: shared_context_(shared_context), num_warm_up_frames_(30), dt_(1.0f / 60.0f)
+{
+}
+
+StressOptions StressBenchmark::parseArguments(int argc, char** argv)
+{
+	StressOptions options;
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		const char* value = argv[i + 1];
+		if (strcmp(argv[i], "--stress-sweep") == 0 && strncmp(value, "--", 2) != 0)
+		{
+			// comma separated list of numbers of objects
+			options.object_counts.clear();
+			for (const char* number = value; *number != '\0'; )
+			{
+				int num_objects = atoi(number);
+				if (num_objects > 0)
+				{
+					options.object_counts.push_back(num_objects);
+				}
+				const char* comma = strchr(number, ',');
+				number = (comma != nullptr) ? comma + 1 : number + strlen(number);
+			}
+		}
+		else if (strcmp(argv[i], "--lights") == 0)
+			options.num_lights = atoi(value);
+		else if (strcmp(argv[i], "--mirrors") == 0)
+			options.num_mirrors = atoi(value);
+		else if (strcmp(argv[i], "--seed") == 0)
+			options.seed = (unsigned int)strtoul(value, nullptr, 10);
+		else if (strcmp(argv[i], "--frames") == 0)
+			options.num_frames = atoi(value);
+		else if (strcmp(argv[i], "--csv") == 0)
+			options.csv_url = value;
+	}
+
+	// openGL has 8 lights
+	if (options.num_lights > 8)
+	{
+		printf("StressBenchmark: %i lights asked, openGL only has 8\n", options.num_lights);
+		options.num_lights = 8;
+	}
+	options.num_lights = max(options.num_lights, 0);
+	options.num_mirrors = max(options.num_mirrors, 0);
+	options.num_frames = max(options.num_frames, 1);
+	return options;
+}
+
+void StressBenchmark::generateScene(SceneDescription& scene_description, int num_objects, int num_lights, int num_mirrors, unsigned int seed)
+{
+	auto random = [](float min, float max) { return min + (max - min) * (rand() / (float)RAND_MAX); };
+	srand(seed);
+	scene_description.clear();
+
+	// the floor grows with the objects (about 1.5 x 1.5 units for each one), it is at least as big as the main scene
+	int size = max(24, (int)ceilf(sqrtf((float)num_objects) * 1.5f));
+	float side = (float)size;
+
+	/* Textures (the ones of the main scene) */
+
+	int earth = scene_description.addTexture("earth", "gfx/earth.png");
+	int donut = scene_description.addTexture("donut", "gfx/donut.png");
+	int dice_map = scene_description.addTexture("dice_map", "gfx/dicemap.png", true);
+	int wood = scene_description.addTexture("dark_gray_wood", "gfx/dark_gray_wood.jpg", false, false, true);
+	int metal = scene_description.addTexture("metal", "gfx/metal.jpg", false, false, true);
+	int spaceship = scene_description.addTexture("spaceship", "gfx/spaceship.jpg", false, true);
+	int spaceship2 = scene_description.addTexture("spaceship2", "gfx/spaceship2_texture.png");
+
+	/* Floor and walls */
+
+	SceneObjectDesc floor = SceneDescription::getDefaultObject(SceneShape::kPlane);
+	floor.params[0] = (float)(int)Facing::kUp;
+	floor.params[1] = side;
+	floor.params[2] = side;
+	floor.texture = wood;
+	scene_description.addObject("floor", "", floor);
+
+	SceneObjectDesc wall_back = SceneDescription::getDefaultObject(SceneShape::kPlane);
+	wall_back.params[0] = (float)(int)Facing::kBackward;
+	wall_back.params[1] = 10.0f;
+	wall_back.params[2] = side;
+	wall_back.texture = metal;
+	wall_back.translation[2] = -side;
+	scene_description.addObject("wall_back", "", wall_back);
+
+	SceneObjectDesc wall_right = SceneDescription::getDefaultObject(SceneShape::kPlane);
+	wall_right.params[0] = (float)(int)Facing::kLeft;
+	wall_right.params[1] = 10.0f;
+	wall_right.params[2] = side;
+	wall_right.texture = metal;
+	wall_right.translation[0] = side;
+	wall_right.translation[1] = 10.0f;
+	scene_description.addObject("wall_right", "", wall_right);
+
+	/* Objects: a mix of the meshes of the main scene with less segments, and a few models (each one reads its .obj file) */
+
+	vector<int> objects;
+	for (int i = 0; i < num_objects; i++)
+	{
+		SceneObjectDesc object;
+		string name, url;
+		float scale = 1.0f;
+		int kind = rand() % 20;
+		if (kind < 6)
+		{
+			// the same sphere with different scales, so all of them can be drawn in one group
+			object = SceneDescription::getDefaultObject(SceneShape::kSphere);
+			object.params[1] = object.params[2] = 24.0f;
+			object.texture = earth;
+			scale = random(0.3f, 0.8f);
+			name = "sphere_";
+		}
+		else if (kind < 10)
+		{
+			// cones, pyramids, cylinders and prisms
+			const float sides[] = { 3.0f, 5.0f, 6.0f, 8.0f, 24.0f };
+			object = SceneDescription::getDefaultObject(SceneShape::kCone);
+			object.params[0] = 2.0f;
+			object.params[1] = (rand() % 2 == 0) ? 0.0f : 2.0f;
+			object.params[2] = 4.0f;
+			object.params[3] = 24.0f;
+			object.params[4] = sides[rand() % 5];
+			object.texture = earth;
+			scale = random(0.15f, 0.3f);
+			name = "cone_";
+		}
+		else if (kind < 14)
+		{
+			object = SceneDescription::getDefaultObject(SceneShape::kCube);
+			object.params[0] = 4.0f;
+			object.params[1] = 1.0f;
+			object.texture = dice_map;
+			scale = random(0.15f, 0.3f);
+			name = "cube_";
+		}
+		else if (kind < 19)
+		{
+			object = SceneDescription::getDefaultObject(SceneShape::kTorus);
+			object.params[0] = 1.0f;
+			object.params[1] = 2.0f;
+			object.params[2] = 16.0f;
+			object.params[3] = 32.0f;
+			object.texture = donut;
+			scale = random(0.15f, 0.3f);
+			name = "torus_";
+		}
+		else
+		{
+			object = SceneDescription::getDefaultObject(SceneShape::kModel);
+			bool small_ship = rand() % 2 == 0;
+			url = small_ship ? "models/spaceship2.obj" : "models/spaceship.obj";
+			object.texture = small_ship ? spaceship2 : spaceship;
+			scale = small_ship ? 0.1f : 0.9f;
+			name = "model_";
+		}
+		object.scale[0] = object.scale[1] = object.scale[2] = scale;
+		object.translation[0] = random(1.0f, side - 1.0f);
+		object.translation[1] = random(0.5f, 3.0f);
+		object.translation[2] = random(-side + 1.0f, -1.0f);
+		object.rotation[1] = random(0.0f, 360.0f);
+
+		// half of them rotate around y, a third move along x or z (between limits inside the floor) and the rest are still
+		int movement = rand() % 6;
+		if (movement < 3)
+		{
+			object.rotating[1] = 1;
+			object.speed = random(10.0f, 60.0f) * (rand() % 2 == 0 ? 1.0f : -1.0f);
+		}
+		else if (movement < 5)
+		{
+			int axis = (rand() % 2 == 0) ? 0 : 2;
+			float low = (axis == 0) ? 1.0f : -side + 1.0f;
+			float high = (axis == 0) ? side - 1.0f : -1.0f;
+			float length = random(2.0f, 8.0f);
+			float start = max(low, object.translation[axis] - length * 0.5f);
+			float end = min(high, start + length);
+			for (int a = 0; a < 3; a++)
+			{
+				object.limits_max[a] = object.limits_min[a] = object.translation[a];
+			}
+			object.limits_min[axis] = start;
+			object.limits_max[axis] = end;
+			object.translation[axis] = random(start, end);
+			object.moving[axis] = 1;
+			object.direction[axis] = (rand() % 2 == 0) ? 1.0f : -1.0f;
+			object.speed = random(0.5f, 3.0f);
+		}
+		objects.push_back(scene_description.addObject(name + to_string(i), url, object));
+	}
+
+	/* Cameras */
+
+	// looking at the floor from the front, it can fly around
+	SceneCameraDesc floating = SceneDescription::getDefaultCamera();
+	floating.type = (int)CameraType::kFloating;
+	floating.position[0] = side * 0.5f;
+	floating.position[1] = 3.0f + side * 0.3f;
+	floating.position[2] = 4.0f;
+	floating.rotation[0] = -30.0f;
+	floating.rotation_speed = 80.0f;
+	floating.movement_speed = 80.0f;
+	floating.zoom_speed = 400.0f;
+	floating.pitch_limits[0] = 89.0f;
+	floating.pitch_limits[1] = -89.0f;
+	scene_description.addCamera("floating", floating);
+
+	// looking down from above the center of the floor (the far plane is at 100)
+	SceneCameraDesc top = SceneDescription::getDefaultCamera();
+	top.type = (int)CameraType::kFixedPoint;
+	top.position[0] = side * 0.5f;
+	top.position[1] = min(side * 1.4f, 90.0f);
+	top.position[2] = -side * 0.5f;
+	top.rotation[0] = -90.0f;
+	scene_description.addCamera("top", top);
+
+	/* Lights: white-ish points above the floor, only the first one adds ambient light */
+
+	for (int i = 0; i < num_lights; i++)
+	{
+		SceneLightDesc light = SceneDescription::getDefaultLight();
+		float ambient = (i == 0) ? 0.2f : 0.0f;
+		light.ambient[0] = light.ambient[1] = light.ambient[2] = ambient;
+		for (int c = 0; c < 3; c++)
+		{
+			light.diffuse[c] = random(0.6f, 1.0f);
+		}
+		light.position[0] = random(2.0f, side - 2.0f);
+		light.position[1] = random(6.0f, 9.0f);
+		light.position[2] = random(-side + 2.0f, -2.0f);
+		scene_description.addLight("light_" + to_string(i), light);
+	}
+
+	/* Mirrors: discs on the front edge looking into the scene, each one reflects some random objects with its matrix */
+
+	for (int i = 0; i < num_mirrors; i++)
+	{
+		SceneMirrorDesc mirror = SceneDescription::getDefaultMirror();
+		mirror.disc = 1;
+		mirror.facing = (int)Facing::kForward;
+		mirror.size[0] = 2.0f;
+		mirror.size[1] = 64.0f;
+		mirror.translation[0] = side * (i + 1) / (num_mirrors + 1);
+		mirror.translation[1] = 3.0f;
+		mirror.colour[0] = mirror.colour[1] = 0.8f;
+		mirror.colour[3] = 0.3f;
+		mirror.texture_scale = 0.25f;
+		mirror.update_interval = 2;
+		int mirror_index = scene_description.addMirror("mirror_" + to_string(i), mirror);
+
+		int num_reflections = min(num_objects, 16);
+		for (int r = 0; r < num_reflections; r++)
+		{
+			SceneReflectionDesc reflection = { mirror_index, objects[rand() % num_objects], 0, 0, -1 };
+			scene_description.addReflection(reflection);
+		}
+	}
+}
+
+void StressBenchmark::run(const StressOptions& options)
+{
+	int width = *shared_context_->window_width, height = *shared_context_->window_height;
+	printf("\nStress sweep: %i lights, %i mirrors, seed %u, %i frames per scene (%ix%i) with %i thread(s)\n", options.num_lights, options.num_mirrors,
+		options.seed, options.num_frames, width, height, shared_context_->thread_pool != nullptr ? shared_context_->thread_pool->getNumThreads() : 1);
+	printf("%-8s %8s %9s %9s %9s %9s %9s %9s %9s %9s %7s %7s  %s\n", "Objects", "Load s", "Frame ms", "Worst ms", "Update", "Culling",
+		"Reflect", "Meshes", "Mirrors", "Other", "Draws", "Binds", "Bottleneck");
+
+	vector<StressResult> results;
+	for (int num_objects : options.object_counts)
+	{
+		StressResult result = runScene(num_objects, options);
+		const SceneFrameStats& parts = result.parts;
+		printf("%-8i %8.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %7i %7i  %s\n", num_objects, result.load_ms / 1000.0, result.frame_ms,
+			result.worst_frame_ms, parts.update_ms, parts.culling_ms, parts.reflections_ms, parts.meshes_ms, parts.mirrors_ms, result.other_ms,
+			parts.num_draws, parts.num_texture_binds, getBottleneck(result));
+		results.push_back(result);
+	}
+	printf("(ms per frame: the whole frame and the CPU time of each part, 'Meshes' includes the shadows and 'Other' is the text, the swap\n"
+		" and the wait for the graphics card)\n");
+
+	/* CSV with the curves */
+
+	FILE* file = nullptr;
+#ifdef _WIN32
+	fopen_s(&file, options.csv_url.c_str(), "w");
+#else
+	file = fopen(options.csv_url.c_str(), "w");
+#endif
+	if (file == nullptr)
+	{
+		printf("StressBenchmark: %s cannot be written\n\n", options.csv_url.c_str());
+		return;
+	}
+	fprintf(file, "objects,lights,mirrors,load_ms,frame_ms,worst_frame_ms,update_ms,culling_ms,reflections_ms,meshes_ms,mirrors_ms,other_ms,draws,binds\n");
+	for (const StressResult& result : results)
+	{
+		const SceneFrameStats& parts = result.parts;
+		fprintf(file, "%i,%i,%i,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%i,%i\n", result.num_objects, options.num_lights, options.num_mirrors,
+			result.load_ms, result.frame_ms, result.worst_frame_ms, parts.update_ms, parts.culling_ms, parts.reflections_ms, parts.meshes_ms,
+			parts.mirrors_ms, result.other_ms, parts.num_draws, parts.num_texture_binds);
+	}
+	fclose(file);
+	printf("Saved in %s\n\n", options.csv_url.c_str());
+}
+
+StressBenchmark::StressResult StressBenchmark::runScene(int num_objects, const StressOptions& options)
+{
+	using Clock = chrono::high_resolution_clock;
+
+	StressResult result = {};
+	result.num_objects = num_objects;
+
+	SceneDescription scene_description;
+	generateScene(scene_description, num_objects, options.num_lights, options.num_mirrors, options.seed);
+
+	Clock::time_point load_start = Clock::now();
+	Scene* scene = new Scene(shared_context_, scene_description);
+	scene->resize(*shared_context_->window_width, *shared_context_->window_height);
+	glFinish();
+	result.load_ms = chrono::duration<double, milli>(Clock::now() - load_start).count();
+
+	// the first frames load the mip levels, build the shadow proxies, etc
+	for (int frame = 0; frame < num_warm_up_frames_; frame++)
+	{
+		scene->update(dt_);
+		scene->render();
+	}
+	glFinish();
+
+	for (int frame = 0; frame < options.num_frames; frame++)
+	{
+		Clock::time_point frame_start = Clock::now();
+		scene->update(dt_);
+		scene->render();
+		glFinish();
+		double frame_ms = chrono::duration<double, milli>(Clock::now() - frame_start).count();
+
+		const SceneFrameStats& parts = scene->getFrameStats();
+		result.frame_ms += frame_ms;
+		result.worst_frame_ms = max(result.worst_frame_ms, frame_ms);
+		result.parts.update_ms += parts.update_ms;
+		result.parts.culling_ms += parts.culling_ms;
+		result.parts.reflections_ms += parts.reflections_ms;
+		result.parts.meshes_ms += parts.meshes_ms;
+		result.parts.mirrors_ms += parts.mirrors_ms;
+		result.parts.num_draws += parts.num_draws;
+		result.parts.num_texture_binds += parts.num_texture_binds;
+	}
+	delete scene;
+
+	// averages
+	int num_frames = options.num_frames;
+	result.frame_ms /= num_frames;
+	result.parts.update_ms /= num_frames;
+	result.parts.culling_ms /= num_frames;
+	result.parts.reflections_ms /= num_frames;
+	result.parts.meshes_ms /= num_frames;
+	result.parts.mirrors_ms /= num_frames;
+	result.parts.num_draws /= num_frames;
+	result.parts.num_texture_binds /= num_frames;
+	result.other_ms = max(0.0, result.frame_ms - result.parts.update_ms - result.parts.culling_ms - result.parts.reflections_ms -
+		result.parts.meshes_ms - result.parts.mirrors_ms);
+	return result;
+}
+
+const char* StressBenchmark::getBottleneck(const StressResult& result)
+{
+	const SceneFrameStats& parts = result.parts;
+	pair<double, const char*> times[] = { { parts.update_ms, "update" }, { parts.culling_ms, "culling" },
+		{ parts.reflections_ms, "reflections" }, { parts.meshes_ms, "meshes and shadows" }, { parts.mirrors_ms, "mirrors" },
+		{ result.other_ms, "graphics card" } };
+
+	const pair<double, const char*>* slowest = &times[0];
+	for (const pair<double, const char*>& time : times)
+	{
+		if (time.first > slowest->first)
+			slowest = &time;
+	}
+	return slowest->second;
+}
@@ -0,0 +1,74 @@
+// Class Stress Benchmark
+// It generates scenes of any size from a seed (spheres, cones/prisms, cubes, tori and a few models with random transforms and movement, M lights
+// and K mirrors reflecting some of the objects) and measures how the frame time grows with the number of objects.
+// For each number of objects it renders some frames to warm up (textures, shadow proxies, residency) and then measures the next ones: the
+// time of the frame (glFinish, so the graphics card is included) and the CPU time of each part of the scene (update, culling, reflection
+// textures, meshes with their shadows, mirrors), the draws and the texture binds. The part which grows the most is the bottleneck.
+// The results are printed and saved in a CSV file (one row per number of objects) to plot the curves. The vertical sync of the driver
+// should be disabled, otherwise the frames are never shorter than the refresh of the screen.
+// It is run from the command line with: GraphicsProgramming.exe --stress-sweep [100,250,500,...] [--lights M] [--mirrors K] [--seed S]
+// [--frames F] [--csv file], and a generated scene can be played with: GraphicsProgramming.exe --stress N [--lights M] [--mirrors K] [--seed S]
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include "Scene.h"
+#include "SceneDescription.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// options of the generated scenes and of the sweep
+struct StressOptions
+{
+	vector<int> object_counts = { 100, 250, 500, 1000, 2000, 4000 }; // number of objects of each scene of the sweep
+	int num_lights = 3; // at most 8 (the lights of openGL)
+	int num_mirrors = 2;
+	unsigned int seed = 1; // the same seed gives the same scenes
+	int num_frames = 120; // frames measured in each scene (after the warm up)
+	string csv_url = "stress_sweep.csv";
+};
+
+class StressBenchmark
+{
+public:
+	// constructor
+	StressBenchmark(SharedContext* shared_context);
+
+	// read the options from the command line (the values not passed keep their default)
+	static StressOptions parseArguments(int argc, char** argv);
+
+	// fill the description with a random scene: the floor and walls grow with the number of objects, so the density is the same
+	static void generateScene(SceneDescription& scene_description, int num_objects, int num_lights, int num_mirrors, unsigned int seed);
+
+	// run a scene for each number of objects, print the results and save them in the CSV file
+	void run(const StressOptions& options);
+
+private:
+	// times (ms per frame, average of the frames measured) and calls of a scene
+	struct StressResult
+	{
+		int num_objects;
+		double load_ms; // creation of the scene
+		double frame_ms; // whole frame, the graphics card included
+		double worst_frame_ms;
+		SceneFrameStats parts; // average of each part
+		double other_ms; // rest of the frame (text, swap and waiting for the graphics card)
+	};
+
+	// context of the window, the scenes are rendered in it
+	SharedContext* shared_context_;
+
+	// frames rendered before measuring
+	int num_warm_up_frames_;
+
+	// time step of each frame (s), fixed so all the scenes simulate the same
+	float dt_;
+
+	// create the scene of num_objects objects and measure its frames
+	StressResult runScene(int num_objects, const StressOptions& options);
+
+	// name of the part of the frame which takes the longest
+	static const char* getBottleneck(const StressResult& result);
+};
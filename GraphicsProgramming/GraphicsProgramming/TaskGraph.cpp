@@ -0,0 +1,172 @@
+#include "TaskGraph.h"
+#include <stdio.h>
+
+TaskGraph::TaskGraph(ThreadPool* thread_pool)
+	: thread_pool_(thread_pool), first_pending_task_(0), num_finished_tasks_(0), run_time_ms_(0.0)
+{
+	clear();
+}
+
+void TaskGraph::clear()
+{
+	tasks_.clear();
+	first_pending_task_ = 0;
+	run_time_ms_ = 0.0;
+	frame_start_ = Clock::now();
+}
+
+int TaskGraph::addTask(const string& name, const function<void()>& work, const vector<int>& dependencies)
+{
+	int id = (int)tasks_.size();
+
+	Task task;
+	task.name = name;
+	task.work = work;
+	task.thread_index = -1;
+	task.start_ms = 0.0;
+	task.end_ms = 0.0;
+
+	// only the tasks added before can be dependencies, so there can't be cycles
+	for (int dependency : dependencies)
+	{
+		if (dependency < 0 || dependency >= id)
+		{
+			printf("TaskGraph: task '%s' depends on an unknown task (%i), the dependency is ignored\n", name.c_str(), dependency);
+			continue;
+		}
+		task.dependencies.push_back(dependency);
+		tasks_[dependency].dependents.push_back(id);
+	}
+
+	tasks_.push_back(task);
+	return id;
+}
+
+void TaskGraph::run()
+{
+	int num_tasks = (int)tasks_.size() - first_pending_task_;
+	if (num_tasks <= 0)
+	{
+		return;
+	}
+	Clock::time_point run_start = Clock::now();
+
+	// without pool the tasks are run in order, the dependencies are always before
+	if (thread_pool_ == nullptr)
+	{
+		for (int id = first_pending_task_; id < (int)tasks_.size(); id++)
+		{
+			Task& task = tasks_[id];
+			task.thread_index = 0;
+			task.start_ms = chrono::duration<double, milli>(Clock::now() - frame_start_).count();
+			task.work();
+			task.end_ms = chrono::duration<double, milli>(Clock::now() - frame_start_).count();
+		}
+	}
+	else
+	{
+		// count the dependencies of each task which are not done yet (the ones of a previous run() are)
+		remaining_dependencies_.reset(new atomic<int>[num_tasks]);
+		for (int i = 0; i < num_tasks; i++)
+		{
+			int num_remaining = 0;
+			for (int dependency : tasks_[first_pending_task_ + i].dependencies)
+			{
+				if (dependency >= first_pending_task_)
+				{
+					num_remaining++;
+				}
+			}
+			remaining_dependencies_[i] = num_remaining;
+		}
+		num_finished_tasks_ = 0;
+
+		// the tasks found first are checked before sending any, as a task can finish and send its dependents at any moment
+		vector<int> ready_tasks;
+		for (int i = 0; i < num_tasks; i++)
+		{
+			if (remaining_dependencies_[i].load() == 0)
+			{
+				ready_tasks.push_back(first_pending_task_ + i);
+			}
+		}
+		for (int id : ready_tasks)
+		{
+			thread_pool_->submit([this, id]() { runTask(id); });
+		}
+
+		// work on the tasks until all of them are done
+		thread_pool_->waitUntil([this, num_tasks]() { return num_finished_tasks_.load() == num_tasks; });
+	}
+
+	first_pending_task_ = (int)tasks_.size();
+	run_time_ms_ += chrono::duration<double, milli>(Clock::now() - run_start).count();
+}
+
+void TaskGraph::runTask(int id)
+{
+	Task& task = tasks_[id];
+	task.thread_index = thread_pool_->getThreadIndex();
+	task.start_ms = chrono::duration<double, milli>(Clock::now() - frame_start_).count();
+	task.work();
+	task.end_ms = chrono::duration<double, milli>(Clock::now() - frame_start_).count();
+
+	// send the tasks which were only waiting for this one
+	for (int dependent : task.dependents)
+	{
+		if (remaining_dependencies_[dependent - first_pending_task_].fetch_sub(1) == 1)
+		{
+			thread_pool_->submit([this, dependent]() { runTask(dependent); });
+		}
+	}
+
+	// the last thing done, the thread waiting in run() can return after it
+	num_finished_tasks_++;
+}
+
+void TaskGraph::printDump() const
+{
+	int num_threads = (thread_pool_ != nullptr) ? thread_pool_->getNumThreads() : 1;
+	printf("\nFrame tasks: %i tasks, %.3f ms running them on %i threads (%.0f%% utilization)\n", (int)tasks_.size(), run_time_ms_, num_threads,
+		getUtilization() * 100.0f);
+	printf("%4s %-28s %7s %10s %10s  %s\n", "Id", "Task", "Thread", "Start ms", "End ms", "Depends on");
+
+	for (size_t id = 0; id < tasks_.size(); id++)
+	{
+		const Task& task = tasks_[id];
+		string dependencies;
+		for (int dependency : task.dependencies)
+		{
+			dependencies += (dependencies.empty() ? "" : ", ") + to_string(dependency);
+		}
+		printf("%4i %-28s %7i %10.3f %10.3f  %s\n", (int)id, task.name.c_str(), task.thread_index, task.start_ms, task.end_ms, dependencies.c_str());
+	}
+	printf("(thread 0 is the GL thread, the others are the workers)\n\n");
+}
+
+int TaskGraph::getNumTasks() const
+{
+	return (int)tasks_.size();
+}
+
+double TaskGraph::getRunTime() const
+{
+	return run_time_ms_;
+}
+
+float TaskGraph::getUtilization() const
+{
+	int num_threads = (thread_pool_ != nullptr) ? thread_pool_->getNumThreads() : 1;
+	if (run_time_ms_ <= 0.0)
+	{
+		return 0.0f;
+	}
+
+	double busy_ms = 0.0;
+	for (const Task& task : tasks_)
+	{
+		busy_ms += task.end_ms - task.start_ms;
+	}
+	float utilization = (float)(busy_ms / (run_time_ms_ * num_threads));
+	return (utilization < 1.0f) ? utilization : 1.0f;
+}
@@ -0,0 +1,86 @@
+// Class Task Graph
+// The CPU work of a frame split in named tasks with dependencies between them (ex: the camera follows a mesh, so it is updated after the
+// meshes), which the thread pool runs in parallel: the tasks without dependencies are sent first and each task sends the ones which were
+// only waiting for it when it finishes. The thread which calls run() also works on the tasks until all of them are done.
+// The tasks can be added and run in several times during the frame (ex: the update ones and then the culling ones), a dependency on a
+// task of a previous run() is already done. The tasks are kept until clear(), so the whole frame can be printed (which thread ran each
+// task and when) to see how the work is shared between the threads.
+// The tasks must not use openGL (only the GL thread can), that work stays out of the graph.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include "ThreadPool.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <chrono>
+
+using namespace std;
+
+class TaskGraph
+{
+public:
+	// constructor
+	// thread_pool: pool which runs the tasks, if it is null they are run in the calling thread in the order they were added
+	TaskGraph(ThreadPool* thread_pool);
+
+	// remove all the tasks, it starts a new frame (the times of the tasks are from here)
+	void clear();
+
+	// add a task which runs after its dependencies (ids returned by addTask() before this one) and return its id
+	int addTask(const string& name, const function<void()>& work, const vector<int>& dependencies = {});
+
+	// run the tasks added since the last run() and return when all of them are done
+	void run();
+
+	// print each task of the frame (thread, start and end time, dependencies) and the utilization of the threads
+	void printDump() const;
+
+	// number of tasks since clear()
+	int getNumTasks() const;
+
+	// time (ms) inside run() since clear()
+	double getRunTime() const;
+
+	// fraction of the threads busy with the tasks while they were running [0, 1]
+	float getUtilization() const;
+
+private:
+	using Clock = chrono::steady_clock;
+
+	struct Task
+	{
+		string name;
+		function<void()> work;
+		vector<int> dependencies;
+		vector<int> dependents; // tasks which wait for this one
+
+		// filled when it runs
+		int thread_index;
+		double start_ms;
+		double end_ms;
+	};
+
+	ThreadPool* thread_pool_;
+
+	vector<Task> tasks_;
+
+	// first task not run yet
+	int first_pending_task_;
+
+	// dependencies not done of each task not run yet (index from first_pending_task_)
+	unique_ptr<atomic<int>[]> remaining_dependencies_;
+
+	// tasks of the current run() done, the calling thread waits until all of them are
+	atomic<int> num_finished_tasks_;
+
+	// start of the frame (clear()) and time spent in run()
+	Clock::time_point frame_start_;
+	double run_time_ms_;
+
+	// run a task and send its dependents which are ready
+	void runTask(int id);
+};
@@ -1,9 +1,20 @@
 #include "Texture.h"
 
-Texture::Texture(const char texture_url[], TextureCoordsType texture_coords_type, bool y_inverted)
-	: texture_coords_type_(texture_coords_type)
+// shared components of all the textures
+GLuint Texture::bound_texture_ = 0;
+int Texture::num_binds_ = 0;
+
+Texture::Texture(const char texture_url[], TextureCoordsType texture_coords_type, bool y_inverted, TextureCache* texture_cache)
+	: url_(texture_url), y_inverted_(y_inverted), texture_cache_(texture_cache), texture_coords_type_(texture_coords_type)
 {
-	if (!y_inverted)
+	if (texture_cache != nullptr)
+	{
+		// same steps as the SOIL flags below, but done by the preprocessor (SIMD and multithreaded) and only the first time, the next times it is read from the cache
+		TexturePreprocessOptions options;
+		options.invert_y = y_inverted;
+		texture_ = texture_cache->loadTexture(texture_url, options, 0, &info_);
+	}
+	else if (!y_inverted)
 	{
 		texture_ = SOIL_load_OGL_texture(
 			texture_url,
@@ -22,8 +33,11 @@ Texture::Texture(const char texture_url[], TextureCoordsType texture_coords_type
 		);
 	}
 
-	//check for an error during the load process
-	if (texture_ == 0)
+	// the loaders bind the new texture object by themselves and leave none bound
+	invalidateBinding();
+
+	//check for an error during the load process (the preprocessor prints its own error)
+	if (texture_ == 0 && texture_cache == nullptr)
 	{
 		printf("SOIL loading error: '%s'\n", SOIL_last_result());
 	}
@@ -46,12 +60,34 @@ void Texture::setWrapST(GLint wrap_s, GLint wrap_t)
 	wrap_t_ = wrap_t; // it is for the 'v'or 'y' axis
 }
 
+GLint Texture::getWrapS() const
+{
+	return wrap_s_;
+}
+
+GLint Texture::getWrapT() const
+{
+	return wrap_t_;
+}
+
+const char* Texture::getUrl() const
+{
+	return url_.c_str();
+}
+
+bool Texture::isYInverted() const
+{
+	return y_inverted_;
+}
+
 void Texture::use()
 {
 	glEnable(GL_TEXTURE_2D); // allows polygons to use textures
 
 	// bind the texture
 	glBindTexture(GL_TEXTURE_2D, texture_); // tells to openGl to use this texture_
+	bound_texture_ = texture_;
+	num_binds_++;
 
 	// set if the texture is going to be is repeated, mirrored, clamped...
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s_);
@@ -63,6 +99,148 @@ void Texture::use()
 void Texture::stopUsing()
 {
 	glBindTexture(GL_TEXTURE_2D, NULL); // bind a null texture
+	bound_texture_ = 0;
 
 	glDisable(GL_TEXTURE_2D); // disable texture
 }
+
+void Texture::setAtlasRegion(GLuint atlas_page, float starting_u, float starting_v, float ending_u, float ending_v)
+{
+	atlas_page_ = atlas_page;
+	atlas_starting_u_ = starting_u;
+	atlas_starting_v_ = starting_v;
+	atlas_ending_u_ = ending_u;
+	atlas_ending_v_ = ending_v;
+}
+
+bool Texture::isInAtlas() const
+{
+	return atlas_page_ != 0;
+}
+
+void Texture::remapToAtlas(float& u, float& v) const
+{
+	// the texture is clamped so a coord out of the image is the same as the coord in the border of the image
+	u = (u < 0.0f) ? 0.0f : ((u > 1.0f) ? 1.0f : u);
+	v = (v < 0.0f) ? 0.0f : ((v > 1.0f) ? 1.0f : v);
+
+	// scale and move the coord to the region of the atlas
+	u = atlas_starting_u_ + u * (atlas_ending_u_ - atlas_starting_u_);
+	v = atlas_starting_v_ + v * (atlas_ending_v_ - atlas_starting_v_);
+}
+
+void Texture::useAtlas()
+{
+	glEnable(GL_TEXTURE_2D); // allows polygons to use textures
+
+	// bind the page only if it is not the one is currently bound
+	// the wrap and filters of the page has been set when the atlas was created so they don't need to be set again
+	if (bound_texture_ != atlas_page_)
+	{
+		glBindTexture(GL_TEXTURE_2D, atlas_page_);
+		bound_texture_ = atlas_page_;
+		num_binds_++;
+	}
+}
+
+void Texture::stopUsingAtlas()
+{
+	glDisable(GL_TEXTURE_2D); // disable texture (the page is kept bound)
+}
+
+int Texture::getNumBinds()
+{
+	return num_binds_;
+}
+
+void Texture::resetNumBinds()
+{
+	num_binds_ = 0;
+}
+
+void Texture::bindTextureObject(GLuint texture_object)
+{
+	if (bound_texture_ != texture_object)
+	{
+		glBindTexture(GL_TEXTURE_2D, texture_object);
+		bound_texture_ = texture_object;
+		num_binds_++;
+	}
+}
+
+void Texture::invalidateBinding()
+{
+	bound_texture_ = 0;
+}
+
+bool Texture::isStreamable() const
+{
+	return texture_cache_ != nullptr && texture_ != 0 && !isInAtlas();
+}
+
+int Texture::getNumLevels() const
+{
+	return info_.num_levels;
+}
+
+int Texture::getFirstLevel() const
+{
+	return first_level_;
+}
+
+int Texture::getWidth() const
+{
+	return info_.width;
+}
+
+int Texture::getHeight() const
+{
+	return info_.height;
+}
+
+size_t Texture::getGPUBytes(int first_level) const
+{
+	size_t bytes = 0;
+	int width = info_.width, height = info_.height;
+	for (int i = 0; i < info_.num_levels; i++)
+	{
+		if (i >= first_level)
+		{
+			bytes += TextureCache::getLevelSize(width, height, info_.format);
+		}
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+	}
+	return bytes;
+}
+
+size_t Texture::getGPUBytes() const
+{
+	return getGPUBytes(first_level_);
+}
+
+bool Texture::setFirstLevel(int first_level)
+{
+	if (!isStreamable() || first_level == first_level_ || first_level < 0 || first_level >= info_.num_levels)
+	{
+		return false;
+	}
+
+	// the cache maps the file and uploads only the levels needed
+	TexturePreprocessOptions options;
+	options.invert_y = y_inverted_;
+	GLuint new_texture = texture_cache_->loadTexture(url_.c_str(), options, first_level);
+	if (new_texture == 0)
+	{
+		return false;
+	}
+
+	// replace the texture object
+	// the cache has left no texture bound (not only the old one), ex: the page of the atlas which useAtlas() thinks is still bound
+	glDeleteTextures(1, &texture_);
+	invalidateBinding();
+	texture_ = new_texture;
+	first_level_ = first_level;
+
+	return true;
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
-// Texture Class 
+// Texture Class
 // It is used to load a texture(image) and create a texture object with it
+// A texture can also be packed inside a texture atlas (see TextureAtlas), in that case the meshes which use it can remap their texture coords
+// into the region of the atlas and bind the atlas page instead of this texture object (avoiding a bind per mesh)
 // @author Francisco Diaz (FMGameDev)
 
 #pragma once
@@ -9,12 +11,14 @@
 #include <gl/GL.h>
 #include <gl/GLU.h>
 #include <fstream> // printf
+#include <string>
 
 #include "SOIL.h"
+#include "TextureCache.h"
 
 // Define the type of texture coords this texture has.
 // It is mainly used for the cube (planes-rectangles) based on this parameter the classes initialise their texture coords
-// If a texture is loaded from a model then use kDefault as the model has already the texture coords 
+// If a texture is loaded from a model then use kDefault as the model has already the texture coords
 enum class TextureCoordsType
 {
 	kDefault, // the coords for the texture will take the full image coords (from 0 to 1) for 'u' and 'v'
@@ -26,7 +30,8 @@ class Texture
 {
 public:
 	// constructor
-	Texture(const char texture_url[], TextureCoordsType texture_coords_type = TextureCoordsType::kDefault, bool y_inverted = false); // by default the texture_ will take the full image coords
+	// if a texture cache is passed the texture is loaded from it (or processed by its preprocessor the first time) instead of by SOIL
+	Texture(const char texture_url[], TextureCoordsType texture_coords_type = TextureCoordsType::kDefault, bool y_inverted = false, TextureCache* texture_cache = nullptr); // by default the texture_ will take the full image coords
 
 	// destructor
 	~Texture();
@@ -43,10 +48,80 @@ public:
 	// fucntion for set the wrap_s and wrap_t
 	void setWrapST(GLint wrap_s, GLint wrap_t);
 
+	// return the wrap values ('s' and 't')
+	GLint getWrapS() const;
+	GLint getWrapT() const;
+
+	// return the url of the image this texture has been loaded from
+	const char* getUrl() const;
+
+	// return if the image was flipped vertically when it was loaded
+	bool isYInverted() const;
+
+
+	/* TEXTURE ATLAS */
+
+	// set the atlas page and the region (from 0 to 1 in the page) where this texture has been packed
+	void setAtlasRegion(GLuint atlas_page, float starting_u, float starting_v, float ending_u, float ending_v);
+
+	// return true if this texture has been packed in an atlas
+	bool isInAtlas() const;
+
+	// transform a texture coord of this texture (from 0 to 1) into the coord of the atlas page
+	void remapToAtlas(float& u, float& v) const;
+
+	// bind the atlas page this texture is packed in, it is not rebinded if the page is already bound
+	void useAtlas();
+
+	// stop using the atlas page, the page is kept bound so the next mesh using the same page doesn't need to bind it again
+	void stopUsingAtlas();
+
+	// number of texture binds done since the last reset (for the stats of the scene)
+	static int getNumBinds();
+	static void resetNumBinds();
+
+	// bind a texture object which is not owned by a texture (ex: the blob shadow), so the texture bound is still known
+	static void bindTextureObject(GLuint texture_object);
+
+	// forget the texture object bound, it must be called after binding or deleting textures without this class (ex: the uploads of the
+	// texture cache), so the next use() or useAtlas() binds its texture again
+	static void invalidateBinding();
+
+
+	/* MIP STREAMING (used by the residency manager) */
+
+	// return true if the mip levels of this texture can be streamed (it has been loaded from the texture cache and it is not in the atlas)
+	bool isStreamable() const;
+
+	// return the number of mip levels of the full texture and the first level currently uploaded
+	int getNumLevels() const;
+	int getFirstLevel() const;
+
+	// return the size of the level 0 of the full texture
+	int getWidth() const;
+	int getHeight() const;
+
+	// memory used in the graphics card if the levels from first_level are uploaded
+	size_t getGPUBytes(int first_level) const;
+	// memory currently used in the graphics card
+	size_t getGPUBytes() const;
+
+	// upload again the texture with only the levels from first_level (higher level means less detail and memory)
+	bool setFirstLevel(int first_level);
+
 private:
 	// texture component
 	GLuint texture_;
 
+	// url of the image and if it was inverted, they are kept so the image can be loaded again (ex: by the texture atlas)
+	std::string url_;
+	bool y_inverted_;
+
+	// cache the texture was loaded from (nullptr if it was loaded by SOIL) and the information of its levels
+	TextureCache* texture_cache_;
+	CachedTextureInfo info_;
+	int first_level_ = 0;
+
 	// type of coords must follow the texture, respect the image
 	TextureCoordsType texture_coords_type_;
 
@@ -55,5 +130,13 @@ private:
 	// GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP, GL_CALMP_TO_EDGE, GL_CLAMP_TO_BORDER..
 	GLint wrap_s_ = GL_CLAMP; // by default repeat ('s' is like 'x')
 	GLint wrap_t_ = GL_CLAMP; // by default repeat ('t' is like 'y')
-};
 
+	// atlas components, the page is 0 if this texture is not in an atlas
+	GLuint atlas_page_ = 0;
+	float atlas_starting_u_ = 0.0f, atlas_starting_v_ = 0.0f;
+	float atlas_ending_u_ = 1.0f, atlas_ending_v_ = 1.0f;
+
+	// texture object currently bound and the number of binds done (shared by all the textures)
+	static GLuint bound_texture_;
+	static int num_binds_;
+};
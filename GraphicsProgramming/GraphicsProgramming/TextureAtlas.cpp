@@ -0,0 +1,262 @@
+#include "TextureAtlas.h"
+#include "TexturePreprocessor.h"
+#include <algorithm> // sort
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F // openGL 1.2, it is not in the windows header
+#endif
+#ifndef GL_MIRRORED_REPEAT
+#define GL_MIRRORED_REPEAT 0x8370
+#endif
+
+TextureAtlas::TextureAtlas(int page_size, int padding, int max_entry_size)
+	: page_size_(page_size), padding_(padding), max_entry_size_(max_entry_size)
+{
+	// the page cannot be bigger than the max size supported by the graphics card
+	GLint max_texture_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+	if (max_texture_size > 0 && page_size_ > max_texture_size)
+	{
+		page_size_ = max_texture_size;
+	}
+
+	// an entry plus its padding must fit in a page
+	if (max_entry_size_ + 2 * padding_ > page_size_)
+	{
+		max_entry_size_ = page_size_ - 2 * padding_;
+	}
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	// delete the pages created
+	if (!pages_.empty())
+	{
+		glDeleteTextures((GLsizei)pages_.size(), pages_.data());
+	}
+	// the last texture bound can be a page deleted (its name can be given to a new texture)
+	Texture::invalidateBinding();
+}
+
+bool TextureAtlas::addTexture(Texture* texture)
+{
+	// repeated textures are kept out of the atlas, their coords go further than the region
+	if (texture->getWrapS() == GL_REPEAT || texture->getWrapT() == GL_REPEAT ||
+		texture->getWrapS() == GL_MIRRORED_REPEAT || texture->getWrapT() == GL_MIRRORED_REPEAT)
+	{
+		return false;
+	}
+
+	// load the image again (the texture object doesn't keep its pixels)
+	int channels;
+	AtlasEntry entry;
+	unsigned char* img = SOIL_load_image(texture->getUrl(), &entry.width, &entry.height, &channels, SOIL_LOAD_RGBA);
+	if (img == nullptr)
+	{
+		printf("Texture atlas - SOIL loading error: '%s'\n", SOIL_last_result());
+		return false;
+	}
+
+	entry.texture = texture;
+	entry.page = -1;
+	entry.x = 0;
+	entry.y = 0;
+	entry.pixels.assign(img, img + (entry.width * entry.height * 4));
+	SOIL_free_image_data(img);
+
+	// flip the image and make the colours NTSC safe in the same way the texture did
+	if (texture->isYInverted())
+	{
+		TexturePreprocessor::flipVertically(entry.pixels.data(), entry.width, entry.height);
+	}
+	TexturePreprocessor::scaleToNTSCSafe(entry.pixels.data(), entry.width * entry.height);
+
+	// reduce it if it is too big for the atlas
+	fitToMaxEntrySize(entry);
+
+	entries_.push_back(entry);
+	return true;
+}
+
+void TextureAtlas::build()
+{
+	if (entries_.empty())
+	{
+		return;
+	}
+
+	// sort the entries by height (tallest first), so the shelves waste less space
+	vector<AtlasEntry*> sorted_entries;
+	for (AtlasEntry& entry : entries_)
+	{
+		sorted_entries.push_back(&entry);
+	}
+	sort(sorted_entries.begin(), sorted_entries.end(), [](const AtlasEntry* a, const AtlasEntry* b) { return a->height > b->height; });
+
+	/* Shelf packing */
+	// each shelf is a row of the page, its height is the height of its first (tallest) entry
+	vector<int> pages_height; // height used in each page
+	vector<int> pages_width; // width used in each page
+	int page = 0, shelf_x = 0, shelf_y = 0, shelf_height = 0;
+	pages_height.push_back(0);
+	pages_width.push_back(0);
+
+	for (AtlasEntry* entry : sorted_entries)
+	{
+		int entry_width = entry->width + 2 * padding_;
+		int entry_height = entry->height + 2 * padding_;
+
+		// if it doesn't fit in the current shelf then open a new shelf
+		if (shelf_x + entry_width > page_size_)
+		{
+			shelf_y += shelf_height;
+			shelf_x = 0;
+			shelf_height = 0;
+		}
+
+		// if the new shelf doesn't fit in the page then open a new page
+		if (shelf_y + entry_height > page_size_)
+		{
+			page++;
+			shelf_x = 0;
+			shelf_y = 0;
+			shelf_height = 0;
+			pages_height.push_back(0);
+			pages_width.push_back(0);
+		}
+
+		// place the entry (the position is the one of the image, without the padding)
+		entry->page = page;
+		entry->x = shelf_x + padding_;
+		entry->y = shelf_y + padding_;
+
+		shelf_x += entry_width;
+		shelf_height = max(shelf_height, entry_height);
+		pages_height[page] = max(pages_height[page], shelf_y + shelf_height);
+		pages_width[page] = max(pages_width[page], shelf_x);
+	}
+
+	/* Create the pages */
+	for (int i = 0; i <= page; i++)
+	{
+		// the dimension of the page is the power of two which contains all its entries
+		int page_width = 1, page_height = 1;
+		while (page_width < pages_width[i]) page_width *= 2;
+		while (page_height < pages_height[i]) page_height *= 2;
+
+		vector<unsigned char> page_pixels(page_width * page_height * 4, 0);
+		for (AtlasEntry& entry : entries_)
+		{
+			if (entry.page == i)
+			{
+				copyEntryToPage(entry, page_pixels, page_width, page_height);
+			}
+		}
+
+		GLuint page_texture = createPage(page_pixels, page_width, page_height);
+		pages_.push_back(page_texture);
+
+		// tell each texture of this page its region
+		for (AtlasEntry& entry : entries_)
+		{
+			if (entry.page == i)
+			{
+				entry.texture->setAtlasRegion(page_texture,
+					(float)entry.x / (float)page_width, (float)entry.y / (float)page_height,
+					(float)(entry.x + entry.width) / (float)page_width, (float)(entry.y + entry.height) / (float)page_height);
+			}
+		}
+	}
+
+	// the pixels are in the graphics card now, they are not longer needed
+	for (AtlasEntry& entry : entries_)
+	{
+		vector<unsigned char>().swap(entry.pixels);
+	}
+}
+
+int TextureAtlas::getNumPages() const
+{
+	return (int)pages_.size();
+}
+
+int TextureAtlas::getNumTexturesPacked() const
+{
+	return (int)entries_.size();
+}
+
+void TextureAtlas::fitToMaxEntrySize(AtlasEntry& entry)
+{
+	while (entry.width > max_entry_size_ || entry.height > max_entry_size_)
+	{
+		int new_width = max(entry.width / 2, 1);
+		int new_height = max(entry.height / 2, 1);
+		vector<unsigned char> new_pixels(new_width * new_height * 4);
+
+		// each new pixel is the average of the 2x2 pixels it replaces (clamped to the border for odd dimensions)
+		for (int y = 0; y < new_height; y++)
+		{
+			int y0 = min(y * 2, entry.height - 1), y1 = min(y * 2 + 1, entry.height - 1);
+			for (int x = 0; x < new_width; x++)
+			{
+				int x0 = min(x * 2, entry.width - 1), x1 = min(x * 2 + 1, entry.width - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					int sum = entry.pixels[(y0 * entry.width + x0) * 4 + c] + entry.pixels[(y0 * entry.width + x1) * 4 + c] +
+						entry.pixels[(y1 * entry.width + x0) * 4 + c] + entry.pixels[(y1 * entry.width + x1) * 4 + c];
+					new_pixels[(y * new_width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+
+		entry.width = new_width;
+		entry.height = new_height;
+		entry.pixels.swap(new_pixels);
+	}
+}
+
+void TextureAtlas::copyEntryToPage(const AtlasEntry& entry, vector<unsigned char>& page_pixels, int page_width, int page_height)
+{
+	// copy the image and its padding, the pixels of the padding take the colour of the closest border pixel of the image
+	for (int y = -padding_; y < entry.height + padding_; y++)
+	{
+		int src_y = min(max(y, 0), entry.height - 1);
+		int dst_y = entry.y + y;
+		if (dst_y < 0 || dst_y >= page_height) continue;
+
+		for (int x = -padding_; x < entry.width + padding_; x++)
+		{
+			int src_x = min(max(x, 0), entry.width - 1);
+			int dst_x = entry.x + x;
+			if (dst_x < 0 || dst_x >= page_width) continue;
+
+			const unsigned char* src = &entry.pixels[(src_y * entry.width + src_x) * 4];
+			unsigned char* dst = &page_pixels[(dst_y * page_width + dst_x) * 4];
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+			dst[3] = src[3];
+		}
+	}
+}
+
+GLuint TextureAtlas::createPage(const vector<unsigned char>& page_pixels, int page_width, int page_height)
+{
+	GLuint page_texture;
+	glGenTextures(1, &page_texture);
+	glBindTexture(GL_TEXTURE_2D, page_texture);
+
+	// the regions are never repeated, the filters use the mipmaps as the textures loaded by SOIL
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+	// upload the page and create its mipmaps
+	gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGBA, page_width, page_height, GL_RGBA, GL_UNSIGNED_BYTE, page_pixels.data());
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	Texture::invalidateBinding(); // the page has been bound without use()
+
+	return page_texture;
+}
@@ -0,0 +1,73 @@
+// Class Texture Atlas
+// It packs the textures of the scene into one or a few big textures (pages) when the scene is loaded,
+// so the meshes can remap their texture coords into the region of their texture and the scene can render most of the geometry without rebinding textures.
+// Textures which are repeated or mirrored (GL_REPEAT, GL_MIRRORED_REPEAT) are kept out of the atlas, as their coords go further than 0-1 and they would read the neighbour regions.
+// Each region is surrounded by a padding where the border pixels of the image are extruded, so the filtering and the mipmaps don't bleed the colour of the neighbours.
+// Images bigger than the max entry size are halved (box filter) until they fit, to keep the pages in a reasonable size.
+// The packing is done with shelves (rows) sorted by height, when a page is full a new page is created.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+// Include GLUT, openGL, input.
+#include "glut.h"
+#include <gl/GL.h>
+#include <gl/GLU.h>
+#include <vector>
+
+#include "Texture.h"
+
+using namespace std;
+
+class TextureAtlas
+{
+public:
+	// constructor
+	// page_size: width (and max height) of each page in pixels, padding: pixels around each region, max_entry_size: max width/height of an image inside the atlas
+	TextureAtlas(int page_size = 4096, int padding = 8, int max_entry_size = 2048);
+
+	// destructor
+	~TextureAtlas();
+
+	// add a texture to be packed, it returns false if the texture cannot be packed (it is repeated or the image cannot be loaded)
+	bool addTexture(Texture* texture);
+
+	// pack all the textures added, create the pages and tell each texture its region
+	void build();
+
+	// return the number of pages created
+	int getNumPages() const;
+
+	// return the number of textures packed
+	int getNumTexturesPacked() const;
+
+private:
+	// texture waiting to be packed, with its pixels (RGBA) and its position once it has been packed
+	struct AtlasEntry
+	{
+		Texture* texture;
+		int width, height;
+		vector<unsigned char> pixels;
+		int page, x, y;
+	};
+
+	// settings of the atlas
+	int page_size_;
+	int padding_;
+	int max_entry_size_;
+
+	// collection of textures to pack
+	vector<AtlasEntry> entries_;
+
+	// texture objects of the pages created
+	vector<GLuint> pages_;
+
+	// halve the image (box filter) until it fits in the max entry size
+	void fitToMaxEntrySize(AtlasEntry& entry);
+
+	// copy the entry into the page pixels, extruding its borders into the padding
+	void copyEntryToPage(const AtlasEntry& entry, vector<unsigned char>& page_pixels, int page_width, int page_height);
+
+	// create the texture object of a page from its pixels
+	GLuint createPage(const vector<unsigned char>& page_pixels, int page_width, int page_height);
+};
@@ -0,0 +1,177 @@
+#include "TextureBenchmark.h"
+#include <chrono>
+#include <cmath> // log10
+
+TextureBenchmark::TextureBenchmark(ThreadPool* thread_pool)
+	: preprocessor_(thread_pool), texture_cache_(&preprocessor_, "cache_benchmark/"), num_runs_(3)
+{
+}
+
+void TextureBenchmark::run(const vector<BenchmarkImage>& images)
+{
+	using Clock = chrono::high_resolution_clock;
+
+	GLExtensions::load();
+	bool compress = GLExtensions::hasCompressedTextures();
+	if (!compress)
+	{
+		printf("The graphics card doesn't support DXT textures, the textures are compared uncompressed\n");
+	}
+
+	printf("\n%-34s %11s %10s %10s %8s %10s %10s %10s\n", "Image", "Size", "SOIL ms", "Ours ms", "Speedup", "MPix/s", "SOIL dB", "Ours dB");
+
+	double total_soil_ms = 0.0, total_ours_ms = 0.0;
+	for (const BenchmarkImage& image : images)
+	{
+		TexturePreprocessOptions options;
+		options.invert_y = image.y_inverted;
+		options.compress_dxt = compress;
+
+		unsigned int soil_flags = SOIL_FLAG_MIPMAPS | SOIL_FLAG_NTSC_SAFE_RGB;
+		if (compress) soil_flags |= SOIL_FLAG_COMPRESS_TO_DXT;
+		if (image.y_inverted) soil_flags |= SOIL_FLAG_INVERT_Y;
+
+		/* SOIL (same call as the Texture class did) */
+		GLuint soil_texture = 0;
+		double soil_ms = 0.0;
+		for (int run = 0; run < num_runs_; run++)
+		{
+			if (soil_texture != 0) glDeleteTextures(1, &soil_texture);
+
+			Clock::time_point start = Clock::now();
+			soil_texture = SOIL_load_OGL_texture(image.url.c_str(), SOIL_LOAD_AUTO, SOIL_CREATE_NEW_ID, soil_flags);
+			glFinish();
+			soil_ms += chrono::duration<double, milli>(Clock::now() - start).count();
+		}
+		soil_ms /= num_runs_;
+
+		/* Preprocessor */
+		GLuint our_texture = 0;
+		double our_ms = 0.0;
+		for (int run = 0; run < num_runs_; run++)
+		{
+			if (our_texture != 0) glDeleteTextures(1, &our_texture);
+
+			Clock::time_point start = Clock::now();
+			our_texture = preprocessor_.loadTexture(image.url.c_str(), options);
+			glFinish();
+			our_ms += chrono::duration<double, milli>(Clock::now() - start).count();
+		}
+		our_ms /= num_runs_;
+
+		if (soil_texture == 0 || our_texture == 0)
+		{
+			printf("%-34s could not be loaded\n", image.url.c_str());
+			continue;
+		}
+
+		/* Quality: both level 0 against the image processed without compression */
+		vector<unsigned char> pixels;
+		int width, height;
+		bool has_alpha;
+		preprocessor_.loadImage(image.url.c_str(), pixels, width, height, has_alpha);
+		TexturePreprocessOptions reference_options = options;
+		reference_options.compress_dxt = false;
+		ProcessedTexture reference;
+		preprocessor_.process(pixels, width, height, has_alpha, reference_options, reference);
+
+		vector<unsigned char> soil_pixels, our_pixels;
+		int soil_width, soil_height, our_width, our_height;
+		readBack(soil_texture, soil_pixels, soil_width, soil_height);
+		readBack(our_texture, our_pixels, our_width, our_height);
+
+		const TextureLevel& reference_level = reference.levels[0];
+		float soil_psnr = -1.0f, our_psnr = -1.0f; // -1 means the sizes are different and they cannot be compared
+		if (soil_width == reference_level.width && soil_height == reference_level.height)
+		{
+			soil_psnr = calculatePSNR(soil_pixels, reference_level.data, has_alpha);
+		}
+		if (our_width == reference_level.width && our_height == reference_level.height)
+		{
+			our_psnr = calculatePSNR(our_pixels, reference_level.data, has_alpha);
+		}
+
+		char size_text[16];
+		snprintf(size_text, sizeof(size_text), "%ix%i", width, height);
+		double megapixels = (double)width * (double)height / 1000000.0;
+		printf("%-34s %11s %10.2f %10.2f %7.2fx %10.2f %10.2f %10.2f\n", image.url.c_str(), size_text, soil_ms, our_ms, soil_ms / our_ms,
+			megapixels / (our_ms / 1000.0), soil_psnr, our_psnr);
+
+		total_soil_ms += soil_ms;
+		total_ours_ms += our_ms;
+
+		glDeleteTextures(1, &soil_texture);
+		glDeleteTextures(1, &our_texture);
+	}
+
+	printf("\nTotal: SOIL %.2f ms, ours %.2f ms (%.2fx) with %i thread(s)\n\n", total_soil_ms, total_ours_ms,
+		total_ours_ms > 0.0 ? total_soil_ms / total_ours_ms : 0.0, preprocessor_.getNumThreads());
+
+	runCache(images);
+}
+
+void TextureBenchmark::runCache(const vector<BenchmarkImage>& images)
+{
+	// cold: remove the cached files so all the images are processed and saved
+	for (const BenchmarkImage& image : images)
+	{
+		TexturePreprocessOptions options;
+		options.invert_y = image.y_inverted;
+		texture_cache_.removeCachedTexture(image.url.c_str(), options);
+	}
+
+	// load all the images twice (cold and warm), as the scene does at startup
+	for (int pass = 0; pass < 2; pass++)
+	{
+		texture_cache_.resetStats();
+		vector<GLuint> textures;
+		for (const BenchmarkImage& image : images)
+		{
+			TexturePreprocessOptions options;
+			options.invert_y = image.y_inverted;
+			textures.push_back(texture_cache_.loadTexture(image.url.c_str(), options));
+		}
+		glFinish();
+
+		printf("%s startup: ", pass == 0 ? "Cold" : "Warm");
+		texture_cache_.printStats();
+
+		glDeleteTextures((GLsizei)textures.size(), textures.data());
+	}
+	printf("\n");
+}
+
+void TextureBenchmark::readBack(GLuint texture, vector<unsigned char>& pixels, int& width, int& height)
+{
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+
+	// the driver decompresses the texture when it is read as RGBA
+	pixels.resize(width * height * 4);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+float TextureBenchmark::calculatePSNR(const vector<unsigned char>& image, const vector<unsigned char>& reference, bool has_alpha)
+{
+	int num_channels = has_alpha ? 4 : 3;
+	double squared_error = 0.0;
+	size_t num_pixels = reference.size() / 4;
+	for (size_t i = 0; i < num_pixels; i++)
+	{
+		for (int c = 0; c < num_channels; c++)
+		{
+			double difference = (double)image[i * 4 + c] - (double)reference[i * 4 + c];
+			squared_error += difference * difference;
+		}
+	}
+
+	double mean_squared_error = squared_error / (double)(num_pixels * num_channels);
+	if (mean_squared_error == 0.0)
+	{
+		return 99.0f; // identical
+	}
+	return (float)(10.0 * log10(255.0 * 255.0 / mean_squared_error));
+}
@@ -0,0 +1,49 @@
+// Class Texture Benchmark
+// It compares the texture preprocessor against SOIL loading the same images with the same steps (invert y, NTSC safe, mipmaps and DXT).
+// For each image it prints the time of both (load + process + upload), the throughput and the quality of the level 0 (PSNR in dB),
+// the quality is measured reading back the texture from the graphics card and comparing it with the image uncompressed.
+// After that it loads all the images through the texture cache twice: cold (cache files removed first) and warm (from the cache).
+// It is run from the command line with: GraphicsProgramming.exe --texture-benchmark
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include "TexturePreprocessor.h"
+#include "TextureCache.h"
+#include <string>
+
+// image to test and if it is loaded inverted in the scene
+struct BenchmarkImage
+{
+	std::string url;
+	bool y_inverted;
+};
+
+class TextureBenchmark
+{
+public:
+	// constructor
+	TextureBenchmark(ThreadPool* thread_pool);
+
+	// run the benchmark for all the images and print the results
+	void run(const vector<BenchmarkImage>& images);
+
+private:
+	// preprocessor tested
+	TexturePreprocessor preprocessor_;
+
+	// cache tested (in its own folder, so the cache of the game is not modified)
+	TextureCache texture_cache_;
+
+	// number of times each image is loaded (the time is the average)
+	int num_runs_;
+
+	// load all the images through the cache, cold and then warm, and print the times
+	void runCache(const vector<BenchmarkImage>& images);
+
+	// read back the level 0 of a texture as RGBA
+	void readBack(GLuint texture, vector<unsigned char>& pixels, int& width, int& height);
+
+	// peak signal to noise ratio of the rgb channels (the alpha too if has_alpha) between two images of the same size
+	float calculatePSNR(const vector<unsigned char>& image, const vector<unsigned char>& reference, bool has_alpha);
+};
@@ -0,0 +1,429 @@
+#include "TextureCache.h"
+#include <chrono>
+#include <cstring> // memcpy, memset
+#include <cstdio> // fopen, remove
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h> // _mkdir
+#endif
+
+/* DDS FILE FORMAT */
+// "DDS " + header (124 bytes) + the levels one after another
+// the reserved fields of the header are used to save the key of the cache, so a file can be validated
+
+#define DDS_MAGIC 0x20534444 // "DDS "
+#define DDS_CACHE_MAGIC 0x48434354 // "TCCH", it identifies the files created by this cache
+#define DDS_CACHE_VERSION 2 // it must be incremented if the way the textures are processed changes
+
+// header flags
+#define DDSD_CAPS 0x1
+#define DDSD_HEIGHT 0x2
+#define DDSD_WIDTH 0x4
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_LINEARSIZE 0x80000
+
+// pixel format flags
+#define DDPF_ALPHAPIXELS 0x1
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+#define FOURCC_DXT1 0x31545844 // "DXT1"
+#define FOURCC_DXT5 0x35545844 // "DXT5"
+
+// caps
+#define DDSCAPS_COMPLEX 0x8
+#define DDSCAPS_TEXTURE 0x1000
+#define DDSCAPS_MIPMAP 0x400000
+
+struct DDSPixelFormat
+{
+	unsigned int size;
+	unsigned int flags;
+	unsigned int four_cc;
+	unsigned int rgb_bit_count;
+	unsigned int r_bit_mask, g_bit_mask, b_bit_mask, a_bit_mask;
+};
+
+struct DDSHeader
+{
+	unsigned int size;
+	unsigned int flags;
+	unsigned int height;
+	unsigned int width;
+	unsigned int pitch_or_linear_size;
+	unsigned int depth;
+	unsigned int mip_map_count;
+	unsigned int reserved1[11]; // [0] cache magic, [1] cache version, [2-3] modification time, [4] options flags, [5-6] hash of the url
+	DDSPixelFormat pixel_format;
+	unsigned int caps, caps2, caps3, caps4;
+	unsigned int reserved2;
+};
+
+size_t TextureCache::getLevelSize(int width, int height, GLenum format)
+{
+	if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+	if (format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 16;
+	return (size_t)width * height * 4;
+}
+
+// 64 bits FNV-1a hash, used for naming the cached files
+static unsigned long long hashString(const std::string& text)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	for (char c : text)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+TextureCache::TextureCache(TexturePreprocessor* preprocessor, const char* cache_directory)
+	: preprocessor_(preprocessor), cache_directory_(cache_directory)
+{
+	resetStats();
+
+	// create the folder (nothing happens if it already exists)
+	std::string directory = cache_directory_;
+	if (!directory.empty() && (directory.back() == '/' || directory.back() == '\\'))
+	{
+		directory.pop_back();
+	}
+#ifdef _WIN32
+	_mkdir(directory.c_str());
+#else
+	mkdir(directory.c_str(), 0755);
+#endif
+}
+
+TextureCache::~TextureCache()
+{
+}
+
+GLuint TextureCache::loadTexture(const char* url, TexturePreprocessOptions options, int first_level, CachedTextureInfo* info)
+{
+	using Clock = chrono::high_resolution_clock;
+	Clock::time_point start = Clock::now();
+
+	// the key must be made with the options really used (without support for DXT the texture is not compressed)
+	if (!GLExtensions::hasCompressedTextures())
+	{
+		options.compress_dxt = false;
+	}
+
+	long long modification_time = getModificationTime(url);
+	unsigned int options_flags = getOptionsFlags(options);
+	std::string cached_url = getCachedUrl(url, modification_time, options_flags);
+
+	/* Warm: the texture is in the cache */
+	GLuint texture = loadCachedTexture(cached_url, url, modification_time, options_flags, first_level, info);
+	if (texture != 0)
+	{
+		num_warm_loads_++;
+		warm_loads_ms_ += chrono::duration<double, milli>(Clock::now() - start).count();
+		return texture;
+	}
+
+	/* Cold: process the image and save it in the cache */
+	vector<unsigned char> pixels;
+	int width, height;
+	bool has_alpha;
+	if (!preprocessor_->loadImage(url, pixels, width, height, has_alpha))
+	{
+		return 0;
+	}
+
+	ProcessedTexture processed_texture;
+	preprocessor_->process(pixels, width, height, has_alpha, options, processed_texture);
+	texture = preprocessor_->upload(processed_texture, first_level);
+
+	if (info != nullptr)
+	{
+		info->width = processed_texture.levels[0].width;
+		info->height = processed_texture.levels[0].height;
+		info->num_levels = (int)processed_texture.levels.size();
+		info->format = processed_texture.format;
+	}
+
+	if (!saveCachedTexture(cached_url, url, processed_texture, modification_time, options_flags))
+	{
+		printf("Texture cache - the file '%s' cannot be written\n", cached_url.c_str());
+	}
+
+	num_cold_loads_++;
+	cold_loads_ms_ += chrono::duration<double, milli>(Clock::now() - start).count();
+	return texture;
+}
+
+void TextureCache::removeCachedTexture(const char* url, TexturePreprocessOptions options)
+{
+	if (!GLExtensions::hasCompressedTextures())
+	{
+		options.compress_dxt = false;
+	}
+
+	std::string cached_url = getCachedUrl(url, getModificationTime(url), getOptionsFlags(options));
+	std::remove(cached_url.c_str());
+}
+
+void TextureCache::printStats() const
+{
+	printf("Texture cache: %i warm load(s) in %.2f ms, %i cold load(s) in %.2f ms\n", num_warm_loads_, warm_loads_ms_, num_cold_loads_, cold_loads_ms_);
+}
+
+int TextureCache::getNumWarmLoads() const
+{
+	return num_warm_loads_;
+}
+
+int TextureCache::getNumColdLoads() const
+{
+	return num_cold_loads_;
+}
+
+double TextureCache::getWarmLoadsTime() const
+{
+	return warm_loads_ms_;
+}
+
+double TextureCache::getColdLoadsTime() const
+{
+	return cold_loads_ms_;
+}
+
+void TextureCache::resetStats()
+{
+	num_warm_loads_ = 0;
+	num_cold_loads_ = 0;
+	warm_loads_ms_ = 0.0;
+	cold_loads_ms_ = 0.0;
+}
+
+long long TextureCache::getModificationTime(const char* url) const
+{
+#ifdef _WIN32
+	struct _stat64 file_info;
+	if (_stat64(url, &file_info) != 0)
+	{
+		return 0;
+	}
+#else
+	struct stat file_info;
+	if (stat(url, &file_info) != 0)
+	{
+		return 0;
+	}
+#endif
+	return (long long)file_info.st_mtime;
+}
+
+unsigned int TextureCache::getOptionsFlags(const TexturePreprocessOptions& options) const
+{
+	return (options.invert_y ? 1u : 0u) | (options.ntsc_safe ? 2u : 0u) | (options.mipmaps ? 4u : 0u) | (options.compress_dxt ? 8u : 0u);
+}
+
+std::string TextureCache::getCachedUrl(const char* url, long long modification_time, unsigned int options_flags) const
+{
+	// key: url, modification time and options
+	std::string key = std::string(url) + "|" + std::to_string(modification_time) + "|" + std::to_string(options_flags);
+
+	char file_name[32];
+	snprintf(file_name, sizeof(file_name), "%016llx.dds", hashString(key));
+	return cache_directory_ + file_name;
+}
+
+GLuint TextureCache::loadCachedTexture(const std::string& cached_url, const char* url, long long modification_time, unsigned int options_flags, int first_level, CachedTextureInfo* info)
+{
+	MappedFile file;
+	if (!file.open(cached_url.c_str()))
+	{
+		return 0; // it is not in the cache
+	}
+
+	/* Validate the file */
+	const unsigned char* data = file.getData();
+	size_t size = file.getSize();
+	if (size < 4 + sizeof(DDSHeader))
+	{
+		return 0;
+	}
+
+	unsigned int magic;
+	DDSHeader header;
+	memcpy(&magic, data, 4);
+	memcpy(&header, data + 4, sizeof(DDSHeader));
+	if (magic != DDS_MAGIC || header.size != sizeof(DDSHeader) || header.reserved1[0] != DDS_CACHE_MAGIC || header.reserved1[1] != DDS_CACHE_VERSION)
+	{
+		return 0;
+	}
+
+	// the key saved must be the same (two keys could have the same hash): the url is checked by its own hash, which is not the one of the name
+	long long saved_modification_time = (long long)(((unsigned long long)header.reserved1[3] << 32) | header.reserved1[2]);
+	unsigned long long saved_url_hash = ((unsigned long long)header.reserved1[6] << 32) | header.reserved1[5];
+	if (saved_modification_time != modification_time || header.reserved1[4] != options_flags || saved_url_hash != hashString(url))
+	{
+		return 0;
+	}
+
+	GLenum format;
+	bool compressed;
+	if (header.pixel_format.flags & DDPF_FOURCC)
+	{
+		if (header.pixel_format.four_cc == FOURCC_DXT1) format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		else if (header.pixel_format.four_cc == FOURCC_DXT5) format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		else return 0;
+		compressed = true;
+
+		if (!GLExtensions::hasCompressedTextures())
+		{
+			return 0;
+		}
+	}
+	else
+	{
+		format = GL_RGBA;
+		compressed = false;
+	}
+
+	// all the levels must be in the file
+	int num_levels = (header.mip_map_count > 0) ? (int)header.mip_map_count : 1;
+	size_t required_size = 4 + sizeof(DDSHeader);
+	int width = (int)header.width, height = (int)header.height;
+	for (int i = 0; i < num_levels; i++)
+	{
+		required_size += getLevelSize(width, height, format);
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+	}
+	if (required_size > size)
+	{
+		return 0;
+	}
+
+	if (info != nullptr)
+	{
+		info->width = (int)header.width;
+		info->height = (int)header.height;
+		info->num_levels = num_levels;
+		info->format = format;
+	}
+
+	/* Upload the levels directly from the mapped file (the levels before first_level are skipped) */
+	if (first_level < 0) first_level = 0;
+	if (first_level > num_levels - 1) first_level = num_levels - 1;
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	const unsigned char* level_data = data + 4 + sizeof(DDSHeader);
+	width = (int)header.width;
+	height = (int)header.height;
+	for (int i = 0; i < num_levels; i++)
+	{
+		size_t level_size = getLevelSize(width, height, format);
+		if (i >= first_level)
+		{
+			if (compressed)
+			{
+				GLExtensions::compressedTexImage2D(GL_TEXTURE_2D, i - first_level, format, width, height, 0, (GLsizei)level_size, level_data);
+			}
+			else
+			{
+				glTexImage2D(GL_TEXTURE_2D, i - first_level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level_data);
+			}
+		}
+
+		level_data += level_size;
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+	}
+
+	// same filters as the preprocessor
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, num_levels - first_level - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (num_levels - first_level) > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return texture;
+}
+
+bool TextureCache::saveCachedTexture(const std::string& cached_url, const char* url, const ProcessedTexture& processed_texture, long long modification_time, unsigned int options_flags)
+{
+	if (processed_texture.levels.empty())
+	{
+		return false;
+	}
+
+	/* Header */
+	DDSHeader header;
+	memset(&header, 0, sizeof(DDSHeader));
+	header.size = sizeof(DDSHeader);
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.width = processed_texture.levels[0].width;
+	header.height = processed_texture.levels[0].height;
+	header.pitch_or_linear_size = (unsigned int)processed_texture.levels[0].data.size();
+	header.mip_map_count = (unsigned int)processed_texture.levels.size();
+	header.caps = DDSCAPS_TEXTURE | (processed_texture.levels.size() > 1 ? (DDSCAPS_COMPLEX | DDSCAPS_MIPMAP) : 0);
+
+	// key of the cache
+	header.reserved1[0] = DDS_CACHE_MAGIC;
+	header.reserved1[1] = DDS_CACHE_VERSION;
+	header.reserved1[2] = (unsigned int)((unsigned long long)modification_time & 0xFFFFFFFF);
+	header.reserved1[3] = (unsigned int)((unsigned long long)modification_time >> 32);
+	header.reserved1[4] = options_flags;
+	unsigned long long url_hash = hashString(url);
+	header.reserved1[5] = (unsigned int)(url_hash & 0xFFFFFFFF);
+	header.reserved1[6] = (unsigned int)(url_hash >> 32);
+
+	// pixel format
+	header.pixel_format.size = sizeof(DDSPixelFormat);
+	if (processed_texture.compressed)
+	{
+		header.pixel_format.flags = DDPF_FOURCC;
+		header.pixel_format.four_cc = (processed_texture.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? FOURCC_DXT5 : FOURCC_DXT1;
+	}
+	else
+	{
+		header.pixel_format.flags = DDPF_RGB | DDPF_ALPHAPIXELS;
+		header.pixel_format.rgb_bit_count = 32;
+		header.pixel_format.r_bit_mask = 0x000000FF;
+		header.pixel_format.g_bit_mask = 0x0000FF00;
+		header.pixel_format.b_bit_mask = 0x00FF0000;
+		header.pixel_format.a_bit_mask = 0xFF000000;
+	}
+
+	/* Write the file, first with a temporary name so a file half written is never read */
+	std::string temporary_url = cached_url + ".tmp";
+	FILE* file = nullptr;
+#ifdef _WIN32
+	fopen_s(&file, temporary_url.c_str(), "wb");
+#else
+	file = fopen(temporary_url.c_str(), "wb");
+#endif
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	unsigned int magic = DDS_MAGIC;
+	bool written = fwrite(&magic, 4, 1, file) == 1 && fwrite(&header, sizeof(DDSHeader), 1, file) == 1;
+	for (const TextureLevel& level : processed_texture.levels)
+	{
+		written = written && fwrite(level.data.data(), 1, level.data.size(), file) == level.data.size();
+	}
+	fclose(file);
+
+	std::remove(cached_url.c_str()); // rename fails on windows if the file exists
+	if (!written || std::rename(temporary_url.c_str(), cached_url.c_str()) != 0)
+	{
+		std::remove(temporary_url.c_str());
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,80 @@
+// Class Texture Cache
+// It keeps in the disk the textures already processed (all the mip levels, DXT compressed) in DDS files, so the next time the game is run
+// the textures are uploaded directly from the file without decoding or compressing them again.
+// Each file is named by a key made of the url of the image, its modification time and the options used to process it,
+// so if the image is modified or it is loaded with other options a new file is created.
+// The cached files are memory mapped and the levels are uploaded from the mapped memory (no copy, no decode).
+// It keeps the number of textures loaded from the cache (warm) and processed (cold) and the time spent in each case.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include "TexturePreprocessor.h"
+#include "MappedFile.h"
+#include <string>
+
+// information of a texture loaded by the cache, it is used by the residency manager to know the memory of each level
+struct CachedTextureInfo
+{
+	int width = 0; // size of the level 0 (the full texture, even if it has not been uploaded)
+	int height = 0;
+	int num_levels = 0; // levels of the full texture
+	GLenum format = GL_RGBA;
+};
+
+class TextureCache
+{
+public:
+	// constructor
+	// cache_directory: folder where the DDS files are saved, it is created if it doesn't exist
+	TextureCache(TexturePreprocessor* preprocessor, const char* cache_directory = "cache/");
+
+	// destructor
+	~TextureCache();
+
+	// return the texture object of the image, from the cache if it is there or processing it (and saving it in the cache) if it is not
+	// first_level: first mip level uploaded (the levels before it stay in the disk), info: if it is not null it is filled with the full texture information
+	GLuint loadTexture(const char* url, TexturePreprocessOptions options, int first_level = 0, CachedTextureInfo* info = nullptr);
+
+	// remove the cached file of the image (the next load will be cold)
+	void removeCachedTexture(const char* url, TexturePreprocessOptions options);
+
+	// print the number of textures and the time of the warm (from the cache) and cold (processed) loads
+	void printStats() const;
+
+	// stats of the loads
+	int getNumWarmLoads() const;
+	int getNumColdLoads() const;
+	double getWarmLoadsTime() const; // ms
+	double getColdLoadsTime() const; // ms
+	void resetStats();
+
+	// size in bytes of a level of a texture
+	static size_t getLevelSize(int width, int height, GLenum format);
+
+private:
+	// preprocessor used when the texture is not in the cache
+	TexturePreprocessor* preprocessor_;
+
+	// folder of the cache files
+	std::string cache_directory_;
+
+	// stats of the loads
+	int num_warm_loads_, num_cold_loads_;
+	double warm_loads_ms_, cold_loads_ms_;
+
+	// return the modification time of the file (0 if it doesn't exist)
+	long long getModificationTime(const char* url) const;
+
+	// return the options as bits, they are part of the key
+	unsigned int getOptionsFlags(const TexturePreprocessOptions& options) const;
+
+	// return the url of the cached file of the image
+	std::string getCachedUrl(const char* url, long long modification_time, unsigned int options_flags) const;
+
+	// upload the texture from the cached file (from first_level), it returns 0 if the file is not valid or it was saved for another key
+	GLuint loadCachedTexture(const std::string& cached_url, const char* url, long long modification_time, unsigned int options_flags, int first_level, CachedTextureInfo* info);
+
+	// save the processed texture in a DDS file with its key (modification time, options and hash of the url)
+	bool saveCachedTexture(const std::string& cached_url, const char* url, const ProcessedTexture& processed_texture, long long modification_time, unsigned int options_flags);
+};
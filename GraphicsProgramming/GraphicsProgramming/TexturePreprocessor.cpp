@@ -0,0 +1,543 @@
+#include "TexturePreprocessor.h"
+#include <emmintrin.h> // SSE2
+#include <cstring> // memcpy
+#include <algorithm> // min, max
+
+// run the job over the range in tiles, in the thread pool if there is one or in this thread if there isn't
+static void runTiles(ThreadPool* thread_pool, int begin, int end, const function<void(int, int)>& job, int grain)
+{
+	if (thread_pool != nullptr)
+	{
+		thread_pool->parallelFor(begin, end, job, grain);
+	}
+	else
+	{
+		job(begin, end);
+	}
+}
+
+// number of elements per tile, so each thread gets a few tiles (it balances the work if some tiles are slower)
+static int tileGrain(ThreadPool* thread_pool, int num_elements)
+{
+	int num_threads = (thread_pool != nullptr) ? thread_pool->getNumThreads() : 1;
+	return max(1, num_elements / (num_threads * 4));
+}
+
+TexturePreprocessor::TexturePreprocessor(ThreadPool* thread_pool)
+	: thread_pool_(thread_pool)
+{
+}
+
+TexturePreprocessor::~TexturePreprocessor()
+{
+}
+
+GLuint TexturePreprocessor::loadTexture(const char* url, TexturePreprocessOptions options)
+{
+	vector<unsigned char> pixels;
+	int width, height;
+	bool has_alpha;
+	if (!loadImage(url, pixels, width, height, has_alpha))
+	{
+		return 0;
+	}
+
+	// if the graphics card cannot receive compressed textures, keep the levels uncompressed
+	if (!GLExtensions::hasCompressedTextures())
+	{
+		options.compress_dxt = false;
+	}
+
+	ProcessedTexture processed_texture;
+	process(pixels, width, height, has_alpha, options, processed_texture);
+
+	return upload(processed_texture);
+}
+
+bool TexturePreprocessor::loadImage(const char* url, vector<unsigned char>& pixels, int& width, int& height, bool& has_alpha)
+{
+	// decode the image, always as RGBA so all the kernels work with 4 bytes per pixel
+	int channels;
+	unsigned char* img = SOIL_load_image(url, &width, &height, &channels, SOIL_LOAD_RGBA);
+	if (img == nullptr)
+	{
+		printf("SOIL loading error: '%s'\n", SOIL_last_result());
+		return false;
+	}
+
+	pixels.assign(img, img + (width * height * 4));
+	SOIL_free_image_data(img);
+
+	// the original channels decide the format (as SOIL: DXT1 for RGB, DXT5 for RGBA)
+	has_alpha = (channels == 2 || channels == 4);
+
+	return true;
+}
+
+void TexturePreprocessor::process(vector<unsigned char>& pixels, int width, int height, bool has_alpha, TexturePreprocessOptions options, ProcessedTexture& result)
+{
+	// the pixels become the level 0
+	vector<TextureLevel> rgba_levels(1);
+	rgba_levels[0].width = width;
+	rgba_levels[0].height = height;
+	rgba_levels[0].data.swap(pixels);
+
+	// same order of steps as SOIL
+	if (options.invert_y)
+	{
+		flipVertically(rgba_levels[0].data.data(), width, height, thread_pool_);
+	}
+
+	if (options.ntsc_safe)
+	{
+		scaleToNTSCSafe(rgba_levels[0].data.data(), width * height, thread_pool_);
+	}
+
+	if (options.mipmaps)
+	{
+		resizeToPowerOfTwo(rgba_levels[0]);
+
+		// create the levels until the level of 1x1 pixel
+		while (rgba_levels.back().width > 1 || rgba_levels.back().height > 1)
+		{
+			TextureLevel next_level;
+			generateMipLevel(rgba_levels.back(), next_level);
+			rgba_levels.push_back(move(next_level));
+		}
+	}
+
+	result.levels.clear();
+	if (options.compress_dxt)
+	{
+		result.format = has_alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		result.compressed = true;
+		result.levels.resize(rgba_levels.size());
+		for (size_t i = 0; i < rgba_levels.size(); i++)
+		{
+			compressLevel(rgba_levels[i], has_alpha, result.levels[i]);
+			vector<unsigned char>().swap(rgba_levels[i].data); // free the RGBA data once it has been compressed
+		}
+	}
+	else
+	{
+		result.format = GL_RGBA;
+		result.compressed = false;
+		result.levels = move(rgba_levels);
+	}
+}
+
+GLuint TexturePreprocessor::upload(const ProcessedTexture& processed_texture, int first_level)
+{
+	int num_levels = (int)processed_texture.levels.size();
+	first_level = max(0, min(first_level, num_levels - 1));
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	// upload each level (the first level uploaded becomes the level 0 of the texture object)
+	for (int i = first_level; i < num_levels; i++)
+	{
+		const TextureLevel& level = processed_texture.levels[i];
+		if (processed_texture.compressed)
+		{
+			GLExtensions::compressedTexImage2D(GL_TEXTURE_2D, i - first_level, processed_texture.format, level.width, level.height, 0, (GLsizei)level.data.size(), level.data.data());
+		}
+		else
+		{
+			glTexImage2D(GL_TEXTURE_2D, i - first_level, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data.data());
+		}
+	}
+
+	// same filters as SOIL
+	bool has_mipmaps = (num_levels - first_level) > 1;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, num_levels - first_level - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, has_mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return texture;
+}
+
+int TexturePreprocessor::getNumThreads() const
+{
+	return (thread_pool_ != nullptr) ? thread_pool_->getNumThreads() : 1;
+}
+
+void TexturePreprocessor::flipVertically(unsigned char* pixels, int width, int height, ThreadPool* thread_pool)
+{
+	int row_size = width * 4;
+	int half_height = height / 2;
+
+	// each tile is a group of rows of the top half, they are swapped with their rows of the bottom half
+	runTiles(thread_pool, 0, half_height, [pixels, row_size, height](int begin, int end)
+	{
+		for (int row = begin; row < end; row++)
+		{
+			unsigned char* top = pixels + row * row_size;
+			unsigned char* bottom = pixels + (height - 1 - row) * row_size;
+
+			// 16 bytes (4 pixels) at once
+			int i = 0;
+			for (; i + 16 <= row_size; i += 16)
+			{
+				__m128i top_pixels = _mm_loadu_si128((const __m128i*)(top + i));
+				__m128i bottom_pixels = _mm_loadu_si128((const __m128i*)(bottom + i));
+				_mm_storeu_si128((__m128i*)(top + i), bottom_pixels);
+				_mm_storeu_si128((__m128i*)(bottom + i), top_pixels);
+			}
+			// rest of the row
+			for (; i < row_size; i++)
+			{
+				swap(top[i], bottom[i]);
+			}
+		}
+	}, tileGrain(thread_pool, half_height));
+}
+
+void TexturePreprocessor::scaleToNTSCSafe(unsigned char* pixels, int num_pixels, ThreadPool* thread_pool)
+{
+	// SOIL scales each value with: 16 + value * 219 / 255 (rounded), it is done here with integers:
+	// value * 220 + 3953 and then divided by 255 with (x + 1 + (x >> 8)) >> 8 (exact for x < 65535)
+	runTiles(thread_pool, 0, num_pixels, [pixels](int begin, int end)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i scale = _mm_set1_epi16(220);
+		const __m128i offset = _mm_set1_epi16(3953);
+		const __m128i one = _mm_set1_epi16(1);
+		const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000); // the alpha byte of each pixel
+
+		int i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128i original = _mm_loadu_si128((const __m128i*)(pixels + i * 4));
+
+			// 8 bits to 16 bits (2 pixels per half)
+			__m128i low = _mm_unpacklo_epi8(original, zero);
+			__m128i high = _mm_unpackhi_epi8(original, zero);
+
+			// value * 220 + 3953
+			low = _mm_add_epi16(_mm_mullo_epi16(low, scale), offset);
+			high = _mm_add_epi16(_mm_mullo_epi16(high, scale), offset);
+
+			// divide by 255
+			low = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(low, one), _mm_srli_epi16(low, 8)), 8);
+			high = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(high, one), _mm_srli_epi16(high, 8)), 8);
+
+			// back to 8 bits and keep the original alpha
+			__m128i scaled = _mm_packus_epi16(low, high);
+			scaled = _mm_or_si128(_mm_andnot_si128(alpha_mask, scaled), _mm_and_si128(alpha_mask, original));
+
+			_mm_storeu_si128((__m128i*)(pixels + i * 4), scaled);
+		}
+		// rest of the pixels
+		for (; i < end; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				unsigned int x = pixels[i * 4 + c] * 220 + 3953;
+				pixels[i * 4 + c] = (unsigned char)((x + 1 + (x >> 8)) >> 8);
+			}
+		}
+	}, max(4096, tileGrain(thread_pool, num_pixels)));
+}
+
+void TexturePreprocessor::resizeToPowerOfTwo(TextureLevel& level)
+{
+	// next power of two (bigger or equal, as SOIL does)
+	int new_width = 1, new_height = 1;
+	while (new_width < level.width) new_width *= 2;
+	while (new_height < level.height) new_height *= 2;
+
+	if (new_width == level.width && new_height == level.height)
+	{
+		return;
+	}
+
+	TextureLevel resized;
+	resized.width = new_width;
+	resized.height = new_height;
+	resized.data.resize(new_width * new_height * 4);
+
+	const TextureLevel& source = level;
+	float scale_x = (float)source.width / (float)new_width;
+	float scale_y = (float)source.height / (float)new_height;
+
+	// bilinear, each tile is a group of rows
+	runTiles(thread_pool_, 0, new_height, [&source, &resized, scale_x, scale_y](int begin, int end)
+	{
+		for (int y = begin; y < end; y++)
+		{
+			float source_y = max(0.0f, (y + 0.5f) * scale_y - 0.5f);
+			int y0 = min((int)source_y, source.height - 1);
+			int y1 = min(y0 + 1, source.height - 1);
+			float fy = source_y - y0;
+
+			for (int x = 0; x < resized.width; x++)
+			{
+				float source_x = max(0.0f, (x + 0.5f) * scale_x - 0.5f);
+				int x0 = min((int)source_x, source.width - 1);
+				int x1 = min(x0 + 1, source.width - 1);
+				float fx = source_x - x0;
+
+				const unsigned char* p00 = &source.data[(y0 * source.width + x0) * 4];
+				const unsigned char* p01 = &source.data[(y0 * source.width + x1) * 4];
+				const unsigned char* p10 = &source.data[(y1 * source.width + x0) * 4];
+				const unsigned char* p11 = &source.data[(y1 * source.width + x1) * 4];
+				unsigned char* destination = &resized.data[(y * resized.width + x) * 4];
+
+				for (int c = 0; c < 4; c++)
+				{
+					float top = p00[c] + (p01[c] - p00[c]) * fx;
+					float bottom = p10[c] + (p11[c] - p10[c]) * fx;
+					destination[c] = (unsigned char)(top + (bottom - top) * fy + 0.5f);
+				}
+			}
+		}
+	}, tileGrain(thread_pool_, new_height));
+
+	level = move(resized);
+}
+
+void TexturePreprocessor::generateMipLevel(const TextureLevel& source, TextureLevel& destination)
+{
+	destination.width = max(1, source.width / 2);
+	destination.height = max(1, source.height / 2);
+	destination.data.resize(destination.width * destination.height * 4);
+
+	// each tile is a group of rows of the new level
+	runTiles(thread_pool_, 0, destination.height, [&source, &destination](int begin, int end)
+	{
+		for (int y = begin; y < end; y++)
+		{
+			const unsigned char* row0 = &source.data[(min(y * 2, source.height - 1) * source.width) * 4];
+			const unsigned char* row1 = &source.data[(min(y * 2 + 1, source.height - 1) * source.width) * 4];
+			unsigned char* destination_row = &destination.data[(y * destination.width) * 4];
+
+			// 4 new pixels (8 pixels of each source row) at once
+			int x = 0;
+			for (; (x + 4) * 2 <= source.width && x + 4 <= destination.width; x += 4)
+			{
+				// vertical average
+				__m128i top0 = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+				__m128i top1 = _mm_loadu_si128((const __m128i*)(row0 + x * 8 + 16));
+				__m128i bottom0 = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+				__m128i bottom1 = _mm_loadu_si128((const __m128i*)(row1 + x * 8 + 16));
+				__m128i vertical0 = _mm_avg_epu8(top0, bottom0);
+				__m128i vertical1 = _mm_avg_epu8(top1, bottom1);
+
+				// separate the even and odd pixels and do the horizontal average
+				__m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(vertical0), _mm_castsi128_ps(vertical1), _MM_SHUFFLE(2, 0, 2, 0)));
+				__m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(vertical0), _mm_castsi128_ps(vertical1), _MM_SHUFFLE(3, 1, 3, 1)));
+
+				_mm_storeu_si128((__m128i*)(destination_row + x * 4), _mm_avg_epu8(even, odd));
+			}
+			// rest of the row (and images with odd width)
+			for (; x < destination.width; x++)
+			{
+				int x0 = min(x * 2, source.width - 1);
+				int x1 = min(x * 2 + 1, source.width - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					int sum = row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c];
+					destination_row[x * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+	}, tileGrain(thread_pool_, destination.height));
+}
+
+void TexturePreprocessor::compressLevel(const TextureLevel& source, bool has_alpha, TextureLevel& destination)
+{
+	int blocks_x = (source.width + 3) / 4;
+	int blocks_y = (source.height + 3) / 4;
+	int block_size = has_alpha ? 16 : 8; // DXT5: 8 bytes of alpha + 8 bytes of colour, DXT1: 8 bytes of colour
+
+	destination.width = source.width;
+	destination.height = source.height;
+	destination.data.resize(blocks_x * blocks_y * block_size);
+
+	// each tile is a group of rows of blocks
+	runTiles(thread_pool_, 0, blocks_y, [&source, &destination, blocks_x, block_size, has_alpha](int begin, int end)
+	{
+		unsigned char block[64]; // 4x4 RGBA pixels
+
+		for (int block_y = begin; block_y < end; block_y++)
+		{
+			for (int block_x = 0; block_x < blocks_x; block_x++)
+			{
+				// copy the pixels of the block, the blocks in the border of small levels repeat their last pixels
+				for (int row = 0; row < 4; row++)
+				{
+					int y = min(block_y * 4 + row, source.height - 1);
+					const unsigned char* source_row = &source.data[(y * source.width) * 4];
+					if (block_x * 4 + 4 <= source.width)
+					{
+						memcpy(block + row * 16, source_row + block_x * 16, 16);
+					}
+					else
+					{
+						for (int column = 0; column < 4; column++)
+						{
+							int x = min(block_x * 4 + column, source.width - 1);
+							memcpy(block + row * 16 + column * 4, source_row + x * 4, 4);
+						}
+					}
+				}
+
+				unsigned char* output = &destination.data[(block_y * blocks_x + block_x) * block_size];
+				if (has_alpha)
+				{
+					compressAlphaBlock(block, output);
+					compressColourBlock(block, output + 8);
+				}
+				else
+				{
+					compressColourBlock(block, output);
+				}
+			}
+		}
+	}, tileGrain(thread_pool_, blocks_y));
+}
+
+// convert a 8 bits per channel colour to 5:6:5 (rounded)
+static unsigned short toRGB565(int r, int g, int b)
+{
+	return (unsigned short)((((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255));
+}
+
+// convert a 5:6:5 colour back to 8 bits per channel, as the graphics card does when it decodes it
+static void fromRGB565(unsigned short colour, int& r, int& g, int& b)
+{
+	int r5 = (colour >> 11) & 31, g6 = (colour >> 5) & 63, b5 = colour & 31;
+	r = (r5 << 3) | (r5 >> 2);
+	g = (g6 << 2) | (g6 >> 4);
+	b = (b5 << 3) | (b5 >> 2);
+}
+
+// min and max of each channel of the 16 pixels of a block (they are returned as a RGBA pixel each one)
+static void blockBoundingBox(const unsigned char* block, unsigned int& min_pixel, unsigned int& max_pixel)
+{
+	__m128i row0 = _mm_loadu_si128((const __m128i*)(block));
+	__m128i row1 = _mm_loadu_si128((const __m128i*)(block + 16));
+	__m128i row2 = _mm_loadu_si128((const __m128i*)(block + 32));
+	__m128i row3 = _mm_loadu_si128((const __m128i*)(block + 48));
+
+	// 4 rows to 1 row of 4 pixels
+	__m128i min_colour = _mm_min_epu8(_mm_min_epu8(row0, row1), _mm_min_epu8(row2, row3));
+	__m128i max_colour = _mm_max_epu8(_mm_max_epu8(row0, row1), _mm_max_epu8(row2, row3));
+
+	// 4 pixels to 1 pixel
+	min_colour = _mm_min_epu8(min_colour, _mm_shuffle_epi32(min_colour, _MM_SHUFFLE(1, 0, 3, 2)));
+	min_colour = _mm_min_epu8(min_colour, _mm_shuffle_epi32(min_colour, _MM_SHUFFLE(2, 3, 0, 1)));
+	max_colour = _mm_max_epu8(max_colour, _mm_shuffle_epi32(max_colour, _MM_SHUFFLE(1, 0, 3, 2)));
+	max_colour = _mm_max_epu8(max_colour, _mm_shuffle_epi32(max_colour, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	min_pixel = (unsigned int)_mm_cvtsi128_si32(min_colour);
+	max_pixel = (unsigned int)_mm_cvtsi128_si32(max_colour);
+}
+
+void TexturePreprocessor::compressColourBlock(const unsigned char* block, unsigned char* output)
+{
+	unsigned int min_pixel, max_pixel;
+	blockBoundingBox(block, min_pixel, max_pixel);
+
+	// end points: the corners of the bounding box, inset 1/16 of the box to reduce the error of the pixels in the middle
+	int min_colour[3], max_colour[3];
+	for (int c = 0; c < 3; c++)
+	{
+		min_colour[c] = (min_pixel >> (c * 8)) & 0xFF;
+		max_colour[c] = (max_pixel >> (c * 8)) & 0xFF;
+		int inset = (max_colour[c] - min_colour[c]) >> 4;
+		min_colour[c] += inset;
+		max_colour[c] -= inset;
+	}
+
+	unsigned short colour0 = toRGB565(max_colour[0], max_colour[1], max_colour[2]);
+	unsigned short colour1 = toRGB565(min_colour[0], min_colour[1], min_colour[2]);
+
+	// write the end points (little endian)
+	output[0] = colour0 & 0xFF;
+	output[1] = colour0 >> 8;
+	output[2] = colour1 & 0xFF;
+	output[3] = colour1 >> 8;
+
+	// a block of a single colour uses the index 0 for all its pixels
+	unsigned int indices = 0;
+	if (colour0 != colour1)
+	{
+		// the bounding box keeps colour0 > colour1, so the block uses the mode of 4 colours: c0, c1, 2/3c0+1/3c1, 1/3c0+2/3c1
+		int p0[3], p1[3];
+		fromRGB565(colour0, p0[0], p0[1], p0[2]);
+		fromRGB565(colour1, p1[0], p1[1], p1[2]);
+		int axis[3] = { p0[0] - p1[0], p0[1] - p1[1], p0[2] - p1[2] };
+		int axis_length = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+		// project each pixel into the axis c1->c0 (4 pixels at once), t = dot(pixel - c1, c0 - c1)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i base = _mm_setr_epi16((short)p1[0], (short)p1[1], (short)p1[2], 0, (short)p1[0], (short)p1[1], (short)p1[2], 0);
+		const __m128i direction = _mm_setr_epi16((short)axis[0], (short)axis[1], (short)axis[2], 0, (short)axis[0], (short)axis[1], (short)axis[2], 0);
+		int projections[16];
+		for (int row = 0; row < 4; row++)
+		{
+			__m128i pixels = _mm_loadu_si128((const __m128i*)(block + row * 16));
+
+			// each result has 2 sums per pixel: (r*dr + g*dg) and (b*db + 0)
+			__m128i low = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(pixels, zero), base), direction);
+			__m128i high = _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(pixels, zero), base), direction);
+
+			// add the 2 sums of each pixel
+			__m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high), _MM_SHUFFLE(2, 0, 2, 0)));
+			__m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low), _mm_castsi128_ps(high), _MM_SHUFFLE(3, 1, 3, 1)));
+			_mm_storeu_si128((__m128i*)(projections + row * 4), _mm_add_epi32(even, odd));
+		}
+
+		// choose the closest colour of the palette (t/length: 1 is c0, 2/3 is index 2, 1/3 is index 3, 0 is c1)
+		for (int i = 0; i < 16; i++)
+		{
+			int t = projections[i];
+			unsigned int index;
+			if (t * 6 > axis_length * 5) index = 0;
+			else if (t * 2 > axis_length) index = 2;
+			else if (t * 6 > axis_length) index = 3;
+			else index = 1;
+			indices |= index << (i * 2);
+		}
+	}
+
+	output[4] = indices & 0xFF;
+	output[5] = (indices >> 8) & 0xFF;
+	output[6] = (indices >> 16) & 0xFF;
+	output[7] = (indices >> 24) & 0xFF;
+}
+
+void TexturePreprocessor::compressAlphaBlock(const unsigned char* block, unsigned char* output)
+{
+	unsigned int min_pixel, max_pixel;
+	blockBoundingBox(block, min_pixel, max_pixel);
+
+	int alpha0 = max_pixel >> 24; // max alpha
+	int alpha1 = min_pixel >> 24; // min alpha
+	output[0] = (unsigned char)alpha0;
+	output[1] = (unsigned char)alpha1;
+
+	// alpha0 > alpha1 uses the mode of 8 alphas: a0, a1 and 6 values between them (index 2 is the closest to a0)
+	unsigned long long indices = 0;
+	if (alpha0 != alpha1)
+	{
+		int range = alpha0 - alpha1;
+		for (int i = 0; i < 16; i++)
+		{
+			int step = ((block[i * 4 + 3] - alpha1) * 7 + range / 2) / range; // 0 (a1) to 7 (a0)
+			unsigned long long index = (step == 7) ? 0 : ((step == 0) ? 1 : (unsigned long long)(8 - step));
+			indices |= index << (i * 3);
+		}
+	}
+
+	// 16 indices of 3 bits (48 bits)
+	for (int i = 0; i < 6; i++)
+	{
+		output[2 + i] = (unsigned char)((indices >> (i * 8)) & 0xFF);
+	}
+}
@@ -0,0 +1,103 @@
+// Class Texture Preprocessor
+// It replaces the work SOIL does when a texture is loaded (invert y, NTSC safe colours, mipmaps and DXT compression) with our own pipeline.
+// The image is only decoded by SOIL, the rest of the work is done with SSE2 kernels (16 bytes = 4 pixels at once) and it is split
+// in tiles (rows or rows of 4x4 blocks) which run in parallel in the thread pool.
+// - Invert y: rows are swapped 16 bytes at a time.
+// - NTSC safe: the RGB values are scaled to 16-235 in the same way SOIL does it (the alpha is not modified).
+// - Mipmaps: each level is the box filter (average of 2x2 pixels) of the previous one. Images which are not power of two are resized first (as SOIL does).
+// - DXT: BC1 (DXT1) for images without alpha and BC3 (DXT5) for images with alpha. The end points of each block are its colour bounding box (range fit)
+//   inset a bit to reduce the error, like the "fast" mode of the common DXT encoders.
+// If the graphics card doesn't support compressed textures the levels are uploaded uncompressed.
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+// Include GLUT, openGL, input.
+#include "glut.h"
+#include <gl/GL.h>
+#include <gl/GLU.h>
+#include <vector>
+
+#include "SOIL.h"
+#include "ThreadPool.h"
+#include "GLExtensions.h"
+
+using namespace std;
+
+// steps to apply to an image, by default the same ones SOIL applied in the Texture class
+struct TexturePreprocessOptions
+{
+	bool invert_y = false; // flip the image vertically
+	bool ntsc_safe = true; // scale the rgb values to 16-235
+	bool mipmaps = true; // create all the mip levels (the image is resized to power of two if it is not)
+	bool compress_dxt = true; // compress each level to DXT1 (no alpha) or DXT5 (alpha)
+};
+
+// a level of the texture (the level 0 is the full size image), the data is RGBA or DXT blocks
+struct TextureLevel
+{
+	int width = 0;
+	int height = 0;
+	vector<unsigned char> data;
+};
+
+// result of the preprocessing, ready to be uploaded
+struct ProcessedTexture
+{
+	GLenum format = GL_RGBA; // GL_RGBA, GL_COMPRESSED_RGB_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	bool compressed = false;
+	vector<TextureLevel> levels;
+};
+
+class TexturePreprocessor
+{
+public:
+	// constructor, if there is no thread pool the work is done in the calling thread
+	TexturePreprocessor(ThreadPool* thread_pool = nullptr);
+
+	// destructor
+	~TexturePreprocessor();
+
+	// load, process and upload the image, it returns the texture object created (0 if the image cannot be loaded)
+	GLuint loadTexture(const char* url, TexturePreprocessOptions options);
+
+	// decode the image with SOIL into RGBA pixels, has_alpha is true if the image file had an alpha channel
+	bool loadImage(const char* url, vector<unsigned char>& pixels, int& width, int& height, bool& has_alpha);
+
+	// apply the steps of the options to the RGBA pixels (the pixels are moved into the result)
+	void process(vector<unsigned char>& pixels, int width, int height, bool has_alpha, TexturePreprocessOptions options, ProcessedTexture& result);
+
+	// create the texture object with the levels of the processed texture, starting from first_level (the levels before it are not uploaded)
+	GLuint upload(const ProcessedTexture& processed_texture, int first_level = 0);
+
+	// return the number of threads the tiles are split in
+	int getNumThreads() const;
+
+
+	/* KERNELS (they can be used without a preprocessor object, ex: by the texture atlas) */
+
+	// flip the RGBA image vertically
+	static void flipVertically(unsigned char* pixels, int width, int height, ThreadPool* thread_pool = nullptr);
+
+	// scale the rgb values of the RGBA pixels to 16-235 (NTSC safe), the alpha values are not modified
+	static void scaleToNTSCSafe(unsigned char* pixels, int num_pixels, ThreadPool* thread_pool = nullptr);
+
+private:
+	// thread pool where the tiles are run
+	ThreadPool* thread_pool_;
+
+	// resize the image to the next power of two (bilinear), as openGL 1.1 and the mipmaps need it
+	void resizeToPowerOfTwo(TextureLevel& level);
+
+	// create the next mip level (half size) from the level passed
+	void generateMipLevel(const TextureLevel& source, TextureLevel& destination);
+
+	// compress a RGBA level into DXT1 or DXT5 blocks
+	void compressLevel(const TextureLevel& source, bool has_alpha, TextureLevel& destination);
+
+	// compress a block of 4x4 RGBA pixels (64 bytes) into the colour part of a DXT block (8 bytes)
+	static void compressColourBlock(const unsigned char* block, unsigned char* output);
+
+	// compress the alpha of a block of 4x4 RGBA pixels into the alpha part of a DXT5 block (8 bytes)
+	static void compressAlphaBlock(const unsigned char* block, unsigned char* output);
+};
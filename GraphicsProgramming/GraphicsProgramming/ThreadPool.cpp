@@ -0,0 +1,269 @@
+#include "ThreadPool.h"
+#include <chrono>
+
+// pool and index of the calling thread (index 0 if it is not a worker of that pool)
+static thread_local ThreadPool* current_pool = nullptr;
+static thread_local int current_index = 0;
+
+// tasks running in the calling thread (a task can run others while it waits, ex: parallelFor() in a task), only the outer one is timed
+static thread_local int task_depth = 0;
+
+ThreadPool::ThreadPool(int num_threads)
+	: num_pending_tasks_(0), num_worker_tasks_(0), stopping_(false), busy_nanoseconds_(0)
+{
+	// by default use all the cores, the calling thread counts as one of them
+	if (num_threads <= 0)
+	{
+		num_threads = (int)thread::hardware_concurrency() - 1;
+		if (num_threads < 1)
+		{
+			num_threads = 1;
+		}
+	}
+
+	// the shared deque and one for each worker, they are created before the workers start stealing
+	for (int i = 0; i <= num_threads; i++)
+	{
+		queues_.push_back(unique_ptr<TaskQueue>(new TaskQueue()));
+	}
+
+	// create the workers
+	for (int i = 1; i <= num_threads; i++)
+	{
+		workers_.push_back(thread(&ThreadPool::workerLoop, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	// tell the workers to stop and wake them up
+	{
+		lock_guard<mutex> lock(sleep_mutex_);
+		stopping_ = true;
+	}
+	sleep_condition_.notify_all();
+
+	// wait for them
+	for (thread& worker : workers_)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::parallelFor(int begin, int end, const function<void(int, int)>& job, int grain)
+{
+	if (end <= begin)
+	{
+		return;
+	}
+	if (grain < 1)
+	{
+		grain = 1;
+	}
+
+	// if there is only one chunk it is not worth to send it to the workers
+	if (end - begin <= grain)
+	{
+		job(begin, end);
+		return;
+	}
+
+	// number of chunks which are not finished yet, the last one wakes up the calling thread
+	int num_chunks = (end - begin + grain - 1) / grain;
+	atomic<int> remaining_chunks(num_chunks);
+	mutex done_mutex;
+	condition_variable done_condition;
+
+	// push a task per chunk
+	for (int chunk_begin = begin; chunk_begin < end; chunk_begin += grain)
+	{
+		int chunk_end = (chunk_begin + grain < end) ? chunk_begin + grain : end;
+		push([&job, &remaining_chunks, &done_mutex, &done_condition, chunk_begin, chunk_end]()
+		{
+			job(chunk_begin, chunk_end);
+
+			// the last chunk tells the calling thread that all the job has been done
+			// the counter is decreased inside the lock, so the calling thread can't return (destroying them) while they are being used
+			lock_guard<mutex> done_lock(done_mutex);
+			if (remaining_chunks.fetch_sub(1) == 1)
+			{
+				done_condition.notify_all();
+			}
+		});
+	}
+
+	// work on the tasks while they are not finished (they can also be tasks of other calls)
+	while (remaining_chunks.load() > 0)
+	{
+		if (!runPendingTask())
+		{
+			// nothing left to run or steal, wait for the workers to finish the last chunks
+			unique_lock<mutex> done_lock(done_mutex);
+			done_condition.wait(done_lock, [&remaining_chunks]() { return remaining_chunks.load() == 0; });
+		}
+	}
+
+	// wait until the last chunk has released the lock (it could still be notifying)
+	lock_guard<mutex> done_lock(done_mutex);
+}
+
+void ThreadPool::submit(const function<void()>& task)
+{
+	// without workers nobody would take the task, so it is run now
+	if (workers_.empty())
+	{
+		task();
+		return;
+	}
+
+	push(task);
+}
+
+void ThreadPool::submitToWorkers(const function<void()>& task)
+{
+	if (workers_.empty())
+	{
+		task();
+		return;
+	}
+
+	{
+		lock_guard<mutex> lock(worker_queue_.tasks_mutex);
+		worker_queue_.tasks.push_back(task);
+	}
+	num_worker_tasks_++;
+	num_pending_tasks_++;
+
+	{
+		lock_guard<mutex> lock(sleep_mutex_);
+	}
+	sleep_condition_.notify_one();
+}
+
+void ThreadPool::waitUntil(const function<bool()>& done)
+{
+	while (!done())
+	{
+		if (!runPendingTask())
+		{
+			// the tasks left are running in other threads, they can push new ones or finish at any moment
+			// (a non worker thread doesn't wake up for the tasks of the worker deque, it cannot take them)
+			int index = getThreadIndex();
+			unique_lock<mutex> lock(sleep_mutex_);
+			sleep_condition_.wait_for(lock, chrono::microseconds(100), [this, index]()
+			{
+				return num_pending_tasks_.load() > (index == 0 ? num_worker_tasks_.load() : 0);
+			});
+		}
+	}
+}
+
+int ThreadPool::getNumThreads() const
+{
+	return (int)workers_.size() + 1;
+}
+
+int ThreadPool::getThreadIndex() const
+{
+	return (current_pool == this) ? current_index : 0;
+}
+
+double ThreadPool::getBusyTime() const
+{
+	return busy_nanoseconds_.load() / 1e9;
+}
+
+void ThreadPool::push(const function<void()>& task)
+{
+	TaskQueue& queue = *queues_[getThreadIndex()];
+	{
+		lock_guard<mutex> lock(queue.tasks_mutex);
+		queue.tasks.push_back(task);
+	}
+	num_pending_tasks_++;
+
+	// the lock makes sure a worker which has just seen no tasks is already waiting (otherwise it would miss the notification)
+	{
+		lock_guard<mutex> lock(sleep_mutex_);
+	}
+	sleep_condition_.notify_one();
+}
+
+void ThreadPool::workerLoop(int index)
+{
+	current_pool = this;
+	current_index = index;
+
+	while (true)
+	{
+		if (runPendingTask())
+		{
+			continue;
+		}
+
+		// wait until there is a task or the pool is stopping
+		unique_lock<mutex> lock(sleep_mutex_);
+		sleep_condition_.wait(lock, [this]() { return stopping_.load() || num_pending_tasks_.load() > 0; });
+
+		if (stopping_.load() && num_pending_tasks_.load() == 0)
+		{
+			return;
+		}
+	}
+}
+
+bool ThreadPool::runPendingTask()
+{
+	function<void()> task;
+	int index = getThreadIndex();
+	int num_queues = (int)queues_.size();
+
+	// the own deque from the back (the newest task), then the others from the front (the oldest ones)
+	for (int i = 0; i < num_queues && !task; i++)
+	{
+		int victim = (index + i) % num_queues;
+		TaskQueue& queue = *queues_[victim];
+		lock_guard<mutex> lock(queue.tasks_mutex);
+		if (queue.tasks.empty())
+		{
+			continue;
+		}
+		if (i == 0 && index != 0)
+		{
+			task = move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+	}
+
+	// the jobs only for the workers, after the rest (the frame tasks which the GL thread is waiting for go first)
+	if (!task && index != 0)
+	{
+		lock_guard<mutex> lock(worker_queue_.tasks_mutex);
+		if (!worker_queue_.tasks.empty())
+		{
+			task = move(worker_queue_.tasks.front());
+			worker_queue_.tasks.pop_front();
+			num_worker_tasks_--;
+		}
+	}
+	if (!task)
+	{
+		return false;
+	}
+	num_pending_tasks_--;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	task_depth++;
+	task();
+	task_depth--;
+	if (task_depth == 0)
+	{
+		busy_nanoseconds_ += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+	}
+	return true;
+}
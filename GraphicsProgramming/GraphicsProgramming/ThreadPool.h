@@ -0,0 +1,101 @@
+// Class Thread Pool
+// It keeps a group of worker threads alive during all the game, so the heavy CPU work (ex: preprocessing the textures) can be split in
+// tasks and run in parallel without creating and destroying threads each time.
+// The thread which calls parallelFor() also works on the tasks while it is waiting, so no core is wasted waiting.
+// It is created in the main.cpp and shared with the scenes by the SharedContext.
+// The tasks are scheduled by work stealing: each worker has its own deque, the tasks it creates (ex: the chunks of a parallelFor() inside
+// a task) are pushed to the back of it and it takes them from the back (the last ones, their data is still in the cache). When a worker
+// has nothing to do it steals from the front of the deques of the others (the oldest tasks, usually the biggest). The threads which are
+// not workers (ex: the GL thread) push their tasks to a shared deque which is stolen the same way. The long jobs which must not block the GL
+// thread (ex: the simulation of the next frame) are submitted to a deque which only the workers take, so waitUntil() never runs them inline.
+// The time the threads spend running tasks is accumulated, so the scene can show how much of the workers is used (getBusyTime()).
+// @author Francisco Diaz (FMGameDev)
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+class ThreadPool
+{
+public:
+	// constructor
+	// num_threads: number of worker threads, by default (0) it is the number of cores minus one (the main thread also works)
+	ThreadPool(int num_threads = 0);
+
+	// destructor, it waits the workers to finish their current task and stops them
+	~ThreadPool();
+
+	// split the range [begin, end) in chunks of 'grain' elements and call job(chunk_begin, chunk_end) for each chunk in parallel
+	// it returns when all the chunks have been done
+	void parallelFor(int begin, int end, const function<void(int, int)>& job, int grain = 1);
+
+	// run the task in a worker without waiting for it (ex: loading a file in the background)
+	// the task must tell by itself when it has finished (ex: with an atomic flag)
+	void submit(const function<void()>& task);
+
+	// as submit(), but the task is only run by a worker: the threads which are not workers don't take it while they wait in waitUntil() or
+	// parallelFor() (ex: the simulation of the next frame, the GL thread would render late if it ran it while waiting for the frame tasks)
+	void submitToWorkers(const function<void()>& task);
+
+	// run tasks in the calling thread until done() returns true (it sleeps a little when there is nothing to run)
+	void waitUntil(const function<bool()>& done);
+
+	// return the number of threads working in a parallelFor (workers plus the calling thread)
+	int getNumThreads() const;
+
+	// return the index of the calling thread: 1 to the number of workers for the workers, 0 for the other threads
+	int getThreadIndex() const;
+
+	// return the time (s) all the threads have spent running tasks since the pool was created (the tasks run inside other tasks are not added twice)
+	double getBusyTime() const;
+
+private:
+	// deque of tasks of a thread, it is locked by the owner and by the threads which steal from it
+	struct TaskQueue
+	{
+		deque<function<void()>> tasks;
+		mutex tasks_mutex;
+	};
+
+	// worker threads
+	vector<thread> workers_;
+
+	// deque of each worker (index 1 to n) and the shared deque of the other threads (index 0)
+	vector<unique_ptr<TaskQueue>> queues_;
+
+	// deque of the tasks only the workers can take (submitToWorkers())
+	TaskQueue worker_queue_;
+
+	// tasks in all the deques, the workers sleep when it is 0
+	atomic<int> num_pending_tasks_;
+	// tasks of them in the worker deque, the other threads don't wake up for them
+	atomic<int> num_worker_tasks_;
+
+	// synchronisation components for sleeping when there are no tasks
+	mutex sleep_mutex_;
+	condition_variable sleep_condition_;
+
+	// component to tell the workers to stop
+	atomic<bool> stopping_;
+
+	// time running tasks (ns)
+	atomic<long long> busy_nanoseconds_;
+
+	// loop of each worker, it runs the tasks of its deque or steals them and sleeps when there are none
+	void workerLoop(int index);
+
+	// push a task to the deque of the calling thread and wake up a worker
+	void push(const function<void()>& task);
+
+	// take a task (from the back of the own deque or from the front of the others) and run it, it returns false if there was no task
+	bool runPendingTask();
+};
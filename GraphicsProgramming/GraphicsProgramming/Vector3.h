@@ -2,6 +2,7 @@
 // Repesents a vector 3 object, storing x, y and z. Provided functions for vector maths and manipulation
 // @author Paul Robertson
 // It has been added the function "Vector3 operator*(float scale)" by Francisco Diaz (@FMGameDev)
+// The functions which do not modify the vector have been made const by Francisco Diaz (@FMGameDev), the SIMD version is in MathSIMD.h
 
 
 #ifndef _VECTOR3_H_
@@ -13,7 +14,7 @@ class Vector3 {
 
 public:
 	Vector3(float x = 0, float y = 0, float z = 0);
-	Vector3 copy();
+	Vector3 copy() const;
 
 
 	void set(float x, float y, float z);
@@ -21,28 +22,28 @@ public:
 	void setY(float y);
 	void setZ(float z);
 
-	float getX();
-	float getY();
-	float getZ();
+	float getX() const;
+	float getY() const;
+	float getZ() const;
 
 	void add(const Vector3& v1, float scale = 1.0);
 	void subtract(const Vector3& v1, float scale = 1.0);
 	void scale(float scale);
 
-	float dot(const Vector3& v2);
-	Vector3 cross(const Vector3& v2);
+	float dot(const Vector3& v2) const;
+	Vector3 cross(const Vector3& v2) const;
 
 	void normalise();
-	Vector3 normalised();
-	float length();
-	float lengthSquared();
+	Vector3 normalised() const;
+	float length() const;
+	float lengthSquared() const;
 
-	bool equals(const Vector3& v2, float epsilon);
-	bool equals(const Vector3& v2);
+	bool equals(const Vector3& v2, float epsilon) const;
+	bool equals(const Vector3& v2) const;
 
-	Vector3 operator+(const Vector3& v2);
-	Vector3 operator-(const Vector3& v2);
-	Vector3 operator*(float scale);
+	Vector3 operator+(const Vector3& v2) const;
+	Vector3 operator-(const Vector3& v2) const;
+	Vector3 operator*(float scale) const;
 
 	Vector3& operator+=(const Vector3& v2);
 	Vector3& operator-=(const Vector3& v2);